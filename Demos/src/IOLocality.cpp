@@ -0,0 +1,332 @@
+/*
+  IOLocality - a demo program for libosmscout
+  Copyright (C) 2014  Tim Teulings
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <set>
+#include <vector>
+
+#include <osmscout/Database.h>
+
+#include <osmscout/util/File.h>
+#include <osmscout/util/FileScanner.h>
+
+/*
+  Reports, how many pages of the node, way and area data files are touched by
+  a reference set of bounding box queries. The bounding box of the database
+  (or the given bounding box) is split into a grid of cells and one query is
+  executed for each cell. Use it to compare the locality of different sort
+  orders of the data files (see the --sortOrder option of the Import tool).
+
+  Example:
+
+  src/IOLocality ../maps/nordrhein-westfalen 8
+  src/IOLocality ../maps/nordrhein-westfalen 8 51.2 6.5 51.7 8
+*/
+
+static const osmscout::FileOffset pageSize=4096;
+
+/**
+ * Offsets of all objects in a data file, ascending, plus the end of the last
+ * object as end marker, so that the extent of the object at offsets[i] is
+ * [offsets[i],offsets[i+1]).
+ */
+struct DataFileLayout
+{
+  std::string                       name;
+  std::vector<osmscout::FileOffset> offsets;
+
+  size_t                            queryCount;
+  size_t                            objectCount;
+  size_t                            pageCount;
+  size_t                            minPageCount;
+
+  DataFileLayout()
+  : queryCount(0),
+    objectCount(0),
+    pageCount(0),
+    minPageCount(0)
+  {
+    // no code
+  }
+
+  bool GetExtent(osmscout::FileOffset offset,
+                 osmscout::FileOffset& end) const
+  {
+    std::vector<osmscout::FileOffset>::const_iterator entry=std::lower_bound(offsets.begin(),
+                                                                             offsets.end(),
+                                                                             offset);
+
+    if (entry==offsets.end() ||
+        *entry!=offset ||
+        entry+1==offsets.end()) {
+      return false;
+    }
+
+    end=*(entry+1);
+
+    return true;
+  }
+
+  /**
+   * Add the given query result (the offsets of all returned objects)
+   */
+  void AddQuery(const std::vector<osmscout::FileOffset>& objects)
+  {
+    std::set<osmscout::FileOffset> pages;
+    osmscout::FileOffset           bytes=0;
+
+    for (std::vector<osmscout::FileOffset>::const_iterator offset=objects.begin();
+         offset!=objects.end();
+         ++offset) {
+      osmscout::FileOffset end;
+
+      if (!GetExtent(*offset,end)) {
+        std::cerr << "Cannot find object at offset " << *offset << " in '" << name << "'" << std::endl;
+        continue;
+      }
+
+      for (osmscout::FileOffset page=*offset/pageSize;
+           page<=(end-1)/pageSize;
+           page++) {
+        pages.insert(page);
+      }
+
+      bytes+=end-*offset;
+    }
+
+    queryCount++;
+    objectCount+=objects.size();
+    pageCount+=pages.size();
+    minPageCount+=(size_t)((bytes+pageSize-1)/pageSize);
+  }
+
+  void Dump() const
+  {
+    std::cout << name << ": ";
+
+    if (queryCount==0) {
+      std::cout << "no queries" << std::endl;
+      return;
+    }
+
+    std::cout << "objects/query: " << (double)objectCount/queryCount << " ";
+    std::cout << "pages/query: " << (double)pageCount/queryCount << " ";
+    std::cout << "minimum pages/query: " << (double)minPageCount/queryCount << " ";
+
+    if (minPageCount>0) {
+      std::cout << "overhead: " << (double)pageCount/minPageCount;
+    }
+    else {
+      std::cout << "overhead: -";
+    }
+
+    std::cout << std::endl;
+  }
+};
+
+template<class N>
+bool ScanDataFile(const std::string& directory,
+                  const std::string& name,
+                  DataFileLayout& layout)
+{
+  osmscout::FileScanner scanner;
+  uint32_t              dataCount;
+  N                     data;
+
+  layout.name=name;
+
+  if (!scanner.Open(osmscout::AppendFileToDir(directory,name),
+                    osmscout::FileScanner::Sequential,
+                    true)) {
+    std::cerr << "Cannot open '" << scanner.GetFilename() << "'" << std::endl;
+    return false;
+  }
+
+  if (!scanner.Read(dataCount)) {
+    std::cerr << "Error while reading number of data entries in file '" << scanner.GetFilename() << "'" << std::endl;
+    return false;
+  }
+
+  layout.offsets.reserve(dataCount+1);
+
+  for (uint32_t d=1; d<=dataCount; d++) {
+    osmscout::FileOffset offset;
+
+    scanner.GetPos(offset);
+
+    if (!data.Read(scanner)) {
+      std::cerr << "Error while reading data entry " << d << " of " << dataCount << " in file '" << scanner.GetFilename() << "'" << std::endl;
+      return false;
+    }
+
+    layout.offsets.push_back(offset);
+  }
+
+  osmscout::FileOffset end;
+
+  scanner.GetPos(end);
+  layout.offsets.push_back(end);
+
+  return scanner.Close();
+}
+
+int main(int argc, char* argv[])
+{
+  std::string  map;
+  unsigned int gridSize=8;
+
+  double       latTop=0.0,latBottom=0.0,lonLeft=0.0,lonRight=0.0;
+
+  if (argc!=2 && argc!=3 && argc!=7) {
+    std::cerr << "IOLocality <map directory> [<grid size> [<lat_top> <lon_left> <lat_bottom> <lon_right>]]" << std::endl;
+    return 1;
+  }
+
+  map=argv[1];
+
+  if (argc>=3) {
+    if (sscanf(argv[2],"%u",&gridSize)!=1 ||
+        gridSize==0) {
+      std::cerr << "grid size is not numeric!" << std::endl;
+      return 1;
+    }
+  }
+
+  if (argc==7) {
+    if (sscanf(argv[3],"%lf",&latTop)!=1) {
+      std::cerr << "lat_top is not numeric!" << std::endl;
+      return 1;
+    }
+
+    if (sscanf(argv[4],"%lf",&lonLeft)!=1) {
+      std::cerr << "lon_left is not numeric!" << std::endl;
+      return 1;
+    }
+
+    if (sscanf(argv[5],"%lf",&latBottom)!=1) {
+      std::cerr << "lat_bottom is not numeric!" << std::endl;
+      return 1;
+    }
+
+    if (sscanf(argv[6],"%lf",&lonRight)!=1) {
+      std::cerr << "lon_right is not numeric!" << std::endl;
+      return 1;
+    }
+  }
+
+  osmscout::DatabaseParameter databaseParameter;
+  osmscout::Database          database(databaseParameter);
+
+  if (!database.Open(map.c_str())) {
+    std::cerr << "Cannot open database" << std::endl;
+
+    return 1;
+  }
+
+  DataFileLayout nodeLayout;
+  DataFileLayout wayLayout;
+  DataFileLayout areaLayout;
+
+  if (!ScanDataFile<osmscout::Node>(map,"nodes.dat",nodeLayout) ||
+      !ScanDataFile<osmscout::Way>(map,"ways.dat",wayLayout) ||
+      !ScanDataFile<osmscout::Area>(map,"areas.dat",areaLayout)) {
+    return 1;
+  }
+
+  double minLat,minLon,maxLat,maxLon;
+
+  if (argc==7) {
+    minLat=std::min(latTop,latBottom);
+    minLon=std::min(lonLeft,lonRight);
+    maxLat=std::max(latTop,latBottom);
+    maxLon=std::max(lonLeft,lonRight);
+  }
+  else if (!database.GetBoundingBox(minLat,minLon,maxLat,maxLon)) {
+    std::cerr << "Cannot read bounding box of database" << std::endl;
+    return 1;
+  }
+
+  osmscout::TypeConfig* typeConfig=database.GetTypeConfig();
+  osmscout::TypeSet     types(*typeConfig);
+
+  for (osmscout::TypeId type=0; type<=typeConfig->GetMaxTypeId(); type++) {
+    types.SetType(type);
+  }
+
+  double cellWidth=(maxLon-minLon)/gridSize;
+  double cellHeight=(maxLat-minLat)/gridSize;
+
+  std::cout << "Executing " << gridSize*gridSize << " queries of ";
+  std::cout << cellHeight << "x" << cellWidth << " degrees" << std::endl;
+
+  for (size_t y=0; y<gridSize; y++) {
+    for (size_t x=0; x<gridSize; x++) {
+      std::vector<osmscout::NodeRef>    nodes;
+      std::vector<osmscout::WayRef>     ways;
+      std::vector<osmscout::AreaRef>    areas;
+      std::vector<osmscout::FileOffset> offsets;
+
+      if (!database.GetObjects(minLon+x*cellWidth,
+                               minLat+y*cellHeight,
+                               minLon+(x+1)*cellWidth,
+                               minLat+(y+1)*cellHeight,
+                               types,
+                               nodes,
+                               ways,
+                               areas)) {
+        std::cerr << "Cannot load data from database" << std::endl;
+        return 1;
+      }
+
+      offsets.clear();
+      for (std::vector<osmscout::NodeRef>::const_iterator node=nodes.begin();
+           node!=nodes.end();
+           ++node) {
+        offsets.push_back((*node)->GetFileOffset());
+      }
+      nodeLayout.AddQuery(offsets);
+
+      offsets.clear();
+      for (std::vector<osmscout::WayRef>::const_iterator way=ways.begin();
+           way!=ways.end();
+           ++way) {
+        offsets.push_back((*way)->GetFileOffset());
+      }
+      wayLayout.AddQuery(offsets);
+
+      offsets.clear();
+      for (std::vector<osmscout::AreaRef>::const_iterator area=areas.begin();
+           area!=areas.end();
+           ++area) {
+        offsets.push_back((*area)->GetFileOffset());
+      }
+      areaLayout.AddQuery(offsets);
+    }
+  }
+
+  nodeLayout.Dump();
+  wayLayout.Dump();
+  areaLayout.Dump();
+
+  database.Close();
+
+  return 0;
+}
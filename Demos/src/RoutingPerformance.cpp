@@ -0,0 +1,415 @@
+/*
+  RoutingPerformance - a demo program for libosmscout
+  Copyright (C) 2014  Tim Teulings
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <vector>
+
+#include <osmscout/Database.h>
+#include <osmscout/Router.h>
+
+#include <osmscout/util/StopClock.h>
+
+/*
+  Calculates a number of routes between random locations within the given
+  bounding box and prints the time required for the route calculations.
+
+  Start and target locations are resolved to routable nodes before the
+  measurement starts, so only Router::CalculateRoute() is measured.
+
+  Using --ch the contraction hierarchy generated during import (car only,
+  see the import option --routeCH) is used instead of the A* search.
+  Using --bidirectional the bidirectional A* search is used. Together with
+  --ch it is used as fallback, if the contraction hierarchy is not usable.
+  Using --compact the A* search works on the compact route graph, that is
+  loaded into memory once.
+
+  Using --matrix the start and target locations are used as sources and
+  targets of one route matrix (see Router::CalculateMatrix()) instead,
+  calculated by the given number of workers (--workers, default one per
+  hardware thread).
+
+  Example:
+    RoutingPerformance --count 100 ../maps/nordrhein-westfalen 50.6 6.8 51.6 7.8
+*/
+
+struct RouteRequest
+{
+  osmscout::ObjectFileRef startObject;
+  size_t                  startNodeIndex;
+  osmscout::ObjectFileRef targetObject;
+  size_t                  targetNodeIndex;
+};
+
+static void GetCarSpeedTable(std::map<std::string,double>& map)
+{
+  map["highway_motorway"]=110.0;
+  map["highway_motorway_trunk"]=100.0;
+  map["highway_motorway_primary"]=70.0;
+  map["highway_motorway_link"]=60.0;
+  map["highway_motorway_junction"]=60.0;
+  map["highway_trunk"]=100.0;
+  map["highway_trunk_link"]=60.0;
+  map["highway_primary"]=70.0;
+  map["highway_primary_link"]=60.0;
+  map["highway_secondary"]=60.0;
+  map["highway_secondary_link"]=50.0;
+  map["highway_tertiary"]=55.0;
+  map["highway_unclassified"]=50.0;
+  map["highway_road"]=50.0;
+  map["highway_residential"]=40.0;
+  map["highway_roundabout"]=40.0;
+  map["highway_living_street"]=10.0;
+  map["highway_service"]=30.0;
+}
+
+static double GetRandom(double min,
+                        double max)
+{
+  return min+(max-min)*rand()/RAND_MAX;
+}
+
+static bool GetRandomRoutableNode(osmscout::Database& database,
+                                  osmscout::Vehicle vehicle,
+                                  double minLat,
+                                  double minLon,
+                                  double maxLat,
+                                  double maxLon,
+                                  osmscout::ObjectFileRef& object,
+                                  size_t& nodeIndex)
+{
+  // Locations may be far away from any road, try a few times
+  for (size_t i=0; i<100; i++) {
+    if (!database.GetClosestRoutableNode(GetRandom(minLat,maxLat),
+                                         GetRandom(minLon,maxLon),
+                                         vehicle,
+                                         1000,
+                                         object,
+                                         nodeIndex)) {
+      return false;
+    }
+
+    if (object.Valid() &&
+        object.GetType()==osmscout::refWay) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+int main(int argc, char* argv[])
+{
+  osmscout::Vehicle                   vehicle=osmscout::vehicleCar;
+  osmscout::FastestPathRoutingProfile routingProfile;
+  std::string                         map;
+  unsigned long                       count=100;
+  unsigned int                        seed=0;
+  bool                                contractionHierarchy=false;
+  bool                                bidirectional=false;
+  bool                                compact=false;
+  bool                                matrix=false;
+  size_t                              workers=0;
+
+  double                              minLat;
+  double                              minLon;
+  double                              maxLat;
+  double                              maxLon;
+
+  int currentArg=1;
+  while (currentArg<argc) {
+    if (strcmp(argv[currentArg],"--foot")==0) {
+      vehicle=osmscout::vehicleFoot;
+      currentArg++;
+    }
+    else if (strcmp(argv[currentArg],"--bicycle")==0) {
+      vehicle=osmscout::vehicleBicycle;
+      currentArg++;
+    }
+    else if (strcmp(argv[currentArg],"--car")==0) {
+      vehicle=osmscout::vehicleCar;
+      currentArg++;
+    }
+    else if (strcmp(argv[currentArg],"--ch")==0) {
+      contractionHierarchy=true;
+      currentArg++;
+    }
+    else if (strcmp(argv[currentArg],"--bidirectional")==0) {
+      bidirectional=true;
+      currentArg++;
+    }
+    else if (strcmp(argv[currentArg],"--compact")==0) {
+      compact=true;
+      currentArg++;
+    }
+    else if (strcmp(argv[currentArg],"--matrix")==0) {
+      matrix=true;
+      currentArg++;
+    }
+    else if (strcmp(argv[currentArg],"--workers")==0 && currentArg+1<argc) {
+      if (sscanf(argv[currentArg+1],"%zu",&workers)!=1) {
+        std::cerr << "workers is not numeric!" << std::endl;
+        return 1;
+      }
+      currentArg+=2;
+    }
+    else if (strcmp(argv[currentArg],"--count")==0 && currentArg+1<argc) {
+      if (sscanf(argv[currentArg+1],"%lu",&count)!=1) {
+        std::cerr << "count is not numeric!" << std::endl;
+        return 1;
+      }
+      currentArg+=2;
+    }
+    else if (strcmp(argv[currentArg],"--seed")==0 && currentArg+1<argc) {
+      if (sscanf(argv[currentArg+1],"%u",&seed)!=1) {
+        std::cerr << "seed is not numeric!" << std::endl;
+        return 1;
+      }
+      currentArg+=2;
+    }
+    else {
+      // No more "special" arguments
+      break;
+    }
+  }
+
+  if (argc-currentArg!=5) {
+    std::cout << "RoutingPerformance [--foot|--bicycle|--car] [--ch] [--bidirectional]" << std::endl;
+    std::cout << "                   [--compact] [--matrix] [--workers <workers>]" << std::endl;
+    std::cout << "                   [--count <routes>] [--seed <seed>]" << std::endl;
+    std::cout << "                   <map directory>" << std::endl;
+    std::cout << "                   <min lat> <min lon>" << std::endl;
+    std::cout << "                   <max lat> <max lon>" << std::endl;
+    return 1;
+  }
+
+  map=argv[currentArg];
+  currentArg++;
+
+  if (sscanf(argv[currentArg],"%lf",&minLat)!=1) {
+    std::cerr << "lat is not numeric!" << std::endl;
+    return 1;
+  }
+  currentArg++;
+
+  if (sscanf(argv[currentArg],"%lf",&minLon)!=1) {
+    std::cerr << "lon is not numeric!" << std::endl;
+    return 1;
+  }
+  currentArg++;
+
+  if (sscanf(argv[currentArg],"%lf",&maxLat)!=1) {
+    std::cerr << "lat is not numeric!" << std::endl;
+    return 1;
+  }
+  currentArg++;
+
+  if (sscanf(argv[currentArg],"%lf",&maxLon)!=1) {
+    std::cerr << "lon is not numeric!" << std::endl;
+    return 1;
+  }
+  currentArg++;
+
+  osmscout::DatabaseParameter databaseParameter;
+  osmscout::Database          database(databaseParameter);
+
+  if (!database.Open(map.c_str())) {
+    std::cerr << "Cannot open database" << std::endl;
+
+    return 1;
+  }
+
+  osmscout::RouterParameter routerParameter;
+
+  routerParameter.SetContractionHierarchy(contractionHierarchy);
+  routerParameter.SetBidirectional(bidirectional);
+  routerParameter.SetCompactRouteGraph(compact);
+  routerParameter.SetMatrixWorkerCount(workers);
+  osmscout::Router          router(routerParameter,
+                                   vehicle);
+
+  if (!router.Open(map.c_str())) {
+    std::cerr << "Cannot open routing database" << std::endl;
+
+    return 1;
+  }
+
+  osmscout::TypeConfig         *typeConfig=router.GetTypeConfig();
+  std::map<std::string,double> carSpeedTable;
+
+  switch (vehicle) {
+  case osmscout::vehicleFoot:
+    routingProfile.ParametrizeForFoot(*typeConfig,
+                                      5.0);
+    break;
+  case osmscout::vehicleBicycle:
+    routingProfile.ParametrizeForBicycle(*typeConfig,
+                                         20.0);
+    break;
+  case osmscout::vehicleCar:
+    GetCarSpeedTable(carSpeedTable);
+    routingProfile.ParametrizeForCar(*typeConfig,
+                                     carSpeedTable,
+                                     160.0);
+    break;
+  }
+
+  std::cout << "Searching routing nodes for " << count << " routes..." << std::endl;
+
+  std::vector<RouteRequest> requests;
+
+  srand(seed);
+
+  requests.reserve(count);
+
+  for (size_t i=0; i<count; i++) {
+    RouteRequest request;
+
+    if (!GetRandomRoutableNode(database,
+                               vehicle,
+                               minLat,minLon,
+                               maxLat,maxLon,
+                               request.startObject,
+                               request.startNodeIndex) ||
+        !GetRandomRoutableNode(database,
+                               vehicle,
+                               minLat,minLon,
+                               maxLat,maxLon,
+                               request.targetObject,
+                               request.targetNodeIndex)) {
+      std::cerr << "Cannot find routable nodes within the given bounding box!" << std::endl;
+      return 1;
+    }
+
+    requests.push_back(request);
+  }
+
+  if (matrix) {
+    std::vector<osmscout::RoutePosition> sources;
+    std::vector<osmscout::RoutePosition> targets;
+    osmscout::RouteMatrix                routeMatrix;
+    size_t                               reachable=0;
+
+    for (size_t i=0; i<requests.size(); i++) {
+      sources.push_back(osmscout::RoutePosition(requests[i].startObject,
+                                                requests[i].startNodeIndex));
+      targets.push_back(osmscout::RoutePosition(requests[i].targetObject,
+                                                requests[i].targetNodeIndex));
+    }
+
+    std::cout << "Calculating route matrix..." << std::endl;
+
+    osmscout::StopClock matrixClock;
+
+    if (!router.CalculateMatrix(routingProfile,
+                                sources,
+                                targets,
+                                routeMatrix)) {
+      std::cerr << "There was an error while calculating the route matrix!" << std::endl;
+      router.Close();
+      return 1;
+    }
+
+    matrixClock.Stop();
+
+    for (size_t s=0; s<routeMatrix.GetSourceCount(); s++) {
+      for (size_t t=0; t<routeMatrix.GetTargetCount(); t++) {
+        if (routeMatrix.IsReachable(s,t)) {
+          reachable++;
+        }
+      }
+    }
+
+    double matrixTime=matrixClock.GetMilliseconds();
+    size_t entries=sources.size()*targets.size();
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Matrix:              " << sources.size() << "x" << targets.size() << " (" << reachable << " reachable)" << std::endl;
+    std::cout << "Overall time:        " << matrixTime << "ms" << std::endl;
+    std::cout << "Entries per second:  " << entries*1000.0/matrixTime << std::endl;
+
+    router.Close();
+
+    return 0;
+  }
+
+  std::cout << "Calculating routes..." << std::endl;
+
+  osmscout::RouteData data;
+  size_t              routesFound=0;
+  size_t              routeNodesSum=0;
+  double              minTime=0.0;
+  double              maxTime=0.0;
+  osmscout::StopClock overallClock;
+
+  for (size_t i=0; i<requests.size(); i++) {
+    osmscout::StopClock clock;
+
+    if (!router.CalculateRoute(routingProfile,
+                               requests[i].startObject,
+                               requests[i].startNodeIndex,
+                               requests[i].targetObject,
+                               requests[i].targetNodeIndex,
+                               data)) {
+      std::cerr << "There was an error while calculating the route!" << std::endl;
+      router.Close();
+      return 1;
+    }
+
+    clock.Stop();
+
+    double time=clock.GetMilliseconds();
+
+    if (i==0) {
+      minTime=time;
+      maxTime=time;
+    }
+    else {
+      minTime=std::min(minTime,time);
+      maxTime=std::max(maxTime,time);
+    }
+
+    if (!data.IsEmpty()) {
+      routesFound++;
+      routeNodesSum+=data.Entries().size();
+    }
+  }
+
+  overallClock.Stop();
+
+  double overallTime=overallClock.GetMilliseconds();
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "Routes:              " << requests.size() << " (" << routesFound << " found)" << std::endl;
+  std::cout << "Overall time:        " << overallTime << "ms" << std::endl;
+  std::cout << "Time per route:      " << overallTime/requests.size() << "ms (min " << minTime << "ms, max " << maxTime << "ms)" << std::endl;
+  std::cout << "Routes per second:   " << requests.size()*1000.0/overallTime << std::endl;
+  if (routesFound>0) {
+    std::cout << "Avg. route length:   " << routeNodesSum/routesFound << " nodes" << std::endl;
+  }
+
+  router.Close();
+
+  return 0;
+}
@@ -0,0 +1,282 @@
+/*
+  TilerPerformance - a demo program for libosmscout
+  Copyright (C) 2014  Tim Teulings
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+#include <osmscout/Database.h>
+#include <osmscout/MapPainterAgg.h>
+#include <osmscout/StyleConfigLoader.h>
+#include <osmscout/TileRenderer.h>
+
+#include <osmscout/util/StopClock.h>
+
+/*
+  Renders all tiles of the given bounding box and zoom level using the
+  TileRenderer with an increasing number of worker threads and reports
+  the number of tiles rendered per second. Tiles are rendered into memory
+  only.
+
+  If metatiles are used, the areas and ways of a metatile are prepared
+  once for all its tiles, unless 0 is passed as <prepare metatiles>.
+
+  Example for the nordrhein-westfalen.osm (to be executed in the Demos top
+  level directory), drawing the "Ruhrgebiet" with up to 8 workers and
+  metatiles of 4x4 tiles:
+
+  src/TilerPerformance ../maps/nordrhein-westfalen ../stylesheets/standard.oss 51.2 6.5 51.7 8 13 8 4
+*/
+
+static size_t tileWidth=256;
+static size_t tileHeight=256;
+
+class AggTileBackend : public osmscout::TileRenderBackend
+{
+private:
+  unsigned char           *buffer;
+  agg::rendering_buffer   rbuf;
+  osmscout::MapPainterAgg painter;
+
+public:
+  AggTileBackend()
+  : buffer(new unsigned char[tileWidth*tileHeight*3])
+  {
+    rbuf.attach(buffer,
+                tileWidth,tileHeight,
+                tileWidth*3);
+  }
+
+  ~AggTileBackend()
+  {
+    delete [] buffer;
+  }
+
+  osmscout::MapPainter* GetMapPainter()
+  {
+    return &painter;
+  }
+
+  bool DrawTile(const osmscout::StyleConfig& styleConfig,
+                const osmscout::Projection& projection,
+                const osmscout::MapParameter& parameter,
+                const osmscout::MapData& data,
+                const osmscout::MapTile& /*tile*/)
+  {
+    agg::pixfmt_rgb24 pf(rbuf);
+
+    memset(buffer,0,tileWidth*tileHeight*3);
+
+    return painter.DrawMap(styleConfig,
+                           projection,
+                           parameter,
+                           data,
+                           &pf);
+  }
+};
+
+class AggTileBackendFactory : public osmscout::TileRenderBackendFactory
+{
+public:
+  osmscout::TileRenderBackend* CreateBackend(size_t /*worker*/)
+  {
+    return new AggTileBackend();
+  }
+};
+
+int main(int argc, char* argv[])
+{
+  std::string   map;
+  std::string   style;
+  double        latTop,latBottom,lonLeft,lonRight;
+  unsigned long zoom;
+  unsigned long maxWorkers=4;
+  unsigned long metaTileSize=1;
+  unsigned long prepareMetaTiles=1;
+
+  if (argc<8 || argc>11) {
+    std::cerr << "TilerPerformance ";
+    std::cerr << "<map directory> <style-file> ";
+    std::cerr << "<lat_top> <lon_left> <lat_bottom> <lon_right> ";
+    std::cerr << "<zoom> [<max workers> [<metatile size> [<prepare metatiles>]]]" << std::endl;
+    return 1;
+  }
+
+  map=argv[1];
+  style=argv[2];
+
+  if (sscanf(argv[3],"%lf",&latTop)!=1) {
+    std::cerr << "lat_top is not numeric!" << std::endl;
+    return 1;
+  }
+
+  if (sscanf(argv[4],"%lf",&lonLeft)!=1) {
+    std::cerr << "lon_left is not numeric!" << std::endl;
+    return 1;
+  }
+
+  if (sscanf(argv[5],"%lf",&latBottom)!=1) {
+    std::cerr << "lat_bottom is not numeric!" << std::endl;
+    return 1;
+  }
+
+  if (sscanf(argv[6],"%lf",&lonRight)!=1) {
+    std::cerr << "lon_right is not numeric!" << std::endl;
+    return 1;
+  }
+
+  if (sscanf(argv[7],"%lu",&zoom)!=1) {
+    std::cerr << "zoom is not numeric!" << std::endl;
+    return 1;
+  }
+
+  if (argc>=9) {
+    if (sscanf(argv[8],"%lu",&maxWorkers)!=1 ||
+        maxWorkers==0) {
+      std::cerr << "max workers is not numeric!" << std::endl;
+      return 1;
+    }
+  }
+
+  if (argc>=10) {
+    if (sscanf(argv[9],"%lu",&metaTileSize)!=1 ||
+        metaTileSize==0) {
+      std::cerr << "metatile size is not numeric!" << std::endl;
+      return 1;
+    }
+  }
+
+  if (argc>=11) {
+    if (sscanf(argv[10],"%lu",&prepareMetaTiles)!=1) {
+      std::cerr << "prepare metatiles is not numeric!" << std::endl;
+      return 1;
+    }
+  }
+
+  osmscout::DatabaseParameter databaseParameter;
+  osmscout::Database          database(databaseParameter);
+
+  if (!database.Open(map.c_str())) {
+    std::cerr << "Cannot open database" << std::endl;
+
+    return 1;
+  }
+
+  osmscout::StyleConfig styleConfig(database.GetTypeConfig());
+
+  if (!osmscout::LoadStyleConfig(style.c_str(),styleConfig)) {
+    std::cerr << "Cannot open style" << std::endl;
+  }
+
+  osmscout::MapParameter          drawParameter;
+  osmscout::AreaSearchParameter   searchParameter;
+  osmscout::TileRendererParameter rendererParameter;
+  AggTileBackendFactory           factory;
+
+  // Change this, to match your system
+  drawParameter.SetFontName("/usr/share/fonts/TTF/DejaVuSans.ttf");
+  drawParameter.SetFontSize(6.0);
+  // Fadings make problems with tile approach, we disable it
+  drawParameter.SetDrawFadings(false);
+  // To get accurate label drawing at tile borders, we take into account labels
+  // of other than the current tile, too.
+  drawParameter.SetDropNotVisiblePointLabels(false);
+
+  searchParameter.SetUseLowZoomOptimization(false);
+  searchParameter.SetMaximumAreaLevel(3);
+  searchParameter.SetMaximumNodes(std::numeric_limits<unsigned long>::max());
+  searchParameter.SetMaximumWays(std::numeric_limits<unsigned long>::max());
+  searchParameter.SetMaximumAreas(std::numeric_limits<unsigned long>::max());
+
+  rendererParameter.SetMetaTileSize(metaTileSize);
+  rendererParameter.SetTileSize(tileWidth,tileHeight);
+  rendererParameter.SetPrepareMetaTiles(prepareMetaTiles!=0);
+
+  size_t xTileStart=osmscout::MapTile::LonToX(std::min(lonLeft,lonRight),zoom);
+  size_t xTileEnd=osmscout::MapTile::LonToX(std::max(lonLeft,lonRight),zoom);
+  size_t yTileStart=osmscout::MapTile::LatToY(std::max(latTop,latBottom),zoom);
+  size_t yTileEnd=osmscout::MapTile::LatToY(std::min(latTop,latBottom),zoom);
+
+  std::cout << "Drawing zoom " << zoom << ", " << (xTileEnd-xTileStart+1)*(yTileEnd-yTileStart+1) << " tiles [" << xTileStart << "," << yTileStart << " - " <<  xTileEnd << "," << yTileEnd << "]";
+  std::cout << ", metatile size " << metaTileSize;
+
+  if (metaTileSize>1) {
+    std::cout << (prepareMetaTiles!=0 ? ", prepared once" : ", prepared per tile");
+  }
+
+  std::cout << std::endl;
+
+  double singleWorkerTilesPerSecond=0.0;
+
+  // The first round (with one worker) is executed twice, so that all
+  // rounds run with warm caches
+  for (size_t round=0; round<=maxWorkers; round++) {
+    size_t workers=std::max((size_t)1,round);
+
+    rendererParameter.SetWorkerCount(workers);
+
+    osmscout::TileRenderer renderer(database,
+                                    styleConfig,
+                                    drawParameter,
+                                    searchParameter,
+                                    rendererParameter);
+
+    if (!renderer.Start(factory)) {
+      std::cerr << "Cannot start tile renderer" << std::endl;
+      return 1;
+    }
+
+    osmscout::StopClock timer;
+
+    for (size_t y=yTileStart; y<=yTileEnd; y++) {
+      for (size_t x=xTileStart; x<=xTileEnd; x++) {
+        renderer.AddRequest(osmscout::MapTile(zoom,x,y));
+      }
+    }
+
+    renderer.Wait();
+
+    timer.Stop();
+
+    if (round==0) {
+      continue;
+    }
+
+    double tilesPerSecond=renderer.GetTileCount()/(timer.GetMilliseconds()/1000.0);
+
+    if (workers==1) {
+      singleWorkerTilesPerSecond=tilesPerSecond;
+    }
+
+    std::cout << "Workers: " << workers << " ";
+    std::cout << "tiles: " << renderer.GetTileCount() << " ";
+    std::cout << "metatiles: " << renderer.GetMetaTileCount() << " ";
+    std::cout << "errors: " << renderer.GetErrorCount() << " ";
+    std::cout << "time: " << timer.ResultString() << " ";
+    std::cout << "tiles/s: " << tilesPerSecond << " ";
+    std::cout << "speedup: " << tilesPerSecond/singleWorkerTilesPerSecond << std::endl;
+
+    renderer.Stop();
+  }
+
+  database.Close();
+
+  return 0;
+}
@@ -52,6 +52,29 @@ static const char* BoolToString(bool value)
   }
 }
 
+static const char* CoordDataLayoutToString(osmscout::CoordDataFile::Layout layout)
+{
+  if (layout==osmscout::CoordDataFile::layoutDense) {
+    return "dense";
+  }
+  else {
+    return "sparse";
+  }
+}
+
+static const char* SortOrderToString(osmscout::ImportParameter::SortOrder sortOrder)
+{
+  if (sortOrder==osmscout::ImportParameter::sortOrderZOrder) {
+    return "zorder";
+  }
+  else if (sortOrder==osmscout::ImportParameter::sortOrderHilbert) {
+    return "hilbert";
+  }
+  else {
+    return "cell";
+  }
+}
+
 void DumpHelp(osmscout::ImportParameter& parameter)
 {
   std::cout << "Import -h -d -s <start step> -e <end step> [openstreetmapdata.osm|openstreetmapdata.osm.pbf]" << std::endl;
@@ -61,12 +84,14 @@ void DumpHelp(osmscout::ImportParameter& parameter)
   std::cout << " -s <end step>                        set final step" << std::endl;
   std::cout << " --typefile <path>                    path and name of the map.ost file (default: " << parameter.GetTypefile() << ")" << std::endl;
   std::cout << " --destinationDirectory <path>        destination for generated map files (default: " << parameter.GetDestinationDirectory() << ")" << std::endl;
+  std::cout << " --moduleWorkers <number>             number of steps executed in parallel, 0 for one per core (default: " << parameter.GetModuleWorkerCount() << ")" << std::endl;
 
   std::cout << " --strictAreas true|false             assure that areas are simple (default: " << BoolToString(parameter.GetStrictAreas()) << ")" << std::endl;
 
   std::cout << " --numericIndexPageSize <number>      size of an numeric index page in bytes (default: " << parameter.GetNumericIndexPageSize() << ")" << std::endl;
 
   std::cout << " --coordDataMemoryMaped true|false    memory maped coord data file access (default: " << BoolToString(parameter.GetCoordDataMemoryMaped()) << ")" << std::endl;
+  std::cout << " --coordDataLayout dense|sparse       layout of the coord data file, dense for (nearly) complete id ranges (default: " << CoordDataLayoutToString(parameter.GetCoordDataLayout()) << ")" << std::endl;
 
   std::cout << " --rawNodeDataMemoryMaped true|false  memory maped raw node data file access (default: " << BoolToString(parameter.GetRawNodeDataMemoryMaped()) << ")" << std::endl;
   std::cout << " --rawNodeDataCacheSize <number>      raw node data cache size (default: " << parameter.GetRawNodeDataCacheSize() << ")" << std::endl;
@@ -79,6 +104,8 @@ void DumpHelp(osmscout::ImportParameter& parameter)
 
   std::cout << " --noSort                             do not sort objects" << std::endl;
   std::cout << " --sortBlockSize <number>             size of one data block during sorting (default: " << parameter.GetSortBlockSize() << ")" << std::endl;
+  std::cout << " --sortMemoryBudget <number>          maximum bytes of data in one data block during sorting (default: " << parameter.GetSortMemoryBudget() << ")" << std::endl;
+  std::cout << " --sortOrder cell|zorder|hilbert      order of the sorted objects in the data files (default: " << SortOrderToString(parameter.GetSortOrder()) << ")" << std::endl;
 
   std::cout << " --areaDataMemoryMaped true|false     memory maped area data file access (default: " << BoolToString(parameter.GetAreaDataMemoryMaped()) << ")" << std::endl;
   std::cout << " --areaDataCacheSize <number>         area data cache size (default: " << parameter.GetAreaDataCacheSize() << ")" << std::endl;
@@ -87,6 +114,7 @@ void DumpHelp(osmscout::ImportParameter& parameter)
   std::cout << " --wayDataCacheSize <number>          way data cache size (default: " << parameter.GetWayDataCacheSize() << ")" << std::endl;
 
   std::cout << " --routeNodeBlockSize <number>        number of route nodes resolved in block (default: " << BoolToString(parameter.GetRouteNodeBlockSize()) << ")" << std::endl;
+  std::cout << " --routeCH true|false                 generate contraction hierarchy for car routing (default: " << BoolToString(parameter.GetRouteCH()) << ")" << std::endl;
 }
 
 bool ParseBoolArgument(int argc,
@@ -172,14 +200,18 @@ int main(int argc, char* argv[])
 
   size_t                    startStep=parameter.GetStartStep();
   size_t                    endStep=parameter.GetEndStep();
+  size_t                    moduleWorkerCount=parameter.GetModuleWorkerCount();
 
   bool                      strictAreas=parameter.GetStrictAreas();
 
   size_t                    numericIndexPageSize=parameter.GetNumericIndexPageSize();
 
   size_t                    sortBlockSize=parameter.GetSortBlockSize();
+  size_t                    sortMemoryBudget=parameter.GetSortMemoryBudget();
+  std::string               sortOrder=SortOrderToString(parameter.GetSortOrder());
 
   bool                      coordDataMemoryMaped=parameter.GetCoordDataMemoryMaped();
+  std::string               coordDataLayout=CoordDataLayoutToString(parameter.GetCoordDataLayout());
 
   bool                      rawNodeDataMemoryMaped=parameter.GetRawNodeDataMemoryMaped();
   size_t                    rawNodeDataCacheSize=parameter.GetRawNodeDataCacheSize();
@@ -197,6 +229,7 @@ int main(int argc, char* argv[])
   size_t                    wayDataCacheSize=parameter.GetWayDataCacheSize();
 
   size_t                    routeNodeBlockSize=parameter.GetRouteNodeBlockSize();
+  bool                      routeCH=parameter.GetRouteCH();
 
   // Simple way to analyse command line parameters, but enough for now...
   int i=1;
@@ -213,6 +246,12 @@ int main(int argc, char* argv[])
                                          i,
                                          endStep);
     }
+    else if (strcmp(argv[i],"--moduleWorkers")==0) {
+      parameterError=!ParseSizeTArgument(argc,
+                                         argv,
+                                         i,
+                                         moduleWorkerCount);
+    }
     else if (strcmp(argv[i],"-d")==0) {
       progress.SetOutputDebug(true);
 
@@ -258,6 +297,12 @@ int main(int argc, char* argv[])
                                         i,
                                         coordDataMemoryMaped);
     }
+    else if (strcmp(argv[i],"--coordDataLayout")==0) {
+      parameterError=!ParseStringArgument(argc,
+                                          argv,
+                                          i,
+                                          coordDataLayout);
+    }
     else if (strcmp(argv[i],"--rawNodeDataMemoryMaped")==0) {
       parameterError=!ParseBoolArgument(argc,
                                         argv,
@@ -311,6 +356,18 @@ int main(int argc, char* argv[])
                                          i,
                                          sortBlockSize);
     }
+    else if (strcmp(argv[i],"--sortMemoryBudget")==0) {
+      parameterError=!ParseSizeTArgument(argc,
+                                         argv,
+                                         i,
+                                         sortMemoryBudget);
+    }
+    else if (strcmp(argv[i],"--sortOrder")==0) {
+      parameterError=!ParseStringArgument(argc,
+                                          argv,
+                                          i,
+                                          sortOrder);
+    }
     else if (strcmp(argv[i],"--areaDataMemoryMaped")==0) {
       parameterError=!ParseBoolArgument(argc,
                                         argv,
@@ -341,6 +398,12 @@ int main(int argc, char* argv[])
                                          i,
                                          routeNodeBlockSize);
     }
+    else if (strcmp(argv[i],"--routeCH")==0) {
+      parameterError=!ParseBoolArgument(argc,
+                                        argv,
+                                        i,
+                                        routeCH);
+    }
     else if (mapfile.empty()) {
       mapfile=argv[i];
 
@@ -368,15 +431,42 @@ int main(int argc, char* argv[])
   parameter.SetTypefile(typefile);
   parameter.SetDestinationDirectory(destinationDirectory);
   parameter.SetSteps(startStep,endStep);
+  parameter.SetModuleWorkerCount(moduleWorkerCount);
 
   parameter.SetStrictAreas(strictAreas);
 
   parameter.SetNumericIndexPageSize(numericIndexPageSize);
 
   parameter.SetSortBlockSize(sortBlockSize);
+  parameter.SetSortMemoryBudget(sortMemoryBudget);
+
+  if (sortOrder=="cell") {
+    parameter.SetSortOrder(osmscout::ImportParameter::sortOrderCell);
+  }
+  else if (sortOrder=="zorder") {
+    parameter.SetSortOrder(osmscout::ImportParameter::sortOrderZOrder);
+  }
+  else if (sortOrder=="hilbert") {
+    parameter.SetSortOrder(osmscout::ImportParameter::sortOrderHilbert);
+  }
+  else {
+    std::cerr << "Unknown sort order '" << sortOrder << "'" << std::endl;
+    return 1;
+  }
 
   parameter.SetCoordDataMemoryMaped(coordDataMemoryMaped);
 
+  if (coordDataLayout=="dense") {
+    parameter.SetCoordDataLayout(osmscout::CoordDataFile::layoutDense);
+  }
+  else if (coordDataLayout=="sparse") {
+    parameter.SetCoordDataLayout(osmscout::CoordDataFile::layoutSparse);
+  }
+  else {
+    std::cerr << "Unknown coord data layout '" << coordDataLayout << "'" << std::endl;
+    return 1;
+  }
+
   parameter.SetRawNodeDataMemoryMaped(rawNodeDataMemoryMaped);
   parameter.SetRawNodeDataCacheSize(rawNodeDataCacheSize);
 
@@ -393,6 +483,7 @@ int main(int argc, char* argv[])
   parameter.SetWayDataCacheSize(wayDataCacheSize);
 
   parameter.SetRouteNodeBlockSize(routeNodeBlockSize);
+  parameter.SetRouteCH(routeCH);
 
   parameter.SetOptimizationWayMethod(osmscout::TransPolygon::quality);
 
@@ -404,6 +495,8 @@ int main(int argc, char* argv[])
                 osmscout::NumberToString(parameter.GetStartStep())+
                 " - "+
                 osmscout::NumberToString(parameter.GetEndStep()));
+  progress.Info(std::string("ModuleWorkers: ")+
+                osmscout::NumberToString(parameter.GetModuleWorkerCount()));
 
   progress.Info(std::string("StrictAreas: ")+
                 (parameter.GetStrictAreas() ? "true" : "false"));
@@ -413,6 +506,8 @@ int main(int argc, char* argv[])
 
   progress.Info(std::string("CoordDataMemoryMaped: ")+
                 (parameter.GetCoordDataMemoryMaped() ? "true" : "false"));
+  progress.Info(std::string("CoordDataLayout: ")+
+                CoordDataLayoutToString(parameter.GetCoordDataLayout()));
 
   progress.Info(std::string("RawNodeDataMemoryMaped: ")+
                 (parameter.GetRawNodeDataMemoryMaped() ? "true" : "false"));
@@ -435,6 +530,10 @@ int main(int argc, char* argv[])
                 (parameter.GetSortObjects() ? "true" : "false"));
   progress.Info(std::string("SortBlockSize: ")+
                 osmscout::NumberToString(parameter.GetSortBlockSize()));
+  progress.Info(std::string("SortMemoryBudget: ")+
+                osmscout::NumberToString(parameter.GetSortMemoryBudget()));
+  progress.Info(std::string("SortOrder: ")+
+                SortOrderToString(parameter.GetSortOrder()));
 
   progress.Info(std::string("AreaDataMemoryMaped: ")+
                 (parameter.GetAreaDataMemoryMaped() ? "true" : "false"));
@@ -448,6 +547,8 @@ int main(int argc, char* argv[])
 
   progress.Info(std::string("RouteNodeBlockSize: ")+
                 osmscout::NumberToString(parameter.GetRouteNodeBlockSize()));
+  progress.Info(std::string("RouteCH: ")+
+                (parameter.GetRouteCH() ? "true" : "false"));
 
   if (osmscout::Import(parameter,progress)) {
     std::cout << "Import OK!" << std::endl;
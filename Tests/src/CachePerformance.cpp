@@ -21,6 +21,12 @@
 #include <iostream>
 #include <vector>
 
+#include <osmscout/CoreFeatures.h>
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+#include <thread>
+#endif
+
 #include <osmscout/util/Cache.h>
 #include <osmscout/util/FileScanner.h>
 #include <osmscout/util/Reference.h>
@@ -31,6 +37,7 @@
   * cache insertion
   * cache hit
   * cache miss
+  * concurrent access to a sharded cache by a growing number of threads
 */
 
 /**
@@ -54,6 +61,7 @@ public:
 
 private:
   Data2(Data2& other)
+  : Referencable(other)
   {
   }
 
@@ -278,10 +286,104 @@ void TestData2()
   std::cout << "Copy time: "  << copyTimer << std::endl;
 }
 
+#if defined(OSMSCOUT_HAVE_THREAD)
+struct Data3 : public osmscout::Referencable
+{
+  size_t              value;
+  std::vector<size_t> value2;
+};
+
+typedef osmscout::Ref<Data3>                          Data3Ref;
+typedef osmscout::ShardedCache<osmscout::Id,Data3Ref> Data3Cache;
+
+static const size_t shardedCacheSize=200000;
+static const size_t shardedAccessCount=4000000;
+
+/**
+  Simulates a render thread: mostly cache hits on objects already loaded,
+  every 16th access is a miss that loads and inserts a new object.
+  */
+void AccessShardedCache(Data3Cache* cache,
+                        size_t threadIndex,
+                        size_t accessCount)
+{
+  size_t key=threadIndex*7919;
+
+  for (size_t i=0; i<accessCount; i++) {
+    Data3Ref value;
+
+    key=(key*1103515245+12345) % (shardedCacheSize+shardedCacheSize/16);
+
+    if (!cache->GetValue(key,value)) {
+      value=new Data3();
+      value->value=key;
+
+      cache->SetValue(key,value);
+    }
+
+    assert(value->value==key);
+  }
+}
+
+void TestShardedCache(size_t shardCount)
+{
+  std::cout << "*** Concurrent access to cache with " << shardCount << " shard(s) ***" << std::endl;
+
+  double singleThreadTime=0.0;
+
+  for (size_t threadCount=1; threadCount<=16; threadCount*=2) {
+    Data3Cache cache(shardedCacheSize,shardCount);
+
+    for (size_t i=0; i<shardedCacheSize; i++) {
+      Data3Ref value=new Data3();
+
+      value->value=i;
+
+      cache.SetValue(i,value);
+    }
+
+    std::vector<std::thread> threads;
+    osmscout::StopClock      accessTimer;
+
+    for (size_t t=0; t<threadCount; t++) {
+      threads.push_back(std::thread(AccessShardedCache,
+                                    &cache,
+                                    t,
+                                    shardedAccessCount/threadCount));
+    }
+
+    for (size_t t=0; t<threads.size(); t++) {
+      threads[t].join();
+    }
+
+    accessTimer.Stop();
+
+    double time=accessTimer.GetMilliseconds();
+
+    if (threadCount==1) {
+      singleThreadTime=time;
+    }
+
+    std::cout << threadCount << " thread(s): " << accessTimer;
+
+    if (time>0.0) {
+      std::cout << ", " << (size_t)(shardedAccessCount/time) << " accesses/ms";
+      std::cout << ", speedup " << singleThreadTime/time;
+    }
+
+    std::cout << std::endl;
+  }
+}
+#endif
+
 int main(int argc, char* argv[])
 {
   TestData();
   TestData2();
+#if defined(OSMSCOUT_HAVE_THREAD)
+  TestShardedCache(1);
+  TestShardedCache(64);
+#endif
 
   return 0;
 }
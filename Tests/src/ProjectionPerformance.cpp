@@ -0,0 +1,146 @@
+/*
+  ProjectionPerformance - a test program for libosmscout
+  Copyright (C) 2014  Tim Teulings
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <osmscout/GeoCoord.h>
+#include <osmscout/Pixel.h>
+
+#include <osmscout/util/Projection.h>
+#include <osmscout/util/StopClock.h>
+
+/**
+  Generate a number of random coordinates around the center of the projection
+  and compare the time for transforming them to pixel coordinates calling
+  GeoToPixel() for each coordinate, using a BatchTransformer and using the
+  bulk GeoToPixel() for coordinate arrays for a low and a high magnification.
+  The maximum difference of the bulk result to the single coordinate result
+  is printed, too.
+*/
+
+#define COORD_COUNT 1000000
+#define ROUNDS      10
+
+static void Measure(const osmscout::Projection& projection,
+                    const std::vector<osmscout::GeoCoord>& coords)
+{
+  std::vector<osmscout::Vertex2D> singlePixels(coords.size());
+  std::vector<osmscout::Vertex2D> batchPixels(coords.size());
+  std::vector<osmscout::Vertex2D> bulkPixels(coords.size());
+
+  osmscout::StopClock singleTimer;
+
+  for (size_t r=0; r<ROUNDS; r++) {
+    for (size_t i=0; i<coords.size(); i++) {
+      double x,y;
+
+      projection.GeoToPixel(coords[i].GetLon(),
+                            coords[i].GetLat(),
+                            x,y);
+
+      singlePixels[i].Set(x,y);
+    }
+  }
+
+  singleTimer.Stop();
+
+  std::vector<double> x(coords.size());
+  std::vector<double> y(coords.size());
+
+  osmscout::StopClock batchTimer;
+
+  for (size_t r=0; r<ROUNDS; r++) {
+    osmscout::Projection::BatchTransformer batchTransformer(projection);
+
+    for (size_t i=0; i<coords.size(); i++) {
+      batchTransformer.GeoToPixel(coords[i].GetLon(),
+                                  coords[i].GetLat(),
+                                  x[i],
+                                  y[i]);
+    }
+  }
+
+  batchTimer.Stop();
+
+  for (size_t i=0; i<coords.size(); i++) {
+    batchPixels[i].Set(x[i],y[i]);
+  }
+
+  osmscout::StopClock bulkTimer;
+
+  for (size_t r=0; r<ROUNDS; r++) {
+    projection.GeoToPixel(&coords[0],
+                          coords.size(),
+                          &bulkPixels[0]);
+  }
+
+  bulkTimer.Stop();
+
+  double maxBatchError=0.0;
+  double maxBulkError=0.0;
+
+  for (size_t i=0; i<coords.size(); i++) {
+    maxBatchError=std::max(maxBatchError,std::fabs(batchPixels[i].GetX()-singlePixels[i].GetX()));
+    maxBatchError=std::max(maxBatchError,std::fabs(batchPixels[i].GetY()-singlePixels[i].GetY()));
+    maxBulkError=std::max(maxBulkError,std::fabs(bulkPixels[i].GetX()-singlePixels[i].GetX()));
+    maxBulkError=std::max(maxBulkError,std::fabs(bulkPixels[i].GetY()-singlePixels[i].GetY()));
+  }
+
+  std::cout << "Magnification " << projection.GetMagnification().GetLevel() << ":" << std::endl;
+  std::cout << "Transforming " << ROUNDS << "x" << coords.size() << " coordinates one by one took " << singleTimer << std::endl;
+  std::cout << "Transforming " << ROUNDS << "x" << coords.size() << " coordinates using BatchTransformer took " << batchTimer << " (max. difference " << maxBatchError << " pixel)" << std::endl;
+  std::cout << "Transforming " << ROUNDS << "x" << coords.size() << " coordinates in bulk took " << bulkTimer << " (max. difference " << maxBulkError << " pixel)" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  size_t levels[]={8,16};
+
+  for (size_t l=0; l<sizeof(levels)/sizeof(levels[0]); l++) {
+    osmscout::MercatorProjection projection;
+    osmscout::Magnification      magnification;
+
+    magnification.SetLevel(levels[l]);
+
+    projection.Set(7.465,51.514,
+                   magnification,
+                   1024,768);
+
+    double latSpan=projection.GetLatMax()-projection.GetLatMin();
+    double lonSpan=projection.GetLonMax()-projection.GetLonMin();
+
+    std::vector<osmscout::GeoCoord> coords;
+
+    coords.resize(COORD_COUNT);
+
+    // Coordinates of the visible region and the region around it
+    for (size_t i=0; i<coords.size(); i++) {
+      coords[i].Set(projection.GetLat()+latSpan*(2.0*rand()/RAND_MAX-1.0),
+                    projection.GetLon()+lonSpan*(2.0*rand()/RAND_MAX-1.0));
+    }
+
+    Measure(projection,
+            coords);
+  }
+
+  return 0;
+}
@@ -53,6 +53,10 @@ namespace osmscout {
 
   public:
     std::string GetDescription() const;
+    void GetInputFiles(const ImportParameter& parameter,
+                       std::list<std::string>& files) const;
+    void GetOutputFiles(const ImportParameter& parameter,
+                        std::list<std::string>& files) const;
     bool Import(const ImportParameter& parameter,
                 Progress& progress,
                 const TypeConfig& typeConfig);
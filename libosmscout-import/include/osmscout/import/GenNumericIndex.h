@@ -20,6 +20,7 @@
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
 */
 
+#include <list>
 #include <vector>
 
 
@@ -49,6 +50,10 @@ namespace osmscout {
     virtual ~NumericIndexGenerator();
 
     std::string GetDescription() const;
+    void GetInputFiles(const ImportParameter& parameter,
+                       std::list<std::string>& files) const;
+    void GetOutputFiles(const ImportParameter& parameter,
+                        std::list<std::string>& files) const;
     bool Import(const ImportParameter& parameter,
                 Progress& progress,
                 const TypeConfig& typeConfig);
@@ -77,6 +82,20 @@ namespace osmscout {
     return description;
   }
 
+  template <class N,class T>
+  void NumericIndexGenerator<N,T>::GetInputFiles(const ImportParameter& /*parameter*/,
+                                                 std::list<std::string>& files) const
+  {
+    files.push_back(datafile);
+  }
+
+  template <class N,class T>
+  void NumericIndexGenerator<N,T>::GetOutputFiles(const ImportParameter& /*parameter*/,
+                                                  std::list<std::string>& files) const
+  {
+    files.push_back(indexfile);
+  }
+
   template <class N,class T>
   bool NumericIndexGenerator<N,T>::Import(const ImportParameter& parameter,
                                           Progress& progress,
@@ -0,0 +1,122 @@
+#ifndef OSMSCOUT_IMPORT_GENROUTECHDAT_H
+#define OSMSCOUT_IMPORT_GENROUTECHDAT_H
+
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2014  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <map>
+#include <vector>
+
+#include <osmscout/ContractionHierarchy.h>
+#include <osmscout/RoutingProfile.h>
+
+#include <osmscout/util/IndexedHeap.h>
+
+#include <osmscout/import/Import.h>
+
+namespace osmscout {
+
+  /**
+   * Generates a contraction hierarchy (see ContractionHierarchy) for the car
+   * routing graph, using a fastest path profile parametrized by the speed table
+   * of the ImportParameter.
+   *
+   * Routes calculated using the hierarchy are only correct for this profile.
+   */
+  class RouteCHDataGenerator : public ImportModule
+  {
+  private:
+    typedef ContractionHierarchy::Edge Edge;
+    typedef std::vector<Edge>          EdgeList;
+
+    /**
+     * The graph during contraction. For each node not yet contracted the edges
+     * to and from other nodes not yet contracted. For contracted nodes the
+     * final edges upwards the hierarchy.
+     */
+    struct Graph
+    {
+      std::vector<EdgeList>  outEdges;             //! Edges leaving the node (Edge::node is the target)
+      std::vector<EdgeList>  inEdges;              //! Edges arriving at the node (Edge::node is the source)
+      std::vector<EdgeList>  upEdges;              //! Edges of contracted nodes
+      std::vector<bool>      core;                 //! Node must not be contracted
+      std::vector<bool>      contracted;           //! Node is already contracted
+      std::vector<uint32_t>  contractedNeighbours; //! Number of contracted neighbours
+
+      // Witness search state
+      std::vector<double>    witnessCosts;         //! Costs of the current witness search or -1
+      std::vector<uint32_t>  witnessTouched;       //! Nodes with witnessCosts set
+      IndexedHeap<double>    witnessHeap;          //! Open list of the witness search
+    };
+
+    struct Shortcut
+    {
+      uint32_t source;
+      uint32_t target;
+      Edge     edge;
+    };
+
+  private:
+    bool ReadRouteGraph(const ImportParameter& parameter,
+                        Progress& progress,
+                        const RoutingProfile& profile,
+                        std::vector<FileOffset>& offsets,
+                        std::map<uint32_t,ContractionHierarchy::CoreNode>& coreNodes,
+                        Graph& graph);
+
+    void AddEdge(Graph& graph,
+                 uint32_t source,
+                 uint32_t target,
+                 const Edge& edge);
+    void RemoveEdges(EdgeList& edges,
+                     uint32_t node);
+
+    void SearchWitnesses(Graph& graph,
+                         uint32_t source,
+                         uint32_t excluded,
+                         double maxCosts);
+    void ClearWitnesses(Graph& graph);
+
+    size_t GetShortcuts(Graph& graph,
+                        uint32_t node,
+                        std::vector<Shortcut>* shortcuts);
+    int GetPriority(Graph& graph,
+                    uint32_t node);
+    void ContractNode(Graph& graph,
+                      uint32_t node,
+                      std::vector<Shortcut>& shortcuts,
+                      std::vector<uint32_t>& neighbours);
+
+    bool ContractGraph(Progress& progress,
+                       Graph& graph);
+
+  public:
+    RouteCHDataGenerator();
+    std::string GetDescription() const;
+    void GetInputFiles(const ImportParameter& parameter,
+                       std::list<std::string>& files) const;
+    void GetOutputFiles(const ImportParameter& parameter,
+                        std::list<std::string>& files) const;
+    bool Import(const ImportParameter& parameter,
+                Progress& progress,
+                const TypeConfig& typeConfig);
+  };
+}
+
+#endif
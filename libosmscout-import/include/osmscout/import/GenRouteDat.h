@@ -21,6 +21,7 @@
 */
 
 #include <osmscout/NumericIndex.h>
+#include <osmscout/ReverseRouteNode.h>
 #include <osmscout/RouteNode.h>
 #include <osmscout/TurnRestriction.h>
 #include <osmscout/Types.h>
@@ -204,11 +205,36 @@ namespace osmscout {
                          const NodeIdObjectsMap& nodeObjectsMap,
                          const ViaTurnRestrictionMap& restrictions,
                          Vehicle vehicle,
-                         const std::string& filename);
+                         const std::string& filename,
+                         std::vector<GeoCoord>& routeNodeCoords);
+
+    /**
+     * Writes the reverse routing graph (see ReverseRouteNode) for the given
+     * route graph file.
+     */
+    bool WriteReverseRouteGraph(const ImportParameter& parameter,
+                                Progress& progress,
+                                const std::vector<GeoCoord>& routeNodeCoords,
+                                const std::string& routeFilename,
+                                const std::string& reverseFilename);
+
+    /**
+     * Writes the compact route graph (see RouteGraph) for the given
+     * route graph file.
+     */
+    bool WriteCompactRouteGraph(const ImportParameter& parameter,
+                                Progress& progress,
+                                const std::vector<GeoCoord>& routeNodeCoords,
+                                const std::string& routeFilename,
+                                const std::string& graphFilename);
 
   public:
     RouteDataGenerator();
     std::string GetDescription() const;
+    void GetInputFiles(const ImportParameter& parameter,
+                       std::list<std::string>& files) const;
+    void GetOutputFiles(const ImportParameter& parameter,
+                        std::list<std::string>& files) const;
     bool Import(const ImportParameter& parameter,
                 Progress& progress,
                 const TypeConfig& typeConfig);
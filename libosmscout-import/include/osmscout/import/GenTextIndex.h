@@ -35,6 +35,10 @@ namespace osmscout
     TextIndexGenerator();
 
     std::string GetDescription() const;
+    void GetInputFiles(const ImportParameter& parameter,
+                       std::list<std::string>& files) const;
+    void GetOutputFiles(const ImportParameter& parameter,
+                        std::list<std::string>& files) const;
 
     bool Import(const ImportParameter &parameter,
                 Progress &progress,
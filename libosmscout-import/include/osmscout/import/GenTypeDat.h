@@ -28,6 +28,8 @@ namespace osmscout {
   {
   public:
     std::string GetDescription() const;
+    void GetOutputFiles(const ImportParameter& parameter,
+                        std::list<std::string>& files) const;
     bool Import(const ImportParameter& parameter,
                 Progress& progress,
                 const TypeConfig& typeConfig);
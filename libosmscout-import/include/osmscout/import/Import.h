@@ -20,12 +20,15 @@
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
 */
 
+#include <list>
+#include <map>
 #include <string>
 
 #include <osmscout/ImportFeatures.h>
 
 #include <osmscout/private/ImportImportExport.h>
 
+#include <osmscout/CoordDataFile.h>
 #include <osmscout/TypeConfig.h>
 
 #include <osmscout/util/Progress.h>
@@ -43,22 +46,36 @@ namespace osmscout {
     */
   class OSMSCOUT_IMPORT_API ImportParameter
   {
+  public:
+    /**
+     * Order of the objects in the sorted data files
+     */
+    enum SortOrder {
+      sortOrderCell    = 0, //! By cell, within a cell by coordinate
+      sortOrderZOrder  = 1, //! Along a Z-order (Morton) curve over the cells
+      sortOrderHilbert = 2  //! Along a Hilbert curve over the cells
+    };
+
   private:
     std::string                  mapfile;                  //! Name of the file containing the map (either *.osm or *.osm.pbf)
     std::string                  typefile;                 //! Name and path ff type definition file (map.ost.xml)
     std::string                  destinationDirectory;     //! Name of the destination directory
     size_t                       startStep;                //! Starting step for import
     size_t                       endStep;                  //! End step for import
+    size_t                       moduleWorkerCount;        //! Maximum number of import steps executed in parallel (0: number of cores)
 
     bool                         strictAreas;              //! Assure that areas conform to "simple" definition
 
     bool                         sortObjects;              //! Sort all objects
     size_t                       sortBlockSize;            //! Number of entries loaded in one sort iteration
+    size_t                       sortMemoryBudget;         //! Maximum number of bytes of data loaded in one sort iteration
     size_t                       sortTileMag;              //! Zoom level for individual sorting cells
+    SortOrder                    sortOrder;                //! Order of the objects in the sorted data files
 
     size_t                       numericIndexPageSize;     //! Size of an numeric index page in bytes
 
     bool                         coordDataMemoryMaped;     //! Use memory mapping for coord data file access
+    CoordDataFile::Layout        coordDataLayout;          //! Layout of the coord data file (dense or sparse array)
 
     bool                         rawNodeDataMemoryMaped;   //! Use memory mapping for raw node data file access
     size_t                       rawNodeDataCacheSize;     //! Size of the raw node data cache
@@ -99,6 +116,10 @@ namespace osmscout {
 
     size_t                       routeNodeBlockSize;       //! Number of route nodes loaded during import until ways get resolved
 
+    bool                         routeCH;                  //! Generate a contraction hierarchy for car routing
+    std::map<std::string,double> routeCHCarSpeedTable;     //! Speed for each way type used for the contraction hierarchy
+    double                       routeCHCarMaxSpeed;       //! Maximum speed of the car used for the contraction hierarchy
+
     bool                         assumeLand;               //! During sea/land detection,we either trust coastlines only or make some
                                                            //! assumptions which tiles are sea and which are land.
 
@@ -111,16 +132,20 @@ namespace osmscout {
 
     size_t GetStartStep() const;
     size_t GetEndStep() const;
+    size_t GetModuleWorkerCount() const;
 
     bool GetStrictAreas() const;
 
     bool GetSortObjects() const;
     size_t GetSortBlockSize() const;
+    size_t GetSortMemoryBudget() const;
     size_t GetSortTileMag() const;
+    SortOrder GetSortOrder() const;
 
     size_t GetNumericIndexPageSize() const;
 
     bool GetCoordDataMemoryMaped() const;
+    CoordDataFile::Layout GetCoordDataLayout() const;
 
     bool GetRawNodeDataMemoryMaped() const;
     size_t GetRawNodeDataCacheSize() const;
@@ -161,6 +186,10 @@ namespace osmscout {
 
     size_t GetRouteNodeBlockSize() const;
 
+    bool GetRouteCH() const;
+    const std::map<std::string,double>& GetRouteCHCarSpeedTable() const;
+    double GetRouteCHCarMaxSpeed() const;
+
     bool GetAssumeLand() const;
 
     void SetMapfile(const std::string& mapfile);
@@ -169,16 +198,20 @@ namespace osmscout {
 
     void SetStartStep(size_t startStep);
     void SetSteps(size_t startStep, size_t endStep);
+    void SetModuleWorkerCount(size_t moduleWorkerCount);
 
     void SetStrictAreas(bool strictAreas);
 
     void SetSortObjects(bool sortObjects);
     void SetSortBlockSize(size_t sortBlockSize);
+    void SetSortMemoryBudget(size_t sortMemoryBudget);
     void SetSortTileMag(size_t sortTileMag);
+    void SetSortOrder(SortOrder sortOrder);
 
     void SetNumericIndexPageSize(size_t numericIndexPageSize);
 
     void SetCoordDataMemoryMaped(bool memoryMaped);
+    void SetCoordDataLayout(CoordDataFile::Layout layout);
 
     void SetRawNodeDataMemoryMaped(bool memoryMaped);
     void SetRawNodeDataCacheSize(size_t nodeDataCacheSize);
@@ -219,6 +252,10 @@ namespace osmscout {
 
     void SetRouteNodeBlockSize(size_t blockSize);
 
+    void SetRouteCH(bool routeCH);
+    void SetRouteCHCarSpeedTable(const std::map<std::string,double>& speedTable);
+    void SetRouteCHCarMaxSpeed(double maxSpeed);
+
     void SetAssumeLand(bool assumeLand);
   };
 
@@ -228,12 +265,22 @@ namespace osmscout {
     An import consists of a number of sequentially executed steps. A step normally
     works on one object type and generates one output file (though this is just
     an suggestion). Such a step is realized by a ImportModule.
+
+    A module declares the files it reads and the files it writes. Steps that do
+    not depend on each other (directly or indirectly) via these files may be
+    executed in parallel (see ImportParameter::SetModuleWorkerCount()). A module
+    that does not declare any output file is never executed in parallel to other
+    modules.
     */
   class OSMSCOUT_IMPORT_API ImportModule
   {
   public:
     virtual ~ImportModule();
     virtual std::string GetDescription() const = 0;
+    virtual void GetInputFiles(const ImportParameter& parameter,
+                               std::list<std::string>& files) const;
+    virtual void GetOutputFiles(const ImportParameter& parameter,
+                                std::list<std::string>& files) const;
     virtual bool Import(const ImportParameter& parameter,
                         Progress& progress,
                         const TypeConfig& typeConfig) = 0;
@@ -20,57 +20,58 @@
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
 */
 
+#include <osmscout/CoordDataFile.h>
+
 #include <osmscout/import/Import.h>
 #include <osmscout/import/RawRelation.h>
 
-#include <osmscout/util/HashMap.h>
 #include <osmscout/util/FileWriter.h>
 
 namespace osmscout {
   class Preprocess : public ImportModule
   {
   private:
-    typedef OSMSCOUT_HASHMAP<PageId,FileOffset> CoordPageOffsetMap;
-
-  private:
-    FileWriter          nodeWriter;
-    FileWriter          wayWriter;
-    FileWriter          relationWriter;
-    FileWriter          coastlineWriter;
-
-    std::vector<Tag>    tags;
-
-    uint32_t            nodeCount;
-    uint32_t            wayCount;
-    uint32_t            areaCount;
-    uint32_t            relationCount;
-    uint32_t            coastlineCount;
-
-    OSMId               lastNodeId;
-    OSMId               lastWayId;
-    OSMId               lastRelationId;
-
-    bool                nodeSortingError;
-    bool                waySortingError;
-    bool                relationSortingError;
-
-    Id                  coordPageCount;
-    CoordPageOffsetMap  coordIndex;
-    FileWriter          coordWriter;
-    PageId              currentPageId;
-    FileOffset          currentPageOffset;
-    std::vector<double> lats;
-    std::vector<double> lons;
-    std::vector<bool>   isSet;
+    FileWriter            nodeWriter;
+    FileWriter            wayWriter;
+    FileWriter            relationWriter;
+    FileWriter            coastlineWriter;
+
+    std::vector<Tag>      tags;
+    InternedTagList       internedTags;
+
+    uint32_t              nodeCount;
+    uint32_t              wayCount;
+    uint32_t              areaCount;
+    uint32_t              relationCount;
+    uint32_t              coastlineCount;
+
+    OSMId                 lastNodeId;
+    OSMId                 lastWayId;
+    OSMId                 lastRelationId;
+
+    bool                  nodeSortingError;
+    bool                  waySortingError;
+    bool                  relationSortingError;
+    bool                  nodeDuplicateError;
+
+    CoordDataFile::Layout coordLayout;
+    FileWriter            coordWriter;
+    Id                    coordCount;
+    OSMId                 coordMinId;
+    OSMId                 lastCoordId;
+    std::vector<OSMId>    coordBlockIds;
 
   private:
-    bool StoreCurrentPage();
     bool StoreCoord(OSMId id,
                     double lat,
                     double lon);
 
   public:
     std::string GetDescription() const;
+    void GetInputFiles(const ImportParameter& parameter,
+                       std::list<std::string>& files) const;
+    void GetOutputFiles(const ImportParameter& parameter,
+                        std::list<std::string>& files) const;
     bool Import(const ImportParameter& parameter,
                 Progress& progress,
                 const TypeConfig& typeConfig);
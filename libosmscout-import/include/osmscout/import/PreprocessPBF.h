@@ -37,27 +37,83 @@ namespace osmscout {
 
   class PreprocessPBF : public Preprocess
   {
+  private:
+    enum ObjectType
+    {
+      objectNode,
+      objectWay,
+      objectRelation
+    };
+
+    /**
+      An object of a primitive block, with its tags, node ids and members
+      already decoded into the arrays of the Batch.
+      */
+    struct Object
+    {
+      ObjectType type;
+      OSMId      id;
+      double     lon;       //! Longitude (nodes only)
+      double     lat;       //! Latitude (nodes only)
+      size_t     tagCount;  //! Number of tags of the object
+      size_t     refCount;  //! Number of nodes (ways) or members (relations)
+    };
+
+    /**
+      The data of one block of the PBF file. The raw blob is read by the
+      reading thread, a worker decodes it into objects and the objects are
+      then processed in file order.
+
+      All arrays are only cleared, not freed, between two blocks, so they grow
+      to the size of the largest block and are reused afterwards.
+      */
+    struct Batch
+    {
+      std::vector<char>                blob;      //! The blob as read from the file
+      std::string                      data;      //! The uncompressed data of the blob
+      std::vector<Object>              objects;   //! All objects of the block in file order
+      std::vector<TagId>               tagIds;    //! Tag ids of the tags of all objects
+      std::vector<std::string>         tagValues; //! Values of the tags of all objects
+      std::vector<OSMId>               nodes;     //! Nodes of all ways
+      std::vector<RawRelation::Member> members;   //! Members of all relations
+      bool                             success;   //! Block was successfully decoded
+      std::string                      error;     //! Description of the error otherwise
+    };
+
+    class DecodeJob;
+
   private:
     std::map<TagId,std::string>      tagMap;
     std::vector<OSMId>               nodes;
     std::vector<RawRelation::Member> members;
 
   private:
-    void ReadNodes(const TypeConfig& typeConfig,
-                   const PBF::PrimitiveBlock& block,
-                   const PBF::PrimitiveGroup &group);
-
-    void ReadDenseNodes(const TypeConfig& typeConfig,
-                        const PBF::PrimitiveBlock& block,
-                        const PBF::PrimitiveGroup &group);
-
-    void ReadWays(const TypeConfig& typeConfig,
-                  const PBF::PrimitiveBlock& block,
-                  const PBF::PrimitiveGroup &group);
-
-    void ReadRelations(const TypeConfig& typeConfig,
-                       const PBF::PrimitiveBlock& block,
-                       const PBF::PrimitiveGroup &group);
+    static void DecodeNodes(const TypeConfig& typeConfig,
+                            const PBF::PrimitiveBlock& block,
+                            const PBF::PrimitiveGroup &group,
+                            Batch& batch);
+
+    static void DecodeDenseNodes(const TypeConfig& typeConfig,
+                                 const PBF::PrimitiveBlock& block,
+                                 const PBF::PrimitiveGroup &group,
+                                 Batch& batch);
+
+    static void DecodeWays(const TypeConfig& typeConfig,
+                           const PBF::PrimitiveBlock& block,
+                           const PBF::PrimitiveGroup &group,
+                           Batch& batch);
+
+    static void DecodeRelations(const TypeConfig& typeConfig,
+                                const PBF::PrimitiveBlock& block,
+                                const PBF::PrimitiveGroup &group,
+                                Batch& batch);
+
+    static void DecodeBatch(const TypeConfig& typeConfig,
+                            PBF::PrimitiveBlock& block,
+                            Batch& batch);
+
+    void ProcessBatch(const TypeConfig& typeConfig,
+                      const Batch& batch);
 
   public:
     std::string GetDescription() const;
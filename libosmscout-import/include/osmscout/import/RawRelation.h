@@ -73,6 +73,8 @@ namespace osmscout {
     void SetId(OSMId id);
     void SetType(TypeId type);
 
+    size_t GetMemorySize() const;
+
     bool Read(FileScanner& scanner);
     bool Write(FileWriter& writer) const;
   };
@@ -20,8 +20,11 @@
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
 */
 
+#include <algorithm>
 #include <cmath>
 #include <list>
+#include <queue>
+#include <vector>
 
 #include <osmscout/import/Import.h>
 
@@ -30,6 +33,7 @@
 
 #include <osmscout/util/FileWriter.h>
 #include <osmscout/util/HashMap.h>
+#include <osmscout/util/ThreadPool.h>
 
 namespace osmscout {
 
@@ -46,35 +50,111 @@ namespace osmscout {
       FileScanner scanner;
     };
 
-    struct CellEntry
+    /**
+     * Sort order of the objects: by cell (or the index of the cell on a space
+     * filling curve, see ImportParameter::SortOrder), within a cell by
+     * longitude and latitude. The sequence number (the position in the input)
+     * makes the order total, so the result does not depend on how the data
+     * was split into runs.
+     */
+    struct SortKey
     {
-      Id                                   id;
-      typename std::list<Source>::iterator source;
-      FileOffset                           fileOffset;
-      double                               lat;
-      double                               lon;
-
-      inline CellEntry(Id id,
-                       const typename std::list<Source>::iterator source,
-                       FileOffset fileOffset,
-                       double lat,
-                       double lon)
-      : id(id),
-        source(source),
-        fileOffset(fileOffset),
-        lat(lat),
-        lon(lon)
+      size_t   cell;
+      double   lat;
+      double   lon;
+      uint32_t sequence;
+
+      inline bool operator<(const SortKey& other) const
+      {
+        if (cell!=other.cell) {
+          return cell<other.cell;
+        }
+
+        if (lon!=other.lon) {
+          return lon<other.lon;
+        }
+
+        if (lat!=other.lat) {
+          return lat>other.lat;
+        }
+
+        return sequence<other.sequence;
+      }
+    };
+
+    /**
+     * An object of the current run. The data of the object is stored as is
+     * (as read from the source file) in the run buffer.
+     */
+    struct SortEntry
+    {
+      SortKey key;
+      Id      id;
+      uint8_t type;
+      size_t  dataOffset; //! Offset of the data in the run buffer
+      size_t  dataSize;   //! Size of the data in bytes
+
+      inline bool operator<(const SortEntry& other) const
+      {
+        return key<other.key;
+      }
+    };
+
+    /**
+     * The current object of a run during merging
+     */
+    struct MergeEntry
+    {
+      SortKey key;
+      size_t  run;
+
+      inline bool operator<(const MergeEntry& other) const
+      {
+        // std::priority_queue returns the largest entry first
+        return other.key<key;
+      }
+    };
+
+    struct SortRange
+    {
+      size_t begin;
+      size_t middle;
+      size_t end;
+    };
+
+    /**
+     * Sorts (or merges two sorted halfs of) ranges of the run in parallel
+     */
+    class SortJob : public ParallelJob
+    {
+    private:
+      std::vector<SortEntry>& entries;
+
+    public:
+      std::vector<SortRange>  ranges;
+      bool                    merge;
+
+    public:
+      SortJob(std::vector<SortEntry>& entries)
+      : entries(entries),
+        merge(false)
       {
         // no code
       }
 
-      inline bool operator<(const CellEntry& other) const
+      void Execute(size_t task,
+                   size_t /*worker*/)
       {
-        if (lon==other.lon) {
-          return lat>other.lat;
+        const SortRange& range=ranges[task];
+
+        if (merge) {
+          std::inplace_merge(entries.begin()+range.begin,
+                             entries.begin()+range.middle,
+                             entries.begin()+range.end);
         }
         else {
-          return lon<other.lon;
+          std::sort(entries.begin()+range.begin,
+                    entries.begin()+range.end);
         }
       }
     };
@@ -85,6 +165,38 @@ namespace osmscout {
     std::string       mapFilename;
 
   private:
+    static size_t GetZOrderIndex(size_t cellCount,
+                                 size_t x,
+                                 size_t y);
+    static size_t GetHilbertIndex(size_t cellCount,
+                                  size_t x,
+                                  size_t y);
+
+    void GetSortKey(const ImportParameter& parameter,
+                    const N& data,
+                    uint32_t sequence,
+                    SortKey& key);
+
+    void SortRun(ThreadPool& threadPool,
+                 std::vector<SortEntry>& entries);
+
+    bool WriteRun(const ImportParameter& parameter,
+                  Progress& progress,
+                  std::vector<SortEntry>& entries,
+                  std::vector<char>& buffer,
+                  std::vector<std::string>& runFilenames);
+
+    bool ReadRunEntry(const ImportParameter& parameter,
+                      FileScanner& scanner,
+                      Id& id,
+                      uint8_t& type,
+                      N& data,
+                      SortKey& key);
+
+    bool SortAndMerge(const ImportParameter& parameter,
+                      Progress& progress,
+                      std::vector<std::string>& runFilenames);
+
     bool Renumber(const ImportParameter& parameter,
                   Progress& progress);
 
@@ -103,6 +215,10 @@ namespace osmscout {
                    const std::string& filename);
 
   public:
+    void GetInputFiles(const ImportParameter& parameter,
+                       std::list<std::string>& files) const;
+    void GetOutputFiles(const ImportParameter& parameter,
+                        std::list<std::string>& files) const;
     bool Import(const ImportParameter& parameter,
                 Progress& progress,
                 const TypeConfig& typeConfig);
@@ -130,17 +246,293 @@ namespace osmscout {
   }
 
   template <class N>
-  bool SortDataGenerator<N>::Renumber(const ImportParameter& parameter,
-                                      Progress& progress)
+  void SortDataGenerator<N>::GetInputFiles(const ImportParameter& parameter,
+                                           std::list<std::string>& files) const
   {
-    FileWriter  dataWriter;
-    FileWriter  mapWriter;
-    uint32_t    overallDataCount=0;
-    uint32_t    dataCopyiedCount=0;
-    double      zoomLevel=pow(2.0,(double)parameter.GetSortTileMag());
-    size_t      cellCount=zoomLevel*zoomLevel;
-    size_t      minIndex=0;
-    size_t      maxIndex=cellCount-1;
+    for (typename std::list<Source>::const_iterator source=sources.begin();
+         source!=sources.end();
+         ++source) {
+      files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                      source->filename));
+    }
+  }
+
+  template <class N>
+  void SortDataGenerator<N>::GetOutputFiles(const ImportParameter& parameter,
+                                            std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    dataFilename));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    mapFilename));
+  }
+
+  template <class N>
+  void SortDataGenerator<N>::GetSortKey(const ImportParameter& parameter,
+                                        const N& data,
+                                        uint32_t sequence,
+                                        SortKey& key)
+  {
+    double zoomLevel=pow(2.0,(double)parameter.GetSortTileMag());
+    double maxLat;
+    double minLon;
+
+    GetTopLeftCoordinate(data,maxLat,minLon);
+
+    if (parameter.GetSortOrder()==ImportParameter::sortOrderCell) {
+      size_t cellY=(size_t)((maxLat+90.0)/zoomLevel);
+      size_t cellX=(size_t)((minLon+180.0)/zoomLevel);
+
+      key.cell=cellY*zoomLevel+cellX;
+    }
+    else {
+      size_t cellCount=(size_t)zoomLevel;
+      size_t cellX=(size_t)((minLon+180.0)/360.0*zoomLevel);
+      size_t cellY=(size_t)((maxLat+90.0)/180.0*zoomLevel);
+
+      cellX=std::min(cellX,cellCount-1);
+      cellY=std::min(cellY,cellCount-1);
+
+      if (parameter.GetSortOrder()==ImportParameter::sortOrderZOrder) {
+        key.cell=GetZOrderIndex(cellCount,cellX,cellY);
+      }
+      else {
+        key.cell=GetHilbertIndex(cellCount,cellX,cellY);
+      }
+    }
+
+    key.lat=maxLat;
+    key.lon=minLon;
+    key.sequence=sequence;
+  }
+
+  /**
+   * Return the index of the given cell on a Z-order (Morton) curve over a
+   * grid of cellCount x cellCount cells (cellCount must be a power of 2).
+   */
+  template <class N>
+  size_t SortDataGenerator<N>::GetZOrderIndex(size_t cellCount,
+                                              size_t x,
+                                              size_t y)
+  {
+    size_t index=0;
+    size_t bit=0;
+
+    for (size_t s=1; s<cellCount; s*=2) {
+      if (x & s) {
+        index|=(size_t)1 << bit;
+      }
+
+      if (y & s) {
+        index|=(size_t)1 << (bit+1);
+      }
+
+      bit+=2;
+    }
+
+    return index;
+  }
+
+  /**
+   * Return the index of the given cell on a Hilbert curve over a grid of
+   * cellCount x cellCount cells (cellCount must be a power of 2). In contrast
+   * to the Z-order curve, consecutive cells on the curve are always neighbours.
+   */
+  template <class N>
+  size_t SortDataGenerator<N>::GetHilbertIndex(size_t cellCount,
+                                               size_t x,
+                                               size_t y)
+  {
+    size_t index=0;
+
+    for (size_t s=cellCount/2; s>0; s/=2) {
+      size_t rx=(x & s)>0 ? 1 : 0;
+      size_t ry=(y & s)>0 ? 1 : 0;
+
+      index+=s*s*((3*rx)^ry);
+
+      // Rotate the quadrant, so that the curve of the sub quadrant starts and
+      // ends next to its neighbours
+      if (ry==0) {
+        if (rx==1) {
+          x=cellCount-1-x;
+          y=cellCount-1-y;
+        }
+
+        std::swap(x,y);
+      }
+    }
+
+    return index;
+  }
+
+  /**
+   * Sort the entries of the run. The entries are split into one chunk per
+   * worker, the chunks are sorted in parallel and then merged pairwise (again
+   * in parallel) until one sorted range is left.
+   */
+  template <class N>
+  void SortDataGenerator<N>::SortRun(ThreadPool& threadPool,
+                                     std::vector<SortEntry>& entries)
+  {
+    size_t chunkCount=std::min(threadPool.GetWorkerCount(),
+                               entries.size());
+
+    if (chunkCount<=1) {
+      std::sort(entries.begin(),
+                entries.end());
+      return;
+    }
+
+    SortJob             job(entries);
+    std::vector<size_t> bounds;
+
+    for (size_t chunk=0; chunk<=chunkCount; chunk++) {
+      bounds.push_back(chunk*entries.size()/chunkCount);
+    }
+
+    for (size_t chunk=0; chunk<chunkCount; chunk++) {
+      SortRange range;
+
+      range.begin=bounds[chunk];
+      range.middle=bounds[chunk+1];
+      range.end=bounds[chunk+1];
+
+      job.ranges.push_back(range);
+    }
+
+    threadPool.Execute(job,
+                       job.ranges.size());
+
+    job.merge=true;
+
+    while (bounds.size()>2) {
+      std::vector<size_t> mergedBounds;
+
+      job.ranges.clear();
+
+      for (size_t i=0; i+1<bounds.size(); i+=2) {
+        mergedBounds.push_back(bounds[i]);
+
+        if (i+2<bounds.size()) {
+          SortRange range;
+
+          range.begin=bounds[i];
+          range.middle=bounds[i+1];
+          range.end=bounds[i+2];
+
+          job.ranges.push_back(range);
+        }
+      }
+
+      mergedBounds.push_back(entries.size());
+
+      threadPool.Execute(job,
+                         job.ranges.size());
+
+      bounds.swap(mergedBounds);
+    }
+  }
+
+  /**
+   * Write the (sorted) entries of the current run to a new temporary run file
+   * and clear the run.
+   */
+  template <class N>
+  bool SortDataGenerator<N>::WriteRun(const ImportParameter& parameter,
+                                      Progress& progress,
+                                      std::vector<SortEntry>& entries,
+                                      std::vector<char>& buffer,
+                                      std::vector<std::string>& runFilenames)
+  {
+    FileWriter writer;
+
+    if (!writer.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                     dataFilename+"."+NumberToString(runFilenames.size())+".run"))) {
+      progress.Error(std::string("Cannot create '")+writer.GetFilename()+"'");
+      return false;
+    }
+
+    progress.Info("Writing "+NumberToString(entries.size())+" entries to '"+writer.GetFilename()+"'");
+
+    runFilenames.push_back(writer.GetFilename());
+
+    writer.Write((uint32_t)entries.size());
+
+    for (typename std::vector<SortEntry>::const_iterator entry=entries.begin();
+         entry!=entries.end();
+         ++entry) {
+      writer.Write(entry->id);
+      writer.Write(entry->type);
+      writer.Write(entry->key.sequence);
+
+      if (entry->dataSize>0) {
+        writer.Write(&buffer[entry->dataOffset],
+                     entry->dataSize);
+      }
+    }
+
+    if (writer.HasError() ||
+        !writer.Close()) {
+      progress.Error(std::string("Error while writing '")+writer.GetFilename()+"'");
+      return false;
+    }
+
+    entries.clear();
+    buffer.clear();
+
+    return true;
+  }
+
+  template <class N>
+  bool SortDataGenerator<N>::ReadRunEntry(const ImportParameter& parameter,
+                                          FileScanner& scanner,
+                                          Id& id,
+                                          uint8_t& type,
+                                          N& data,
+                                          SortKey& key)
+  {
+    uint32_t sequence;
+    N        entry; // Objects expect to be read into a fresh instance
+
+    if (!scanner.Read(id) ||
+        !scanner.Read(type) ||
+        !scanner.Read(sequence) ||
+        !entry.Read(scanner)) {
+      return false;
+    }
+
+    GetSortKey(parameter,
+               entry,
+               sequence,
+               key);
+
+    data=entry;
+
+    return true;
+  }
+
+  /**
+   * Sort the data by cell and coordinate using an external merge sort:
+   * the data of all sources is read sequentially into runs that are limited
+   * by the sort block size and the sort memory budget. Each run is sorted (in
+   * parallel) and written to a temporary file. Afterwards all runs are merged
+   * by reading them sequentially. The names of the temporary files are
+   * appended to runFilenames.
+   */
+  template <class N>
+  bool SortDataGenerator<N>::SortAndMerge(const ImportParameter& parameter,
+                                          Progress& progress,
+                                          std::vector<std::string>& runFilenames)
+  {
+    FileWriter               dataWriter;
+    FileWriter               mapWriter;
+    uint32_t                 overallDataCount=0;
+    uint32_t                 dataCopyiedCount=0;
+    ThreadPool               threadPool;
+    std::vector<SortEntry>   entries;
+    std::vector<char>        buffer;
+    uint32_t                 sequence=0;
 
     progress.SetAction("Sorting data");
 
@@ -162,68 +554,49 @@ namespace osmscout {
         return false;
       }
 
-      overallDataCount+=dataCount;
-    }
+      progress.Info("Reading data from file '"+source->scanner.GetFilename()+"'");
 
+      uint32_t current=1;
 
-    if (!dataWriter.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
-                                        dataFilename))) {
-      progress.Error(std::string("Cannot create '")+dataWriter.GetFilename()+"'");
-      return false;
-    }
-
-    dataWriter.Write(overallDataCount);
+      while (current<=dataCount) {
+        Id         id;
+        N          data;
+        FileOffset dataStart;
+        FileOffset dataEnd;
 
-    if (!mapWriter.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
-                                        mapFilename))) {
-      progress.Error(std::string("Cannot create '")+mapWriter.GetFilename()+"'");
-      return false;
-    }
-
-    mapWriter.Write(overallDataCount);
-
-    while (true) {
-      progress.Info("Reading ways in cell range "+NumberToString(minIndex)+ "-"+NumberToString(maxIndex));
-
-      size_t                                currentEntries=0;
-      std::map<size_t,std::list<CellEntry> > dataByCellMap;
-
-      for (typename std::list<Source>::iterator source=sources.begin();
-              source!=sources.end();
-              ++source) {
-        uint32_t dataCount;
-        progress.Info("Reading data from file '"+source->scanner.GetFilename()+"'");
-
-        if (!source->scanner.GotoBegin()) {
-          progress.Error(std::string("Error while setting current position in file '")+
-                         source->scanner.GetFilename()+"'");
-        }
+        progress.SetProgress(current,dataCount);
 
-        if (!source->scanner.Read(dataCount)) {
-          progress.Error("Error while reading number of data entries in file'"+
+        if (!source->scanner.Read(id) ||
+            !source->scanner.GetPos(dataStart) ||
+            !data.Read(source->scanner) ||
+            !source->scanner.GetPos(dataEnd)) {
+          progress.Error(std::string("Error while reading data entry ")+
+                         NumberToString(current)+" of "+
+                         NumberToString(dataCount)+
+                         " in file '"+
                          source->scanner.GetFilename()+"'");
           return false;
         }
 
-        uint32_t current=1;
+        SortEntry entry;
 
-        while (current<=dataCount) {
-          Id  id;
-          N   data;
+        GetSortKey(parameter,
+                   data,
+                   sequence,
+                   entry.key);
 
-          progress.SetProgress(current,dataCount);
+        entry.id=id;
+        entry.type=(uint8_t)source->type;
+        entry.dataOffset=buffer.size();
+        entry.dataSize=(size_t)(dataEnd-dataStart);
 
-          if (!source->scanner.Read(id)) {
-            progress.Error(std::string("Error while reading data entry ")+
-                           NumberToString(current)+" of "+
-                           NumberToString(dataCount)+
-                           " in file '"+
-                           source->scanner.GetFilename()+"'");
+        // Keep the data as read, it is parsed again while merging
+        if (entry.dataSize>0) {
+          buffer.resize(entry.dataOffset+entry.dataSize);
 
-            return false;
-          }
-
-          if (!data.Read(source->scanner)) {
+          if (!source->scanner.SetPos(dataStart) ||
+              !source->scanner.Read(&buffer[entry.dataOffset],
+                                    entry.dataSize)) {
             progress.Error(std::string("Error while reading data entry ")+
                            NumberToString(current)+" of "+
                            NumberToString(dataCount)+
@@ -231,138 +604,159 @@ namespace osmscout {
                            source->scanner.GetFilename()+"'");
             return false;
           }
+        }
 
-          double maxLat;
-          double minLon;
-
-          GetTopLeftCoordinate(data,maxLat,minLon);
-
-          size_t cellY=(size_t)((maxLat+90.0)/zoomLevel);
-          size_t cellX=(size_t)((minLon+180.0)/zoomLevel);
-          size_t cellIndex=cellY*zoomLevel+cellX;
+        entries.push_back(entry);
 
-          if (cellIndex>=minIndex &&
-              cellIndex<=maxIndex) {
-            dataByCellMap[cellIndex].push_back(CellEntry(id,
-                                                         source,
-                                                         data.GetFileOffset(),
-                                                         maxLat,
-                                                         minLon));
-            currentEntries++;
-          }
+        if (entries.size()>=parameter.GetSortBlockSize() ||
+            buffer.size()+entries.size()*sizeof(SortEntry)>=parameter.GetSortMemoryBudget()) {
+          SortRun(threadPool,
+                  entries);
 
-          // Reduce cell interval,deleting all already stored nodes beyond the new
-          // cell range end.
-          if (currentEntries>parameter.GetSortBlockSize()) {
-            size_t                                                    count=0;
-            typename std::map<size_t,std::list<CellEntry> >::iterator cutOff=dataByCellMap.end();
-
-            for (typename std::map<size_t,std::list<CellEntry> >::iterator iter=dataByCellMap.begin();
-                iter!=dataByCellMap.end();
-                ++iter) {
-              if (count<=parameter.GetSortBlockSize() &&
-                  count+iter->second.size()>parameter.GetSortBlockSize()) {
-                cutOff=iter;
-                break;
-              }
-              else {
-                count+=iter->second.size();
-                maxIndex=iter->first;
-              }
-            }
-
-            assert(cutOff!=dataByCellMap.end());
-
-            currentEntries=count;
-            dataByCellMap.erase(cutOff,dataByCellMap.end());
-
-            progress.Debug("Reducing cell range to "+NumberToString(minIndex)+ "-"+NumberToString(maxIndex));
+          if (!WriteRun(parameter,
+                        progress,
+                        entries,
+                        buffer,
+                        runFilenames)) {
+            return false;
           }
-
-          current++;
         }
+
+        sequence++;
+        current++;
       }
 
-      if (maxIndex<cellCount-1) {
-        progress.Info("Cell range was reduced to "+NumberToString(minIndex)+ "-"+NumberToString(maxIndex));
+      overallDataCount+=dataCount;
+
+      if (!source->scanner.Close()) {
+        progress.Error(std::string("Error while closing '")+source->scanner.GetFilename()+"'");
+        return false;
       }
+    }
 
-      progress.Info(std::string("Copy renumbered data to '")+dataWriter.GetFilename()+"'");
+    if (!entries.empty()) {
+      SortRun(threadPool,
+              entries);
 
-      size_t copyCount=0;
-      for (typename std::map<size_t,std::list<CellEntry> >::iterator iter=dataByCellMap.begin();
-          iter!=dataByCellMap.end();
-          ++iter) {
+      if (!WriteRun(parameter,
+                    progress,
+                    entries,
+                    buffer,
+                    runFilenames)) {
+        return false;
+      }
+    }
 
-        iter->second.sort();
+    // Free the memory of the last run before merging
+    std::vector<SortEntry>().swap(entries);
+    std::vector<char>().swap(buffer);
 
-        for (typename std::list<CellEntry>::const_iterator entry=iter->second.begin();
-            entry!=iter->second.end();
-            ++entry) {
-          progress.SetProgress(copyCount,currentEntries);
+    progress.SetAction("Merging "+NumberToString(runFilenames.size())+" run(s)");
 
-          N data;
+    if (!dataWriter.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                        dataFilename))) {
+      progress.Error(std::string("Cannot create '")+dataWriter.GetFilename()+"'");
+      return false;
+    }
 
-          if (!entry->source->scanner.SetPos(entry->fileOffset)) {
-            progress.Error(std::string("Error while setting current position in file '")+
-                           entry->source->scanner.GetFilename()+"'");
+    dataWriter.Write(overallDataCount);
 
-            return false;
-          }
+    if (!mapWriter.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                        mapFilename))) {
+      progress.Error(std::string("Cannot create '")+mapWriter.GetFilename()+"'");
+      return false;
+    }
 
-          if (!data.Read(entry->source->scanner))  {
-            progress.Error(std::string("Error while reading data entry at offset ")+
-                           NumberToString(entry->fileOffset)+
-                           " in file '"+
-                           entry->source->scanner.GetFilename()+"'");
+    mapWriter.Write(overallDataCount);
 
-            return false;
-          }
+    std::vector<FileScanner>        runs(runFilenames.size());
+    std::vector<uint32_t>           runRemaining(runFilenames.size());
+    std::vector<Id>                 runIds(runFilenames.size());
+    std::vector<uint8_t>            runTypes(runFilenames.size());
+    std::vector<N>                  runData(runFilenames.size());
+    std::priority_queue<MergeEntry> queue;
 
-          FileOffset fileOffset;
+    for (size_t r=0; r<runs.size(); r++) {
+      MergeEntry entry;
 
-          if (!dataWriter.GetPos(fileOffset)) {
-            progress.Error(std::string("Error while reading current fileOffset in file '")+
-                           dataWriter.GetFilename()+"'");
-            return false;
-          }
+      entry.run=r;
 
-          if (!data.Write(dataWriter)) {
-            progress.Error(std::string("Error while writing data entry to file '")+
-                           dataWriter.GetFilename()+"'");
-            return false;
-          }
+      if (!runs[r].Open(runFilenames[r],
+                        FileScanner::Sequential,
+                        parameter.GetWayDataMemoryMaped()) ||
+          !runs[r].Read(runRemaining[r])) {
+        progress.Error(std::string("Cannot open '")+runFilenames[r]+"'");
+        return false;
+      }
 
-          mapWriter.Write(entry->id);
-          mapWriter.Write((uint8_t)entry->source->type);
-          mapWriter.WriteFileOffset(fileOffset);
+      if (runRemaining[r]==0) {
+        continue;
+      }
 
-          copyCount++;
-          dataCopyiedCount++;
-        }
+      if (!ReadRunEntry(parameter,
+                        runs[r],
+                        runIds[r],
+                        runTypes[r],
+                        runData[r],
+                        entry.key)) {
+        progress.Error(std::string("Error while reading data entry in file '")+
+                       runFilenames[r]+"'");
+        return false;
       }
 
-      if (currentEntries==0) {
-        progress.Info("No more entries found");
-        break;
+      runRemaining[r]--;
+      queue.push(entry);
+    }
+
+    while (!queue.empty()) {
+      MergeEntry entry=queue.top();
+      size_t     r=entry.run;
+      FileOffset fileOffset;
+
+      queue.pop();
+
+      progress.SetProgress(dataCopyiedCount,overallDataCount);
+
+      if (!dataWriter.GetPos(fileOffset)) {
+        progress.Error(std::string("Error while reading current fileOffset in file '")+
+                       dataWriter.GetFilename()+"'");
+        return false;
       }
 
-      if (maxIndex==cellCount-1) {
-        // We are finished
-        break;
+      if (!runData[r].Write(dataWriter)) {
+        progress.Error(std::string("Error while writing data entry to file '")+
+                       dataWriter.GetFilename()+"'");
+        return false;
       }
 
-      minIndex=maxIndex+1;
-      maxIndex=cellCount-1;
+      mapWriter.Write(runIds[r]);
+      mapWriter.Write(runTypes[r]);
+      mapWriter.WriteFileOffset(fileOffset);
+
+      dataCopyiedCount++;
+
+      if (runRemaining[r]>0) {
+        if (!ReadRunEntry(parameter,
+                          runs[r],
+                          runIds[r],
+                          runTypes[r],
+                          runData[r],
+                          entry.key)) {
+          progress.Error(std::string("Error while reading data entry in file '")+
+                         runFilenames[r]+"'");
+          return false;
+        }
+
+        runRemaining[r]--;
+        queue.push(entry);
+      }
     }
 
     assert(overallDataCount==dataCopyiedCount);
 
-    for (typename std::list<Source>::iterator source=sources.begin();
-            source!=sources.end();
-            ++source) {
-      if (!source->scanner.Close()) {
-        progress.Error(std::string("Error while  closing '")+source->scanner.GetFilename()+"'");
+    for (size_t r=0; r<runs.size(); r++) {
+      if (!runs[r].Close()) {
+        progress.Error(std::string("Error while closing '")+runFilenames[r]+"'");
         return false;
       }
     }
@@ -371,6 +765,33 @@ namespace osmscout {
            mapWriter.Close();
   }
 
+  /**
+   * Sort the data (see SortAndMerge()) and delete the temporary run files
+   * afterwards, on error, too.
+   */
+  template <class N>
+  bool SortDataGenerator<N>::Renumber(const ImportParameter& parameter,
+                                      Progress& progress)
+  {
+    std::vector<std::string> runFilenames;
+    bool                     success;
+
+    success=SortAndMerge(parameter,
+                         progress,
+                         runFilenames);
+
+    for (std::vector<std::string>::const_iterator filename=runFilenames.begin();
+         filename!=runFilenames.end();
+         ++filename) {
+      if (!RemoveFile(*filename)) {
+        progress.Error(std::string("Cannot delete '")+*filename+"'");
+        success=false;
+      }
+    }
+
+    return success;
+  }
+
   template <class N>
   bool SortDataGenerator<N>::Copy(const ImportParameter& parameter,
                                   Progress& progress)
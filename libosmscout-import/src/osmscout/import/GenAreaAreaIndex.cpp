@@ -37,6 +37,20 @@ namespace osmscout {
     return "Generate 'areaarea.idx'";
   }
 
+  void AreaAreaIndexGenerator::GetInputFiles(const ImportParameter& parameter,
+                                             std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "areas.dat"));
+  }
+
+  void AreaAreaIndexGenerator::GetOutputFiles(const ImportParameter& parameter,
+                                              std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "areaarea.idx"));
+  }
+
   void AreaAreaIndexGenerator::SetOffsetOfChildren(const std::map<Pixel,AreaLeaf>& leafs,
                                                    std::map<Pixel,AreaLeaf>& newAreaLeafs)
   {
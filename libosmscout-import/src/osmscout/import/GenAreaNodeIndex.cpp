@@ -55,6 +55,20 @@ namespace osmscout {
     return "Generate 'areanode.idx'";
   }
 
+  void AreaNodeIndexGenerator::GetInputFiles(const ImportParameter& parameter,
+                                             std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "nodes.dat"));
+  }
+
+  void AreaNodeIndexGenerator::GetOutputFiles(const ImportParameter& parameter,
+                                              std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "areanode.idx"));
+  }
+
   bool AreaNodeIndexGenerator::Import(const ImportParameter& parameter,
                                       Progress& progress,
                                       const TypeConfig& typeConfig)
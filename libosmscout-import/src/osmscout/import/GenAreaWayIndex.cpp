@@ -54,6 +54,20 @@ namespace osmscout {
     return "Generate 'areaway.idx'";
   }
 
+  void AreaWayIndexGenerator::GetInputFiles(const ImportParameter& parameter,
+                                            std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "ways.dat"));
+  }
+
+  void AreaWayIndexGenerator::GetOutputFiles(const ImportParameter& parameter,
+                                             std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "areaway.idx"));
+  }
+
   void AreaWayIndexGenerator::CalculateStatistics(size_t level,
                                                   TypeData& typeData,
                                                   const CoordCountMap& cellFillCount)
@@ -1742,6 +1742,26 @@ namespace osmscout {
     return "Generate 'location.idx'";
   }
 
+  void LocationIndexGenerator::GetInputFiles(const ImportParameter& parameter,
+                                             std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "areas.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "nodes.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "ways.dat"));
+  }
+
+  void LocationIndexGenerator::GetOutputFiles(const ImportParameter& parameter,
+                                              std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "location.txt"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    LocationIndex::FILENAME_LOCATION_IDX));
+  }
+
   bool LocationIndexGenerator::Import(const ImportParameter& parameter,
                                       Progress& progress,
                                       const TypeConfig& typeConfig)
@@ -40,6 +40,22 @@ namespace osmscout {
     return "Generate 'nodes.tmp'";
   }
 
+  void NodeDataGenerator::GetInputFiles(const ImportParameter& parameter,
+                                        std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "rawnodes.dat"));
+  }
+
+  void NodeDataGenerator::GetOutputFiles(const ImportParameter& parameter,
+                                         std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "nodes.tmp"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "bounding.dat"));
+  }
+
   bool NodeDataGenerator::Import(const ImportParameter& parameter,
                                  Progress& progress,
                                  const TypeConfig& typeConfig)
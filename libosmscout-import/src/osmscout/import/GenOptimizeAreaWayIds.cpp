@@ -31,6 +31,28 @@ namespace osmscout {
     return "Optimize ids for areas and ways";
   }
 
+  void OptimizeAreaWayIdsGenerator::GetInputFiles(const ImportParameter& parameter,
+                                                  std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "wayarea.tmp"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "relarea.tmp"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "wayway.tmp"));
+  }
+
+  void OptimizeAreaWayIdsGenerator::GetOutputFiles(const ImportParameter& parameter,
+                                                   std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "wayarea.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "relarea.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "wayway.dat"));
+  }
+
   bool OptimizeAreaWayIdsGenerator::ScanWayAreaIds(const ImportParameter& parameter,
                                                    Progress& progress,
                                                    NodeUseMap& nodeUseMap)
@@ -59,6 +59,20 @@ namespace osmscout
     return "Generate '"+std::string(FILE_AREASOPT_DAT)+"'";
   }
 
+  void OptimizeAreasLowZoomGenerator::GetInputFiles(const ImportParameter& parameter,
+                                                    std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "areas.dat"));
+  }
+
+  void OptimizeAreasLowZoomGenerator::GetOutputFiles(const ImportParameter& parameter,
+                                                     std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    FILE_AREASOPT_DAT));
+  }
+
   void OptimizeAreasLowZoomGenerator::GetAreaTypesToOptimize(const TypeConfig& typeConfig,
                                                        std::set<TypeId>& types)
   {
@@ -59,6 +59,20 @@ namespace osmscout
     return "Generate '"+std::string(FILE_WAYSOPT_DAT)+"'";
   }
 
+  void OptimizeWaysLowZoomGenerator::GetInputFiles(const ImportParameter& parameter,
+                                                   std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "ways.dat"));
+  }
+
+  void OptimizeWaysLowZoomGenerator::GetOutputFiles(const ImportParameter& parameter,
+                                                    std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    FILE_WAYSOPT_DAT));
+  }
+
   void OptimizeWaysLowZoomGenerator::GetWayTypesToOptimize(const TypeConfig& typeConfig,
                                                            std::set<TypeId>& types)
   {
@@ -611,7 +611,7 @@ namespace osmscout {
       boundaryId=typeConfig.GetAreaTypeId("boundary_administrative");
     }
 
-    std::set<OSMId>                nodeIds;
+    std::vector<OSMId>             nodeIds;
     std::set<OSMId>                wayIds;
     std::set<OSMId>                relationIds;
 
@@ -743,7 +743,7 @@ namespace osmscout {
       for (std::vector<OSMId>::const_iterator id=way->GetNodes().begin();
            id!=way->GetNodes().end();
            ++id) {
-        nodeIds.insert(*id);
+        nodeIds.push_back(*id);
       }
 
       wayMap[way->GetId()]=way;
@@ -754,6 +754,10 @@ namespace osmscout {
 
     // Now load all node coordinates
 
+    std::sort(nodeIds.begin(),nodeIds.end());
+    nodeIds.erase(std::unique(nodeIds.begin(),nodeIds.end()),
+                  nodeIds.end());
+
     if (!coordDataFile.Get(nodeIds,
                            coordMap)) {
       progress.Error("Cannot resolve child nodes of relation "+
@@ -1009,6 +1013,30 @@ namespace osmscout {
     return "Generate 'relarea.tmp'";
   }
 
+  void RelAreaDataGenerator::GetInputFiles(const ImportParameter& parameter,
+                                           std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "coord.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "rawways.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "rawway.idx"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "rawrels.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "rawrel.idx"));
+  }
+
+  void RelAreaDataGenerator::GetOutputFiles(const ImportParameter& parameter,
+                                            std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "relarea.tmp"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "wayareablack.dat"));
+  }
+
   bool RelAreaDataGenerator::Import(const ImportParameter& parameter,
                                     Progress& progress,
                                     const TypeConfig& typeConfig)
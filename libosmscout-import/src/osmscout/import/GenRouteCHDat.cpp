@@ -0,0 +1,735 @@
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2014  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <osmscout/import/GenRouteCHDat.h>
+
+#include <algorithm>
+
+#include <osmscout/RouteNode.h>
+#include <osmscout/Router.h>
+
+#include <osmscout/system/Assert.h>
+
+#include <osmscout/util/File.h>
+#include <osmscout/util/FileScanner.h>
+#include <osmscout/util/String.h>
+
+namespace osmscout {
+
+  /**
+   * Maximum number of nodes settled during a witness search. If the search
+   * stops early, we just add a (potentially unnecessary) shortcut.
+   */
+  static const size_t witnessSettleLimit=500;
+
+  /**
+   * Return true, if both edges (between the same nodes) are equal regarding
+   * the rules evaluated at core nodes, so that the more expensive one
+   * can be dropped.
+   */
+  static bool IsEquivalentEdge(const ContractionHierarchy::Edge& a,
+                               const ContractionHierarchy::Edge& b,
+                               bool sourceIsCore,
+                               bool targetIsCore)
+  {
+    if (sourceIsCore &&
+        a.sourcePath!=b.sourcePath) {
+      return false;
+    }
+
+    if (targetIsCore &&
+        (a.targetObject!=b.targetObject ||
+         a.HasAccess()!=b.HasAccess())) {
+      return false;
+    }
+
+    return true;
+  }
+
+  RouteCHDataGenerator::RouteCHDataGenerator()
+  {
+    // no code
+  }
+
+  std::string RouteCHDataGenerator::GetDescription() const
+  {
+    return "Generate contraction hierarchy for car routing";
+  }
+
+  void RouteCHDataGenerator::GetInputFiles(const ImportParameter& parameter,
+                                           std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    Router::FILENAME_CAR_DAT));
+  }
+
+  void RouteCHDataGenerator::GetOutputFiles(const ImportParameter& parameter,
+                                            std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    Router::FILENAME_CAR_CH_DAT));
+  }
+
+  /**
+   * Read the car routing graph and create the original edges for all
+   * paths usable by the given profile.
+   */
+  bool RouteCHDataGenerator::ReadRouteGraph(const ImportParameter& parameter,
+                                            Progress& progress,
+                                            const RoutingProfile& profile,
+                                            std::vector<FileOffset>& offsets,
+                                            std::map<uint32_t,ContractionHierarchy::CoreNode>& coreNodes,
+                                            Graph& graph)
+  {
+    struct RawEdge
+    {
+      uint32_t      source;
+      FileOffset    target;
+      uint32_t      sourcePath;
+      ObjectFileRef object;
+      double        cost;
+      bool          access;
+    };
+
+    FileScanner                                 scanner;
+    uint32_t                                    nodeCount;
+    std::vector<RawEdge>                        rawEdges;
+    std::vector<uint32_t>                       pathCounts;
+    std::map<uint32_t,std::vector<ObjectFileRef> > coreObjects;
+
+    progress.SetAction("Reading car routing graph");
+
+    if (!scanner.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                      Router::FILENAME_CAR_DAT),
+                      FileScanner::Sequential,
+                      true)) {
+      progress.Error("Cannot open '"+scanner.GetFilename()+"'");
+      return false;
+    }
+
+    if (!scanner.Read(nodeCount)) {
+      progress.Error("Error while reading number of data entries in file");
+      return false;
+    }
+
+    offsets.reserve(nodeCount);
+    pathCounts.reserve(nodeCount);
+
+    for (uint32_t n=0; n<nodeCount; n++) {
+      RouteNode node;
+
+      progress.SetProgress(n,nodeCount);
+
+      if (!node.Read(scanner)) {
+        progress.Error(std::string("Error while reading data entry ")+
+                       NumberToString(n)+" of "+
+                       NumberToString(nodeCount)+
+                       " in file '"+
+                       scanner.GetFilename()+"'");
+        return false;
+      }
+
+      if (!offsets.empty() &&
+          node.GetFileOffset()<=offsets.back()) {
+        progress.Error("Route nodes are not sorted by file offset");
+        return false;
+      }
+
+      offsets.push_back(node.GetFileOffset());
+      pathCounts.push_back((uint32_t)node.paths.size());
+
+      bool isCore=!node.excludes.empty();
+
+      for (size_t p=0; p<node.paths.size(); p++) {
+        if (!node.paths[p].HasAccess()) {
+          isCore=true;
+        }
+
+        if (!profile.CanUse(node,p)) {
+          continue;
+        }
+
+        RawEdge edge;
+
+        edge.source=n;
+        edge.target=node.paths[p].offset;
+        edge.sourcePath=(uint32_t)p;
+        edge.object=node.objects[node.paths[p].objectIndex];
+        edge.cost=profile.GetCosts(node,p);
+        edge.access=node.paths[p].HasAccess();
+
+        rawEdges.push_back(edge);
+      }
+
+      if (!isCore) {
+        continue;
+      }
+
+      ContractionHierarchy::CoreNode& coreNode=coreNodes[n];
+
+      for (std::vector<RouteNode::Exclude>::const_iterator exclude=node.excludes.begin();
+           exclude!=node.excludes.end();
+           ++exclude) {
+        std::vector<ObjectFileRef>::const_iterator object=std::find(node.objects.begin(),
+                                                                    node.objects.end(),
+                                                                    exclude->source);
+
+        // Cannot arrive via an object not crossing the node
+        if (object==node.objects.end()) {
+          continue;
+        }
+
+        ContractionHierarchy::Exclude coreExclude;
+
+        coreExclude.sourceObject=(uint32_t)(object-node.objects.begin());
+        coreExclude.targetPath=exclude->targetIndex;
+
+        coreNode.excludes.push_back(coreExclude);
+      }
+
+      coreNode.pathAccess.resize(node.paths.size());
+
+      for (size_t p=0; p<node.paths.size(); p++) {
+        coreNode.pathAccess[p]=node.paths[p].HasAccess();
+      }
+
+      if (!node.excludes.empty()) {
+        coreObjects[n]=node.objects;
+      }
+    }
+
+    if (!scanner.Close()) {
+      progress.Error(std::string("Cannot close file '")+scanner.GetFilename()+"'");
+      return false;
+    }
+
+    progress.SetAction("Creating edges");
+
+    std::vector<uint32_t> targets(rawEdges.size(),ContractionHierarchy::noNode);
+
+    for (size_t e=0; e<rawEdges.size(); e++) {
+      std::vector<FileOffset>::const_iterator target=std::lower_bound(offsets.begin(),
+                                                                      offsets.end(),
+                                                                      rawEdges[e].target);
+
+      if (target==offsets.end() ||
+          *target!=rawEdges[e].target) {
+        progress.Warning(std::string("Cannot resolve route node offset ")+NumberToString(rawEdges[e].target));
+        continue;
+      }
+
+      targets[e]=(uint32_t)(target-offsets.begin());
+
+      // Whether one can continue on an accessible path depends on the arrival
+      if (!rawEdges[e].access &&
+          coreNodes.find(targets[e])==coreNodes.end()) {
+        ContractionHierarchy::CoreNode& coreNode=coreNodes[targets[e]];
+
+        coreNode.pathAccess.assign(pathCounts[targets[e]],true);
+      }
+    }
+
+    graph.outEdges.resize(offsets.size());
+    graph.inEdges.resize(offsets.size());
+    graph.upEdges.resize(offsets.size());
+    graph.core.resize(offsets.size(),false);
+    graph.contracted.resize(offsets.size(),false);
+    graph.contractedNeighbours.resize(offsets.size(),0);
+    graph.witnessCosts.resize(offsets.size(),-1.0);
+
+    for (std::map<uint32_t,ContractionHierarchy::CoreNode>::const_iterator coreNode=coreNodes.begin();
+         coreNode!=coreNodes.end();
+         ++coreNode) {
+      graph.core[coreNode->first]=true;
+    }
+
+    for (size_t e=0; e<rawEdges.size(); e++) {
+      if (targets[e]==ContractionHierarchy::noNode ||
+          targets[e]==rawEdges[e].source) {
+        continue;
+      }
+
+      Edge edge;
+
+      edge.node=targets[e];
+      edge.middle=ContractionHierarchy::noNode;
+      edge.sourcePath=rawEdges[e].sourcePath;
+      edge.targetObject=ContractionHierarchy::noNode;
+      edge.cost=rawEdges[e].cost;
+      edge.flags=rawEdges[e].access ? 0 : ContractionHierarchy::noAccess;
+
+      std::map<uint32_t,std::vector<ObjectFileRef> >::const_iterator objects=coreObjects.find(targets[e]);
+
+      if (objects!=coreObjects.end()) {
+        std::vector<ObjectFileRef>::const_iterator object=std::find(objects->second.begin(),
+                                                                    objects->second.end(),
+                                                                    rawEdges[e].object);
+
+        if (object!=objects->second.end()) {
+          edge.targetObject=(uint32_t)(object-objects->second.begin());
+        }
+      }
+
+      AddEdge(graph,
+              rawEdges[e].source,
+              targets[e],
+              edge);
+    }
+
+    progress.Info(NumberToString(offsets.size())+" nodes, "+
+                  NumberToString(coreNodes.size())+" core nodes, "+
+                  NumberToString(rawEdges.size())+" edges");
+
+    return true;
+  }
+
+  /**
+   * Add the given edge from source to target. If there already is an
+   * equivalent edge, only the cheaper one is kept.
+   */
+  void RouteCHDataGenerator::AddEdge(Graph& graph,
+                                     uint32_t source,
+                                     uint32_t target,
+                                     const Edge& edge)
+  {
+    bool     sourceIsCore=graph.core[source];
+    bool     targetIsCore=graph.core[target];
+    EdgeList &outEdges=graph.outEdges[source];
+    EdgeList &inEdges=graph.inEdges[target];
+
+    for (EdgeList::iterator outEdge=outEdges.begin();
+         outEdge!=outEdges.end();
+         ++outEdge) {
+      if (outEdge->node!=target ||
+          !IsEquivalentEdge(*outEdge,edge,sourceIsCore,targetIsCore)) {
+        continue;
+      }
+
+      if (outEdge->cost<=edge.cost) {
+        return;
+      }
+
+      for (EdgeList::iterator inEdge=inEdges.begin();
+           inEdge!=inEdges.end();
+           ++inEdge) {
+        if (inEdge->node==source &&
+            IsEquivalentEdge(*inEdge,edge,sourceIsCore,targetIsCore)) {
+          *inEdge=edge;
+          inEdge->node=source;
+          break;
+        }
+      }
+
+      *outEdge=edge;
+      outEdge->node=target;
+
+      return;
+    }
+
+    outEdges.push_back(edge);
+    outEdges.back().node=target;
+
+    inEdges.push_back(edge);
+    inEdges.back().node=source;
+  }
+
+  void RouteCHDataGenerator::RemoveEdges(EdgeList& edges,
+                                         uint32_t node)
+  {
+    size_t i=0;
+
+    while (i<edges.size()) {
+      if (edges[i].node==node) {
+        edges[i]=edges.back();
+        edges.pop_back();
+      }
+      else {
+        i++;
+      }
+    }
+  }
+
+  /**
+   * Dijkstra from the given source over the nodes not yet contracted,
+   * ignoring the given node (the node to be contracted) and core nodes.
+   */
+  void RouteCHDataGenerator::SearchWitnesses(Graph& graph,
+                                             uint32_t source,
+                                             uint32_t excluded,
+                                             double maxCosts)
+  {
+    size_t settled=0;
+
+    graph.witnessCosts[source]=0.0;
+    graph.witnessTouched.push_back(source);
+    graph.witnessHeap.Push(source,0.0);
+
+    while (!graph.witnessHeap.IsEmpty() &&
+           graph.witnessHeap.GetTopKey()<=maxCosts &&
+           settled<witnessSettleLimit) {
+      uint32_t current=graph.witnessHeap.Pop();
+
+      settled++;
+
+      for (EdgeList::const_iterator edge=graph.outEdges[current].begin();
+           edge!=graph.outEdges[current].end();
+           ++edge) {
+        if (edge->node==excluded ||
+            graph.core[edge->node]) {
+          continue;
+        }
+
+        double costs=graph.witnessCosts[current]+edge->cost;
+
+        if (graph.witnessCosts[edge->node]<0.0) {
+          graph.witnessCosts[edge->node]=costs;
+          graph.witnessTouched.push_back(edge->node);
+          graph.witnessHeap.Push(edge->node,costs);
+        }
+        else if (costs<graph.witnessCosts[edge->node] &&
+                 graph.witnessHeap.Contains(edge->node)) {
+          graph.witnessCosts[edge->node]=costs;
+          graph.witnessHeap.DecreaseKey(edge->node,costs);
+        }
+      }
+    }
+
+    graph.witnessHeap.Clear();
+  }
+
+  void RouteCHDataGenerator::ClearWitnesses(Graph& graph)
+  {
+    for (std::vector<uint32_t>::const_iterator node=graph.witnessTouched.begin();
+         node!=graph.witnessTouched.end();
+         ++node) {
+      graph.witnessCosts[*node]=-1.0;
+    }
+
+    graph.witnessTouched.clear();
+  }
+
+  /**
+   * Return the number of shortcuts required for contracting the given node
+   * and optionally the shortcuts itself.
+   *
+   * Turn restrictions and access rules of core nodes are only evaluated
+   * during routing, so a witness path cannot replace a shortcut starting or
+   * ending at a core node.
+   */
+  size_t RouteCHDataGenerator::GetShortcuts(Graph& graph,
+                                            uint32_t node,
+                                            std::vector<Shortcut>* shortcuts)
+  {
+    const EdgeList& inEdges=graph.inEdges[node];
+    const EdgeList& outEdges=graph.outEdges[node];
+    size_t          count=0;
+
+    for (EdgeList::const_iterator inEdge=inEdges.begin();
+         inEdge!=inEdges.end();
+         ++inEdge) {
+      uint32_t source=inEdge->node;
+      bool     searched=false;
+
+      if (!graph.core[source]) {
+        double maxCosts=-1.0;
+
+        for (EdgeList::const_iterator outEdge=outEdges.begin();
+             outEdge!=outEdges.end();
+             ++outEdge) {
+          if (outEdge->node!=source &&
+              !graph.core[outEdge->node]) {
+            maxCosts=std::max(maxCosts,inEdge->cost+outEdge->cost);
+          }
+        }
+
+        if (maxCosts>=0.0) {
+          SearchWitnesses(graph,
+                          source,
+                          node,
+                          maxCosts);
+          searched=true;
+        }
+      }
+
+      for (EdgeList::const_iterator outEdge=outEdges.begin();
+           outEdge!=outEdges.end();
+           ++outEdge) {
+        uint32_t target=outEdge->node;
+
+        if (target==source) {
+          continue;
+        }
+
+        double costs=inEdge->cost+outEdge->cost;
+
+        if (searched &&
+            !graph.core[target] &&
+            graph.witnessCosts[target]>=0.0 &&
+            graph.witnessCosts[target]<=costs) {
+          continue;
+        }
+
+        count++;
+
+        if (shortcuts!=NULL) {
+          Shortcut shortcut;
+
+          shortcut.source=source;
+          shortcut.target=target;
+          shortcut.edge.node=target;
+          shortcut.edge.middle=node;
+          shortcut.edge.sourcePath=inEdge->sourcePath;
+          shortcut.edge.targetObject=outEdge->targetObject;
+          shortcut.edge.cost=costs;
+          shortcut.edge.flags=outEdge->flags & ContractionHierarchy::noAccess;
+
+          shortcuts->push_back(shortcut);
+        }
+      }
+
+      if (searched) {
+        ClearWitnesses(graph);
+      }
+    }
+
+    return count;
+  }
+
+  /**
+   * The edge difference (shortcuts added minus edges removed) plus the
+   * number of already contracted neighbours, to contract evenly
+   * over the whole graph.
+   */
+  int RouteCHDataGenerator::GetPriority(Graph& graph,
+                                        uint32_t node)
+  {
+    return (int)GetShortcuts(graph,node,NULL)-
+           (int)(graph.inEdges[node].size()+graph.outEdges[node].size())+
+           (int)graph.contractedNeighbours[node];
+  }
+
+  void RouteCHDataGenerator::ContractNode(Graph& graph,
+                                          uint32_t node,
+                                          std::vector<Shortcut>& shortcuts,
+                                          std::vector<uint32_t>& neighbours)
+  {
+    EdgeList& upEdges=graph.upEdges[node];
+
+    shortcuts.clear();
+    neighbours.clear();
+
+    GetShortcuts(graph,
+                 node,
+                 &shortcuts);
+
+    for (EdgeList::const_iterator edge=graph.outEdges[node].begin();
+         edge!=graph.outEdges[node].end();
+         ++edge) {
+      upEdges.push_back(*edge);
+      upEdges.back().flags|=ContractionHierarchy::forward;
+
+      RemoveEdges(graph.inEdges[edge->node],node);
+      neighbours.push_back(edge->node);
+    }
+
+    for (EdgeList::const_iterator edge=graph.inEdges[node].begin();
+         edge!=graph.inEdges[node].end();
+         ++edge) {
+      upEdges.push_back(*edge);
+      upEdges.back().flags|=ContractionHierarchy::backward;
+
+      RemoveEdges(graph.outEdges[edge->node],node);
+      neighbours.push_back(edge->node);
+    }
+
+    EdgeList().swap(graph.outEdges[node]);
+    EdgeList().swap(graph.inEdges[node]);
+
+    graph.contracted[node]=true;
+
+    for (std::vector<Shortcut>::const_iterator shortcut=shortcuts.begin();
+         shortcut!=shortcuts.end();
+         ++shortcut) {
+      AddEdge(graph,
+              shortcut->source,
+              shortcut->target,
+              shortcut->edge);
+    }
+
+    std::sort(neighbours.begin(),neighbours.end());
+    neighbours.erase(std::unique(neighbours.begin(),neighbours.end()),
+                     neighbours.end());
+
+    for (std::vector<uint32_t>::const_iterator neighbour=neighbours.begin();
+         neighbour!=neighbours.end();
+         ++neighbour) {
+      graph.contractedNeighbours[*neighbour]++;
+    }
+  }
+
+  bool RouteCHDataGenerator::ContractGraph(Progress& progress,
+                                           Graph& graph)
+  {
+    IndexedHeap<int>      queue;
+    std::vector<Shortcut> shortcuts;
+    std::vector<uint32_t> neighbours;
+    size_t                nodeCount=0;
+    size_t                contractedCount=0;
+
+    progress.SetAction("Calculating initial node order");
+
+    for (uint32_t n=0; n<graph.core.size(); n++) {
+      progress.SetProgress(n,graph.core.size());
+
+      if (!graph.core[n]) {
+        queue.Push(n,GetPriority(graph,n));
+        nodeCount++;
+      }
+    }
+
+    progress.SetAction("Contracting nodes");
+
+    while (!queue.IsEmpty()) {
+      uint32_t node=queue.Pop();
+
+      // Priority might have changed since the last update (lazy update)
+      int priority=GetPriority(graph,node);
+
+      if (!queue.IsEmpty() &&
+          priority>queue.GetTopKey()) {
+        queue.Push(node,priority);
+        continue;
+      }
+
+      progress.SetProgress(contractedCount,nodeCount);
+
+      ContractNode(graph,
+                   node,
+                   shortcuts,
+                   neighbours);
+
+      contractedCount++;
+
+      for (std::vector<uint32_t>::const_iterator neighbour=neighbours.begin();
+           neighbour!=neighbours.end();
+           ++neighbour) {
+        if (queue.Contains(*neighbour)) {
+          queue.UpdateKey(*neighbour,GetPriority(graph,*neighbour));
+        }
+      }
+    }
+
+    return true;
+  }
+
+  bool RouteCHDataGenerator::Import(const ImportParameter& parameter,
+                                    Progress& progress,
+                                    const TypeConfig& typeConfig)
+  {
+    if (!parameter.GetRouteCH()) {
+      progress.Info("Generation of contraction hierarchy is disabled");
+      return true;
+    }
+
+    FastestPathRoutingProfile                         profile;
+    std::vector<FileOffset>                           offsets;
+    std::map<uint32_t,ContractionHierarchy::CoreNode> coreNodes;
+    Graph                                             graph;
+
+    if (!profile.ParametrizeForCar(typeConfig,
+                                   parameter.GetRouteCHCarSpeedTable(),
+                                   parameter.GetRouteCHCarMaxSpeed())) {
+      progress.Warning("Speed table is not complete, some ways will not be routable");
+    }
+
+    if (!ReadRouteGraph(parameter,
+                        progress,
+                        profile,
+                        offsets,
+                        coreNodes,
+                        graph)) {
+      return false;
+    }
+
+    if (!ContractGraph(progress,
+                       graph)) {
+      return false;
+    }
+
+    progress.SetAction("Writing contraction hierarchy");
+
+    ContractionHierarchy hierarchy;
+    EdgeList             edges;
+    size_t               shortcutCount=0;
+
+    hierarchy.SetProfileHash(profile.GetCostHash());
+
+    for (uint32_t n=0; n<offsets.size(); n++) {
+      edges.clear();
+
+      if (graph.contracted[n]) {
+        edges.swap(graph.upEdges[n]);
+      }
+      else {
+        // Core nodes keep all edges to other core nodes
+        for (EdgeList::const_iterator edge=graph.outEdges[n].begin();
+             edge!=graph.outEdges[n].end();
+             ++edge) {
+          edges.push_back(*edge);
+          edges.back().flags|=ContractionHierarchy::forward;
+        }
+
+        for (EdgeList::const_iterator edge=graph.inEdges[n].begin();
+             edge!=graph.inEdges[n].end();
+             ++edge) {
+          edges.push_back(*edge);
+          edges.back().flags|=ContractionHierarchy::backward;
+        }
+      }
+
+      for (EdgeList::const_iterator edge=edges.begin();
+           edge!=edges.end();
+           ++edge) {
+        if (edge->IsShortcut()) {
+          shortcutCount++;
+        }
+      }
+
+      hierarchy.AddNode(offsets[n],edges);
+    }
+
+    for (std::map<uint32_t,ContractionHierarchy::CoreNode>::const_iterator coreNode=coreNodes.begin();
+         coreNode!=coreNodes.end();
+         ++coreNode) {
+      hierarchy.SetCoreNode(coreNode->first,
+                            coreNode->second);
+    }
+
+    if (!hierarchy.Write(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                         Router::FILENAME_CAR_CH_DAT))) {
+      progress.Error(std::string("Cannot write '")+Router::FILENAME_CAR_CH_DAT+"'");
+      return false;
+    }
+
+    progress.Info(NumberToString(hierarchy.GetEdgeCount())+" edges, "+
+                  NumberToString(shortcutCount)+" shortcuts");
+
+    return true;
+  }
+}
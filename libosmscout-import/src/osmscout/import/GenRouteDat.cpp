@@ -22,11 +22,13 @@
 #include <algorithm>
 
 #include <osmscout/ObjectRef.h>
+#include <osmscout/RouteGraph.h>
 #include <osmscout/Router.h>
 
 #include <osmscout/system/Assert.h>
 #include <osmscout/system/Math.h>
 
+#include <osmscout/util/File.h>
 #include <osmscout/util/Geometry.h>
 #include <osmscout/util/StopClock.h>
 #include <osmscout/util/String.h>
@@ -113,6 +115,44 @@ namespace osmscout {
     return "Generate routing graphs";
   }
 
+  void RouteDataGenerator::GetInputFiles(const ImportParameter& parameter,
+                                         std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "turnrestr.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "ways.idmap"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "ways.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "areas.dat"));
+  }
+
+  void RouteDataGenerator::GetOutputFiles(const ImportParameter& parameter,
+                                          std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    Router::FILENAME_INTERSECTIONS_DAT));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    Router::FILENAME_FOOT_DAT));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    Router::FILENAME_FOOT_REV_DAT));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    Router::FILENAME_FOOT_GRAPH_DAT));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    Router::FILENAME_BICYCLE_DAT));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    Router::FILENAME_BICYCLE_REV_DAT));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    Router::FILENAME_BICYCLE_GRAPH_DAT));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    Router::FILENAME_CAR_DAT));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    Router::FILENAME_CAR_REV_DAT));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    Router::FILENAME_CAR_GRAPH_DAT));
+  }
+
   bool RouteDataGenerator::ReadTurnRestrictionWayIds(const ImportParameter& parameter,
                                                      Progress& progress,
                                                      std::map<Id,FileOffset>& wayIdOffsetMap)
@@ -1413,7 +1453,8 @@ namespace osmscout {
                                            const NodeIdObjectsMap& nodeObjectsMap,
                                            const ViaTurnRestrictionMap& restrictions,
                                            Vehicle vehicle,
-                                           const std::string& filename)
+                                           const std::string& filename,
+                                           std::vector<GeoCoord>& routeNodeCoords)
   {
     FileScanner                wayScanner;
     FileScanner                areaScanner;
@@ -1427,6 +1468,8 @@ namespace osmscout {
     NodeIdOffsetMap            routeNodeIdOffsetMap;
     PendingRouteNodeOffsetsMap pendingOffsetsMap;
 
+    routeNodeCoords.clear();
+
     //
     // Writing route nodes
     //
@@ -1586,6 +1629,53 @@ namespace osmscout {
           continue;
         }
 
+        //
+        // Remember the coordinates of the route node, they are not part of the
+        // route node itself but are required for the reverse route graph
+        //
+
+        GeoCoord coord;
+        bool     coordFound=false;
+
+        for (std::list<ObjectFileRef>::const_iterator ref=node->second.begin();
+            ref!=node->second.end() && !coordFound;
+            ref++) {
+          if (ref->GetType()==refWay) {
+            const WayRef& way=waysMap[ref->GetFileOffset()];
+
+            if (way.Invalid()) {
+              continue;
+            }
+
+            for (size_t i=0; i<way->ids.size(); i++) {
+              if (way->ids[i]==node->first) {
+                coord=way->nodes[i];
+                coordFound=true;
+                break;
+              }
+            }
+          }
+          else if (ref->GetType()==refArea) {
+            const AreaRef& area=areasMap[ref->GetFileOffset()];
+
+            if (area.Invalid()) {
+              continue;
+            }
+
+            for (size_t r=0; r<area->rings.size() && !coordFound; r++) {
+              for (size_t i=0; i<area->rings[r].ids.size(); i++) {
+                if (area->rings[r].ids[i]==node->first) {
+                  coord=area->rings[r].nodes[i];
+                  coordFound=true;
+                  break;
+                }
+              }
+            }
+          }
+        }
+
+        routeNodeCoords.push_back(coord);
+
         //
         // Calculate all outgoing paths
         //
@@ -1705,6 +1795,402 @@ namespace osmscout {
     return true;
   }
 
+  /**
+   * Writes the reverse routing graph. For each route node of the route graph
+   * a reverse route node with all paths leading to it is written, in the same
+   * order as the route nodes.
+   *
+   * Incoming paths are collected for a block of route nodes at a time by scanning
+   * the complete route graph. Since the file offsets of the reverse route nodes
+   * are not known before they are written, the graph is first written with
+   * placeholders to a temporary file and then copied to the final file
+   * with the file offsets resolved.
+   */
+  bool RouteDataGenerator::WriteReverseRouteGraph(const ImportParameter& parameter,
+                                                  Progress& progress,
+                                                  const std::vector<GeoCoord>& routeNodeCoords,
+                                                  const std::string& routeFilename,
+                                                  const std::string& reverseFilename)
+  {
+    std::string             tmpFilename=AppendFileToDir(parameter.GetDestinationDirectory(),
+                                                        reverseFilename+".tmp");
+    FileScanner             scanner;
+    FileWriter              writer;
+    uint32_t                routeNodeCount;
+    FileOffset              routeNodesStart;
+    std::vector<FileOffset> routeNodeOffsets;
+    std::vector<FileOffset> reverseNodeOffsets;
+    uint32_t                writtenPathCount=0;
+
+    if (!scanner.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                      routeFilename),
+                      FileScanner::Sequential,
+                      true)) {
+      progress.Error("Cannot open '"+scanner.GetFilename()+"'");
+      return false;
+    }
+
+    if (!scanner.Read(routeNodeCount) ||
+        !scanner.GetPos(routeNodesStart)) {
+      progress.Error("Error while reading route node count from '"+scanner.GetFilename()+"'");
+      return false;
+    }
+
+    if (routeNodeCount!=routeNodeCoords.size()) {
+      progress.Error("Number of route nodes and route node coordinates do not match (Internal error?)");
+      return false;
+    }
+
+    routeNodeOffsets.reserve(routeNodeCount);
+    reverseNodeOffsets.reserve(routeNodeCount);
+
+    // Route nodes are written in order, so the offsets are sorted
+    for (uint32_t r=0; r<routeNodeCount; r++) {
+      RouteNode routeNode;
+
+      if (!routeNode.Read(scanner)) {
+        progress.Error("Error while reading route node "+NumberToString(r)+" from '"+scanner.GetFilename()+"'");
+        return false;
+      }
+
+      routeNodeOffsets.push_back(routeNode.GetFileOffset());
+    }
+
+    //
+    // Writing reverse route nodes with placeholder offsets
+    //
+
+    if (!writer.Open(tmpFilename)) {
+      progress.Error("Cannot create '"+tmpFilename+"'");
+      return false;
+    }
+
+    writer.Write(routeNodeCount);
+
+    std::vector<ReverseRouteNode> block;
+
+    for (uint32_t blockStart=0;
+         blockStart<routeNodeCount;
+         blockStart+=(uint32_t)parameter.GetRouteNodeBlockSize()) {
+      uint32_t blockEnd=std::min(routeNodeCount,
+                                 blockStart+(uint32_t)parameter.GetRouteNodeBlockSize());
+
+      progress.Info("Collecting incoming paths of route nodes "+NumberToString(blockStart)+" - "+NumberToString(blockEnd));
+
+      block.clear();
+      block.resize(blockEnd-blockStart);
+
+      if (!scanner.SetPos(routeNodesStart)) {
+        progress.Error("Cannot rewind '"+scanner.GetFilename()+"'");
+        return false;
+      }
+
+      for (uint32_t r=0; r<routeNodeCount; r++) {
+        RouteNode routeNode;
+
+        if (!routeNode.Read(scanner)) {
+          progress.Error("Error while reading route node "+NumberToString(r)+" from '"+scanner.GetFilename()+"'");
+          return false;
+        }
+
+        if (r>=blockStart && r<blockEnd) {
+          ReverseRouteNode& reverseNode=block[r-blockStart];
+
+          reverseNode.id=routeNode.id;
+          reverseNode.routeNodeOffset=routeNode.GetFileOffset();
+          reverseNode.excludes=routeNode.excludes;
+        }
+
+        for (size_t p=0; p<routeNode.paths.size(); p++) {
+          const RouteNode::Path&                  path=routeNode.paths[p];
+          std::vector<FileOffset>::const_iterator target=std::lower_bound(routeNodeOffsets.begin(),
+                                                                           routeNodeOffsets.end(),
+                                                                           path.offset);
+
+          if (target==routeNodeOffsets.end() ||
+              *target!=path.offset) {
+            progress.Error("Cannot resolve target of path at route node "+NumberToString(routeNode.id)+" (Internal error?)");
+            continue;
+          }
+
+          uint32_t targetIndex=(uint32_t)(target-routeNodeOffsets.begin());
+
+          if (targetIndex<blockStart || targetIndex>=blockEnd) {
+            continue;
+          }
+
+          ReverseRouteNode&       reverseNode=block[targetIndex-blockStart];
+          ReverseRouteNode::Path  reversePath;
+
+          reversePath.offset=0;
+          reversePath.routeNodeOffset=routeNode.GetFileOffset();
+          reversePath.pathIndex=(uint32_t)p;
+          reversePath.objectIndex=reverseNode.AddObject(routeNode.objects[path.objectIndex]);
+          reversePath.type=path.type;
+          reversePath.maxSpeed=path.maxSpeed;
+          reversePath.grade=path.grade;
+          reversePath.flags=path.flags;
+          reversePath.distance=path.distance;
+          reversePath.lat=routeNodeCoords[r].GetLat();
+          reversePath.lon=routeNodeCoords[r].GetLon();
+
+          reverseNode.paths.push_back(reversePath);
+        }
+      }
+
+      for (size_t b=0; b<block.size(); b++) {
+        FileOffset reverseNodeOffset;
+
+        if (!writer.GetPos(reverseNodeOffset)) {
+          return false;
+        }
+
+        reverseNodeOffsets.push_back(reverseNodeOffset);
+
+        if (!block[b].Write(writer)) {
+          progress.Error(std::string("Error while writing reverse route node to file '")+
+                         writer.GetFilename()+"'");
+          return false;
+        }
+
+        writtenPathCount+=(uint32_t)block[b].paths.size();
+      }
+    }
+
+    block.clear();
+
+    if (!scanner.Close()) {
+      progress.Error("Cannot close file '"+scanner.GetFilename()+"'");
+      return false;
+    }
+
+    if (!writer.Close()) {
+      return false;
+    }
+
+    //
+    // Resolving offsets
+    //
+
+    progress.Info("Resolving file offsets");
+
+    if (!scanner.Open(tmpFilename,
+                      FileScanner::Sequential,
+                      true)) {
+      progress.Error("Cannot open '"+scanner.GetFilename()+"'");
+      return false;
+    }
+
+    if (!writer.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                     reverseFilename))) {
+      progress.Error("Cannot create '"+reverseFilename+"'");
+      return false;
+    }
+
+    scanner.Read(routeNodeCount);
+    writer.Write(routeNodeCount);
+
+    for (uint32_t r=0; r<routeNodeCount; r++) {
+      ReverseRouteNode reverseNode;
+
+      if (!reverseNode.Read(scanner)) {
+        progress.Error("Error while reading reverse route node "+NumberToString(r)+" from '"+scanner.GetFilename()+"'");
+        return false;
+      }
+
+      for (size_t p=0; p<reverseNode.paths.size(); p++) {
+        size_t source=std::lower_bound(routeNodeOffsets.begin(),
+                                       routeNodeOffsets.end(),
+                                       reverseNode.paths[p].routeNodeOffset)-routeNodeOffsets.begin();
+
+        reverseNode.paths[p].offset=reverseNodeOffsets[source];
+      }
+
+      if (!reverseNode.Write(writer)) {
+        progress.Error(std::string("Error while writing reverse route node to file '")+
+                       writer.GetFilename()+"'");
+        return false;
+      }
+    }
+
+    if (!scanner.Close()) {
+      progress.Error("Cannot close file '"+scanner.GetFilename()+"'");
+      return false;
+    }
+
+    if (!writer.Close()) {
+      return false;
+    }
+
+    if (!RemoveFile(tmpFilename)) {
+      progress.Warning("Cannot delete temporary file '"+tmpFilename+"'");
+    }
+
+    progress.Info(NumberToString(routeNodeCount) + " reverse route node(s) and " + NumberToString(writtenPathCount)+ " paths written");
+
+    return true;
+  }
+
+  bool RouteDataGenerator::WriteCompactRouteGraph(const ImportParameter& parameter,
+                                                  Progress& progress,
+                                                  const std::vector<GeoCoord>& routeNodeCoords,
+                                                  const std::string& routeFilename,
+                                                  const std::string& graphFilename)
+  {
+    FileScanner                      scanner;
+    uint32_t                         routeNodeCount;
+    FileOffset                       routeNodesStart;
+    std::vector<FileOffset>          routeNodeOffsets;
+    std::vector<ObjectFileRef>       objects;
+    std::vector<uint32_t>            latValues;
+    std::vector<uint32_t>            lonValues;
+    std::vector<RouteGraph::Edge>    edges;
+    std::vector<RouteGraph::Exclude> excludes;
+    RouteGraph                       graph;
+
+    if (!scanner.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                      routeFilename),
+                      FileScanner::Sequential,
+                      true)) {
+      progress.Error("Cannot open '"+scanner.GetFilename()+"'");
+      return false;
+    }
+
+    if (!scanner.Read(routeNodeCount) ||
+        !scanner.GetPos(routeNodesStart)) {
+      progress.Error("Error while reading route node count from '"+scanner.GetFilename()+"'");
+      return false;
+    }
+
+    if (routeNodeCount!=routeNodeCoords.size()) {
+      progress.Error("Number of route nodes and route node coordinates do not match (Internal error?)");
+      return false;
+    }
+
+    progress.Info("Collecting route nodes and objects");
+
+    routeNodeOffsets.reserve(routeNodeCount);
+
+    // Route nodes are written in order, so the offsets are sorted
+    for (uint32_t r=0; r<routeNodeCount; r++) {
+      RouteNode routeNode;
+
+      if (!routeNode.Read(scanner)) {
+        progress.Error("Error while reading route node "+NumberToString(r)+" from '"+scanner.GetFilename()+"'");
+        return false;
+      }
+
+      routeNodeOffsets.push_back(routeNode.GetFileOffset());
+
+      objects.insert(objects.end(),
+                     routeNode.objects.begin(),
+                     routeNode.objects.end());
+
+      for (size_t e=0; e<routeNode.excludes.size(); e++) {
+        objects.push_back(routeNode.excludes[e].source);
+      }
+    }
+
+    std::sort(objects.begin(),objects.end());
+    objects.erase(std::unique(objects.begin(),objects.end()),objects.end());
+
+    graph.SetObjects(objects);
+
+    // Coordinates of nodes are taken from the paths leading to them (so that
+    // they are identical to the coordinates the router uses on the route nodes),
+    // the route node coordinates are only used for nodes without such a path
+    latValues.resize(routeNodeCount);
+    lonValues.resize(routeNodeCount);
+
+    for (uint32_t r=0; r<routeNodeCount; r++) {
+      latValues[r]=(uint32_t)floor((routeNodeCoords[r].GetLat()+90.0)*conversionFactor+0.5);
+      lonValues[r]=(uint32_t)floor((routeNodeCoords[r].GetLon()+180.0)*conversionFactor+0.5);
+    }
+
+    progress.Info("Collecting paths");
+
+    // Without route nodes the scanner is already at the end of the file
+    // (where rewinding a memory mapped file fails) and there are no paths,
+    // but an empty graph is written nevertheless
+    if (routeNodeCount>0 &&
+        !scanner.SetPos(routeNodesStart)) {
+      progress.Error("Cannot rewind '"+scanner.GetFilename()+"'");
+      return false;
+    }
+
+    for (uint32_t r=0; r<routeNodeCount; r++) {
+      RouteNode routeNode;
+
+      if (!routeNode.Read(scanner)) {
+        progress.Error("Error while reading route node "+NumberToString(r)+" from '"+scanner.GetFilename()+"'");
+        return false;
+      }
+
+      edges.resize(routeNode.paths.size());
+
+      for (size_t p=0; p<routeNode.paths.size(); p++) {
+        const RouteNode::Path&                  path=routeNode.paths[p];
+        std::vector<FileOffset>::const_iterator target=std::lower_bound(routeNodeOffsets.begin(),
+                                                                         routeNodeOffsets.end(),
+                                                                         path.offset);
+
+        if (target==routeNodeOffsets.end() ||
+            *target!=path.offset) {
+          progress.Error("Cannot resolve target of path at route node "+NumberToString(routeNode.id)+" (Internal error?)");
+          return false;
+        }
+
+        uint32_t targetIndex=(uint32_t)(target-routeNodeOffsets.begin());
+
+        edges[p].target=targetIndex;
+        edges[p].object=(uint32_t)(std::lower_bound(objects.begin(),
+                                                    objects.end(),
+                                                    routeNode.objects[path.objectIndex])-objects.begin());
+        edges[p].distance=(uint32_t)floor(path.distance*(1000.0*100.0)+0.5);
+        edges[p].type=path.type;
+        edges[p].maxSpeed=path.maxSpeed;
+        edges[p].flags=path.flags;
+
+        latValues[targetIndex]=(uint32_t)floor((path.lat+90.0)*conversionFactor+0.5);
+        lonValues[targetIndex]=(uint32_t)floor((path.lon+180.0)*conversionFactor+0.5);
+      }
+
+      excludes.resize(routeNode.excludes.size());
+
+      for (size_t e=0; e<routeNode.excludes.size(); e++) {
+        excludes[e].sourceObject=(uint32_t)(std::lower_bound(objects.begin(),
+                                                             objects.end(),
+                                                             routeNode.excludes[e].source)-objects.begin());
+        excludes[e].targetPath=routeNode.excludes[e].targetIndex;
+      }
+
+      graph.AddNode(routeNode.GetFileOffset(),
+                    edges,
+                    excludes);
+    }
+
+    if (!scanner.Close()) {
+      progress.Error("Cannot close file '"+scanner.GetFilename()+"'");
+      return false;
+    }
+
+    for (uint32_t r=0; r<routeNodeCount; r++) {
+      graph.SetCoord(r,
+                     latValues[r],
+                     lonValues[r]);
+    }
+
+    if (!graph.Write(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                     graphFilename))) {
+      progress.Error("Cannot write '"+graphFilename+"'");
+      return false;
+    }
+
+    progress.Info(NumberToString(routeNodeCount) + " node(s) and " + NumberToString(graph.GetEdgeCount())+ " paths written");
+
+    return true;
+  }
+
   bool RouteDataGenerator::Import(const ImportParameter& parameter,
                                   Progress& progress,
                                   const TypeConfig& typeConfig)
@@ -1715,6 +2201,9 @@ namespace osmscout {
     NodeUseMap            nodeUseMap;
     NodeIdObjectsMap      nodeObjectsMap;
 
+    // Coordinates of the route nodes of the last route graph written
+    std::vector<GeoCoord> routeNodeCoords;
+
     //
     // Handling of restriction relations
     //
@@ -1787,7 +2276,28 @@ namespace osmscout {
                     nodeObjectsMap,
                     restrictions,
                     vehicleFoot,
-                    Router::FILENAME_FOOT_DAT);
+                    Router::FILENAME_FOOT_DAT,
+                    routeNodeCoords);
+
+    progress.SetAction(std::string("Writing reverse route graph '")+Router::FILENAME_FOOT_REV_DAT+"'");
+
+    if (!WriteReverseRouteGraph(parameter,
+                                progress,
+                                routeNodeCoords,
+                                Router::FILENAME_FOOT_DAT,
+                                Router::FILENAME_FOOT_REV_DAT)) {
+      return false;
+    }
+
+    progress.SetAction(std::string("Writing compact route graph '")+Router::FILENAME_FOOT_GRAPH_DAT+"'");
+
+    if (!WriteCompactRouteGraph(parameter,
+                                progress,
+                                routeNodeCoords,
+                                Router::FILENAME_FOOT_DAT,
+                                Router::FILENAME_FOOT_GRAPH_DAT)) {
+      return false;
+    }
 
     progress.SetAction(std::string("Writing route graph '")+Router::FILENAME_BICYCLE_DAT+"'");
 
@@ -1798,7 +2308,28 @@ namespace osmscout {
                     nodeObjectsMap,
                     restrictions,
                     vehicleBicycle,
-                    Router::FILENAME_BICYCLE_DAT);
+                    Router::FILENAME_BICYCLE_DAT,
+                    routeNodeCoords);
+
+    progress.SetAction(std::string("Writing reverse route graph '")+Router::FILENAME_BICYCLE_REV_DAT+"'");
+
+    if (!WriteReverseRouteGraph(parameter,
+                                progress,
+                                routeNodeCoords,
+                                Router::FILENAME_BICYCLE_DAT,
+                                Router::FILENAME_BICYCLE_REV_DAT)) {
+      return false;
+    }
+
+    progress.SetAction(std::string("Writing compact route graph '")+Router::FILENAME_BICYCLE_GRAPH_DAT+"'");
+
+    if (!WriteCompactRouteGraph(parameter,
+                                progress,
+                                routeNodeCoords,
+                                Router::FILENAME_BICYCLE_DAT,
+                                Router::FILENAME_BICYCLE_GRAPH_DAT)) {
+      return false;
+    }
 
     progress.SetAction(std::string("Writing route graph '")+Router::FILENAME_CAR_DAT+"'");
 
@@ -1809,12 +2340,34 @@ namespace osmscout {
                     nodeObjectsMap,
                     restrictions,
                     vehicleCar,
-                    Router::FILENAME_CAR_DAT);
+                    Router::FILENAME_CAR_DAT,
+                    routeNodeCoords);
+
+    progress.SetAction(std::string("Writing reverse route graph '")+Router::FILENAME_CAR_REV_DAT+"'");
+
+    if (!WriteReverseRouteGraph(parameter,
+                                progress,
+                                routeNodeCoords,
+                                Router::FILENAME_CAR_DAT,
+                                Router::FILENAME_CAR_REV_DAT)) {
+      return false;
+    }
+
+    progress.SetAction(std::string("Writing compact route graph '")+Router::FILENAME_CAR_GRAPH_DAT+"'");
+
+    if (!WriteCompactRouteGraph(parameter,
+                                progress,
+                                routeNodeCoords,
+                                Router::FILENAME_CAR_DAT,
+                                Router::FILENAME_CAR_GRAPH_DAT)) {
+      return false;
+    }
 
     // Cleaning up...
 
     nodeObjectsMap.clear();
     restrictions.clear();
+    routeNodeCoords.clear();
 
     return true;
   }
@@ -44,6 +44,30 @@ namespace osmscout
     return "Generate text data files 'text(poi,loc,region,other).dat'";
   }
 
+  void TextIndexGenerator::GetInputFiles(const ImportParameter& parameter,
+                                         std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "nodes.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "ways.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "areas.dat"));
+  }
+
+  void TextIndexGenerator::GetOutputFiles(const ImportParameter& parameter,
+                                          std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "textpoi.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "textloc.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "textregion.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "textother.dat"));
+  }
+
 
   bool TextIndexGenerator::Import(const ImportParameter &parameter,
                                   Progress &progress,
@@ -35,6 +35,20 @@ namespace osmscout {
     return "Generate 'rawturnrestr.dat'";
   }
 
+  void TurnRestrictionDataGenerator::GetInputFiles(const ImportParameter& parameter,
+                                                   std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "rawrels.dat"));
+  }
+
+  void TurnRestrictionDataGenerator::GetOutputFiles(const ImportParameter& parameter,
+                                                    std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "rawturnrestr.dat"));
+  }
+
   bool TurnRestrictionDataGenerator::Import(const ImportParameter& parameter,
                                             Progress& progress,
                                             const TypeConfig& typeConfig)
@@ -30,6 +30,13 @@ namespace osmscout {
     return "Generate 'types.dat'";
   }
 
+  void TypeDataGenerator::GetOutputFiles(const ImportParameter& parameter,
+                                         std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "types.dat"));
+  }
+
   bool TypeDataGenerator::Import(const ImportParameter& parameter,
                                 Progress& progress,
                                 const TypeConfig& typeConfig)
@@ -19,6 +19,7 @@
 
 #include <osmscout/import/GenWaterIndex.h>
 
+#include <algorithm>
 #include <vector>
 #include <iostream>
 #include <iomanip>
@@ -176,7 +177,7 @@ namespace osmscout {
       return false;
     }
 
-    std::set<OSMId> nodeIds;
+    std::vector<OSMId> nodeIds;
 
     for (std::list<RawCoastlineRef>::const_iterator c=rawCoastlines.begin();
          c!=rawCoastlines.end();
@@ -184,10 +185,14 @@ namespace osmscout {
       RawCoastlineRef coastline(*c);
 
       for (size_t n=0; n<coastline->GetNodeCount(); n++) {
-        nodeIds.insert(coastline->GetNodeId(n));
+        nodeIds.push_back(coastline->GetNodeId(n));
       }
     }
 
+    std::sort(nodeIds.begin(),nodeIds.end());
+    nodeIds.erase(std::unique(nodeIds.begin(),nodeIds.end()),
+                  nodeIds.end());
+
     CoordDataFile::CoordResultMap coordsMap;
 
     if (!coordDataFile.Get(nodeIds,
@@ -1640,6 +1645,26 @@ namespace osmscout {
     return "Generate 'water.idx'";
   }
 
+  void WaterIndexGenerator::GetInputFiles(const ImportParameter& parameter,
+                                          std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "rawcoastline.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "coord.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "ways.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "bounding.dat"));
+  }
+
+  void WaterIndexGenerator::GetOutputFiles(const ImportParameter& parameter,
+                                           std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "water.idx"));
+  }
+
   bool WaterIndexGenerator::Import(const ImportParameter& parameter,
                                    Progress& progress,
                                    const TypeConfig& typeConfig)
@@ -60,6 +60,24 @@ namespace osmscout {
     return "Generate 'wayarea.tmp'";
   }
 
+  void WayAreaDataGenerator::GetInputFiles(const ImportParameter& parameter,
+                                           std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "wayareablack.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "coord.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "rawways.dat"));
+  }
+
+  void WayAreaDataGenerator::GetOutputFiles(const ImportParameter& parameter,
+                                            std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "wayarea.tmp"));
+  }
+
   bool WayAreaDataGenerator::ReadWayBlacklist(const ImportParameter& parameter,
                                               Progress& progress,
                                               BlacklistSet& wayBlacklist)
@@ -330,13 +348,19 @@ namespace osmscout {
 
       collectedWaysCount++;
 
-      std::set<OSMId>               nodeIds;
+      std::vector<OSMId>            nodeIds;
       CoordDataFile::CoordResultMap coordsMap;
 
+      nodeIds.reserve(way->GetNodeCount());
+
       for (size_t n=0; n<way->GetNodeCount(); n++) {
-        nodeIds.insert(way->GetNodeId(n));
+        nodeIds.push_back(way->GetNodeId(n));
       }
 
+      std::sort(nodeIds.begin(),nodeIds.end());
+      nodeIds.erase(std::unique(nodeIds.begin(),nodeIds.end()),
+                    nodeIds.end());
+
       if (!coordDataFile.Get(nodeIds,coordsMap)) {
         std::cerr << "Cannot read nodes!" << std::endl;
         return false;
@@ -445,7 +469,7 @@ namespace osmscout {
 
       progress.SetAction("Collecting node ids");
 
-      std::set<OSMId>               nodeIds;
+      std::vector<OSMId>            nodeIds;
       CoordDataFile::CoordResultMap coordsMap;
 
       for (size_t type=0; type<areasByType.size(); type++) {
@@ -455,11 +479,15 @@ namespace osmscout {
           RawWayRef areas(*w);
 
           for (size_t n=0; n<areas->GetNodeCount(); n++) {
-            nodeIds.insert(areas->GetNodeId(n));
+            nodeIds.push_back(areas->GetNodeId(n));
           }
         }
       }
 
+      std::sort(nodeIds.begin(),nodeIds.end());
+      nodeIds.erase(std::unique(nodeIds.begin(),nodeIds.end()),
+                    nodeIds.end());
+
       if (!nodeIds.empty()) {
         progress.SetAction("Loading "+NumberToString(nodeIds.size())+" nodes");
         if (!coordDataFile.Get(nodeIds,coordsMap)) {
@@ -66,6 +66,26 @@ namespace osmscout {
     return "Generate 'wayway.tmp'";
   }
 
+  void WayWayDataGenerator::GetInputFiles(const ImportParameter& parameter,
+                                          std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "rawturnrestr.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "coord.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "rawways.dat"));
+  }
+
+  void WayWayDataGenerator::GetOutputFiles(const ImportParameter& parameter,
+                                           std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "turnrestr.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "wayway.tmp"));
+  }
+
   bool WayWayDataGenerator::ReadTurnRestrictions(const ImportParameter& parameter,
                                                  Progress& progress,
                                                  std::multimap<OSMId,TurnRestrictionRef>& restrictions)
@@ -615,7 +635,7 @@ namespace osmscout {
 
       progress.SetAction("Collecting node ids");
 
-      std::set<OSMId>               nodeIds;
+      std::vector<OSMId>            nodeIds;
       CoordDataFile::CoordResultMap coordsMap;
 
       for (size_t type=0; type<waysByType.size(); type++) {
@@ -625,11 +645,15 @@ namespace osmscout {
           RawWayRef way(*w);
 
           for (size_t n=0; n<way->GetNodeCount(); n++) {
-            nodeIds.insert(way->GetNodeId(n));
+            nodeIds.push_back(way->GetNodeId(n));
           }
         }
       }
 
+      std::sort(nodeIds.begin(),nodeIds.end());
+      nodeIds.erase(std::unique(nodeIds.begin(),nodeIds.end()),
+                    nodeIds.end());
+
       progress.SetAction("Loading "+NumberToString(nodeIds.size())+" nodes");
       if (!coordDataFile.Get(nodeIds,coordsMap)) {
         std::cerr << "Cannot read nodes!" << std::endl;
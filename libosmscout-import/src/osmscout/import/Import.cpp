@@ -19,7 +19,16 @@
 
 #include <osmscout/import/Import.h>
 
+#include <algorithm>
 #include <iostream>
+#include <vector>
+
+#include <osmscout/CoreFeatures.h>
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+#include <condition_variable>
+#include <mutex>
+#endif
 
 #include <osmscout/TypeConfigLoader.h>
 #include <osmscout/Types.h>
@@ -31,6 +40,7 @@
 
 #include <osmscout/Router.h>
 #include <osmscout/RouteNode.h>
+#include <osmscout/ReverseRouteNode.h>
 #include <osmscout/Intersection.h>
 
 #include <osmscout/import/GenTypeDat.h>
@@ -64,6 +74,7 @@
 
 // Routing
 #include <osmscout/import/GenRouteDat.h>
+#include <osmscout/import/GenRouteCHDat.h>
 
 #if defined(OSMSCOUT_IMPORT_HAVE_LIB_MARISA)
 #include <osmscout/import/GenTextIndex.h>
@@ -71,26 +82,31 @@
 
 #include <osmscout/util/Progress.h>
 #include <osmscout/util/StopClock.h>
+#include <osmscout/util/ThreadPool.h>
 
 namespace osmscout {
 
   static const size_t defaultStartStep=1;
 #if defined(OSMSCOUT_IMPORT_HAVE_LIB_MARISA)
-  static const size_t defaultEndStep=27;
+  static const size_t defaultEndStep=31;
 #else
-  static const size_t defaultEndStep=26;
+  static const size_t defaultEndStep=30;
 #endif
 
   ImportParameter::ImportParameter()
    : typefile("map.ost"),
      startStep(defaultStartStep),
      endStep(defaultEndStep),
+     moduleWorkerCount(1),
      strictAreas(false),
      sortObjects(true),
      sortBlockSize(40000000),
+     sortMemoryBudget(512*1024*1024),
      sortTileMag(13),
+     sortOrder(sortOrderCell),
      numericIndexPageSize(4096),
      coordDataMemoryMaped(false),
+     coordDataLayout(CoordDataFile::layoutSparse),
      rawNodeDataMemoryMaped(false),
      rawNodeDataCacheSize(10000),
      rawWayIndexMemoryMaped(true),
@@ -120,9 +136,28 @@ namespace osmscout {
      optimizationCellSizeMax(255),
      optimizationWayMethod(TransPolygon::quality),
      routeNodeBlockSize(500000),
+     routeCH(false),
+     routeCHCarMaxSpeed(160.0),
      assumeLand(true)
   {
-    // no code
+    routeCHCarSpeedTable["highway_motorway"]=110.0;
+    routeCHCarSpeedTable["highway_motorway_trunk"]=100.0;
+    routeCHCarSpeedTable["highway_motorway_primary"]=70.0;
+    routeCHCarSpeedTable["highway_motorway_link"]=60.0;
+    routeCHCarSpeedTable["highway_motorway_junction"]=60.0;
+    routeCHCarSpeedTable["highway_trunk"]=100.0;
+    routeCHCarSpeedTable["highway_trunk_link"]=60.0;
+    routeCHCarSpeedTable["highway_primary"]=70.0;
+    routeCHCarSpeedTable["highway_primary_link"]=60.0;
+    routeCHCarSpeedTable["highway_secondary"]=60.0;
+    routeCHCarSpeedTable["highway_secondary_link"]=50.0;
+    routeCHCarSpeedTable["highway_tertiary"]=55.0;
+    routeCHCarSpeedTable["highway_unclassified"]=50.0;
+    routeCHCarSpeedTable["highway_road"]=50.0;
+    routeCHCarSpeedTable["highway_residential"]=40.0;
+    routeCHCarSpeedTable["highway_roundabout"]=40.0;
+    routeCHCarSpeedTable["highway_living_street"]=10.0;
+    routeCHCarSpeedTable["highway_service"]=30.0;
   }
 
   std::string ImportParameter::GetMapfile() const
@@ -150,6 +185,11 @@ namespace osmscout {
     return endStep;
   }
 
+  size_t ImportParameter::GetModuleWorkerCount() const
+  {
+    return moduleWorkerCount;
+  }
+
   bool ImportParameter::GetStrictAreas() const
   {
     return strictAreas;
@@ -165,11 +205,21 @@ namespace osmscout {
     return sortBlockSize;
   }
 
+  size_t ImportParameter::GetSortMemoryBudget() const
+  {
+    return sortMemoryBudget;
+  }
+
   size_t ImportParameter::GetSortTileMag() const
   {
     return sortTileMag;
   }
 
+  ImportParameter::SortOrder ImportParameter::GetSortOrder() const
+  {
+    return sortOrder;
+  }
+
   size_t ImportParameter::GetNumericIndexPageSize() const
   {
     return numericIndexPageSize;
@@ -180,6 +230,11 @@ namespace osmscout {
     return coordDataMemoryMaped;
   }
 
+  CoordDataFile::Layout ImportParameter::GetCoordDataLayout() const
+  {
+    return coordDataLayout;
+  }
+
   bool ImportParameter::GetRawNodeDataMemoryMaped() const
   {
     return rawNodeDataMemoryMaped;
@@ -325,6 +380,21 @@ namespace osmscout {
     return routeNodeBlockSize;
   }
 
+  bool ImportParameter::GetRouteCH() const
+  {
+    return routeCH;
+  }
+
+  const std::map<std::string,double>& ImportParameter::GetRouteCHCarSpeedTable() const
+  {
+    return routeCHCarSpeedTable;
+  }
+
+  double ImportParameter::GetRouteCHCarMaxSpeed() const
+  {
+    return routeCHCarMaxSpeed;
+  }
+
   bool ImportParameter::GetAssumeLand() const
   {
     return assumeLand;
@@ -357,6 +427,21 @@ namespace osmscout {
     this->endStep=endStep;
   }
 
+  /**
+    Set the maximum number of import steps executed in parallel. Only steps that
+    do not depend on the files of each other are executed in parallel, so the
+    result of the import does not depend on this value. Note that each parallel
+    step allocates its own caches and buffers, so the memory requirements of the
+    import grow with the number of workers.
+
+    Default is 1 (all steps are executed sequentially), 0 means as many workers
+    as there are cores.
+    */
+  void ImportParameter::SetModuleWorkerCount(size_t moduleWorkerCount)
+  {
+    this->moduleWorkerCount=moduleWorkerCount;
+  }
+
   void ImportParameter::SetStrictAreas(bool strictAreas)
   {
     this->strictAreas=strictAreas;
@@ -372,11 +457,21 @@ namespace osmscout {
     this->sortBlockSize=sortBlockSize;
   }
 
+  void ImportParameter::SetSortMemoryBudget(size_t sortMemoryBudget)
+  {
+    this->sortMemoryBudget=sortMemoryBudget;
+  }
+
   void ImportParameter::SetSortTileMag(size_t sortTileMag)
   {
     this->sortTileMag=sortTileMag;
   }
 
+  void ImportParameter::SetSortOrder(SortOrder sortOrder)
+  {
+    this->sortOrder=sortOrder;
+  }
+
   void ImportParameter::SetNumericIndexPageSize(size_t numericIndexPageSize)
   {
     this->numericIndexPageSize=numericIndexPageSize;
@@ -387,6 +482,11 @@ namespace osmscout {
     this->coordDataMemoryMaped=memoryMaped;
   }
 
+  void ImportParameter::SetCoordDataLayout(CoordDataFile::Layout layout)
+  {
+    this->coordDataLayout=layout;
+  }
+
   void ImportParameter::SetRawNodeDataMemoryMaped(bool memoryMaped)
   {
     this->rawNodeDataMemoryMaped=memoryMaped;
@@ -535,6 +635,21 @@ namespace osmscout {
     this->routeNodeBlockSize=blockSize;
   }
 
+  void ImportParameter::SetRouteCH(bool routeCH)
+  {
+    this->routeCH=routeCH;
+  }
+
+  void ImportParameter::SetRouteCHCarSpeedTable(const std::map<std::string,double>& speedTable)
+  {
+    this->routeCHCarSpeedTable=speedTable;
+  }
+
+  void ImportParameter::SetRouteCHCarMaxSpeed(double maxSpeed)
+  {
+    this->routeCHCarMaxSpeed=maxSpeed;
+  }
+
   void ImportParameter::SetAssumeLand(bool assumeLand)
   {
     this->assumeLand=assumeLand;
@@ -545,13 +660,24 @@ namespace osmscout {
     // no code
   }
 
-  static bool ExecuteModules(std::list<ImportModule*>& modules,
-                            const ImportParameter& parameter,
-                            Progress& progress,
-                            const TypeConfig& typeConfig)
+  void ImportModule::GetInputFiles(const ImportParameter& /*parameter*/,
+                                   std::list<std::string>& /*files*/) const
   {
-    StopClock overAllTimer;
-    size_t    currentStep=1;
+    // no code
+  }
+
+  void ImportModule::GetOutputFiles(const ImportParameter& /*parameter*/,
+                                    std::list<std::string>& /*files*/) const
+  {
+    // no code
+  }
+
+  static bool ExecuteModulesSequential(std::list<ImportModule*>& modules,
+                                       const ImportParameter& parameter,
+                                       Progress& progress,
+                                       const TypeConfig& typeConfig)
+  {
+    size_t currentStep=1;
 
     for (std::list<ImportModule*>::const_iterator module=modules.begin();
          module!=modules.end();
@@ -581,6 +707,299 @@ namespace osmscout {
       currentStep++;
     }
 
+    return true;
+  }
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+  /**
+    Progress of a step executed in parallel to other steps. Prefixes all
+    messages with the number of the step, so that the interleaved output of
+    the steps can be told apart.
+    */
+  class StepProgress : public Progress
+  {
+  private:
+    Progress&   progress;
+    std::string prefix;
+
+  public:
+    StepProgress(Progress& progress,
+                 size_t step)
+    : progress(progress),
+      prefix(std::string("#")+NumberToString(step)+" ")
+    {
+      SetOutputDebug(progress.OutputDebug());
+    }
+
+    void SetStep(const std::string& step)
+    {
+      progress.SetStep(step);
+    }
+
+    void SetAction(const std::string& action)
+    {
+      progress.SetAction(prefix+action);
+    }
+
+    void SetProgress(double current, double total)
+    {
+      progress.SetProgress(current,total);
+    }
+
+    void Debug(const std::string& text)
+    {
+      progress.Debug(prefix+text);
+    }
+
+    void Info(const std::string& text)
+    {
+      progress.Info(prefix+text);
+    }
+
+    void Warning(const std::string& text)
+    {
+      progress.Warning(prefix+text);
+    }
+
+    void Error(const std::string& text)
+    {
+      progress.Error(prefix+text);
+    }
+  };
+
+  static bool HaveCommonFile(const std::list<std::string>& a,
+                             const std::list<std::string>& b)
+  {
+    for (std::list<std::string>::const_iterator file=a.begin();
+         file!=a.end();
+         ++file) {
+      if (std::find(b.begin(),b.end(),*file)!=b.end()) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /**
+    Executes the steps of the import on a ThreadPool. Each task executes the
+    first step that was not yet started and whose dependencies have all
+    finished, waiting for running steps to finish if there is no such step.
+
+    A step depends on an earlier step, if it reads a file the earlier step
+    writes or if it writes a file the earlier step reads or writes. Steps
+    that do not declare their output files depend on all earlier steps and
+    all later steps depend on them.
+    */
+  class ModuleScheduler : public ParallelJob
+  {
+  private:
+    struct Step
+    {
+      ImportModule           *module;
+      size_t                 number;       //! Number of the step
+      std::list<std::string> inputFiles;   //! Files read by the step
+      std::list<std::string> outputFiles;  //! Files written by the step
+      std::vector<size_t>    dependencies; //! Indexes of the steps that must be finished first
+      bool                   started;
+      bool                   finished;
+    };
+
+  private:
+    const ImportParameter&  parameter;
+    Progress&               progress;
+    const TypeConfig&       typeConfig;
+    std::vector<Step>       steps;
+    std::mutex              mutex;
+    std::condition_variable finishedCondition; //! Signaled if a step has finished
+    bool                    failed;
+
+  private:
+    size_t GetNextStep() const
+    {
+      for (size_t s=0; s<steps.size(); s++) {
+        if (steps[s].started) {
+          continue;
+        }
+
+        bool ready=true;
+
+        for (std::vector<size_t>::const_iterator dependency=steps[s].dependencies.begin();
+             dependency!=steps[s].dependencies.end();
+             ++dependency) {
+          if (!steps[*dependency].finished) {
+            ready=false;
+            break;
+          }
+        }
+
+        if (ready) {
+          return s;
+        }
+      }
+
+      return steps.size();
+    }
+
+  public:
+    ModuleScheduler(const ImportParameter& parameter,
+                    Progress& progress,
+                    const TypeConfig& typeConfig)
+    : parameter(parameter),
+      progress(progress),
+      typeConfig(typeConfig),
+      failed(false)
+    {
+      // no code
+    }
+
+    void AddStep(ImportModule* module,
+                 size_t number)
+    {
+      Step step;
+
+      step.module=module;
+      step.number=number;
+      step.started=false;
+      step.finished=false;
+
+      module->GetInputFiles(parameter,step.inputFiles);
+      module->GetOutputFiles(parameter,step.outputFiles);
+
+      for (size_t s=0; s<steps.size(); s++) {
+        if (step.outputFiles.empty() ||
+            steps[s].outputFiles.empty() ||
+            HaveCommonFile(steps[s].outputFiles,step.inputFiles) ||
+            HaveCommonFile(steps[s].outputFiles,step.outputFiles) ||
+            HaveCommonFile(steps[s].inputFiles,step.outputFiles)) {
+          step.dependencies.push_back(s);
+        }
+      }
+
+      steps.push_back(step);
+    }
+
+    size_t GetStepCount() const
+    {
+      return steps.size();
+    }
+
+    bool HasFailed() const
+    {
+      return failed;
+    }
+
+    void Execute(size_t /*task*/,
+                 size_t /*worker*/)
+    {
+      size_t s;
+
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (true) {
+          if (failed) {
+            return;
+          }
+
+          s=GetNextStep();
+
+          if (s<steps.size()) {
+            break;
+          }
+
+          // The first step not yet started waits for a running step
+          finishedCondition.wait(lock);
+        }
+
+        steps[s].started=true;
+      }
+
+      StepProgress stepProgress(progress,steps[s].number);
+      StopClock    timer;
+      bool         success;
+
+      stepProgress.SetStep(std::string("Step #")+
+                           NumberToString(steps[s].number)+
+                           " - "+
+                           steps[s].module->GetDescription());
+
+      success=steps[s].module->Import(parameter,stepProgress,typeConfig);
+
+      timer.Stop();
+
+      stepProgress.Info(std::string("=> ")+timer.ResultString()+" second(s)");
+
+      if (!success) {
+        stepProgress.Error(std::string("Error while executing step '")+steps[s].module->GetDescription()+"'!");
+      }
+
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        steps[s].finished=true;
+
+        if (!success) {
+          failed=true;
+        }
+      }
+
+      finishedCondition.notify_all();
+    }
+  };
+
+  static bool ExecuteModulesParallel(std::list<ImportModule*>& modules,
+                                     const ImportParameter& parameter,
+                                     Progress& progress,
+                                     const TypeConfig& typeConfig)
+  {
+    ThreadSafeProgress threadSafeProgress(progress);
+    ModuleScheduler    scheduler(parameter,threadSafeProgress,typeConfig);
+    ThreadPool         threadPool(parameter.GetModuleWorkerCount());
+    size_t             currentStep=1;
+
+    for (std::list<ImportModule*>::const_iterator module=modules.begin();
+         module!=modules.end();
+         ++module) {
+      if (currentStep>=parameter.GetStartStep() &&
+          currentStep<=parameter.GetEndStep()) {
+        scheduler.AddStep(*module,currentStep);
+      }
+
+      currentStep++;
+    }
+
+    progress.Info(std::string("Executing up to ")+NumberToString(threadPool.GetWorkerCount())+" step(s) in parallel");
+
+    threadPool.Execute(scheduler,scheduler.GetStepCount());
+
+    return !scheduler.HasFailed();
+  }
+#endif
+
+  static bool ExecuteModules(std::list<ImportModule*>& modules,
+                            const ImportParameter& parameter,
+                            Progress& progress,
+                            const TypeConfig& typeConfig)
+  {
+    StopClock overAllTimer;
+    bool      success;
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+    if (parameter.GetModuleWorkerCount()!=1) {
+      success=ExecuteModulesParallel(modules,parameter,progress,typeConfig);
+    }
+    else {
+      success=ExecuteModulesSequential(modules,parameter,progress,typeConfig);
+    }
+#else
+    success=ExecuteModulesSequential(modules,parameter,progress,typeConfig);
+#endif
+
+    if (!success) {
+      return false;
+    }
+
     overAllTimer.Stop();
     progress.Info(std::string("=> ")+overAllTimer.ResultString()+" second(s)");
 
@@ -708,8 +1127,32 @@ namespace osmscout {
                                                               AppendFileToDir(parameter.GetDestinationDirectory(),
                                                                               Router::FILENAME_CAR_IDX)));
 
-#if defined(OSMSCOUT_IMPORT_HAVE_LIB_MARISA)
     /* 27 */
+    modules.push_back(new NumericIndexGenerator<Id,ReverseRouteNode>(std::string("Generating '")+Router::FILENAME_FOOT_REV_IDX+"'",
+                                                                     AppendFileToDir(parameter.GetDestinationDirectory(),
+                                                                                     Router::FILENAME_FOOT_REV_DAT),
+                                                                     AppendFileToDir(parameter.GetDestinationDirectory(),
+                                                                                     Router::FILENAME_FOOT_REV_IDX)));
+
+    /* 28 */
+    modules.push_back(new NumericIndexGenerator<Id,ReverseRouteNode>(std::string("Generating '")+Router::FILENAME_BICYCLE_REV_IDX+"'",
+                                                                     AppendFileToDir(parameter.GetDestinationDirectory(),
+                                                                                     Router::FILENAME_BICYCLE_REV_DAT),
+                                                                     AppendFileToDir(parameter.GetDestinationDirectory(),
+                                                                                     Router::FILENAME_BICYCLE_REV_IDX)));
+
+    /* 29 */
+    modules.push_back(new NumericIndexGenerator<Id,ReverseRouteNode>(std::string("Generating '")+Router::FILENAME_CAR_REV_IDX+"'",
+                                                                     AppendFileToDir(parameter.GetDestinationDirectory(),
+                                                                                     Router::FILENAME_CAR_REV_DAT),
+                                                                     AppendFileToDir(parameter.GetDestinationDirectory(),
+                                                                                     Router::FILENAME_CAR_REV_IDX)));
+
+    /* 30 */
+    modules.push_back(new RouteCHDataGenerator());
+
+#if defined(OSMSCOUT_IMPORT_HAVE_LIB_MARISA)
+    /* 31 */
     modules.push_back(new TextIndexGenerator());
 #endif
 
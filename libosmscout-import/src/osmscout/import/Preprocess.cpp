@@ -43,80 +43,48 @@
 #include <iostream>
 namespace osmscout {
 
-  static uint32_t coordPageSize=64;
-
-  bool Preprocess::StoreCurrentPage()
-  {
-    if (!coordWriter.SetPos(currentPageOffset)) {
-      return false;
-    }
-
-    for (size_t i=0; i<coordPageSize; i++) {
-
-      if (!isSet[i]) {
-        uint32_t latValue=0xffffffff;
-        uint32_t lonValue=0xffffffff;
-
-        coordWriter.Write(latValue);
-        coordWriter.Write(lonValue);
-      }
-      else {
-        coordWriter.WriteCoord(lats[i],lons[i]);
-      }
-    }
-
-    currentPageId=std::numeric_limits<PageId>::max();
-
-    return !coordWriter.HasError();
-  }
-
+  /**
+   * Append the coordinate of the given node to the coord data file. Nodes must
+   * be passed in ascending order of their id, see CoordDataFile for the layout.
+   */
   bool Preprocess::StoreCoord(OSMId id,
                               double lat,
                               double lon)
   {
-    PageId relatedId=id-std::numeric_limits<Id>::min();
-    PageId pageId=relatedId/coordPageSize;
-    FileOffset coordPageOffset=relatedId%coordPageSize;
-
-    if (currentPageId!=std::numeric_limits<PageId>::max()) {
-      if (currentPageId==pageId) {
-        lats[coordPageOffset]=lat;
-        lons[coordPageOffset]=lon;
-        isSet[coordPageOffset]=true;
+    if (coordCount>0 &&
+        id<=lastCoordId) {
+      return false;
+    }
 
-        return true;
+    if (coordLayout==CoordDataFile::layoutDense) {
+      if (coordCount==0) {
+        coordMinId=id;
       }
       else {
-        StoreCurrentPage();
+        // Mark all ids between the last and the current node as unset
+        uint32_t noCoord=0xffffffff;
+
+        for (OSMId gapId=lastCoordId+1; gapId<id; gapId++) {
+          coordWriter.Write(noCoord);
+          coordWriter.Write(noCoord);
+          coordCount++;
+        }
       }
     }
+    else {
+      if (coordCount%CoordDataFile::sparseBlockSize==0) {
+        coordBlockIds.push_back(id);
+      }
 
-    CoordPageOffsetMap::const_iterator pageOffsetEntry=coordIndex.find(pageId);
-
-    if (pageOffsetEntry==coordIndex.end()) {
-      isSet.assign(coordPageSize,false);
-
-      lats[coordPageOffset]=lat;
-      lons[coordPageOffset]=lon;
-      isSet[coordPageOffset]=true;
-
-      FileOffset pageOffset=coordPageCount*coordPageSize*2*sizeof(uint32_t);
-
-      currentPageId=pageId;
-      currentPageOffset=pageOffset;
-
-      pageOffsetEntry=coordIndex.insert(std::make_pair(pageId,pageOffset)).first;
-
-      coordPageCount++;
-
-      return true;
+      coordWriter.Write(id);
     }
 
-    if (!coordWriter.SetPos(pageOffsetEntry->second+coordPageOffset*2*sizeof(uint32_t))) {
-      return false;
-    }
+    coordWriter.WriteCoord(lat,lon);
+
+    coordCount++;
+    lastCoordId=id;
 
-    return coordWriter.WriteCoord(lat,lon);
+    return !coordWriter.HasError();
   }
 
   std::string Preprocess::GetDescription() const
@@ -124,6 +92,27 @@ namespace osmscout {
     return "Preprocess";
   }
 
+  void Preprocess::GetInputFiles(const ImportParameter& parameter,
+                                 std::list<std::string>& files) const
+  {
+    files.push_back(parameter.GetMapfile());
+  }
+
+  void Preprocess::GetOutputFiles(const ImportParameter& parameter,
+                                  std::list<std::string>& files) const
+  {
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "rawnodes.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "rawways.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "rawrels.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "rawcoastline.dat"));
+    files.push_back(AppendFileToDir(parameter.GetDestinationDirectory(),
+                                    "coord.dat"));
+  }
+
   bool Preprocess::Import(const ImportParameter& parameter,
                           Progress& progress,
                           const TypeConfig& typeConfig)
@@ -163,8 +152,11 @@ namespace osmscout {
 
   bool Preprocess::Initialize(const ImportParameter& parameter)
   {
-    coordPageCount=0;
-    currentPageId=std::numeric_limits<PageId>::max();
+    coordLayout=parameter.GetCoordDataLayout();
+    coordCount=0;
+    coordMinId=0;
+    lastCoordId=std::numeric_limits<OSMId>::min();
+    coordBlockIds.clear();
 
     nodeCount=0;
     wayCount=0;
@@ -179,6 +171,7 @@ namespace osmscout {
     nodeSortingError=false;
     waySortingError=false;
     relationSortingError=false;
+    nodeDuplicateError=false;
 
     nodeWriter.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
                                     "rawnodes.dat"));
@@ -199,17 +192,9 @@ namespace osmscout {
     coordWriter.Open(AppendFileToDir(parameter.GetDestinationDirectory(),
                                      "coord.dat"));
 
-    FileOffset offset=0;
-
-    coordWriter.Write(coordPageSize);
-    coordWriter.Write(offset);
-    coordWriter.FlushCurrentBlockWithZeros(coordPageSize*2*sizeof(uint32_t));
-
-    coordPageCount++;
-
-    lats.resize(coordPageSize);
-    lons.resize(coordPageSize);
-    isSet.resize(coordPageSize);
+    coordWriter.Write((uint32_t)coordLayout);
+    coordWriter.Write(coordCount);
+    coordWriter.Write(coordMinId);
 
     return !nodeWriter.HasError() &&
            !wayWriter.HasError() &&
@@ -232,7 +217,8 @@ namespace osmscout {
       nodeSortingError=true;
     }
 
-    typeConfig.GetNodeTypeId(tagMap,type);
+    typeConfig.InternTags(tagMap,internedTags);
+    typeConfig.GetNodeTypeId(internedTags,type);
 
     if (type!=typeIgnore) {
       typeConfig.ResolveTags(tagMap,tags);
@@ -252,9 +238,18 @@ namespace osmscout {
       nodeOffset=0;
     }
 
-    StoreCoord(id,
-               lat,
-               lon);
+    if (!StoreCoord(id,
+                    lat,
+                    lon)) {
+      if (coordCount>0 &&
+          id==lastCoordId) {
+        nodeDuplicateError=true;
+      }
+      else if (coordCount>0 &&
+               id<lastCoordId) {
+        nodeSortingError=true;
+      }
+    }
 
     lastNodeId=id;
   }
@@ -299,7 +294,8 @@ namespace osmscout {
       isCoastline=true;
     }
 
-    typeConfig.GetWayAreaTypeId(tagMap,wayType,areaType);
+    typeConfig.InternTags(tagMap,internedTags);
+    typeConfig.GetWayAreaTypeId(internedTags,wayType,areaType);
     typeConfig.ResolveTags(tagMap,tags);
 
     if (isArea==1 &&
@@ -404,7 +400,8 @@ namespace osmscout {
     relation.SetId(id);
     relation.members=members;
 
-    typeConfig.GetRelationTypeId(tagMap,type);
+    typeConfig.InternTags(tagMap,internedTags);
+    typeConfig.GetRelationTypeId(internedTags,type);
     typeConfig.ResolveTags(tagMap,relation.tags);
 
     relation.SetType(type);
@@ -417,10 +414,6 @@ namespace osmscout {
 
   bool Preprocess::Cleanup(Progress& progress)
   {
-    if (currentPageId!=0) {
-      StoreCurrentPage();
-    }
-
     nodeWriter.SetPos(0);
     nodeWriter.Write(nodeCount);
 
@@ -433,29 +426,29 @@ namespace osmscout {
     coastlineWriter.SetPos(0);
     coastlineWriter.Write(coastlineCount);
 
-    coordWriter.SetPos(0);
-
-    coordWriter.Write(coordPageSize);
-
-    FileOffset coordIndexOffset=coordPageCount*coordPageSize*2*sizeof(uint32_t);
+    // The sparse layout is followed by the id of the first node of each block
+    for (std::vector<OSMId>::const_iterator blockId=coordBlockIds.begin();
+         blockId!=coordBlockIds.end();
+         ++blockId) {
+      coordWriter.Write(*blockId);
+    }
 
-    coordWriter.Write(coordIndexOffset);
+    coordWriter.SetPos(0);
+    coordWriter.Write((uint32_t)coordLayout);
+    coordWriter.Write(coordCount);
+    coordWriter.Write(coordMinId);
 
-    coordWriter.SetPos(coordIndexOffset);
-    coordWriter.Write((uint32_t)coordIndex.size());
-
-    for (CoordPageOffsetMap::const_iterator entry=coordIndex.begin();
-         entry!=coordIndex.end();
-         ++entry) {
-      coordWriter.Write(entry->first);
-      coordWriter.Write(entry->second);
-    }
+    // Close() resets the error state, so remember it before
+    bool coordWriteError=coordWriter.HasError();
 
     nodeWriter.Close();
     wayWriter.Close();
     relationWriter.Close();
     coastlineWriter.Close();
-    coordWriter.Close();
+
+    if (!coordWriter.Close()) {
+      coordWriteError=true;
+    }
 
     progress.Info(std::string("Nodes:          ")+NumberToString(nodeCount));
     progress.Info(std::string("Ways/Areas/Sum: ")+NumberToString(wayCount)+" "+
@@ -463,12 +456,21 @@ namespace osmscout {
                   NumberToString(wayCount+areaCount));
     progress.Info(std::string("Relations:      ")+NumberToString(relationCount));
     progress.Info(std::string("Coastlines:     ")+NumberToString(coastlineCount));
-    progress.Info(std::string("Coord pages:    ")+NumberToString(coordIndex.size()));
+    progress.Info(std::string("Coords:         ")+NumberToString(coordCount)+
+                  (coordLayout==CoordDataFile::layoutDense ? " (dense)" : " (sparse)"));
 
     if (nodeSortingError) {
       progress.Error("Nodes are not sorted by increasing id");
     }
 
+    if (nodeDuplicateError) {
+      progress.Error("Nodes with duplicate ids found");
+    }
+
+    if (coordWriteError) {
+      progress.Error("Error while writing 'coord.dat'");
+    }
+
     if (waySortingError) {
       progress.Error("Ways are not sorted by increasing id");
     }
@@ -477,7 +479,8 @@ namespace osmscout {
       progress.Error("Relations are not sorted by increasing id");
     }
 
-    if (nodeSortingError || waySortingError || relationSortingError) {
+    if (nodeSortingError || waySortingError || relationSortingError ||
+        nodeDuplicateError || coordWriteError) {
       return false;
     }
 
@@ -36,6 +36,7 @@
 
 #include <osmscout/util/File.h>
 #include <osmscout/util/String.h>
+#include <osmscout/util/ThreadPool.h>
 
 #include "osmscout/import/Preprocess.h"
 
@@ -86,105 +87,73 @@ namespace osmscout {
     return true;
   }
 
-  bool ReadHeaderBlock(Progress& progress,
-                       FILE* file,
-                       const PBF::BlockHeader& blockHeader,
-                       PBF::HeaderBlock& headerBlock)
+  /**
+    Uncompress the data of the given blob.
+    */
+  static bool DecodeBlob(const PBF::Blob& blob,
+                         std::string& data,
+                         std::string& error)
   {
-    PBF::Blob blob;
-
-    uint32_t length = blockHeader.datasize();
-
-    if (length==0 || length>MAX_BLOB_SIZE) {
-      progress.Error("Blob size invalid!");
-      return false;
-    }
-
-    char *buffer=new char[length];
-
-    if (fread(buffer,sizeof(char),length,file)!=length) {
-      progress.Error("Cannot read blob!");
-      delete[] buffer;
-      return false;
-    }
-
-    if (!blob.ParseFromArray(buffer,length)) {
-      progress.Error("Cannot parse blob!");
-      delete[] buffer;
-      return false;
-    }
-
-    delete [] buffer;
-
     if (blob.has_raw()) {
-      length=(uint32_t)blob.raw().length();
-      buffer = new char[length];
-      memcpy(buffer,blob.raw().data(),length);
+      data.assign(blob.raw());
     }
     else if (blob.has_zlib_data()){
 #if defined(HAVE_LIB_ZLIB)
-      length=blob.raw_size();
-      buffer=new char[length];
+      data.resize(blob.raw_size());
 
       z_stream compressedStream;
 
       compressedStream.next_in=(Bytef*)const_cast<char*>(blob.zlib_data().data());
       compressedStream.avail_in=(uint32_t)blob.zlib_data().size();
-      compressedStream.next_out=(Bytef*)buffer;
-      compressedStream.avail_out=length;
+      compressedStream.next_out=(Bytef*)&data[0];
+      compressedStream.avail_out=(uint32_t)data.size();
       compressedStream.zalloc=Z_NULL;
       compressedStream.zfree=Z_NULL;
       compressedStream.opaque=Z_NULL;
 
       if (inflateInit( &compressedStream)!=Z_OK) {
-        progress.Error("Cannot decode zlib compressed blob data!");
-        delete[] buffer;
+        error="Cannot decode zlib compressed blob data!";
         return false;
       }
 
       if (inflate(&compressedStream,Z_FINISH)!=Z_STREAM_END) {
-        progress.Error("Cannot decode zlib compressed blob data!");
-        delete[] buffer;
+        inflateEnd(&compressedStream);
+        error="Cannot decode zlib compressed blob data!";
         return false;
       }
 
       if (inflateEnd(&compressedStream)!=Z_OK) {
-        progress.Error("Cannot decode zlib compressed blob data!");
-        delete[] buffer;
+        error="Cannot decode zlib compressed blob data!";
         return false;
       }
 #else
-      progress.Error("Data is zlib encoded but zlib support is not enabled!");
+      error="Data is zlib encoded but zlib support is not enabled!";
       return false;
 #endif
     }
     else if (blob.has_bzip2_data()){
-      progress.Error("Data is bzip2 encoded but bzip2 support is not enabled!");
+      error="Data is bzip2 encoded but bzip2 support is not enabled!";
       return false;
     }
     else if (blob.has_lzma_data()){
-      progress.Error("Data is lzma encoded but lzma support is not enabled!");
+      error="Data is lzma encoded but lzma support is not enabled!";
       return false;
     }
-
-    if (!headerBlock.ParseFromArray(buffer,length)) {
-      progress.Error("Cannot parse header block!");
-      delete[] buffer;
-      return false;
+    else {
+      data.clear();
     }
 
-    delete[] buffer;
-
     return true;
   }
 
-  bool ReadPrimitiveBlock(Progress& progress,
-                          FILE* file,
-                          const PBF::BlockHeader& blockHeader,
-                          PBF::PrimitiveBlock& primitiveBlock)
+  /**
+    Read the (still encoded) blob following the given block header
+    */
+  static bool ReadBlob(Progress& progress,
+                       FILE* file,
+                       const PBF::BlockHeader& blockHeader,
+                       std::vector<char>& buffer)
   {
-    PBF::Blob blob;
-
     uint32_t length = blockHeader.datasize();
 
     if (length==0 || length>MAX_BLOB_SIZE) {
@@ -192,117 +161,144 @@ namespace osmscout {
       return false;
     }
 
-    char *buffer=new char[length];
+    buffer.resize(length);
 
-    if (fread(buffer,sizeof(char),length,file)!=length) {
+    if (fread(&buffer[0],sizeof(char),length,file)!=length) {
       progress.Error("Cannot read blob!");
-      delete[] buffer;
       return false;
     }
 
-    if (!blob.ParseFromArray(buffer,length)) {
+    return true;
+  }
+
+  bool ReadHeaderBlock(Progress& progress,
+                       FILE* file,
+                       const PBF::BlockHeader& blockHeader,
+                       PBF::HeaderBlock& headerBlock)
+  {
+    std::vector<char> buffer;
+    PBF::Blob         blob;
+    std::string       data;
+    std::string       error;
+
+    if (!ReadBlob(progress,
+                  file,
+                  blockHeader,
+                  buffer)) {
+      return false;
+    }
+
+    if (!blob.ParseFromArray(&buffer[0],(int)buffer.size())) {
       progress.Error("Cannot parse blob!");
-      delete[] buffer;
       return false;
     }
 
-    delete [] buffer;
+    if (!DecodeBlob(blob,data,error)) {
+      progress.Error(error);
+      return false;
+    }
 
-    if (blob.has_raw()) {
-      length=(uint32_t)blob.raw().length();
-      buffer = new char[length];
-      memcpy(buffer,blob.raw().data(),length);
+    if (!headerBlock.ParseFromString(data)) {
+      progress.Error("Cannot parse header block!");
+      return false;
     }
-    else if (blob.has_zlib_data()){
-#if defined(HAVE_LIB_ZLIB)
-      length=blob.raw_size();
-      buffer=new char[length];
 
-      z_stream compressedStream;
+    return true;
+  }
 
-      compressedStream.next_in=(Bytef*)const_cast<char*>(blob.zlib_data().data());
-      compressedStream.avail_in=(uint32_t)blob.zlib_data().size();
-      compressedStream.next_out=(Bytef*)buffer;
-      compressedStream.avail_out=length;
-      compressedStream.zalloc=Z_NULL;
-      compressedStream.zfree=Z_NULL;
-      compressedStream.opaque=Z_NULL;
+  /**
+    Decodes the blobs of a number of batches in parallel. Each worker has its
+    own protobuf messages, which are reused for all blocks decoded by the
+    worker.
+    */
+  class PreprocessPBF::DecodeJob : public ParallelJob
+  {
+  private:
+    const TypeConfig&                typeConfig;
+    std::vector<Batch>&              batches;
+    std::vector<PBF::Blob>           blobs;
+    std::vector<PBF::PrimitiveBlock> blocks;
+
+  public:
+    DecodeJob(const TypeConfig& typeConfig,
+              std::vector<Batch>& batches,
+              size_t workerCount)
+    : typeConfig(typeConfig),
+      batches(batches),
+      blobs(workerCount),
+      blocks(workerCount)
+    {
+      // no code
+    }
 
-      if (inflateInit( &compressedStream)!=Z_OK) {
-        progress.Error("Cannot decode zlib compressed blob data!");
-        delete[] buffer;
-        return false;
-      }
+    void Execute(size_t task,
+                 size_t worker)
+    {
+      Batch& batch=batches[task];
 
-      if (inflate(&compressedStream,Z_FINISH)!=Z_STREAM_END) {
-        progress.Error("Cannot decode zlib compressed blob data!");
-        delete[] buffer;
-        return false;
+      batch.success=false;
+
+      if (!blobs[worker].ParseFromArray(&batch.blob[0],(int)batch.blob.size())) {
+        batch.error="Cannot parse blob!";
+        return;
       }
 
-      if (inflateEnd(&compressedStream)!=Z_OK) {
-        progress.Error("Cannot decode zlib compressed blob data!");
-        delete[] buffer;
-        return false;
+      if (!DecodeBlob(blobs[worker],batch.data,batch.error)) {
+        return;
       }
-#else
-      progress.Error("Data is zlib encoded but zlib support is not enabled!");
-      return false;
-#endif
-    }
-    else if (blob.has_bzip2_data()){
-      progress.Error("Data is bzip2 encoded but bzip2 support is not enabled!");
-      return false;
-    }
-    else if (blob.has_lzma_data()){
-      progress.Error("Data is lzma encoded but lzma support is not enabled!");
-      return false;
-    }
 
-    if (!primitiveBlock.ParseFromArray(buffer,length)) {
-      progress.Error("Cannot parse primitive block!");
-      delete[] buffer;
-      return false;
-    }
+      if (!blocks[worker].ParseFromString(batch.data)) {
+        batch.error="Cannot parse primitive block!";
+        return;
+      }
 
-    delete[] buffer;
+      DecodeBatch(typeConfig,
+                  blocks[worker],
+                  batch);
 
-    return true;
-  }
+      batch.success=true;
+    }
+  };
 
   std::string PreprocessPBF::GetDescription() const
   {
     return "PreprocessPBF";
   }
 
-  void PreprocessPBF::ReadNodes(const TypeConfig& typeConfig,
-                                const PBF::PrimitiveBlock& block,
-                                const PBF::PrimitiveGroup& group)
+  void PreprocessPBF::DecodeNodes(const TypeConfig& typeConfig,
+                                  const PBF::PrimitiveBlock& block,
+                                  const PBF::PrimitiveGroup& group,
+                                  Batch& batch)
   {
     for (int n=0; n<group.nodes_size(); n++) {
       const PBF::Node &inputNode=group.nodes(n);
+      Object          object;
 
-      tagMap.clear();
+      object.type=objectNode;
+      object.id=inputNode.id();
+      object.lon=(inputNode.lon()*block.granularity()+block.lon_offset())/NANO;
+      object.lat=(inputNode.lat()*block.granularity()+block.lat_offset())/NANO;
+      object.tagCount=0;
+      object.refCount=0;
 
       for (int t=0; t<inputNode.keys_size(); t++) {
         TagId id=typeConfig.GetTagId(block.stringtable().s(inputNode.keys(t)).c_str());
 
         if (id!=tagIgnore) {
-          tagMap[id]=block.stringtable().s(inputNode.vals(t));
+          batch.tagIds.push_back(id);
+          batch.tagValues.push_back(block.stringtable().s(inputNode.vals(t)));
+          object.tagCount++;
         }
       }
 
-      ProcessNode(typeConfig,
-                  inputNode.id(),
-                  (inputNode.lon()*block.granularity()+block.lon_offset())/NANO,
-                  (inputNode.lat()*block.granularity()+block.lat_offset())/NANO,
-                  tagMap);
+      batch.objects.push_back(object);
     }
   }
 
-  void PreprocessPBF::ReadDenseNodes(const TypeConfig& typeConfig,
-                                     const PBF::PrimitiveBlock& block,
-                                     const PBF::PrimitiveGroup& group)
+  void PreprocessPBF::DecodeDenseNodes(const TypeConfig& typeConfig,
+                                       const PBF::PrimitiveBlock& block,
+                                       const PBF::PrimitiveGroup& group,
+                                       Batch& batch)
   {
     const PBF::DenseNodes &dense=group.dense();
     Id     dId=0;
@@ -311,11 +307,18 @@ namespace osmscout {
     int    t=0;
 
     for (int d=0; d<dense.id_size();d++) {
+      Object object;
+
       dId+=dense.id(d);
       dLat+=dense.lat(d);
       dLon+=dense.lon(d);
 
-      tagMap.clear();
+      object.type=objectNode;
+      object.id=dId;
+      object.lon=(dLon*block.granularity()+block.lon_offset())/NANO;
+      object.lat=(dLat*block.granularity()+block.lat_offset())/NANO;
+      object.tagCount=0;
+      object.refCount=0;
 
       while (true) {
         if (t>=dense.keys_vals_size()) {
@@ -330,35 +333,41 @@ namespace osmscout {
         TagId id=typeConfig.GetTagId(block.stringtable().s(dense.keys_vals(t)).c_str());
 
         if (id!=tagIgnore) {
-          tagMap[id]=block.stringtable().s(dense.keys_vals(t+1));
+          batch.tagIds.push_back(id);
+          batch.tagValues.push_back(block.stringtable().s(dense.keys_vals(t+1)));
+          object.tagCount++;
         }
 
         t+=2;
       }
 
-      ProcessNode(typeConfig,
-                  dId,
-                  (dLon*block.granularity()+block.lon_offset())/NANO,
-                  (dLat*block.granularity()+block.lat_offset())/NANO,
-                  tagMap);
+      batch.objects.push_back(object);
     }
   }
 
-  void PreprocessPBF::ReadWays(const TypeConfig& typeConfig,
-                               const PBF::PrimitiveBlock& block,
-                               const PBF::PrimitiveGroup& group)
+  void PreprocessPBF::DecodeWays(const TypeConfig& typeConfig,
+                                 const PBF::PrimitiveBlock& block,
+                                 const PBF::PrimitiveGroup& group,
+                                 Batch& batch)
   {
     for (int w=0; w<group.ways_size(); w++) {
       const PBF::Way &inputWay=group.ways(w);
+      Object         object;
 
-      nodes.clear();
-      tagMap.clear();
+      object.type=objectWay;
+      object.id=inputWay.id();
+      object.lon=0.0;
+      object.lat=0.0;
+      object.tagCount=0;
+      object.refCount=inputWay.refs_size();
 
       for (int t=0; t<inputWay.keys_size(); t++) {
         TagId id=typeConfig.GetTagId(block.stringtable().s(inputWay.keys(t)).c_str());
 
         if (id!=tagIgnore) {
-          tagMap[id]=block.stringtable().s(inputWay.vals(t));
+          batch.tagIds.push_back(id);
+          batch.tagValues.push_back(block.stringtable().s(inputWay.vals(t)));
+          object.tagCount++;
         }
       }
 
@@ -366,31 +375,36 @@ namespace osmscout {
       for (int r=0; r<inputWay.refs_size(); r++) {
         ref+=inputWay.refs(r);
 
-        nodes.push_back(ref);
+        batch.nodes.push_back(ref);
       }
 
-      ProcessWay(typeConfig,
-                 inputWay.id(),
-                 nodes,
-                 tagMap);
+      batch.objects.push_back(object);
     }
   }
 
-  void PreprocessPBF::ReadRelations(const TypeConfig& typeConfig,
-                                    const PBF::PrimitiveBlock& block,
-                                    const PBF::PrimitiveGroup& group)
+  void PreprocessPBF::DecodeRelations(const TypeConfig& typeConfig,
+                                      const PBF::PrimitiveBlock& block,
+                                      const PBF::PrimitiveGroup& group,
+                                      Batch& batch)
   {
     for (int r=0; r<group.relations_size(); r++) {
       const PBF::Relation &inputRelation=group.relations(r);
+      Object              object;
 
-      members.clear();
-      tagMap.clear();
+      object.type=objectRelation;
+      object.id=inputRelation.id();
+      object.lon=0.0;
+      object.lat=0.0;
+      object.tagCount=0;
+      object.refCount=inputRelation.types_size();
 
       for (int t=0; t<inputRelation.keys_size(); t++) {
         TagId id=typeConfig.GetTagId(block.stringtable().s(inputRelation.keys(t)).c_str());
 
         if (id!=tagIgnore) {
-          tagMap[id]=block.stringtable().s(inputRelation.vals(t));
+          batch.tagIds.push_back(id);
+          batch.tagValues.push_back(block.stringtable().s(inputRelation.vals(t)));
+          object.tagCount++;
         }
       }
 
@@ -415,13 +429,108 @@ namespace osmscout {
         member.id=ref;
         member.role=block.stringtable().s(inputRelation.roles_sid(r));
 
-        members.push_back(member);
+        batch.members.push_back(member);
       }
 
-      ProcessRelation(typeConfig,
-                      inputRelation.id(),
-                      members,
-                      tagMap);
+      batch.objects.push_back(object);
+    }
+  }
+
+  /**
+    Decode all objects of the given block into the batch. May be called by
+    multiple threads in parallel (for different batches).
+    */
+  void PreprocessPBF::DecodeBatch(const TypeConfig& typeConfig,
+                                  PBF::PrimitiveBlock& block,
+                                  Batch& batch)
+  {
+    batch.objects.clear();
+    batch.tagIds.clear();
+    batch.tagValues.clear();
+    batch.nodes.clear();
+    batch.members.clear();
+
+    for (int currentGroup=0;
+         currentGroup<block.primitivegroup_size();
+         currentGroup++) {
+      const PBF::PrimitiveGroup &group=block.primitivegroup(currentGroup);
+
+      if (group.nodes_size()>0) {
+        DecodeNodes(typeConfig,
+                    block,
+                    group,
+                    batch);
+      }
+      else if (group.ways_size()>0) {
+        DecodeWays(typeConfig,
+                   block,
+                   group,
+                   batch);
+      }
+      else if (group.relations_size()>0) {
+        DecodeRelations(typeConfig,
+                        block,
+                        group,
+                        batch);
+      }
+      else if (group.has_dense()) {
+        DecodeDenseNodes(typeConfig,
+                         block,
+                         group,
+                         batch);
+      }
+    }
+  }
+
+  /**
+    Pass all objects of the given batch in order to Preprocess.
+    */
+  void PreprocessPBF::ProcessBatch(const TypeConfig& typeConfig,
+                                   const Batch& batch)
+  {
+    size_t tag=0;
+    size_t node=0;
+    size_t member=0;
+
+    for (std::vector<Object>::const_iterator object=batch.objects.begin();
+         object!=batch.objects.end();
+         ++object) {
+      tagMap.clear();
+
+      for (size_t t=0; t<object->tagCount; t++) {
+        tagMap[batch.tagIds[tag]]=batch.tagValues[tag];
+        tag++;
+      }
+
+      switch (object->type) {
+      case objectNode:
+        ProcessNode(typeConfig,
+                    object->id,
+                    object->lon,
+                    object->lat,
+                    tagMap);
+        break;
+      case objectWay:
+        nodes.assign(batch.nodes.begin()+node,
+                     batch.nodes.begin()+node+object->refCount);
+        node+=object->refCount;
+
+        ProcessWay(typeConfig,
+                   object->id,
+                   nodes,
+                   tagMap);
+        break;
+      case objectRelation:
+        members.assign(batch.members.begin()+member,
+                       batch.members.begin()+member+object->refCount);
+        member+=object->refCount;
+
+        ProcessRelation(typeConfig,
+                        object->id,
+                        members,
+                        tagMap);
+        break;
+      }
     }
   }
 
@@ -482,62 +591,66 @@ namespace osmscout {
     nodes.reserve(20000);
     members.reserve(2000);
 
-    while (true) {
-      PBF::BlockHeader blockHeader;
+    // The blobs are read in rounds of a few blocks per worker. The blocks of
+    // one round are decoded in parallel and afterwards processed in file order.
 
-      if (!ReadBlockHeader(progress,
-                           file,
-                           blockHeader,
-                           true)) {
-        fclose(file);
-        break;
-      }
-
-      if (blockHeader.type()!="OSMData") {
-        progress.Error("File is not an OSM PBF file!");
-        fclose(file);
-        return false;
-      }
+    ThreadPool         threadPool;
+    std::vector<Batch> batches(2*threadPool.GetWorkerCount());
+    DecodeJob          decodeJob(typeConfig,
+                                 batches,
+                                 threadPool.GetWorkerCount());
+    bool               endOfFile=false;
 
-      PBF::PrimitiveBlock block;
+    progress.Info(std::string("Decoding blocks using ")+NumberToString(threadPool.GetWorkerCount())+" worker(s)");
 
-      if (!ReadPrimitiveBlock(progress,
-                              file,
-                              blockHeader,
-                              block)) {
-        fclose(file);
-        return false;
-      }
+    while (!endOfFile) {
+      size_t batchCount=0;
 
-      for (int currentGroup=0;
-           currentGroup<block.primitivegroup_size();
-           currentGroup++) {
-        const PBF::PrimitiveGroup &group=block.primitivegroup(currentGroup);
+      while (batchCount<batches.size()) {
+        PBF::BlockHeader blockHeader;
 
-        if (group.nodes_size()>0) {
-          ReadNodes(typeConfig,
-                    block,
-                    group);
+        if (!ReadBlockHeader(progress,
+                             file,
+                             blockHeader,
+                             true)) {
+          endOfFile=true;
+          break;
         }
-        else if (group.ways_size()>0) {
-          ReadWays(typeConfig,
-                   block,
-                   group);
+
+        if (blockHeader.type()!="OSMData") {
+          progress.Error("File is not an OSM PBF file!");
+          fclose(file);
+          return false;
         }
-        else if (group.relations_size()>0) {
-          ReadRelations(typeConfig,
-                        block,
-                        group);
+
+        if (!ReadBlob(progress,
+                      file,
+                      blockHeader,
+                      batches[batchCount].blob)) {
+          fclose(file);
+          return false;
         }
-        else if (group.has_dense()) {
-          ReadDenseNodes(typeConfig,
-                         block,
-                         group);
+
+        batchCount++;
+      }
+
+      threadPool.Execute(decodeJob,
+                         batchCount);
+
+      for (size_t b=0; b<batchCount; b++) {
+        if (!batches[b].success) {
+          progress.Error(batches[b].error);
+          fclose(file);
+          return false;
         }
+
+        ProcessBatch(typeConfig,
+                     batches[b]);
       }
     }
 
+    fclose(file);
+
     return Cleanup(progress);
   }
 }
-
@@ -33,6 +33,26 @@ namespace osmscout {
     this->type=type;
   }
 
+  /**
+    Returns the (approximated) memory used by the raw relation including
+    all allocated data.
+    */
+  size_t RawRelation::GetMemorySize() const
+  {
+    size_t memory=sizeof(RawRelation);
+
+    memory+=GetTagsMemorySize(tags);
+    memory+=members.capacity()*sizeof(Member);
+
+    for (std::vector<Member>::const_iterator member=members.begin();
+         member!=members.end();
+         ++member) {
+      memory+=member->role.length();
+    }
+
+    return memory;
+  }
+
   bool RawRelation::Read(FileScanner& scanner)
   {
     uint32_t tagCount;
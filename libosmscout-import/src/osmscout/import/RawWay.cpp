@@ -52,6 +52,20 @@ namespace osmscout {
     this->nodes=nodes;
   }
 
+  /**
+    Returns the (approximated) memory used by the raw way including
+    all allocated data.
+    */
+  size_t RawWay::GetMemorySize() const
+  {
+    size_t memory=sizeof(RawWay);
+
+    memory+=GetTagsMemorySize(tags);
+    memory+=nodes.capacity()*sizeof(OSMId);
+
+    return memory;
+  }
+
   bool RawWay::Read(FileScanner& scanner)
   {
     if (!scanner.ReadNumber(id)) {
@@ -22,6 +22,7 @@
 
 #include <list>
 #include <string>
+#include <vector>
 
 #include <osmscout/private/MapImportExport.h>
 
@@ -32,9 +33,11 @@
 #include <osmscout/Way.h>
 #include <osmscout/GroundTile.h>
 #include <osmscout/ObjectRef.h>
+#include <osmscout/Pixel.h>
 #include <osmscout/StyleConfig.h>
 
 #include <osmscout/util/Breaker.h>
+#include <osmscout/util/HashMap.h>
 #include <osmscout/util/HashSet.h>
 #include <osmscout/util/Projection.h>
 #include <osmscout/util/Transformation.h>
@@ -304,6 +307,88 @@ namespace osmscout {
       std::string       text;     //! The label text
     };
 
+    /**
+      All labels of one label layer (normal labels or overlay labels) in the order
+      of their registration. Removed labels are only flagged.
+
+      For collision detection each label is registered in all cells of a uniform grid
+      over the map its bounding box (plus the maximum label space) touches. Labels
+      outside the map are registered in the nearest border cells. Shield labels are
+      additionally indexed by their text. The cost of placing a label thus only
+      depends on the number of labels near to it and not on the total number of labels.
+      */
+    struct OSMSCOUT_API LabelLayer
+    {
+      std::vector<LabelData>                             labels;      //! All labels, including removed ones
+      std::vector<bool>                                  removed;     //! Flag for each label, if it has been removed
+      std::vector<size_t>                                visited;     //! Number of the last query that visited the label
+      std::vector<size_t>                                marked;      //! Index of all currently marked labels
+      std::vector<std::vector<size_t> >                  cells;       //! Index of the labels in each grid cell
+      OSMSCOUT_HASHMAP<std::string,std::vector<size_t> > shieldTexts; //! Index of shield labels by their text
+      size_t                                             columns;     //! Number of columns of the grid
+      size_t                                             rows;        //! Number of rows of the grid
+      double                                             space;       //! Space added around each label in the grid
+      size_t                                             query;       //! Number of the current query
+      size_t                                             count;       //! Number of labels not removed
+
+      LabelLayer();
+
+      void Reset(double width,
+                 double height,
+                 double space);
+
+      void GetCells(double bx1,
+                    double bx2,
+                    double by1,
+                    double by2,
+                    size_t& cx1,
+                    size_t& cx2,
+                    size_t& cy1,
+                    size_t& cy2) const;
+
+      void Add(const LabelData& label,
+               bool isShield);
+      void ClearMarks();
+      void RemoveMarked();
+    };
+
+    /**
+      Draw lists of areas and ways, prepared once by PrepareData() for a region that is
+      larger than a single map (e.g. a metatile of several tiles). Coordinates are in the
+      pixel space of the projection passed to PrepareData(). If set via SetPreparedData(),
+      Draw() does not prepare areas and ways itself, but replays the entries overlapping
+      the map, translated into the pixel space of its projection.
+
+      Prepared data references the objects of the MapData it has been prepared from and
+      is only valid as long as this MapData exists.
+      */
+    struct OSMSCOUT_MAP_API PreparedData
+    {
+      struct OSMSCOUT_MAP_API Bounds
+      {
+        double xMin;
+        double yMin;
+        double xMax;
+        double yMax;
+      };
+
+      Magnification            magnification; //! Magnification of the projection
+      size_t                   width;         //! Width of the projection, defines the scale
+      double                   lon;           //! Longitude of the reference point
+      double                   lat;           //! Latitude of the reference point
+      double                   x;             //! Pixel coordinate of the reference point
+      double                   y;             //! Pixel coordinate of the reference point
+      std::vector<AreaData>    areaData;      //! Prepared areas, sorted
+      std::vector<Bounds>      areaBounds;    //! Bounds for each area, including the border
+      std::vector<WayData>     wayData;       //! Prepared way lines, sorted
+      std::vector<Bounds>      wayBounds;     //! Bounds for each way line, including the line width
+      std::vector<WayPathData> wayPathData;   //! Prepared way paths
+      std::vector<Bounds>      wayPathBounds; //! Bounds for each way path, including the line widths
+      std::vector<Vertex2D>    coords;        //! Coordinates, referenced by transStart and transEnd
+
+      void Clear();
+    };
+
   private:
     CoordBuffer               *coordBuffer;
   protected:
@@ -331,12 +416,22 @@ namespace osmscout {
       Temporary data structures for intelligent label positioning
       */
     //@{
-    std::list<LabelData>      labels;
-    std::list<LabelData>      overlayLabels;
+    LabelLayer                labels;
+    LabelLayer                overlayLabels;
     std::vector<ScanCell>     wayScanlines;
     //@}
 
     std::vector<LineStyleRef> lineStyles;     //! Temporary storage for StyleConfig return value
+
+    /**
+      Shared preparation of multiple maps
+      */
+    //@{
+    const PreparedData        *preparedData;  //! Prepared data to replay in Draw() or NULL
+    double                    prepareWidth;   //! Width of the region to prepare areas and ways for
+    double                    prepareHeight;  //! Height of the region to prepare areas and ways for
+    //@}
+
     /**
       Statistics counter
      */
@@ -374,6 +469,12 @@ namespace osmscout {
     //@}
 
   private:
+    bool IsVisible(const Projection& projection,
+                   const std::vector<GeoCoord>& nodes,
+                   double pixelOffset,
+                   double width,
+                   double height) const;
+
     void CalculateEffectiveLabelStyle(const Projection& projection,
                                       const MapParameter& parameter,
                                       const LabelStyle& style,
@@ -394,21 +495,19 @@ namespace osmscout {
      Label placement routines
      */
     //@{
-    void ClearLabelMarks(std::list<LabelData>& labels);
-    void RemoveMarkedLabels(std::list<LabelData>& labels);
     bool MarkAllInBoundingBox(double bx1,
                               double bx2,
                               double by1,
                               double by2,
                               const LabelStyle& style,
-                              std::list<LabelData>& labels);
+                              LabelLayer& labels);
     bool MarkCloseLabelsWithSameText(double bx1,
                                      double bx2,
                                      double by1,
                                      double by2,
                                      const LabelStyle& style,
                                      const std::string& text,
-                                     std::list<LabelData>& labels);
+                                     LabelLayer& labels);
     //@}
 
     /**
@@ -441,6 +540,16 @@ namespace osmscout {
                      const MapParameter& parameter,
                      const MapData& data);
 
+    void CopyPreparedCoords(double dx,
+                            double dy,
+                            size_t start,
+                            size_t end,
+                            size_t& newStart,
+                            size_t& newEnd,
+                            OSMSCOUT_HASHMAP<size_t,size_t>& copiedCoords);
+
+    void ReplayPreparedData(const Projection& projection);
+
     void RegisterPointWayLabel(const Projection& projection,
                                const MapParameter& parameter,
                                const PathShieldStyleRef& style,
@@ -730,6 +839,16 @@ namespace osmscout {
   public:
     MapPainter(CoordBuffer *buffer);
     virtual ~MapPainter();
+
+    bool PrepareData(const StyleConfig& styleConfig,
+                     const Projection& projection,
+                     const MapParameter& parameter,
+                     const MapData& data,
+                     double width,
+                     double height,
+                     PreparedData& prepared);
+
+    void SetPreparedData(const PreparedData* prepared);
   };
 }
 
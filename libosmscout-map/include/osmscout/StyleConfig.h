@@ -177,6 +177,14 @@ namespace osmscout {
   class OSMSCOUT_MAP_API StyleCriteria
   {
   public:
+    /**
+     * Object attributes a criteria can depend on, as bit flags
+     */
+    enum Flag {
+      flagBridge = 1 << 0,
+      flagTunnel = 1 << 1,
+      flagOneway = 1 << 2
+    };
 
   private:
     bool             bridge;
@@ -207,6 +215,14 @@ namespace osmscout {
       return oneway;
     }
 
+    inline const SizeConditionRef& GetSizeCondition() const
+    {
+      return sizeCondition;
+    }
+
+   uint8_t GetFlags() const;
+
+   bool Matches(uint8_t flags) const;
    bool Matches(double meterInPixel,
                 double meterInMM) const;
    bool Matches(const AreaAttributes& attributes,
@@ -275,6 +291,46 @@ namespace osmscout {
     }
   };
 
+  /**
+   * Precompiled result of all StyleSelectors of one type and one magnification level.
+   * The resulting style only depends on the object flags (see StyleCriteria::Flag)
+   * the selectors check and on the result of their size conditions (which only
+   * depend on the projection), so the style for each combination of these is
+   * resolved in advance.
+   */
+  struct StyleResolution
+  {
+    uint32_t firstStyle;         //! Index of the resolved style for an object without any flags
+    uint32_t firstSizeCondition; //! Index of the first size condition the selectors use
+    uint8_t  sizeConditionCount; //! Number of distinct size conditions the selectors use
+    uint8_t  flagMask;           //! Object flags any of the selectors depends on
+    bool     dynamic;            //! Too many size conditions, the style must be evaluated for each object
+  };
+
+  /**
+   * Precompiled styles for a style lookup table. If the size conditions
+   * sizeConditions[firstSizeCondition+i] evaluate to the bits i of sizeMask, the
+   * resolved style for an object with the given flags is
+   * styles[firstStyle+sizeMask*(flagMask+1)+(flags & flagMask)]. All types and
+   * levels without any selector share the invalid style at index 0.
+   */
+  template<class S>
+  struct StyleResolutionTable
+  {
+    size_t                        typeCount;      //! Number of types
+    size_t                        levelCount;     //! Number of levels per type
+    std::vector<StyleResolution>  resolutions;    //! Resolution of each type and level, at type*levelCount+level
+    std::vector<SizeConditionRef> sizeConditions; //! Size conditions of all resolutions
+    std::vector<Ref<S> >          styles;         //! Resolved styles, invalid if there is no visible style
+
+    StyleResolutionTable()
+    : typeCount(0),
+      levelCount(0)
+    {
+      // no code
+    }
+  };
+
   /**
    * Style options for a line.
    */
@@ -411,6 +467,7 @@ namespace osmscout {
   typedef StyleSelector<LineStyle,LineStyle::Attribute>    LineStyleSelector;
   typedef std::list<LineStyleSelector>                     LineStyleSelectorList; //! List of selectors
   typedef std::vector<std::vector<LineStyleSelectorList> > LineStyleLookupTable;  //!Index selectors by type and level
+  typedef StyleResolutionTable<LineStyle>                  LineStyleResolutionTable; //! Precompiled styles by type and level
 
   /**
    * Style options for filling an area.
@@ -514,6 +571,7 @@ namespace osmscout {
   typedef StyleSelector<FillStyle,FillStyle::Attribute>    FillStyleSelector;
   typedef std::list<FillStyleSelector>                     FillStyleSelectorList; //! List of selectors
   typedef std::vector<std::vector<FillStyleSelectorList> > FillStyleLookupTable;  //!Index selectors by type and level
+  typedef StyleResolutionTable<FillStyle>                  FillStyleResolutionTable; //! Precompiled styles by type and level
 
   /**
    * Abstract base class for all (point) labels. All point labels have priority
@@ -633,6 +691,7 @@ namespace osmscout {
   typedef StyleSelector<TextStyle,TextStyle::Attribute>    TextStyleSelector;
   typedef std::list<TextStyleSelector>                     TextStyleSelectorList; //! List of selectors
   typedef std::vector<std::vector<TextStyleSelectorList> > TextStyleLookupTable;  //!Index selectors by type and level
+  typedef StyleResolutionTable<TextStyle>                  TextStyleResolutionTable; //! Precompiled styles by type and level
 
   /**
    * A shield or plate label (text placed on a plate).
@@ -713,6 +772,7 @@ namespace osmscout {
   typedef StyleSelector<ShieldStyle,ShieldStyle::Attribute>    ShieldStyleSelector;
   typedef std::list<ShieldStyleSelector>                       ShieldStyleSelectorList; //! List of selectors
   typedef std::vector<std::vector<ShieldStyleSelectorList> >   ShieldStyleLookupTable;  //!Index selectors by type and level
+  typedef StyleResolutionTable<ShieldStyle>                    ShieldStyleResolutionTable; //! Precompiled styles by type and level
 
   /**
    * A stle definng repretive drawing of a shiled label along a path. It consists
@@ -808,6 +868,7 @@ namespace osmscout {
   typedef StyleSelector<PathShieldStyle,PathShieldStyle::Attribute>    PathShieldStyleSelector;
   typedef std::list<PathShieldStyleSelector>                           PathShieldStyleSelectorList; //! List of selectors
   typedef std::vector<std::vector<PathShieldStyleSelectorList> >       PathShieldStyleLookupTable;  //!Index selectors by type and level
+  typedef StyleResolutionTable<PathShieldStyle>                        PathShieldStyleResolutionTable; //! Precompiled styles by type and level
 
   /**
    * A style for drawing text onto a path, the text following the
@@ -872,6 +933,7 @@ namespace osmscout {
   typedef StyleSelector<PathTextStyle,PathTextStyle::Attribute>    PathTextStyleSelector;
   typedef std::list<PathTextStyleSelector>                         PathTextStyleSelectorList; //! List of selectors
   typedef std::vector<std::vector<PathTextStyleSelectorList> >     PathTextStyleLookupTable;  //!Index selectors by type and level
+  typedef StyleResolutionTable<PathTextStyle>                      PathTextStyleResolutionTable; //! Precompiled styles by type and level
 
   class OSMSCOUT_MAP_API DrawPrimitive : public Referencable
   {
@@ -1092,6 +1154,7 @@ namespace osmscout {
   typedef StyleSelector<IconStyle,IconStyle::Attribute>    IconStyleSelector;
   typedef std::list<IconStyleSelector>                     IconStyleSelectorList; //! List of selectors
   typedef std::vector<std::vector<IconStyleSelectorList> > IconStyleLookupTable;  //!Index selectors by type and level
+  typedef StyleResolutionTable<IconStyle>                  IconStyleResolutionTable; //! Precompiled styles by type and level
 
   /**
    * Style for repretive drawing of symbols on top of a path.
@@ -1141,6 +1204,7 @@ namespace osmscout {
   typedef StyleSelector<PathSymbolStyle,PathSymbolStyle::Attribute>    PathSymbolStyleSelector;
   typedef std::list<PathSymbolStyleSelector>                           PathSymbolStyleSelectorList; //! List of selectors
   typedef std::vector<std::vector<PathSymbolStyleSelectorList> >       PathSymbolStyleLookupTable;  //!Index selectors by type and level
+  typedef StyleResolutionTable<PathSymbolStyle>                        PathSymbolStyleResolutionTable; //! Precompiled styles by type and level
 
   /**
    * A complete style definition
@@ -1162,6 +1226,9 @@ namespace osmscout {
     TextStyleLookupTable                       nodeTextStyleSelectors;
     IconStyleLookupTable                       nodeIconStyleSelectors;
 
+    TextStyleResolutionTable                   nodeTextStyleResolutions;
+    IconStyleResolutionTable                   nodeIconStyleResolutions;
+
     std::vector<TypeSet>                       nodeTypeSets;
 
     // Way
@@ -1178,6 +1245,11 @@ namespace osmscout {
     PathSymbolStyleLookupTable                 wayPathSymbolStyleSelectors;
     PathShieldStyleLookupTable                 wayPathShieldStyleSelectors;
 
+    std::vector<LineStyleResolutionTable>      wayLineStyleResolutions;
+    PathTextStyleResolutionTable               wayPathTextStyleResolutions;
+    PathSymbolStyleResolutionTable             wayPathSymbolStyleResolutions;
+    PathShieldStyleResolutionTable             wayPathShieldStyleResolutions;
+
     std::vector<std::vector<TypeSet> >         wayTypeSets;
 
     // Area
@@ -1190,6 +1262,10 @@ namespace osmscout {
     TextStyleLookupTable                       areaTextStyleSelectors;
     IconStyleLookupTable                       areaIconStyleSelectors;
 
+    FillStyleResolutionTable                   areaFillStyleResolutions;
+    TextStyleResolutionTable                   areaTextStyleResolutions;
+    IconStyleResolutionTable                   areaIconStyleResolutions;
+
     std::vector<TypeSet>                       areaTypeSets;
 
     OSMSCOUT_HASHMAP<std::string,StyleVariableRef> variables;
@@ -1205,6 +1281,7 @@ namespace osmscout {
     void PostprocessAreas();
     void PostprocessIconId();
     void PostprocessPatternId();
+    void PrecompileStyles();
 
   public:
     StyleConfig(TypeConfig* typeConfig);
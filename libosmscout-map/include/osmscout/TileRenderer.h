@@ -0,0 +1,247 @@
+#ifndef OSMSCOUT_MAP_TILERENDERER_H
+#define OSMSCOUT_MAP_TILERENDERER_H
+
+/*
+  This source is part of the libosmscout-map library
+  Copyright (C) 2014  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include <osmscout/CoreFeatures.h>
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+#include <osmscout/private/MapImportExport.h>
+
+#include <osmscout/Database.h>
+
+#include <osmscout/MapPainter.h>
+#include <osmscout/StyleConfig.h>
+
+namespace osmscout {
+
+  /**
+    A tile of the tile pyramid as used by OSM (see
+    http://wiki.openstreetmap.org/wiki/Slippy_map_tilenames)
+    */
+  struct OSMSCOUT_MAP_API MapTile
+  {
+    size_t zoom;
+    size_t x;
+    size_t y;
+
+    MapTile();
+    MapTile(size_t zoom,
+            size_t x,
+            size_t y);
+
+    bool operator==(const MapTile& other) const;
+    bool operator<(const MapTile& other) const;
+
+    static double XToLon(double x,
+                         size_t zoom);
+    static double YToLat(double y,
+                         size_t zoom);
+    static size_t LonToX(double lon,
+                         size_t zoom);
+    static size_t LatToY(double lat,
+                         size_t zoom);
+  };
+
+  /**
+    Draws a tile into some backend specific target. Each worker of the
+    TileRenderer owns its own backend instance (normally wrapping a
+    MapPainter of the given backend and its drawing buffer), so an instance
+    is only ever called by one thread.
+    */
+  class OSMSCOUT_MAP_API TileRenderBackend
+  {
+  public:
+    virtual ~TileRenderBackend();
+
+    virtual MapPainter* GetMapPainter();
+
+    /**
+      Draw the given tile. data contains the objects of the complete
+      metatile the tile belongs to, the projection is already set to the
+      tile.
+      */
+    virtual bool DrawTile(const StyleConfig& styleConfig,
+                          const Projection& projection,
+                          const MapParameter& parameter,
+                          const MapData& data,
+                          const MapTile& tile) = 0;
+  };
+
+  /**
+    Creates one TileRenderBackend for each worker of the TileRenderer.
+    */
+  class OSMSCOUT_MAP_API TileRenderBackendFactory
+  {
+  public:
+    virtual ~TileRenderBackendFactory();
+
+    virtual TileRenderBackend* CreateBackend(size_t worker) = 0;
+  };
+
+  /**
+    Parameter of the TileRenderer.
+
+    Tiles are rendered in blocks of metaTileSize x metaTileSize tiles
+    (aligned to multiples of metaTileSize). Requested tiles of the same
+    block are rendered together by one worker based on the result of one
+    Database::GetObjects() call.
+
+    If prepareMetaTiles is set and the backend gives access to its
+    MapPainter, the areas and ways of a block are also only prepared once
+    (see MapPainter::PrepareData()) and each tile only draws the part of
+    it, that is visible in the tile.
+    */
+  class OSMSCOUT_MAP_API TileRendererParameter
+  {
+  private:
+    size_t workerCount;
+    size_t metaTileSize;
+    size_t tileWidth;
+    size_t tileHeight;
+    bool   prepareMetaTiles;
+
+  public:
+    TileRendererParameter();
+
+    void SetWorkerCount(size_t workerCount);
+    void SetMetaTileSize(size_t metaTileSize);
+    void SetTileSize(size_t width,
+                     size_t height);
+    void SetPrepareMetaTiles(bool prepareMetaTiles);
+
+    size_t GetWorkerCount() const;
+    size_t GetMetaTileSize() const;
+    size_t GetTileWidth() const;
+    size_t GetTileHeight() const;
+    bool GetPrepareMetaTiles() const;
+  };
+
+  /**
+    Renders tiles of the tile pyramid using a number of worker threads.
+    All workers share the (read-only) database and style configuration,
+    each worker draws using its own TileRenderBackend.
+
+    Requests are handled in the order of their priority (higher priority
+    first) and for the same priority in the order they were added.
+    All pending requests for tiles of the same metatile are handled
+    together, with the highest priority of the tiles.
+
+    If thread support is not available, the requests are rendered by the
+    thread calling Wait().
+    */
+  class OSMSCOUT_MAP_API TileRenderer
+  {
+  private:
+    struct MetaTileKey
+    {
+      size_t zoom;
+      size_t x;
+      size_t y;
+
+      bool operator<(const MetaTileKey& other) const;
+    };
+
+    struct PendingMetaTile
+    {
+      int                  priority;
+      size_t               sequence;
+      std::vector<MapTile> tiles;
+    };
+
+    struct QueueEntry
+    {
+      int         priority;
+      size_t      sequence;
+      MetaTileKey key;
+
+      bool operator<(const QueueEntry& other) const;
+    };
+
+  private:
+    const Database&                           database;
+    const StyleConfig&                        styleConfig;
+    MapParameter                              drawParameter;
+    AreaSearchParameter                       searchParameter;
+    TileRendererParameter                     parameter;
+    std::vector<TileRenderBackend*>           backends;
+
+    std::map<MetaTileKey,PendingMetaTile>     pending;        //! Requested, but not yet started metatiles
+    std::set<QueueEntry>                      queue;          //! Pending metatiles ordered by priority
+    size_t                                    nextSequence;
+    size_t                                    runningWorkers; //! Number of workers rendering a metatile
+    size_t                                    tileCount;      //! Number of rendered tiles
+    size_t                                    metaTileCount;  //! Number of rendered metatiles
+    size_t                                    errorCount;     //! Number of tiles that could not be rendered
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+    std::vector<std::thread>                  threads;
+    mutable std::mutex                        mutex;
+    std::condition_variable                   wakeCondition;  //! Signaled on a new request or on shutdown
+    std::condition_variable                   doneCondition;  //! Signaled if all requests have been rendered
+    bool                                      stop;           //! Threads should terminate
+#endif
+
+  private:
+    TileRenderer(const TileRenderer& other);
+    void operator=(const TileRenderer& other);
+
+    bool PopMetaTile(MetaTileKey& key,
+                     std::vector<MapTile>& tiles);
+    void RenderMetaTile(TileRenderBackend& backend,
+                        const MetaTileKey& key,
+                        const std::vector<MapTile>& tiles);
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+    void Work(size_t worker);
+#endif
+
+  public:
+    TileRenderer(const Database& database,
+                 const StyleConfig& styleConfig,
+                 const MapParameter& drawParameter,
+                 const AreaSearchParameter& searchParameter,
+                 const TileRendererParameter& parameter);
+    virtual ~TileRenderer();
+
+    bool Start(TileRenderBackendFactory& factory);
+    void Stop();
+
+    void AddRequest(const MapTile& tile,
+                    int priority=0);
+    void Wait();
+
+    size_t GetWorkerCount() const;
+    size_t GetTileCount() const;
+    size_t GetMetaTileCount() const;
+    size_t GetErrorCount() const;
+  };
+}
+
+#endif
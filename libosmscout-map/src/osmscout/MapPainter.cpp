@@ -19,6 +19,7 @@
 
 #include <osmscout/MapPainter.h>
 
+#include <algorithm>
 #include <iostream>
 #include <limits>
 
@@ -32,6 +33,11 @@
 
 namespace osmscout {
 
+  /**
+   * Width and height of a cell of the label collision grid in pixel
+   */
+  static const double labelGridCellSize=64.0;
+
   /**
    * Return if a > b, a should be drawn before b
    */
@@ -180,7 +186,10 @@ namespace osmscout {
 
   MapPainter::MapPainter(CoordBuffer *buffer)
   : coordBuffer(buffer),
-    transBuffer(coordBuffer)
+    transBuffer(coordBuffer),
+    preparedData(NULL),
+    prepareWidth(0.0),
+    prepareHeight(0.0)
   {
     tunnelDash.push_back(0.4);
     tunnelDash.push_back(0.4);
@@ -209,6 +218,23 @@ namespace osmscout {
   bool MapPainter::IsVisible(const Projection& projection,
                              const std::vector<GeoCoord>& nodes,
                              double pixelOffset) const
+  {
+    return IsVisible(projection,
+                     nodes,
+                     pixelOffset,
+                     projection.GetWidth(),
+                     projection.GetHeight());
+  }
+
+  /**
+   * Returns true, if the bounding box of the nodes (extended by pixelOffset) overlaps
+   * the region [0,width[x[0,height[ in the pixel space of the projection.
+   */
+  bool MapPainter::IsVisible(const Projection& projection,
+                             const std::vector<GeoCoord>& nodes,
+                             double pixelOffset,
+                             double width,
+                             double height) const
   {
     if (nodes.empty()) {
       return false;
@@ -257,8 +283,8 @@ namespace osmscout {
     xMax+=pixelOffset;
     yMax+=pixelOffset;
 
-    return !(xMin>=projection.GetWidth() ||
-             yMin>=projection.GetHeight() ||
+    return !(xMin>=width ||
+             yMin>=height ||
              xMax<0 ||
              yMax<0);
   }
@@ -287,27 +313,146 @@ namespace osmscout {
     }
   }
 
-  void MapPainter::ClearLabelMarks(std::list<LabelData>& labels)
+  MapPainter::LabelLayer::LabelLayer()
+  : columns(0),
+    rows(0),
+    space(0.0),
+    query(0),
+    count(0)
+  {
+    // no code
+  }
+
+  /**
+   * Remove all labels and setup the grid for a map of the given size. space
+   * is the maximum space between two labels.
+   */
+  void MapPainter::LabelLayer::Reset(double width,
+                                     double height,
+                                     double space)
   {
-    for (std::list<LabelData>::iterator label=labels.begin();
-         label!=labels.end();
-         ++label) {
-      label->mark=false;
+    labels.clear();
+    removed.clear();
+    visited.clear();
+    marked.clear();
+    shieldTexts.clear();
+
+    this->space=space;
+
+    columns=(size_t)std::max(1.0,ceil(width/labelGridCellSize));
+    rows=(size_t)std::max(1.0,ceil(height/labelGridCellSize));
+
+    // Keep the capacity of the cells of the last run
+    for (size_t i=0; i<cells.size(); i++) {
+      cells[i].clear();
     }
+
+    cells.resize(columns*rows);
+
+    query=0;
+    count=0;
+  }
+
+  /**
+   * Return the range of grid cells, the given bounding box touches. Coordinates
+   * outside of the map are mapped to the border cells.
+   */
+  void MapPainter::LabelLayer::GetCells(double bx1,
+                                        double bx2,
+                                        double by1,
+                                        double by2,
+                                        size_t& cx1,
+                                        size_t& cx2,
+                                        size_t& cy1,
+                                        size_t& cy2) const
+  {
+    double maxColumn=columns-1;
+    double maxRow=rows-1;
+
+    cx1=(size_t)std::max(0.0,std::min(maxColumn,floor(bx1/labelGridCellSize)));
+    cx2=(size_t)std::max(0.0,std::min(maxColumn,floor(bx2/labelGridCellSize)));
+    cy1=(size_t)std::max(0.0,std::min(maxRow,floor(by1/labelGridCellSize)));
+    cy2=(size_t)std::max(0.0,std::min(maxRow,floor(by2/labelGridCellSize)));
   }
 
-  void MapPainter::RemoveMarkedLabels(std::list<LabelData>& labels)
+  void MapPainter::LabelLayer::Add(const LabelData& label,
+                                   bool isShield)
   {
-    std::list<LabelData>::iterator label=labels.begin();
+    size_t index=labels.size();
+    size_t cx1,cx2,cy1,cy2;
+
+    labels.push_back(label);
+    labels.back().mark=false;
+    removed.push_back(false);
+    visited.push_back(0);
 
-    while (label!=labels.end()) {
-      if (label->mark) {
-        label=labels.erase(label);
+    GetCells(label.bx1-space,label.bx2+space,
+             label.by1-space,label.by2+space,
+             cx1,cx2,cy1,cy2);
+
+    for (size_t y=cy1; y<=cy2; y++) {
+      for (size_t x=cx1; x<=cx2; x++) {
+        cells[y*columns+x].push_back(index);
       }
-      else {
-        ++label;
+    }
+
+    if (isShield) {
+      shieldTexts[label.text].push_back(index);
+    }
+
+    count++;
+  }
+
+  void MapPainter::LabelLayer::ClearMarks()
+  {
+    for (size_t i=0; i<marked.size(); i++) {
+      labels[marked[i]].mark=false;
+    }
+
+    marked.clear();
+  }
+
+  /**
+   * Flag all marked labels as removed and drop them from the grid and the
+   * text index.
+   */
+  void MapPainter::LabelLayer::RemoveMarked()
+  {
+    for (size_t i=0; i<marked.size(); i++) {
+      size_t     index=marked[i];
+      LabelData& label=labels[index];
+      size_t     cx1,cx2,cy1,cy2;
+
+      GetCells(label.bx1-space,label.bx2+space,
+               label.by1-space,label.by2+space,
+               cx1,cx2,cy1,cy2);
+
+      for (size_t y=cy1; y<=cy2; y++) {
+        for (size_t x=cx1; x<=cx2; x++) {
+          std::vector<size_t>& cell=cells[y*columns+x];
+
+          cell.erase(std::find(cell.begin(),cell.end(),index));
+        }
       }
+
+      OSMSCOUT_HASHMAP<std::string,std::vector<size_t> >::iterator entry=shieldTexts.find(label.text);
+
+      if (entry!=shieldTexts.end()) {
+        std::vector<size_t>::iterator textEntry=std::find(entry->second.begin(),
+                                                          entry->second.end(),
+                                                          index);
+
+        if (textEntry!=entry->second.end()) {
+          entry->second.erase(textEntry);
+        }
+      }
+
+      label.mark=false;
+      removed[index]=true;
+      count--;
     }
+
+    marked.clear();
   }
 
   bool MapPainter::MarkAllInBoundingBox(double bx1,
@@ -315,47 +460,70 @@ namespace osmscout {
                                         double by1,
                                         double by2,
                                         const LabelStyle& style,
-                                        std::list<LabelData>& labels)
+                                        LabelLayer& labels)
   {
-    for (std::list<LabelData>::iterator l=labels.begin();
-        l!=labels.end();
-        ++l) {
-      LabelData& label=*l;
+    size_t cx1,cx2,cy1,cy2;
 
-      // We only look at labels, that are not already marked.
-      if (label.mark) {
-        continue;
-      }
+    // Each label is registered in the cells of its bounding box plus the
+    // maximum label space, so looking at the cells of our own bounding box
+    // finds every label in range
+    labels.GetCells(bx1,bx2,by1,by2,
+                    cx1,cx2,cy1,cy2);
+
+    labels.query++;
 
-      double hx1;
-      double hx2;
-      double hy1;
-      double hy2;
+    for (size_t cy=cy1; cy<=cy2; cy++) {
+      for (size_t cx=cx1; cx<=cx2; cx++) {
+        const std::vector<size_t>& cell=labels.cells[cy*labels.columns+cx];
 
-      double horizLabelSpace;
-      double vertLabelSpace;
+        for (size_t i=0; i<cell.size(); i++) {
+          size_t     index=cell[i];
+          LabelData& label=labels.labels[index];
 
-      GetLabelSpace(style,
-                    *label.style,
-                    horizLabelSpace,
-                    vertLabelSpace);
+          // Labels covering multiple cells are only checked once
+          if (labels.visited[index]==labels.query) {
+            continue;
+          }
 
-      hx1=bx1-horizLabelSpace;
-      hx2=bx2+horizLabelSpace;
-      hy1=by1-vertLabelSpace;
-      hy2=by2+vertLabelSpace;
+          labels.visited[index]=labels.query;
 
-      // Check for labels that intersect (including space). If our priority is lower,
-      // we stop processing, else we mark the other label (as to be deleted)
-      if (!(hx1>label.bx2 ||
-            hx2<label.bx1 ||
-            hy1>label.by2 ||
-            hy2<label.by1)) {
-        if (label.style->GetPriority()<=style.GetPriority()) {
-          return false;
-        }
+          // We only look at labels, that are not already marked.
+          if (label.mark) {
+            continue;
+          }
 
-        label.mark=true;
+          double hx1;
+          double hx2;
+          double hy1;
+          double hy2;
+
+          double horizLabelSpace;
+          double vertLabelSpace;
+
+          GetLabelSpace(style,
+                        *label.style,
+                        horizLabelSpace,
+                        vertLabelSpace);
+
+          hx1=bx1-horizLabelSpace;
+          hx2=bx2+horizLabelSpace;
+          hy1=by1-vertLabelSpace;
+          hy2=by2+vertLabelSpace;
+
+          // Check for labels that intersect (including space). If our priority is lower,
+          // we stop processing, else we mark the other label (as to be deleted)
+          if (!(hx1>label.bx2 ||
+                hx2<label.bx1 ||
+                hy1>label.by2 ||
+                hy2<label.by1)) {
+            if (label.style->GetPriority()<=style.GetPriority()) {
+              return false;
+            }
+
+            label.mark=true;
+            labels.marked.push_back(index);
+          }
+        }
       }
     }
 
@@ -368,36 +536,42 @@ namespace osmscout {
                                                double by2,
                                                const LabelStyle& style,
                                                const std::string& text,
-                                               std::list<LabelData>& labels)
+                                               LabelLayer& labels)
   {
-    for (std::list<LabelData>::iterator l=labels.begin();
-        l!=labels.end();
-        ++l) {
-      LabelData& label=*l;
+    // Only shield labels are checked against each other
+    if (dynamic_cast<const ShieldStyle*>(&style)==NULL) {
+      return true;
+    }
+
+    OSMSCOUT_HASHMAP<std::string,std::vector<size_t> >::const_iterator entry=labels.shieldTexts.find(text);
+
+    if (entry==labels.shieldTexts.end()) {
+      return true;
+    }
+
+    double hx1=bx1-sameLabelSpace;
+    double hx2=bx2+sameLabelSpace;
+    double hy1=by1-sameLabelSpace;
+    double hy2=by2+sameLabelSpace;
+
+    for (std::vector<size_t>::const_iterator index=entry->second.begin();
+         index!=entry->second.end();
+         ++index) {
+      const LabelData& label=labels.labels[*index];
 
       if (label.mark) {
         continue;
       }
 
-      if (dynamic_cast<const ShieldStyle*>(&style)!=NULL &&
-          dynamic_cast<const ShieldStyle*>(label.style.Get())!=NULL) {
-        double hx1=bx1-sameLabelSpace;
-        double hx2=bx2+sameLabelSpace;
-        double hy1=by1-sameLabelSpace;
-        double hy2=by2+sameLabelSpace;
-
-        if (!(hx1>label.bx2 ||
-              hx2<label.bx1 ||
-              hy1>label.by2 ||
-              hy2<label.by1)) {
-          if (text==label.text) {
-            // TODO: It may be possible that the labels belong to the same "thing".
-            // perhaps we should not just draw one or the other, but also change
-            // final position of the label (but this would require more complex
-            // collision handling and perhaps processing labels in different order)?
-            return false;
-          }
-        }
+      if (!(hx1>label.bx2 ||
+            hx2<label.bx1 ||
+            hy1>label.by2 ||
+            hy2<label.by1)) {
+        // TODO: It may be possible that the labels belong to the same "thing".
+        // perhaps we should not just draw one or the other, but also change
+        // final position of the label (but this would require more complex
+        // collision handling and perhaps processing labels in different order)?
+        return false;
       }
     }
 
@@ -748,8 +922,12 @@ namespace osmscout {
       labelData.fontSize=1.2;
       labelData.style=debugLabel;
       labelData.text=label;
+      labelData.bx1=px;
+      labelData.by1=py;
+      labelData.bx2=px;
+      labelData.by2=py;
 
-      labels.push_back(labelData);
+      labels.Add(labelData,false);
 
       drawnLabels.insert(Coord(x,y));
 #endif
@@ -805,10 +983,10 @@ namespace osmscout {
     // Reset all marks on labels, because we needs marks
     // for our internal collision handling
     if (overlay) {
-      ClearLabelMarks(overlayLabels);
+      overlayLabels.ClearMarks();
     }
     else {
-      ClearLabelMarks(labels);
+      labels.ClearMarks();
     }
 
     // First rough minimum bounding box, estimated without calculating text dimensions (since this is expensive).
@@ -892,7 +1070,7 @@ namespace osmscout {
 
       // Remove every marked (aka "in conflict" or "intersecting but of lower
       // priority") label.
-      RemoveMarkedLabels(overlayLabels);
+      overlayLabels.RemoveMarked();
     }
     else {
       if (!MarkAllInBoundingBox(bx1,bx2,by1,by2,
@@ -917,7 +1095,7 @@ namespace osmscout {
 
       // Remove every marked (aka "in conflict" or "intersecting but of lower
       // priority") label.
-      RemoveMarkedLabels(labels);
+      labels.RemoveMarked();
     }
 
 
@@ -936,11 +1114,13 @@ namespace osmscout {
     label.style=style;
     label.text=text;
 
+    bool isShield=dynamic_cast<const ShieldStyle*>(style.Get())!=NULL;
+
     if (overlay) {
-      overlayLabels.push_back(label);
+      overlayLabels.Add(label,isShield);
     }
     else {
-      labels.push_back(label);
+      labels.Add(label,isShield);
     }
 
     return true;
@@ -1406,12 +1586,14 @@ namespace osmscout {
     // Draw normal
     //
 
-    for (std::list<LabelData>::const_iterator label=labels.begin();
-         label!=labels.end();
-         ++label) {
+    for (size_t i=0; i<labels.labels.size(); i++) {
+      if (labels.removed[i]) {
+        continue;
+      }
+
       DrawLabel(projection,
                 parameter,
-                *label);
+                labels.labels[i]);
       labelsDrawn++;
     }
 
@@ -1419,12 +1601,14 @@ namespace osmscout {
     // Draw overlays
     //
 
-    for (std::list<LabelData>::const_iterator label=overlayLabels.begin();
-         label!=overlayLabels.end();
-         ++label) {
+    for (size_t i=0; i<overlayLabels.labels.size(); i++) {
+      if (overlayLabels.removed[i]) {
+        continue;
+      }
+
       DrawLabel(projection,
                 parameter,
-                *label);
+                overlayLabels.labels[i]);
       labelsDrawn++;
     }
   }
@@ -1492,7 +1676,9 @@ namespace osmscout {
 
             if (!IsVisible(projection,
                            ring.nodes,
-                           fillStyle->GetBorderWidth()/2)) {
+                           fillStyle->GetBorderWidth()/2,
+                           prepareWidth,
+                           prepareHeight)) {
               continue;
             }
 
@@ -1608,8 +1794,10 @@ namespace osmscout {
       data.lineWidth=lineWidth;
 
       if (!IsVisible(projection,
-                    nodes,
-                    lineWidth/2)) {
+                     nodes,
+                     lineWidth/2,
+                     prepareWidth,
+                     prepareHeight)) {
         continue;
       }
 
@@ -1694,6 +1882,169 @@ namespace osmscout {
     wayData.sort();
   }
 
+  void MapPainter::PreparedData::Clear()
+  {
+    areaData.clear();
+    areaBounds.clear();
+    wayData.clear();
+    wayBounds.clear();
+    wayPathData.clear();
+    wayPathBounds.clear();
+    coords.clear();
+  }
+
+  static void GetPreparedBounds(const std::vector<Vertex2D>& coords,
+                                size_t transStart,
+                                size_t transEnd,
+                                double offset,
+                                MapPainter::PreparedData::Bounds& bounds)
+  {
+    bounds.xMin=coords[transStart].GetX();
+    bounds.xMax=coords[transStart].GetX();
+    bounds.yMin=coords[transStart].GetY();
+    bounds.yMax=coords[transStart].GetY();
+
+    for (size_t i=transStart+1; i<=transEnd; i++) {
+      bounds.xMin=std::min(bounds.xMin,coords[i].GetX());
+      bounds.xMax=std::max(bounds.xMax,coords[i].GetX());
+      bounds.yMin=std::min(bounds.yMin,coords[i].GetY());
+      bounds.yMax=std::max(bounds.yMax,coords[i].GetY());
+    }
+
+    bounds.xMin-=offset;
+    bounds.xMax+=offset;
+    bounds.yMin-=offset;
+    bounds.yMax+=offset;
+  }
+
+  static inline bool IsPreparedVisible(const MapPainter::PreparedData::Bounds& bounds,
+                                       double dx,
+                                       double dy,
+                                       const Projection& projection)
+  {
+    return !(bounds.xMin-dx>=projection.GetWidth() ||
+             bounds.yMin-dy>=projection.GetHeight() ||
+             bounds.xMax-dx<0 ||
+             bounds.yMax-dy<0);
+  }
+
+  /**
+   * Copy the prepared coordinates [start,end] into the coordinate buffer, translated
+   * by (-dx,-dy). Coordinates shared by multiple entries are only copied once.
+   */
+  void MapPainter::CopyPreparedCoords(double dx,
+                                      double dy,
+                                      size_t start,
+                                      size_t end,
+                                      size_t& newStart,
+                                      size_t& newEnd,
+                                      OSMSCOUT_HASHMAP<size_t,size_t>& copiedCoords)
+  {
+    OSMSCOUT_HASHMAP<size_t,size_t>::const_iterator copied=copiedCoords.find(start);
+
+    if (copied!=copiedCoords.end()) {
+      newStart=copied->second;
+      newEnd=newStart+end-start;
+
+      return;
+    }
+
+    const std::vector<Vertex2D>& coords=preparedData->coords;
+
+    newStart=coordBuffer->PushCoord(coords[start].GetX()-dx,
+                                    coords[start].GetY()-dy);
+
+    for (size_t i=start+1; i<=end; i++) {
+      coordBuffer->PushCoord(coords[i].GetX()-dx,
+                             coords[i].GetY()-dy);
+    }
+
+    newEnd=newStart+end-start;
+
+    copiedCoords[start]=newStart;
+  }
+
+  /**
+   * Fill the area and way draw lists with the prepared entries visible in the given
+   * projection, instead of calling PrepareAreas() and PrepareWays().
+   */
+  void MapPainter::ReplayPreparedData(const Projection& projection)
+  {
+    OSMSCOUT_HASHMAP<size_t,size_t> copiedCoords;
+    double                          x;
+    double                          y;
+
+    areaData.clear();
+    wayData.clear();
+    wayPathData.clear();
+
+    // Translation from the prepared pixel space into the pixel space of the projection
+    projection.GeoToPixel(preparedData->lon,
+                          preparedData->lat,
+                          x,y);
+
+    double dx=preparedData->x-x;
+    double dy=preparedData->y-y;
+
+    for (size_t i=0; i<preparedData->areaData.size(); i++) {
+      if (!IsPreparedVisible(preparedData->areaBounds[i],dx,dy,projection)) {
+        continue;
+      }
+
+      AreaData area(preparedData->areaData[i]);
+
+      CopyPreparedCoords(dx,dy,
+                         area.transStart,area.transEnd,
+                         area.transStart,area.transEnd,
+                         copiedCoords);
+
+      for (std::list<PolyData>::iterator clipping=area.clippings.begin();
+           clipping!=area.clippings.end();
+           ++clipping) {
+        CopyPreparedCoords(dx,dy,
+                           clipping->transStart,clipping->transEnd,
+                           clipping->transStart,clipping->transEnd,
+                           copiedCoords);
+      }
+
+      areaData.push_back(area);
+
+      areasSegments++;
+    }
+
+    for (size_t i=0; i<preparedData->wayData.size(); i++) {
+      if (!IsPreparedVisible(preparedData->wayBounds[i],dx,dy,projection)) {
+        continue;
+      }
+
+      WayData way(preparedData->wayData[i]);
+
+      CopyPreparedCoords(dx,dy,
+                         way.transStart,way.transEnd,
+                         way.transStart,way.transEnd,
+                         copiedCoords);
+
+      wayData.push_back(way);
+
+      waysSegments++;
+    }
+
+    for (size_t i=0; i<preparedData->wayPathData.size(); i++) {
+      if (!IsPreparedVisible(preparedData->wayPathBounds[i],dx,dy,projection)) {
+        continue;
+      }
+
+      WayPathData path(preparedData->wayPathData[i]);
+
+      CopyPreparedCoords(dx,dy,
+                         path.transStart,path.transEnd,
+                         path.transStart,path.transEnd,
+                         copiedCoords);
+
+      wayPathData.push_back(path);
+    }
+  }
+
   void MapPainter::GetLabelFrame(const LabelStyle& style,
                                  double& horizontal,
                                  double& vertical)
@@ -1740,15 +2091,22 @@ namespace osmscout {
 
     labelsDrawn=0;
 
-    labels.clear();
-    overlayLabels.clear();
-
     transBuffer.Reset();
 
+    prepareWidth=projection.GetWidth();
+    prepareHeight=projection.GetHeight();
+
     labelSpace=ConvertWidthToPixel(parameter,parameter.GetLabelSpace());
     shieldLabelSpace=ConvertWidthToPixel(parameter,parameter.GetPlateLabelSpace());
     sameLabelSpace=ConvertWidthToPixel(parameter,parameter.GetSameLabelSpace());
 
+    labels.Reset(projection.GetWidth(),
+                 projection.GetHeight(),
+                 std::max(labelSpace,shieldLabelSpace));
+    overlayLabels.Reset(projection.GetWidth(),
+                        projection.GetHeight(),
+                        std::max(labelSpace,shieldLabelSpace));
+
     if (parameter.IsAborted()) {
       return false;
     }
@@ -1767,12 +2125,22 @@ namespace osmscout {
     // Setup and Precalculation
     //
 
+    // Prepared data can only be replayed, if it has the same scale
+    bool replayPreparedData=preparedData!=NULL &&
+                            preparedData->magnification==projection.GetMagnification() &&
+                            preparedData->width==projection.GetWidth();
+
     StopClock prepareAreasTimer;
 
-    PrepareAreas(styleConfig,
-                 projection,
-                 parameter,
-                 data);
+    if (replayPreparedData) {
+      ReplayPreparedData(projection);
+    }
+    else {
+      PrepareAreas(styleConfig,
+                   projection,
+                   parameter,
+                   data);
+    }
 
     prepareAreasTimer.Stop();
 
@@ -1782,10 +2150,12 @@ namespace osmscout {
 
     StopClock prepareWaysTimer;
 
-    PrepareWays(styleConfig,
-                projection,
-                parameter,
-                data);
+    if (!replayPreparedData) {
+      PrepareWays(styleConfig,
+                  projection,
+                  parameter,
+                  data);
+    }
 
     prepareWaysTimer.Stop();
 
@@ -1966,10 +2336,142 @@ namespace osmscout {
       std::cout << data.nodes.size() <<"+" << data.poiNodes.size() << "/" << nodesDrawn << " (pcs) ";
       std::cout << nodesTimer << "/" << poisTimer << " (sec)" << std::endl;
 
-      std::cout << "Labels: " << labels.size() << "/" << overlayLabels.size() << "/" << labelsDrawn << " (pcs) ";
+      std::cout << "Labels: " << labels.count << "/" << overlayLabels.count << "/" << labelsDrawn << " (pcs) ";
       std::cout << labelsTimer << " (sec)" << std::endl;
     }
 
     return true;
   }
+
+  /**
+   * Prepare the areas and ways of the given data once for the region [0,width[x[0,height[
+   * in the pixel space of the projection, e.g. for all tiles of a metatile using the
+   * projection of its upper left tile. The result can be drawn by all maps with the same
+   * magnification and width, that are (partially) within this region (see SetPreparedData()).
+   */
+  bool MapPainter::PrepareData(const StyleConfig& styleConfig,
+                               const Projection& projection,
+                               const MapParameter& parameter,
+                               const MapData& data,
+                               double width,
+                               double height,
+                               PreparedData& prepared)
+  {
+    prepared.Clear();
+
+    waysSegments=0;
+    areasSegments=0;
+
+    transBuffer.Reset();
+
+    prepareWidth=width;
+    prepareHeight=height;
+
+    PrepareAreas(styleConfig,
+                 projection,
+                 parameter,
+                 data);
+
+    if (parameter.IsAborted()) {
+      return false;
+    }
+
+    PrepareWays(styleConfig,
+                projection,
+                parameter,
+                data);
+
+    if (parameter.IsAborted()) {
+      return false;
+    }
+
+    prepared.magnification=projection.GetMagnification();
+    prepared.width=projection.GetWidth();
+
+    projection.PixelToGeo(projection.GetWidth()/2.0,
+                          projection.GetHeight()/2.0,
+                          prepared.lon,
+                          prepared.lat);
+    projection.GeoToPixel(prepared.lon,
+                          prepared.lat,
+                          prepared.x,
+                          prepared.y);
+
+    prepared.coords.resize(coordBuffer->GetLength());
+
+    for (size_t i=0; i<prepared.coords.size(); i++) {
+      double x,y;
+
+      coordBuffer->GetCoord(i,x,y);
+      prepared.coords[i].Set(x,y);
+    }
+
+    prepared.areaData.reserve(areaData.size());
+    prepared.areaBounds.resize(areaData.size());
+
+    for (std::list<AreaData>::const_iterator area=areaData.begin();
+         area!=areaData.end();
+         ++area) {
+      GetPreparedBounds(prepared.coords,
+                        area->transStart,
+                        area->transEnd,
+                        area->fillStyle->GetBorderWidth()/2,
+                        prepared.areaBounds[prepared.areaData.size()]);
+
+      prepared.areaData.push_back(*area);
+    }
+
+    OSMSCOUT_HASHMAP<FileOffset,double> maxLineWidths;
+
+    prepared.wayData.reserve(wayData.size());
+    prepared.wayBounds.resize(wayData.size());
+
+    for (std::list<WayData>::const_iterator way=wayData.begin();
+         way!=wayData.end();
+         ++way) {
+      GetPreparedBounds(prepared.coords,
+                        way->transStart,
+                        way->transEnd,
+                        way->lineWidth/2,
+                        prepared.wayBounds[prepared.wayData.size()]);
+
+      prepared.wayData.push_back(*way);
+
+      double& maxLineWidth=maxLineWidths[way->ref.GetFileOffset()];
+
+      maxLineWidth=std::max(maxLineWidth,way->lineWidth);
+    }
+
+    prepared.wayPathData.reserve(wayPathData.size());
+    prepared.wayPathBounds.resize(wayPathData.size());
+
+    // A path is visible, if one of the lines of its way is visible
+    for (std::list<WayPathData>::const_iterator path=wayPathData.begin();
+         path!=wayPathData.end();
+         ++path) {
+      GetPreparedBounds(prepared.coords,
+                        path->transStart,
+                        path->transEnd,
+                        maxLineWidths[path->ref.GetFileOffset()]/2,
+                        prepared.wayPathBounds[prepared.wayPathData.size()]);
+
+      prepared.wayPathData.push_back(*path);
+    }
+
+    areaData.clear();
+    wayData.clear();
+    wayPathData.clear();
+
+    return true;
+  }
+
+  /**
+   * Set the data prepared by PrepareData() to be used by the following calls of Draw().
+   * Draw() falls back to preparing the data itself, if the projection does not match
+   * the prepared data. Pass NULL to reset.
+   */
+  void MapPainter::SetPreparedData(const PreparedData* prepared)
+  {
+    preparedData=prepared;
+  }
 }
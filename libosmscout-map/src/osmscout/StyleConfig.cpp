@@ -19,6 +19,7 @@
 
 #include <osmscout/StyleConfig.h>
 
+#include <algorithm>
 #include <set>
 
 namespace osmscout {
@@ -144,7 +145,8 @@ namespace osmscout {
   }
 
   LineStyle::LineStyle(const LineStyle& style)
-  : slot(style.slot),
+  : Referencable(style),
+    slot(style.slot),
     lineColor(style.lineColor),
     gapColor(style.gapColor),
     displayWidth(style.displayWidth),
@@ -383,6 +385,7 @@ namespace osmscout {
   }
 
   FillStyle::FillStyle(const FillStyle& style)
+  : Referencable(style)
   {
     this->fillColor=style.fillColor;
     this->pattern=style.pattern;
@@ -533,6 +536,7 @@ namespace osmscout {
   }
 
   LabelStyle::LabelStyle(const LabelStyle& style)
+  : Referencable(style)
   {
     this->priority=style.priority;
     this->size=style.size;
@@ -745,7 +749,8 @@ namespace osmscout {
   }
 
   PathShieldStyle::PathShieldStyle(const PathShieldStyle& style)
-   : shieldStyle(new ShieldStyle(*style.GetShieldStyle().Get())),
+   : Referencable(style),
+     shieldStyle(new ShieldStyle(*style.GetShieldStyle().Get())),
      shieldSpace(style.shieldSpace)
   {
     // no code
@@ -841,6 +846,7 @@ namespace osmscout {
   }
 
   PathTextStyle::PathTextStyle(const PathTextStyle& style)
+  : Referencable(style)
   {
     this->label=style.label;
     this->size=style.size;
@@ -1011,6 +1017,7 @@ namespace osmscout {
   }
 
   IconStyle::IconStyle(const IconStyle& style)
+  : Referencable(style)
   {
     this->iconName=style.iconName;
     this->iconId=style.iconId;
@@ -1062,7 +1069,8 @@ namespace osmscout {
   }
 
   PathSymbolStyle::PathSymbolStyle(const PathSymbolStyle& style)
-  : symbol(style.symbol),
+  : Referencable(style),
+    symbol(style.symbol),
     symbolSpace(style.symbolSpace)
   {
     // no code
@@ -1209,6 +1217,34 @@ namespace osmscout {
            sizeCondition!=other.sizeCondition;
   }
 
+  uint8_t StyleCriteria::GetFlags() const
+  {
+    uint8_t flags=0;
+
+    if (bridge) {
+      flags|=flagBridge;
+    }
+
+    if (tunnel) {
+      flags|=flagTunnel;
+    }
+
+    if (oneway) {
+      flags|=flagOneway;
+    }
+
+    return flags;
+  }
+
+  /**
+   * Return true, if an object with the given flags matches the criteria,
+   * ignoring any size condition.
+   */
+  bool StyleCriteria::Matches(uint8_t flags) const
+  {
+    return (GetFlags() & ~flags)==0;
+  }
+
   bool StyleCriteria::Matches(double meterInPixel,
                               double meterInMM) const
   {
@@ -1758,6 +1794,248 @@ namespace osmscout {
     }
   }
 
+  /**
+   * Maximum number of distinct size conditions in the selectors of one type and
+   * level for which the styles are precompiled
+   */
+  static const size_t maxPrecompiledSizeConditions=4;
+
+  /**
+   * Sum up all selectors matching an object with the given flags (see
+   * GetObjectAttributesStyle()). If ignoreFlags is true, the criteria flags
+   * are not checked (as for areas). The result of the size condition
+   * sizeConditions[i] is given by bit i of sizeMask.
+   */
+  template <class S, class A>
+  void ComposeStyle(const std::list<StyleSelector<S,A> >& selectors,
+                    uint8_t flags,
+                    bool ignoreFlags,
+                    const std::vector<SizeCondition*>& sizeConditions,
+                    size_t sizeMask,
+                    Ref<S>& style)
+  {
+    bool fastpath=false;
+    bool composed=false;
+
+    style=NULL;
+
+    for (typename std::list<StyleSelector<S,A> >::const_iterator s=selectors.begin();
+         s!=selectors.end();
+         ++s) {
+      const StyleSelector<S,A>& selector=*s;
+
+      if (!ignoreFlags &&
+          !selector.criteria.Matches(flags)) {
+        continue;
+      }
+
+      if (selector.criteria.GetSizeCondition().Valid()) {
+        size_t condition=std::find(sizeConditions.begin(),
+                                   sizeConditions.end(),
+                                   selector.criteria.GetSizeCondition().Get())-sizeConditions.begin();
+
+        if ((sizeMask & (1 << condition))==0) {
+          continue;
+        }
+      }
+
+      if (style.Invalid()) {
+        style=selector.style;
+        fastpath=true;
+
+        continue;
+      }
+      else if (fastpath) {
+        style=new S(style);
+        fastpath=false;
+      }
+
+      style->CopyAttributes(*selector.style,
+                            selector.attributes);
+      composed=true;
+    }
+
+    if (composed &&
+        !style->IsVisible()) {
+      style=NULL;
+    }
+  }
+
+  /**
+   * Resolve the style of each type and level of the lookup table for all
+   * combinations of object flags and size condition results the selectors
+   * depend on. Selector lists with too many size conditions are marked as
+   * dynamic.
+   */
+  template <class S, class A>
+  void PrecompileStyleTable(const std::vector<std::vector<std::list<StyleSelector<S,A> > > >& selectors,
+                            bool ignoreFlags,
+                            StyleResolutionTable<S>& table)
+  {
+    std::vector<SizeCondition*> sizeConditions;
+
+    table.typeCount=selectors.size();
+    table.levelCount=selectors.empty() ? 0 : selectors[0].size();
+
+    table.resolutions.clear();
+    table.sizeConditions.clear();
+    table.styles.clear();
+
+    table.resolutions.resize(table.typeCount*table.levelCount);
+    table.styles.push_back(Ref<S>());
+
+    for (size_t type=0; type<selectors.size(); type++) {
+      for (size_t level=0; level<table.levelCount; level++) {
+        StyleResolution& resolution=table.resolutions[type*table.levelCount+level];
+
+        resolution.firstStyle=0;
+        resolution.firstSizeCondition=0;
+        resolution.sizeConditionCount=0;
+        resolution.flagMask=0;
+        resolution.dynamic=false;
+
+        if (selectors[type][level].empty()) {
+          continue;
+        }
+
+        resolution.firstStyle=(uint32_t)table.styles.size();
+        resolution.firstSizeCondition=(uint32_t)table.sizeConditions.size();
+
+        sizeConditions.clear();
+
+        for (typename std::list<StyleSelector<S,A> >::const_iterator s=selectors[type][level].begin();
+             s!=selectors[type][level].end();
+             ++s) {
+          SizeCondition* sizeCondition=s->criteria.GetSizeCondition().Get();
+
+          if (sizeCondition!=NULL &&
+              std::find(sizeConditions.begin(),
+                        sizeConditions.end(),
+                        sizeCondition)==sizeConditions.end()) {
+            sizeConditions.push_back(sizeCondition);
+          }
+
+          if (!ignoreFlags) {
+            resolution.flagMask|=s->criteria.GetFlags();
+          }
+        }
+
+        if (sizeConditions.size()>maxPrecompiledSizeConditions) {
+          resolution.dynamic=true;
+          continue;
+        }
+
+        resolution.sizeConditionCount=(uint8_t)sizeConditions.size();
+
+        for (size_t i=0; i<sizeConditions.size(); i++) {
+          table.sizeConditions.push_back(sizeConditions[i]);
+        }
+
+        for (size_t sizeMask=0; sizeMask<((size_t)1 << sizeConditions.size()); sizeMask++) {
+          for (uint8_t flags=0; flags<=resolution.flagMask; flags++) {
+            Ref<S> style;
+
+            if ((flags & ~resolution.flagMask)==0) {
+              ComposeStyle(selectors[type][level],
+                           flags,
+                           ignoreFlags,
+                           sizeConditions,
+                           sizeMask,
+                           style);
+            }
+
+            table.styles.push_back(style);
+          }
+        }
+      }
+    }
+  }
+
+  /**
+   * Return the precompiled style for the given type, level and object flags.
+   * Returns NULL, if the style must be evaluated for the concrete object.
+   */
+  template <class S>
+  inline const Ref<S>* GetPrecompiledStyle(const StyleResolutionTable<S>& table,
+                                           TypeId type,
+                                           size_t level,
+                                           double meterInPixel,
+                                           double meterInMM,
+                                           uint8_t flags)
+  {
+    if (type>=table.typeCount) {
+      return NULL;
+    }
+
+    if (level>=table.levelCount) {
+      level=table.levelCount-1;
+    }
+
+    const StyleResolution& resolution=table.resolutions[type*table.levelCount+level];
+
+    if (resolution.dynamic) {
+      return NULL;
+    }
+
+    size_t sizeMask=0;
+
+    for (size_t i=0; i<resolution.sizeConditionCount; i++) {
+      if (table.sizeConditions[resolution.firstSizeCondition+i]->Evaluate(meterInPixel,
+                                                                          meterInMM)) {
+        sizeMask|=1 << i;
+      }
+    }
+
+    return &table.styles[resolution.firstStyle+
+                         sizeMask*(resolution.flagMask+1)+
+                         (flags & resolution.flagMask)];
+  }
+
+  static inline uint8_t GetWayFlags(const WayAttributes& way)
+  {
+    uint8_t flags=0;
+
+    if (way.IsBridge()) {
+      flags|=StyleCriteria::flagBridge;
+    }
+
+    if (way.IsTunnel()) {
+      flags|=StyleCriteria::flagTunnel;
+    }
+
+    if (way.GetAccess().IsOneway()) {
+      flags|=StyleCriteria::flagOneway;
+    }
+
+    return flags;
+  }
+
+  /**
+   * Precompile the styles of all lookup tables, so that most style lookups
+   * during drawing are a simple table lookup.
+   */
+  void StyleConfig::PrecompileStyles()
+  {
+    // Nodes do not have any flags, so only selectors without flags match
+    PrecompileStyleTable(nodeTextStyleSelectors,false,nodeTextStyleResolutions);
+    PrecompileStyleTable(nodeIconStyleSelectors,false,nodeIconStyleResolutions);
+
+    wayLineStyleResolutions.resize(wayLineStyleSelectors.size());
+
+    for (size_t slot=0; slot<wayLineStyleSelectors.size(); slot++) {
+      PrecompileStyleTable(wayLineStyleSelectors[slot],false,wayLineStyleResolutions[slot]);
+    }
+
+    PrecompileStyleTable(wayPathTextStyleSelectors,false,wayPathTextStyleResolutions);
+    PrecompileStyleTable(wayPathSymbolStyleSelectors,false,wayPathSymbolStyleResolutions);
+    PrecompileStyleTable(wayPathShieldStyleSelectors,false,wayPathShieldStyleResolutions);
+
+    // Area criteria only evaluate the size condition
+    PrecompileStyleTable(areaFillStyleSelectors,true,areaFillStyleResolutions);
+    PrecompileStyleTable(areaTextStyleSelectors,true,areaTextStyleResolutions);
+    PrecompileStyleTable(areaIconStyleSelectors,true,areaIconStyleResolutions);
+  }
+
   void StyleConfig::Postprocess()
   {
     PostprocessNodes();
@@ -1766,6 +2044,8 @@ namespace osmscout {
 
     PostprocessIconId();
     PostprocessPatternId();
+
+    PrecompileStyles();
   }
 
   TypeConfig* StyleConfig::GetTypeConfig() const
@@ -2036,6 +2316,19 @@ namespace osmscout {
                                      double dpi,
                                      TextStyleRef& textStyle) const
   {
+    double meterInPixel=1/projection.GetPixelSize();
+    const TextStyleRef* style=GetPrecompiledStyle(nodeTextStyleResolutions,
+                                                  node.GetType(),
+                                                  projection.GetMagnification().GetLevel(),
+                                                  meterInPixel,
+                                                  meterInPixel*25.4/dpi,
+                                                  0);
+
+    if (style!=NULL) {
+      textStyle=*style;
+      return;
+    }
+
     GetNodeStyle(nodeTextStyleSelectors[node.GetType()],
                  node,
                  projection,
@@ -2048,6 +2341,19 @@ namespace osmscout {
                                      double dpi,
                                      IconStyleRef& iconStyle) const
   {
+    double meterInPixel=1/projection.GetPixelSize();
+    const IconStyleRef* style=GetPrecompiledStyle(nodeIconStyleResolutions,
+                                                  node.GetType(),
+                                                  projection.GetMagnification().GetLevel(),
+                                                  meterInPixel,
+                                                  meterInPixel*25.4/dpi,
+                                                  0);
+
+    if (style!=NULL) {
+      iconStyle=*style;
+      return;
+    }
+
     GetNodeStyle(nodeIconStyleSelectors[node.GetType()],
                  node,
                  projection,
@@ -2061,11 +2367,35 @@ namespace osmscout {
                                      std::vector<LineStyleRef>& lineStyles) const
   {
     LineStyleRef style;
+    size_t       level=projection.GetMagnification().GetLevel();
+    double       meterInPixel=1/projection.GetPixelSize();
+    double       meterInMM=meterInPixel*25.4/dpi;
+    uint8_t      flags=GetWayFlags(way);
 
     lineStyles.clear();
     lineStyles.reserve(wayLineStyleSelectors.size());
 
     for (size_t slot=0; slot<wayLineStyleSelectors.size(); slot++) {
+      const LineStyleRef* precompiledStyle=NULL;
+
+      if (slot<wayLineStyleResolutions.size()) {
+        precompiledStyle=GetPrecompiledStyle(wayLineStyleResolutions[slot],
+                                             way.GetType(),
+                                             level,
+                                             meterInPixel,
+                                             meterInMM,
+                                             flags);
+      }
+
+      // Avoid copying the reference, if there is no style
+      if (precompiledStyle!=NULL) {
+        if (precompiledStyle->Valid()) {
+          lineStyles.push_back(*precompiledStyle);
+        }
+
+        continue;
+      }
+
       style=NULL;
 
       GetObjectAttributesStyle(wayLineStyleSelectors[slot][way.GetType()],
@@ -2085,6 +2415,19 @@ namespace osmscout {
                                         double dpi,
                                         PathTextStyleRef& pathTextStyle) const
   {
+    double meterInPixel=1/projection.GetPixelSize();
+    const PathTextStyleRef* style=GetPrecompiledStyle(wayPathTextStyleResolutions,
+                                                      way.GetType(),
+                                                      projection.GetMagnification().GetLevel(),
+                                                      meterInPixel,
+                                                      meterInPixel*25.4/dpi,
+                                                      GetWayFlags(way));
+
+    if (style!=NULL) {
+      pathTextStyle=*style;
+      return;
+    }
+
     GetObjectAttributesStyle(wayPathTextStyleSelectors[way.GetType()],
                              way,
                              projection,
@@ -2097,6 +2440,19 @@ namespace osmscout {
                                           double dpi,
                                           PathSymbolStyleRef& pathSymbolStyle) const
   {
+    double meterInPixel=1/projection.GetPixelSize();
+    const PathSymbolStyleRef* style=GetPrecompiledStyle(wayPathSymbolStyleResolutions,
+                                                        way.GetType(),
+                                                        projection.GetMagnification().GetLevel(),
+                                                        meterInPixel,
+                                                        meterInPixel*25.4/dpi,
+                                                        GetWayFlags(way));
+
+    if (style!=NULL) {
+      pathSymbolStyle=*style;
+      return;
+    }
+
     GetObjectAttributesStyle(wayPathSymbolStyleSelectors[way.GetType()],
                              way,
                              projection,
@@ -2109,6 +2465,19 @@ namespace osmscout {
                                           double dpi,
                                           PathShieldStyleRef& pathShieldStyle) const
   {
+    double meterInPixel=1/projection.GetPixelSize();
+    const PathShieldStyleRef* style=GetPrecompiledStyle(wayPathShieldStyleResolutions,
+                                                        way.GetType(),
+                                                        projection.GetMagnification().GetLevel(),
+                                                        meterInPixel,
+                                                        meterInPixel*25.4/dpi,
+                                                        GetWayFlags(way));
+
+    if (style!=NULL) {
+      pathShieldStyle=*style;
+      return;
+    }
+
     GetObjectAttributesStyle(wayPathShieldStyleSelectors[way.GetType()],
                              way,
                              projection,
@@ -2122,6 +2491,19 @@ namespace osmscout {
                                      double dpi,
                                      FillStyleRef& fillStyle) const
   {
+    double meterInPixel=1/projection.GetPixelSize();
+    const FillStyleRef* style=GetPrecompiledStyle(areaFillStyleResolutions,
+                                                  type,
+                                                  projection.GetMagnification().GetLevel(),
+                                                  meterInPixel,
+                                                  meterInPixel*25.4/dpi,
+                                                  0);
+
+    if (style!=NULL) {
+      fillStyle=*style;
+      return;
+    }
+
     GetObjectAttributesStyle(areaFillStyleSelectors[type],
                              area,
                              projection,
@@ -2135,6 +2517,19 @@ namespace osmscout {
                                      double dpi,
                                      TextStyleRef& textStyle) const
   {
+    double meterInPixel=1/projection.GetPixelSize();
+    const TextStyleRef* style=GetPrecompiledStyle(areaTextStyleResolutions,
+                                                  type,
+                                                  projection.GetMagnification().GetLevel(),
+                                                  meterInPixel,
+                                                  meterInPixel*25.4/dpi,
+                                                  0);
+
+    if (style!=NULL) {
+      textStyle=*style;
+      return;
+    }
+
     GetObjectAttributesStyle(areaTextStyleSelectors[type],
                              area,
                              projection,
@@ -2148,6 +2543,19 @@ namespace osmscout {
                                      double dpi,
                                      IconStyleRef& iconStyle) const
   {
+    double meterInPixel=1/projection.GetPixelSize();
+    const IconStyleRef* style=GetPrecompiledStyle(areaIconStyleResolutions,
+                                                  type,
+                                                  projection.GetMagnification().GetLevel(),
+                                                  meterInPixel,
+                                                  meterInPixel*25.4/dpi,
+                                                  0);
+
+    if (style!=NULL) {
+      iconStyle=*style;
+      return;
+    }
+
     GetObjectAttributesStyle(areaIconStyleSelectors[type],
                              area,
                              projection,
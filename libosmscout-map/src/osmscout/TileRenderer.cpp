@@ -0,0 +1,644 @@
+/*
+  This source is part of the libosmscout-map library
+  Copyright (C) 2014  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <osmscout/TileRenderer.h>
+
+#include <algorithm>
+#include <iostream>
+
+#include <osmscout/system/Math.h>
+
+namespace osmscout {
+
+  // Maximum latitude of the tile pyramid
+  static const double tileLatMax=85.0511287798;
+
+  MapTile::MapTile()
+  : zoom(0),
+    x(0),
+    y(0)
+  {
+    // no code
+  }
+
+  MapTile::MapTile(size_t zoom,
+                   size_t x,
+                   size_t y)
+  : zoom(zoom),
+    x(x),
+    y(y)
+  {
+    // no code
+  }
+
+  bool MapTile::operator==(const MapTile& other) const
+  {
+    return zoom==other.zoom &&
+           x==other.x &&
+           y==other.y;
+  }
+
+  bool MapTile::operator<(const MapTile& other) const
+  {
+    if (zoom!=other.zoom) {
+      return zoom<other.zoom;
+    }
+
+    if (y!=other.y) {
+      return y<other.y;
+    }
+
+    return x<other.x;
+  }
+
+  /**
+    Return the longitude of the left border of the tile column x. x may
+    be fractional to address positions within the tile.
+    */
+  double MapTile::XToLon(double x,
+                         size_t zoom)
+  {
+    return x/pow(2.0,(double)zoom)*360.0-180.0;
+  }
+
+  /**
+    Return the latitude of the upper border of the tile row y. y may
+    be fractional to address positions within the tile.
+    */
+  double MapTile::YToLat(double y,
+                         size_t zoom)
+  {
+    double n=M_PI-2.0*M_PI*y/pow(2.0,(double)zoom);
+
+    return 180.0/M_PI*atan(0.5*(exp(n)-exp(-n)));
+  }
+
+  size_t MapTile::LonToX(double lon,
+                         size_t zoom)
+  {
+    return (size_t)(floor((lon+180.0)/360.0*pow(2.0,(double)zoom)));
+  }
+
+  size_t MapTile::LatToY(double lat,
+                         size_t zoom)
+  {
+    return (size_t)(floor((1.0-log(tan(lat*M_PI/180.0)+1.0/cos(lat*M_PI/180.0))/M_PI)/2.0*pow(2.0,(double)zoom)));
+  }
+
+  TileRenderBackend::~TileRenderBackend()
+  {
+    // no code
+  }
+
+  /**
+    Return the MapPainter used by DrawTile() to allow sharing of prepared
+    draw data between the tiles of a metatile. The default implementation
+    returns NULL, which disables sharing.
+    */
+  MapPainter* TileRenderBackend::GetMapPainter()
+  {
+    return NULL;
+  }
+
+  TileRenderBackendFactory::~TileRenderBackendFactory()
+  {
+    // no code
+  }
+
+  TileRendererParameter::TileRendererParameter()
+  : workerCount(0),
+    metaTileSize(1),
+    tileWidth(256),
+    tileHeight(256),
+    prepareMetaTiles(true)
+  {
+    // no code
+  }
+
+  /**
+    Set the number of worker threads. If 0 is given (the default), one
+    worker per hardware thread is used.
+    */
+  void TileRendererParameter::SetWorkerCount(size_t workerCount)
+  {
+    this->workerCount=workerCount;
+  }
+
+  void TileRendererParameter::SetMetaTileSize(size_t metaTileSize)
+  {
+    this->metaTileSize=std::max((size_t)1,metaTileSize);
+  }
+
+  void TileRendererParameter::SetTileSize(size_t width,
+                                          size_t height)
+  {
+    this->tileWidth=width;
+    this->tileHeight=height;
+  }
+
+  void TileRendererParameter::SetPrepareMetaTiles(bool prepareMetaTiles)
+  {
+    this->prepareMetaTiles=prepareMetaTiles;
+  }
+
+  size_t TileRendererParameter::GetWorkerCount() const
+  {
+    return workerCount;
+  }
+
+  size_t TileRendererParameter::GetMetaTileSize() const
+  {
+    return metaTileSize;
+  }
+
+  size_t TileRendererParameter::GetTileWidth() const
+  {
+    return tileWidth;
+  }
+
+  size_t TileRendererParameter::GetTileHeight() const
+  {
+    return tileHeight;
+  }
+
+  bool TileRendererParameter::GetPrepareMetaTiles() const
+  {
+    return prepareMetaTiles;
+  }
+
+  bool TileRenderer::MetaTileKey::operator<(const MetaTileKey& other) const
+  {
+    if (zoom!=other.zoom) {
+      return zoom<other.zoom;
+    }
+
+    if (y!=other.y) {
+      return y<other.y;
+    }
+
+    return x<other.x;
+  }
+
+  bool TileRenderer::QueueEntry::operator<(const QueueEntry& other) const
+  {
+    if (priority!=other.priority) {
+      return priority>other.priority;
+    }
+
+    return sequence<other.sequence;
+  }
+
+  TileRenderer::TileRenderer(const Database& database,
+                             const StyleConfig& styleConfig,
+                             const MapParameter& drawParameter,
+                             const AreaSearchParameter& searchParameter,
+                             const TileRendererParameter& parameter)
+  : database(database),
+    styleConfig(styleConfig),
+    drawParameter(drawParameter),
+    searchParameter(searchParameter),
+    parameter(parameter),
+    nextSequence(0),
+    runningWorkers(0),
+    tileCount(0),
+    metaTileCount(0),
+    errorCount(0)
+#if defined(OSMSCOUT_HAVE_THREAD)
+    ,stop(false)
+#endif
+  {
+    // no code
+  }
+
+  TileRenderer::~TileRenderer()
+  {
+    Stop();
+  }
+
+  /**
+    Remove the metatile with the highest priority from the queue. Must
+    be called with the mutex locked.
+    */
+  bool TileRenderer::PopMetaTile(MetaTileKey& key,
+                                 std::vector<MapTile>& tiles)
+  {
+    if (queue.empty()) {
+      return false;
+    }
+
+    std::set<QueueEntry>::iterator                  entry=queue.begin();
+    std::map<MetaTileKey,PendingMetaTile>::iterator metaTile=pending.find(entry->key);
+
+    key=entry->key;
+    tiles.swap(metaTile->second.tiles);
+
+    pending.erase(metaTile);
+    queue.erase(entry);
+
+    return true;
+  }
+
+  void TileRenderer::RenderMetaTile(TileRenderBackend& backend,
+                                    const MetaTileKey& key,
+                                    const std::vector<MapTile>& tiles)
+  {
+    Magnification        magnification;
+    TypeSet              nodeTypes;
+    std::vector<TypeSet> wayTypes;
+    TypeSet              areaTypes;
+    MapData              data;
+    MercatorProjection   projection;
+    size_t               xMin=tiles.front().x;
+    size_t               xMax=tiles.front().x;
+    size_t               yMin=tiles.front().y;
+    size_t               yMax=tiles.front().y;
+    size_t               tilesRendered=0;
+
+    magnification.SetLevel(key.zoom);
+
+    styleConfig.GetNodeTypesWithMaxMag(magnification,
+                                       nodeTypes);
+
+    styleConfig.GetWayTypesByPrioWithMaxMag(magnification,
+                                            wayTypes);
+
+    styleConfig.GetAreaTypesWithMaxMag(magnification,
+                                       areaTypes);
+
+    // We only load the data for the requested tiles of the metatile
+    for (std::vector<MapTile>::const_iterator tile=tiles.begin();
+         tile!=tiles.end();
+         ++tile) {
+      xMin=std::min(xMin,tile->x);
+      xMax=std::max(xMax,tile->x);
+      yMin=std::min(yMin,tile->y);
+      yMax=std::max(yMax,tile->y);
+    }
+
+    // Ways are loaded for the tiles only, while nodes and areas are loaded
+    // with a border of one tile, so that labels crossing the tile border
+    // are drawn consistently in neighbouring tiles (see Tiler)
+    double wayLonMin=MapTile::XToLon(xMin,key.zoom);
+    double wayLonMax=MapTile::XToLon(xMax+1,key.zoom);
+    double wayLatMin=MapTile::YToLat(yMax+1,key.zoom);
+    double wayLatMax=MapTile::YToLat(yMin,key.zoom);
+
+    double lonMin=std::max(-180.0,MapTile::XToLon((double)xMin-1.0,key.zoom));
+    double lonMax=std::min(180.0,MapTile::XToLon(xMax+2,key.zoom));
+    double latMin=std::max(-tileLatMax,MapTile::YToLat(yMax+2,key.zoom));
+    double latMax=std::min(tileLatMax,MapTile::YToLat((double)yMin-1.0,key.zoom));
+
+    if (!database.GetObjects(searchParameter,
+                             magnification,
+                             nodeTypes,
+                             lonMin,latMin,
+                             lonMax,latMax,
+                             data.nodes,
+                             wayTypes,
+                             wayLonMin,wayLatMin,
+                             wayLonMax,wayLatMax,
+                             data.ways,
+                             areaTypes,
+                             lonMin,latMin,
+                             lonMax,latMax,
+                             data.areas)) {
+      std::cerr << "Cannot load data for metatile " << key.zoom << "/" << key.x << "/" << key.y << std::endl;
+    }
+    else {
+      MapPainter                *painter=backend.GetMapPainter();
+      MapPainter::PreparedData  prepared;
+      bool                      usePrepared=false;
+
+      if (painter!=NULL &&
+          parameter.GetPrepareMetaTiles() &&
+          tiles.size()>1) {
+        MercatorProjection lastProjection;
+        double             lastLon=MapTile::XToLon(xMax+0.5,key.zoom);
+        double             lastLat=MapTile::YToLat(yMax+0.5,key.zoom);
+        double             x,y,lastX,lastY;
+
+        // The pixel space of the upper left tile is the shared pixel space of
+        // the metatile, it is extended to the lower right corner of the last tile
+        projection.Set(MapTile::XToLon(xMin+0.5,key.zoom),
+                       MapTile::YToLat(yMin+0.5,key.zoom),
+                       magnification,
+                       parameter.GetTileWidth(),
+                       parameter.GetTileHeight());
+
+        lastProjection.Set(lastLon,
+                           lastLat,
+                           magnification,
+                           parameter.GetTileWidth(),
+                           parameter.GetTileHeight());
+
+        projection.GeoToPixel(lastLon,lastLat,x,y);
+        lastProjection.GeoToPixel(lastLon,lastLat,lastX,lastY);
+
+        usePrepared=painter->PrepareData(styleConfig,
+                                         projection,
+                                         drawParameter,
+                                         data,
+                                         x-lastX+parameter.GetTileWidth(),
+                                         y-lastY+parameter.GetTileHeight(),
+                                         prepared);
+
+        if (usePrepared) {
+          painter->SetPreparedData(&prepared);
+        }
+      }
+
+      for (std::vector<MapTile>::const_iterator tile=tiles.begin();
+           tile!=tiles.end();
+           ++tile) {
+        projection.Set(MapTile::XToLon(tile->x+0.5,tile->zoom),
+                       MapTile::YToLat(tile->y+0.5,tile->zoom),
+                       magnification,
+                       parameter.GetTileWidth(),
+                       parameter.GetTileHeight());
+
+        if (backend.DrawTile(styleConfig,
+                             projection,
+                             drawParameter,
+                             data,
+                             *tile)) {
+          tilesRendered++;
+        }
+        else {
+          std::cerr << "Cannot draw tile " << tile->zoom << "/" << tile->x << "/" << tile->y << std::endl;
+        }
+      }
+
+      if (usePrepared) {
+        painter->SetPreparedData(NULL);
+      }
+    }
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+    std::unique_lock<std::mutex> lock(mutex);
+#endif
+
+    tileCount+=tilesRendered;
+    errorCount+=tiles.size()-tilesRendered;
+    metaTileCount++;
+  }
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+  void TileRenderer::Work(size_t worker)
+  {
+    MetaTileKey          key;
+    std::vector<MapTile> tiles;
+
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (!stop && queue.empty()) {
+          wakeCondition.wait(lock);
+        }
+
+        if (stop) {
+          return;
+        }
+
+        PopMetaTile(key,tiles);
+        runningWorkers++;
+      }
+
+      RenderMetaTile(*backends[worker],
+                     key,
+                     tiles);
+
+      tiles.clear();
+
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        runningWorkers--;
+
+        if (runningWorkers==0 && queue.empty()) {
+          doneCondition.notify_all();
+        }
+      }
+    }
+  }
+#endif
+
+  /**
+    Create one backend per worker using the given factory and start
+    the workers. The renderer takes ownership of the backends.
+    */
+  bool TileRenderer::Start(TileRenderBackendFactory& factory)
+  {
+    size_t workerCount=parameter.GetWorkerCount();
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+    if (workerCount==0) {
+      workerCount=std::thread::hardware_concurrency();
+    }
+#else
+    workerCount=1;
+#endif
+
+    if (workerCount==0) {
+      workerCount=1;
+    }
+
+    for (size_t worker=0; worker<workerCount; worker++) {
+      TileRenderBackend *backend=factory.CreateBackend(worker);
+
+      if (backend==NULL) {
+        std::cerr << "Cannot create tile render backend for worker " << worker << std::endl;
+        Stop();
+        return false;
+      }
+
+      backends.push_back(backend);
+    }
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+    stop=false;
+
+    for (size_t worker=0; worker<workerCount; worker++) {
+      threads.push_back(std::thread(&TileRenderer::Work,this,worker));
+    }
+#endif
+
+    return true;
+  }
+
+  /**
+    Stop the workers and delete the backends. Requests not yet started
+    are dropped, metatiles currently rendered are finished first.
+    */
+  void TileRenderer::Stop()
+  {
+#if defined(OSMSCOUT_HAVE_THREAD)
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+
+      stop=true;
+      pending.clear();
+      queue.clear();
+    }
+
+    wakeCondition.notify_all();
+    doneCondition.notify_all();
+
+    for (size_t i=0; i<threads.size(); i++) {
+      threads[i].join();
+    }
+
+    threads.clear();
+#else
+    pending.clear();
+    queue.clear();
+#endif
+
+    for (size_t i=0; i<backends.size(); i++) {
+      delete backends[i];
+    }
+
+    backends.clear();
+  }
+
+  /**
+    Add a request for rendering the given tile. Requests with a higher
+    priority are rendered first. Requesting a tile that is still pending
+    only raises the priority of the pending request, if necessary.
+    */
+  void TileRenderer::AddRequest(const MapTile& tile,
+                                int priority)
+  {
+    MetaTileKey key;
+
+    key.zoom=tile.zoom;
+    key.x=tile.x/parameter.GetMetaTileSize();
+    key.y=tile.y/parameter.GetMetaTileSize();
+
+    {
+#if defined(OSMSCOUT_HAVE_THREAD)
+      std::unique_lock<std::mutex> lock(mutex);
+#endif
+
+      std::map<MetaTileKey,PendingMetaTile>::iterator metaTile=pending.find(key);
+
+      if (metaTile==pending.end()) {
+        PendingMetaTile newMetaTile;
+        QueueEntry      entry;
+
+        newMetaTile.priority=priority;
+        newMetaTile.sequence=nextSequence++;
+        newMetaTile.tiles.push_back(tile);
+
+        entry.priority=newMetaTile.priority;
+        entry.sequence=newMetaTile.sequence;
+        entry.key=key;
+
+        pending[key]=newMetaTile;
+        queue.insert(entry);
+      }
+      else {
+        if (std::find(metaTile->second.tiles.begin(),
+                      metaTile->second.tiles.end(),
+                      tile)==metaTile->second.tiles.end()) {
+          metaTile->second.tiles.push_back(tile);
+        }
+
+        if (priority>metaTile->second.priority) {
+          QueueEntry entry;
+
+          entry.priority=metaTile->second.priority;
+          entry.sequence=metaTile->second.sequence;
+          entry.key=key;
+
+          queue.erase(entry);
+
+          metaTile->second.priority=priority;
+          entry.priority=priority;
+
+          queue.insert(entry);
+        }
+      }
+    }
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+    wakeCondition.notify_one();
+#endif
+  }
+
+  /**
+    Wait until all requests have been rendered.
+    */
+  void TileRenderer::Wait()
+  {
+#if defined(OSMSCOUT_HAVE_THREAD)
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (!stop && (!queue.empty() || runningWorkers>0)) {
+      doneCondition.wait(lock);
+    }
+#else
+    MetaTileKey          key;
+    std::vector<MapTile> tiles;
+
+    if (backends.empty()) {
+      return;
+    }
+
+    while (PopMetaTile(key,tiles)) {
+      RenderMetaTile(*backends.front(),
+                     key,
+                     tiles);
+      tiles.clear();
+    }
+#endif
+  }
+
+  size_t TileRenderer::GetWorkerCount() const
+  {
+    return backends.size();
+  }
+
+  size_t TileRenderer::GetTileCount() const
+  {
+#if defined(OSMSCOUT_HAVE_THREAD)
+    std::unique_lock<std::mutex> lock(mutex);
+#endif
+
+    return tileCount;
+  }
+
+  size_t TileRenderer::GetMetaTileCount() const
+  {
+#if defined(OSMSCOUT_HAVE_THREAD)
+    std::unique_lock<std::mutex> lock(mutex);
+#endif
+
+    return metaTileCount;
+  }
+
+  size_t TileRenderer::GetErrorCount() const
+  {
+#if defined(OSMSCOUT_HAVE_THREAD)
+    std::unique_lock<std::mutex> lock(mutex);
+#endif
+
+    return errorCount;
+  }
+}
@@ -64,6 +64,7 @@ namespace osmscout {
                uint8_t flags) const;
 
     friend class Area;
+    friend class AreaView;
 
   public:
     inline AreaAttributes()
@@ -116,6 +117,8 @@ namespace osmscout {
                  const TypeConfig& typeConfig,
                  std::vector<Tag>& tags);
 
+    size_t GetMemorySize() const;
+
     bool operator==(const AreaAttributes& other) const;
     bool operator!=(const AreaAttributes& other) const;
   };
@@ -216,6 +219,8 @@ namespace osmscout {
                         double& minLat,
                         double& maxLat) const;
 
+    size_t GetMemorySize() const;
+
     bool ReadIds(FileScanner& scanner,
                  uint32_t nodesCount,
                  std::vector<Id>& ids);
@@ -24,8 +24,11 @@
 
 #include <osmscout/TypeSet.h>
 
+#include <osmscout/util/Breaker.h>
 #include <osmscout/util/Cache.h>
+#include <osmscout/util/CacheMemoryGovernor.h>
 #include <osmscout/util/FileScanner.h>
+#include <osmscout/util/Mutex.h>
 
 namespace osmscout {
 
@@ -40,6 +43,13 @@ namespace osmscout {
 
     Internally the index is implemented as quadtree. As a result each index entry
     has 4 children (besides entries in the lowest level).
+
+    Optionally the complete index can be loaded into memory. The cells are
+    then stored in one array (in breadth first order, children referenced
+    by their index) and the entries of all cells in a second array, sorted
+    by type within each cell. For each cell a bitmap of the types in its
+    subtree is held, so that subtrees without any of the requested types are
+    skipped. Queries then do not need any file access or cache lookup.
     */
   class OSMSCOUT_API AreaAreaIndex
   {
@@ -79,6 +89,36 @@ namespace osmscout {
       }
     };
 
+    typedef GovernedCacheAdapter<IndexCache> GovernedIndexCache;
+
+    /**
+      An index cell of the in memory index. The entries of the cell are
+      memoryEntries[firstEntry,firstEntry+entryCount[.
+      */
+    struct MemoryCell
+    {
+      uint32_t children[4]; //! Index of each of the four children, or 0 if there is no child
+      uint32_t firstEntry;
+      uint32_t entryCount;
+    };
+
+    struct MemoryCellRef
+    {
+      uint32_t index;
+      size_t   x;
+      size_t   y;
+
+      MemoryCellRef(uint32_t index,
+                    size_t x,
+                    size_t y)
+      : index(index),
+        x(x),
+        y(y)
+      {
+        // no code
+      }
+    };
+
     struct CellRef
     {
       FileOffset offset;
@@ -100,6 +140,7 @@ namespace osmscout {
     std::string                     filepart;       //! name of the data file
     std::string                     datafilename;   //! Fullpath and name of the data file
     mutable FileScanner             scanner;        //! Scanner instance for reading this file
+    mutable Mutex                   accessMutex;    //! Mutex to secure multi-thread access to the scanner
 
     std::vector<double>             cellWidth;      //! Precalculated cellWidth for each level of the quadtree
     std::vector<double>             cellHeight;     //! Precalculated cellHeight for each level of the quadtree
@@ -107,14 +148,53 @@ namespace osmscout {
     FileOffset                      topLevelOffset; //! File offset of the top level index entry
 
     mutable IndexCache              indexCache;     //! Cached map of all index entries by file offset
+    IndexCacheValueSizer            cacheSizer;     //! Sizer for the entries of the index cache
+    GovernedIndexCache              governedCache;  //! Interface for the memory governor
+    CacheMemoryGovernorRef          governor;       //! Memory governor, if the cache is limited by memory
+
+    bool                            inMemory;       //! Load the complete index into memory
+    std::vector<MemoryCell>         memoryCells;    //! All cells of the in memory index, the top level cell first
+    std::vector<IndexEntry>         memoryEntries;  //! Entries of all cells of the in memory index
+    size_t                          typeWordCount;  //! Number of words of a type bitmap
+    std::vector<uint64_t>           subtreeTypes;   //! Bitmap of the types in the subtree of each cell
 
   private:
     bool GetIndexCell(uint32_t level,
                       FileOffset offset,
                       IndexCache::CacheRef& cacheRef) const;
 
+    static bool IndexEntryTypeLess(const IndexEntry& a,
+                                   const IndexEntry& b);
+
+    bool LoadMemoryIndex();
+
+    inline bool HasSubtreeTypes(uint32_t cell,
+                                const std::vector<uint64_t>& types) const
+    {
+      const uint64_t* cellTypes=&subtreeTypes[cell*typeWordCount];
+
+      for (size_t w=0; w<typeWordCount; w++) {
+        if ((cellTypes[w] & types[w])!=0) {
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    bool GetOffsetsInMemory(double minlon,
+                            double minlat,
+                            double maxlon,
+                            double maxlat,
+                            size_t maxLevel,
+                            const TypeSet& types,
+                            size_t maxCount,
+                            std::vector<FileOffset>& offsets) const;
+
   public:
-    AreaAreaIndex(size_t cacheSize);
+    AreaAreaIndex(size_t cacheSize,
+                  bool inMemory=false);
+    ~AreaAreaIndex();
 
     void Close();
     bool Load(const std::string& path);
@@ -128,6 +208,12 @@ namespace osmscout {
                     size_t maxCount,
                     std::vector<FileOffset>& offsets) const;
 
+    void GetCachedOffsets(std::vector<FileOffset>& offsets) const;
+    bool LoadCells(const std::vector<FileOffset>& offsets,
+                   const BreakerRef& breaker=BreakerRef()) const;
+
+    void SetCacheMemoryGovernor(const CacheMemoryGovernorRef& governor);
+
     void DumpStatistics();
   };
 }
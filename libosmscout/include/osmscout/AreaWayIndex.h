@@ -26,6 +26,7 @@
 
 #include <osmscout/util/FileScanner.h>
 #include <osmscout/util/HashSet.h>
+#include <osmscout/util/Mutex.h>
 
 namespace osmscout {
 
@@ -68,6 +69,7 @@ namespace osmscout {
     std::string           filepart;       //! name of the data file
     std::string           datafilename;   //! Full path and name of the data file
     mutable FileScanner   scanner;        //! Scanner instance for reading this file
+    mutable Mutex         accessMutex;    //! Mutex to secure multi-thread access to the scanner
 
     std::vector<TypeData> wayTypeData;
 
@@ -61,6 +61,12 @@ namespace osmscout {
       // no code
     }
 
+    explicit AttributeAccess(uint8_t access)
+    : access(access)
+    {
+      // no code
+    }
+
     inline uint8_t GetAccess()
     {
       return access;
@@ -0,0 +1,216 @@
+#ifndef OSMSCOUT_CONTRACTIONHIERARCHY_H
+#define OSMSCOUT_CONTRACTIONHIERARCHY_H
+
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2014  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <string>
+#include <vector>
+
+#include <osmscout/private/CoreImportExport.h>
+
+#include <osmscout/Types.h>
+
+#include <osmscout/util/Reference.h>
+
+namespace osmscout {
+
+  /**
+   * A contraction hierarchy of the routing graph of one vehicle (as stored
+   * in the route node data file) for one fixed routing profile.
+   *
+   * Nodes are the route nodes, addressed by a dense 32 bit index in the order
+   * of their file offset. Nodes were contracted one after another, bypassed
+   * paths were replaced by shortcut edges. For each node only the edges
+   * to nodes contracted later ("upwards") are stored. A route is found by a
+   * bidirectional search from start and target that only follows these edges.
+   *
+   * Nodes with turn restrictions or with paths without access rights are not
+   * contracted ("core nodes"), since these rules depend on the path used to arrive
+   * at the node. Core nodes store all their edges to other core nodes, the search
+   * is a plain bidirectional Dijkstra between them and evaluates the rules
+   * stored for each core node.
+   *
+   * Shortcut edges store the bypassed node, at which the two replaced edges
+   * can be found, so routes can be unpacked into the original route node paths.
+   */
+  class OSMSCOUT_API ContractionHierarchy : public Referencable
+  {
+  public:
+    static const uint32_t noNode   = 0xffffffff; //! Marker for "no node", "no path" or "no object"
+
+    static const uint8_t  forward  = 1 << 0;     //! The edge leads from the node to the other node
+    static const uint8_t  backward = 1 << 1;     //! The edge leads from the other node to the node
+    static const uint8_t  noAccess = 1 << 2;     //! The last route node path of the edge has no access rights
+
+    /**
+     * An edge between a node and a node higher up in the hierarchy, either an
+     * original route node path or a shortcut. Source and target refer to the
+     * direction of travel.
+     */
+    struct OSMSCOUT_API Edge
+    {
+      uint32_t node;         //! The other node
+      uint32_t middle;       //! The bypassed node of a shortcut or noNode
+      uint32_t sourcePath;   //! Index of the first route node path at the source node
+      uint32_t targetObject; //! Index of the object used to arrive at the target node (in its object list)
+      double   cost;         //! Costs as calculated by the routing profile
+      uint8_t  flags;        //! Direction and access flags
+
+      inline bool IsForward() const
+      {
+        return (flags & forward)!=0;
+      }
+
+      inline bool IsBackward() const
+      {
+        return (flags & backward)!=0;
+      }
+
+      inline bool HasAccess() const
+      {
+        return (flags & noAccess)==0;
+      }
+
+      inline bool IsShortcut() const
+      {
+        return middle!=noNode;
+      }
+    };
+
+    /**
+     * A turn restriction of a core node, see RouteNode::Exclude
+     */
+    struct OSMSCOUT_API Exclude
+    {
+      uint32_t sourceObject; //! Index of the object arriving at the node
+      uint32_t targetPath;   //! Index of the path that cannot be used
+    };
+
+    /**
+     * A single original route node path of a route, the path with the given
+     * index of the route node of the given node.
+     */
+    struct OSMSCOUT_API Step
+    {
+      uint32_t node; //! The node
+      uint32_t path; //! Index of the path of the route node
+    };
+
+    /**
+     * Rules of a node, that depend on the path used to arrive at it.
+     */
+    struct OSMSCOUT_API CoreNode
+    {
+      std::vector<Exclude> excludes;   //! Turn restrictions
+      std::vector<bool>    pathAccess; //! Access rights for each path of the route node
+    };
+
+  private:
+    uint64_t                profileHash; //! Cost hash of the routing profile (see RoutingProfile::GetCostHash())
+    std::vector<FileOffset> offsets;     //! File offset of the route node for each node, ascending
+    std::vector<uint32_t>   firstEdges;  //! Index of the first edge for each node (plus end marker)
+    std::vector<Edge>       edges;       //! Edges of all nodes
+    std::vector<uint32_t>   coreIndexes; //! Index into coreNodes for each node or noNode
+    std::vector<CoreNode>   coreNodes;   //! Rules of the core nodes
+
+  public:
+    ContractionHierarchy();
+    virtual ~ContractionHierarchy();
+
+    void Clear();
+
+    void SetProfileHash(uint64_t profileHash);
+
+    inline uint64_t GetProfileHash() const
+    {
+      return profileHash;
+    }
+
+    uint32_t AddNode(FileOffset offset,
+                     const std::vector<Edge>& nodeEdges);
+    void SetCoreNode(uint32_t node,
+                     const CoreNode& coreNode);
+
+    uint32_t GetNode(FileOffset offset) const;
+
+    inline size_t GetNodeCount() const
+    {
+      return offsets.size();
+    }
+
+    inline size_t GetEdgeCount() const
+    {
+      return edges.size();
+    }
+
+    inline size_t GetCoreNodeCount() const
+    {
+      return coreNodes.size();
+    }
+
+    inline FileOffset GetOffset(uint32_t node) const
+    {
+      return offsets[node];
+    }
+
+    /**
+     * Return the index of the first edge of the given node
+     */
+    inline uint32_t GetEdgesBegin(uint32_t node) const
+    {
+      return firstEdges[node];
+    }
+
+    /**
+     * Return the index after the last edge of the given node
+     */
+    inline uint32_t GetEdgesEnd(uint32_t node) const
+    {
+      return firstEdges[node+1];
+    }
+
+    inline const Edge& GetEdge(uint32_t index) const
+    {
+      return edges[index];
+    }
+
+    inline bool IsCoreNode(uint32_t node) const
+    {
+      return coreIndexes[node]!=noNode;
+    }
+
+    bool Unpack(uint32_t source,
+                uint32_t target,
+                const Edge& edge,
+                std::vector<Step>& steps) const;
+
+    bool CanTurn(uint32_t node,
+                 uint32_t sourceObject,
+                 bool sourceAccess,
+                 uint32_t targetPath) const;
+
+    bool Read(const std::string& filename);
+    bool Write(const std::string& filename) const;
+  };
+
+  typedef Ref<ContractionHierarchy> ContractionHierarchyRef;
+}
+
+#endif
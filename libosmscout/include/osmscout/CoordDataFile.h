@@ -33,12 +33,35 @@
 
 namespace osmscout {
 
+  /**
+   * Access to the coordinates of all OSM nodes as written during preprocessing
+   * (coord.dat).
+   *
+   * The file starts with a header (layout, number of entries, id of the first
+   * entry) followed by an array of fixed size records in one of two layouts:
+   * - layoutDense: one record (lat, lon) for each OSM id starting with the
+   *   first id, ids without node are marked with 0xffffffff. The record of an
+   *   id is addressed directly, this is the best choice for (nearly) complete
+   *   id ranges like the planet.
+   * - layoutSparse: one record (id, lat, lon) for each node, sorted by id.
+   *   Records are grouped into blocks of sparseBlockSize entries, the first id
+   *   of each block is held in memory, so a lookup needs one binary search in
+   *   memory and a sequential read of one block. This is the best choice for
+   *   extracts.
+   *
+   * In both cases the (1 based) index of the record is used as substitute id
+   * for the node.
+   */
   class OSMSCOUT_API CoordDataFile
   {
-  private:
-    typedef OSMSCOUT_HASHMAP<PageId,FileOffset> CoordPageOffsetMap;
-
   public:
+    enum Layout {
+      layoutDense  = 1,
+      layoutSparse = 2
+    };
+
+    static const size_t sparseBlockSize = 256; //! Number of records of one block in the sparse layout
+
     struct CoordEntry
     {
       Point point;
@@ -55,12 +78,27 @@ namespace osmscout {
     typedef OSMSCOUT_HASHMAP<OSMId,CoordEntry> CoordResultMap;
 
   private:
-    bool                isOpen;             //! If true,the data file is opened
-    std::string         datafile;           //! Basename part of the data file name
-    std::string         datafilename;       //! complete filename for data file
-    mutable FileScanner scanner;            //! File stream to the data file
-    uint32_t            coordPageSize;
-    CoordPageOffsetMap  coordPageOffsetMap;
+    bool                          isOpen;         //! If true,the data file is opened
+    std::string                   datafile;       //! Basename part of the data file name
+    std::string                   datafilename;   //! complete filename for data file
+    mutable FileScanner           scanner;        //! File stream to the data file
+    Layout                        layout;         //! Layout of the data
+    Id                            coordCount;     //! Number of records
+    OSMId                         minId;          //! Id of the first record
+    FileOffset                    dataOffset;     //! Offset of the first record
+    std::vector<OSMId>            blockIds;       //! Sparse layout: id of the first record of each block
+
+    mutable size_t                currentBlock;   //! Sparse layout: index of the block currently loaded
+    mutable std::vector<OSMId>    blockEntryIds;  //! Sparse layout: ids of the current block
+    mutable std::vector<uint32_t> blockEntryLats; //! Sparse layout: latitudes of the current block
+    mutable std::vector<uint32_t> blockEntryLons; //! Sparse layout: longitudes of the current block
+
+  private:
+    bool LoadBlock(size_t block) const;
+    bool GetDense(const std::vector<OSMId>& ids,
+                  CoordResultMap& coordsMap) const;
+    bool GetSparse(const std::vector<OSMId>& ids,
+                   CoordResultMap& coordsMap) const;
 
   public:
     CoordDataFile(const std::string& datafile);
@@ -71,6 +109,13 @@ namespace osmscout {
               bool memoryMapedData);
     bool Close();
 
+    inline Layout GetLayout() const
+    {
+      return layout;
+    }
+
+    bool Get(const std::vector<OSMId>& ids,
+             CoordResultMap& coordsMap) const;
     bool Get(std::set<OSMId>& ids,
              CoordResultMap& coordsMap) const;
   };
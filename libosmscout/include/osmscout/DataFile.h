@@ -20,17 +20,41 @@
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
 */
 
+#include <algorithm>
 #include <set>
 #include <vector>
 
 #include <osmscout/NumericIndex.h>
 
 #include <osmscout/util/Cache.h>
+#include <osmscout/util/CacheMemoryGovernor.h>
 #include <osmscout/util/FileScanner.h>
+#include <osmscout/util/Mutex.h>
 #include <osmscout/util/Reference.h>
 
 namespace osmscout {
 
+  /**
+    Access to a file containing serialized objects of type N.
+
+    Objects are referenced by their file offset. Read objects are held in a
+    cache, so multiple requests for the same object share the same instance.
+
+    All const methods are threadsafe, so multiple threads can load objects
+    from the same DataFile instance in parallel. The cache can be split into
+    multiple shards to reduce lock contention in this case. Reading objects
+    that are not in the cache is serialized.
+
+    Instead of a fixed number of entries the cache can get its size assigned
+    by a CacheMemoryGovernor. The memory of an entry is then calculated by
+    calling GetMemorySize() on the object.
+
+    If multiple objects are requested at once, the missing objects are read
+    in file order. Before reading, the file ranges of all of them are handed
+    to the operating system for asynchronous readahead, so that (for not
+    memory mapped files on slow storage) the reads do not wait for one seek
+    after the other.
+    */
   template <class N>
   class DataFile
   {
@@ -38,30 +62,59 @@ namespace osmscout {
     typedef Ref<N> ValueType;
 
   private:
-    typedef Cache<FileOffset,ValueType> DataCache;
+    typedef ShardedCache<FileOffset,ValueType> DataCache;
+    typedef std::pair<size_t,FileOffset>       Miss;
+
+    //! Objects with a smaller gap between them are prefetched as one range
+    static const FileOffset prefetchGapSize=16*1024;
+    //! Number of bytes prefetched after the start of the last object of a range
+    static const FileOffset prefetchTailSize=4*1024;
+
+    static bool MissOffsetLess(const Miss& a,
+                               const Miss& b)
+    {
+      return a.second<b.second;
+    }
 
     struct DataCacheValueSizer : public DataCache::ValueSizer
     {
       unsigned long GetSize(const ValueType& value) const
       {
-        return sizeof(value);
+        return sizeof(value)+value->GetMemorySize();
       }
     };
 
+    typedef GovernedCacheAdapter<DataCache> GovernedDataCache;
+
   private:
-    std::string         datafile;        //! Basename part fo the data file name
-    std::string         datafilename;    //! complete filename for data file
-    FileScanner::Mode   modeData;        //! Type of file access
-    bool                memoryMapedData; //! Use memory mapped files for data access
-    mutable DataCache   cache;           //! Entry cache
-    mutable FileScanner scanner;         //! File stream to the data file
+    std::string            datafile;        //! Basename part fo the data file name
+    std::string            datafilename;    //! complete filename for data file
+    FileScanner::Mode      modeData;        //! Type of file access
+    bool                   memoryMapedData; //! Use memory mapped files for data access
+    mutable DataCache      cache;           //! Entry cache
+    DataCacheValueSizer    cacheSizer;      //! Sizer for the entries of the cache
+    GovernedDataCache      governedCache;   //! Interface for the memory governor
+    CacheMemoryGovernorRef governor;        //! Memory governor, if the cache is limited by memory
+    mutable FileScanner    scanner;         //! File stream to the data file
+    mutable Mutex          accessMutex;     //! Mutex to secure multi-thread access to the scanner
 
   protected:
-    bool                isOpen;          //! If true,the data file is opened
+    bool                   isOpen;          //! If true,the data file is opened
+
+  private:
+    bool ReadData(const FileOffset& offset,
+                  ValueType& entry) const;
+
+    void PrefetchData(const std::vector<Miss>& misses) const;
+
+    template <typename IteratorIn>
+    bool GetByOffset(IteratorIn begin, IteratorIn end, size_t size,
+                     std::vector<ValueType>& data) const;
 
   public:
     DataFile(const std::string& datafile,
-             unsigned long dataCacheSize);
+             unsigned long dataCacheSize,
+             size_t dataCacheShards=1);
 
     virtual ~DataFile();
 
@@ -83,17 +136,27 @@ namespace osmscout {
     bool GetByOffset(const FileOffset& offset,
                      ValueType& entry) const;
 
+    template <class V>
+    bool GetViewsByOffset(const std::vector<FileOffset>& offsets,
+                          std::vector<V>& views) const;
+
+    void GetCachedOffsets(std::vector<FileOffset>& offsets) const;
+
+    void SetCacheMemoryGovernor(const CacheMemoryGovernorRef& governor);
+
     void FlushCache();
     void DumpStatistics() const;
   };
 
   template <class N>
   DataFile<N>::DataFile(const std::string& datafile,
-                        unsigned long dataCacheSize)
+                        unsigned long dataCacheSize,
+                        size_t dataCacheShards)
   : datafile(datafile),
     modeData(FileScanner::LowMemRandom),
     memoryMapedData(false),
-    cache(dataCacheSize),
+    cache(dataCacheSize,dataCacheShards),
+    governedCache(datafile,cache),
     isOpen(false)
 
   {
@@ -106,6 +169,10 @@ namespace osmscout {
     if (isOpen) {
       Close();
     }
+
+    if (governor.Valid()) {
+      governor->Unregister(&governedCache);
+    }
   }
 
   template <class N>
@@ -113,6 +180,8 @@ namespace osmscout {
                          FileScanner::Mode modeData,
                          bool memoryMapedData)
   {
+    ScopedLock lock(accessMutex);
+
     datafilename=AppendFileToDir(path,datafile);
 
     this->memoryMapedData=memoryMapedData;
@@ -126,7 +195,8 @@ namespace osmscout {
   template <class N>
   bool DataFile<N>::Close()
   {
-    bool success=true;
+    ScopedLock lock(accessMutex);
+    bool       success=true;
 
     if (scanner.IsOpen()) {
       if (!scanner.Close()) {
@@ -140,12 +210,14 @@ namespace osmscout {
     return success;
   }
 
+  /**
+    Read the object at the given offset from file. The caller must
+    hold the accessMutex.
+    */
   template <class N>
-  bool DataFile<N>::GetByOffset(const std::vector<FileOffset>& offsets,
-                                std::vector<ValueType>& data) const
+  bool DataFile<N>::ReadData(const FileOffset& offset,
+                             ValueType& entry) const
   {
-    assert(isOpen);
-
     if (!scanner.IsOpen()) {
       if (!scanner.Open(datafilename,modeData,memoryMapedData)) {
         std::cerr << "Error while opening " << datafilename << " for reading!" << std::endl;
@@ -153,186 +225,142 @@ namespace osmscout {
       }
     }
 
-    data.reserve(data.size()+offsets.size());
-
-    if (!cache.IsActive()) {
-      for (std::vector<FileOffset>::const_iterator offset=offsets.begin();
-           offset!=offsets.end();
-           ++offset) {
-        N *value=new N();
+    N *value=new N();
 
-        scanner.SetPos(*offset);
+    scanner.SetPos(offset);
+    value->Read(scanner);
 
-        value->Read(scanner);
-
-        if (scanner.HasError()) {
-          std::cerr << "Error while reading data from offset " << *offset << " of file " << datafilename << "!" << std::endl;
-          // TODO: Remove broken entry from cache
-          scanner.Close();
-          return false;
-        }
-
-        data.push_back(value);
-      }
+    if (scanner.HasError()) {
+      std::cerr << "Error while reading data from offset " << offset << " of file " << datafilename << "!" << std::endl;
+      delete value;
+      scanner.Close();
+      return false;
     }
-    else {
-      typename DataCache::CacheRef cacheRef;
-
-      for (std::vector<FileOffset>::const_iterator offset=offsets.begin();
-           offset!=offsets.end();
-           ++offset) {
-        if (!cache.GetEntry(*offset,cacheRef)) {
-          typename DataCache::CacheEntry cacheEntry(*offset);
-
-          cacheRef=cache.SetEntry(cacheEntry);
-
-          scanner.SetPos(*offset);
-          cacheRef->value=new N();
-          cacheRef->value->Read(scanner);
-
-          if (scanner.HasError()) {
-            std::cerr << "Error while reading data from offset " << *offset << " of file " << datafilename << "!" << std::endl;
-            // TODO: Remove broken entry from cache
-            scanner.Close();
-            return false;
-          }
-        }
 
-        data.push_back(cacheRef->value);
-      }
-    }
+    entry=value;
 
     return true;
   }
 
+  /**
+    Ask the operating system to load the data of the given misses (sorted by
+    offset) in the background. Since the size of an object is not known
+    before reading it, objects near to each other are joined into one range
+    and prefetchTailSize bytes are requested for the last object of a range.
+    The caller must hold the accessMutex.
+    */
   template <class N>
-  bool DataFile<N>::GetByOffset(const std::list<FileOffset>& offsets,
-                                std::vector<ValueType>& data) const
+  void DataFile<N>::PrefetchData(const std::vector<Miss>& misses) const
   {
-    assert(isOpen);
-
     if (!scanner.IsOpen()) {
-      if (!scanner.Open(datafilename,modeData,memoryMapedData)) {
-        std::cerr << "Error while opening " << datafilename << " for reading!" << std::endl;
-        return false;
-      }
+      return;
     }
 
-    data.reserve(data.size()+offsets.size());
+    size_t m=0;
 
-    if (!cache.IsActive()) {
-      for (std::list<FileOffset>::const_iterator offset=offsets.begin();
-           offset!=offsets.end();
-           ++offset) {
-        N *value=new N();
+    while (m<misses.size()) {
+      FileOffset start=misses[m].second;
+      FileOffset end=start+prefetchTailSize;
 
-        scanner.SetPos(*offset);
-        value->Read(scanner);
-
-        if (scanner.HasError()) {
-          std::cerr << "Error while reading data from offset " << *offset << " of file " << datafilename << "!" << std::endl;
-          // TODO: Remove broken entry from cache
-          scanner.Close();
-          return false;
-        }
+      m++;
 
-        data.push_back(value);
+      while (m<misses.size() &&
+             misses[m].second<=end+prefetchGapSize) {
+        end=std::max(end,misses[m].second+prefetchTailSize);
+        m++;
       }
-    }
-    else {
-      typename DataCache::CacheRef cacheRef;
-
-      for (std::list<FileOffset>::const_iterator offset=offsets.begin();
-           offset!=offsets.end();
-           ++offset) {
-        if (!cache.GetEntry(*offset,cacheRef)) {
-          typename DataCache::CacheEntry cacheEntry(*offset);
-
-          cacheRef=cache.SetEntry(cacheEntry);
-
-          scanner.SetPos(*offset);
-          cacheRef->value=new N();
-          cacheRef->value->Read(scanner);
-
-          if (scanner.HasError()) {
-            std::cerr << "Error while reading data from offset " << *offset << " of file " << datafilename << "!" << std::endl;
-            // TODO: Remove broken entry from cache
-            scanner.Close();
-            return false;
-          }
-        }
 
-        data.push_back(cacheRef->value);
-      }
+      scanner.Prefetch(start,end-start);
     }
-
-    return true;
   }
 
+  /**
+    Resolves all offsets from the cache first and then reads all
+    missing objects from file, locking the scanner only once.
+    */
   template <class N>
-  bool DataFile<N>::GetByOffset(const std::set<FileOffset>& offsets,
+  template <typename IteratorIn>
+  bool DataFile<N>::GetByOffset(IteratorIn begin, IteratorIn end, size_t size,
                                 std::vector<ValueType>& data) const
   {
     assert(isOpen);
 
-    if (!scanner.IsOpen()) {
-      if (!scanner.Open(datafilename,modeData,memoryMapedData)) {
-        std::cerr << "Error while opening " << datafilename << " for reading!" << std::endl;
-        return false;
+    size_t            start=data.size();
+    size_t            index=start;
+    std::vector<Miss> misses;
+
+    data.resize(start+size);
+
+    for (IteratorIn offset=begin;
+         offset!=end;
+         ++offset) {
+      if (!cache.GetValue(*offset,data[index])) {
+        misses.push_back(std::make_pair(index,*offset));
       }
+
+      index++;
+    }
+
+    // Count cache hits, too, even if no object has to be read from file
+    if (governor.Valid()) {
+      governor->NotifyAccesses(size);
     }
 
-    data.reserve(data.size()+offsets.size());
+    if (misses.empty()) {
+      return true;
+    }
+
+    if (misses.size()>1) {
+      std::sort(misses.begin(),misses.end(),MissOffsetLess);
+    }
 
-    if (!cache.IsActive()) {
-      for (std::set<FileOffset>::const_iterator offset=offsets.begin();
-           offset!=offsets.end();
-           ++offset) {
-        N *value=new N();
+    {
+      ScopedLock lock(accessMutex);
 
-        scanner.SetPos(*offset);
-        value->Read(scanner);
+      if (misses.size()>1) {
+        PrefetchData(misses);
+      }
 
-        if (scanner.HasError()) {
-          std::cerr << "Error while reading data from offset " << *offset << " of file " << datafilename << "!" << std::endl;
-          // TODO: Remove broken entry from cache
-          scanner.Close();
+      for (std::vector<Miss>::const_iterator miss=misses.begin();
+           miss!=misses.end();
+           ++miss) {
+        if (!ReadData(miss->second,data[miss->first])) {
+          data.resize(start);
           return false;
         }
-
-        data.push_back(value);
       }
     }
-    else {
-      typename DataCache::CacheRef cacheRef;
-
-      for (std::set<FileOffset>::const_iterator offset=offsets.begin();
-           offset!=offsets.end();
-           ++offset) {
-        if (!cache.GetEntry(*offset,cacheRef)) {
-          typename DataCache::CacheEntry cacheEntry(*offset);
-
-          cacheRef=cache.SetEntry(cacheEntry);
-
-          scanner.SetPos(*offset);
-          cacheRef->value=new N();
-          cacheRef->value->Read(scanner);
-
-          if (scanner.HasError()) {
-            std::cerr << "Error while reading data from offset " << *offset << " of file " << datafilename << "!" << std::endl;
-            // TODO: Remove broken entry from cache
-            scanner.Close();
-            return false;
-          }
-        }
 
-        data.push_back(cacheRef->value);
-      }
+    for (std::vector<Miss>::const_iterator miss=misses.begin();
+         miss!=misses.end();
+         ++miss) {
+      cache.SetValue(miss->second,data[miss->first]);
     }
 
     return true;
   }
 
+  template <class N>
+  bool DataFile<N>::GetByOffset(const std::vector<FileOffset>& offsets,
+                                std::vector<ValueType>& data) const
+  {
+    return GetByOffset(offsets.begin(),offsets.end(),offsets.size(),data);
+  }
+
+  template <class N>
+  bool DataFile<N>::GetByOffset(const std::list<FileOffset>& offsets,
+                                std::vector<ValueType>& data) const
+  {
+    return GetByOffset(offsets.begin(),offsets.end(),offsets.size(),data);
+  }
+
+  template <class N>
+  bool DataFile<N>::GetByOffset(const std::set<FileOffset>& offsets,
+                                std::vector<ValueType>& data) const
+  {
+    return GetByOffset(offsets.begin(),offsets.end(),offsets.size(),data);
+  }
+
   template <class N>
   bool DataFile<N>::GetByOffset(const std::set<FileOffset>& offsets,
                                 OSMSCOUT_HASHMAP<FileOffset,ValueType>& dataMap) const
@@ -358,6 +386,40 @@ namespace osmscout {
   {
     assert(isOpen);
 
+    if (!cache.GetValue(offset,entry)) {
+      {
+        ScopedLock lock(accessMutex);
+
+        if (!ReadData(offset,entry)) {
+          return false;
+        }
+      }
+
+      cache.SetValue(offset,entry);
+    }
+
+    if (governor.Valid()) {
+      governor->NotifyAccesses(1);
+    }
+
+    return true;
+  }
+
+  /**
+    Set the given views (see WayView and AreaView) to the objects at the
+    given offsets. The objects are neither copied nor cached, the views point
+    directly into the data file, which therefore must be memory mapped. The
+    views are valid until the data file is closed.
+    */
+  template <class N>
+  template <class V>
+  bool DataFile<N>::GetViewsByOffset(const std::vector<FileOffset>& offsets,
+                                     std::vector<V>& views) const
+  {
+    assert(isOpen);
+
+    ScopedLock lock(accessMutex);
+
     if (!scanner.IsOpen()) {
       if (!scanner.Open(datafilename,modeData,memoryMapedData)) {
         std::cerr << "Error while opening " << datafilename << " for reading!" << std::endl;
@@ -365,45 +427,58 @@ namespace osmscout {
       }
     }
 
-    if (!cache.IsActive()) {
-      N *value=new N();
+    views.resize(offsets.size());
 
-      scanner.SetPos(offset);
-      value->Read(scanner);
+    for (size_t i=0; i<offsets.size(); i++) {
+      const char* data;
+      const char* end;
 
-      if (scanner.HasError()) {
-        std::cerr << "Error while reading data from offset " << offset << " of file " << datafilename << "!" << std::endl;
-        // TODO: Remove broken entry from cache
-        scanner.Close();
+      if (!scanner.GetMappedData(offsets[i],data,end)) {
+        std::cerr << "Cannot access offset " << offsets[i] << " of file " << datafilename << " (not memory mapped?)!" << std::endl;
         return false;
       }
 
-      entry=value;
+      if (!views[i].Set(offsets[i],data,end)) {
+        std::cerr << "Error while reading data from offset " << offsets[i] << " of file " << datafilename << "!" << std::endl;
+        return false;
+      }
     }
-    else {
-      typename DataCache::CacheRef cacheRef;
 
-      if (!cache.GetEntry(offset,cacheRef)) {
-        typename DataCache::CacheEntry cacheEntry(offset);
+    return true;
+  }
 
-        cacheRef=cache.SetEntry(cacheEntry);
+  /**
+    Append the file offsets of all objects currently held in the cache
+    to the given vector.
+    */
+  template <class N>
+  void DataFile<N>::GetCachedOffsets(std::vector<FileOffset>& offsets) const
+  {
+    cache.GetKeys(offsets);
+  }
 
-        scanner.SetPos(offset);
-        cacheRef->value=new N();
-        cacheRef->value->Read(scanner);
+  /**
+    Let the given governor assign the memory limit of the cache. The
+    configured number of entries is no longer used in this case. Passing an
+    invalid reference unregisters the cache from the current governor, the
+    cache keeps its last memory limit.
 
-        if (scanner.HasError()) {
-          std::cerr << "Error while reading data from offset " << offset << " of file " << datafilename << "!" << std::endl;
-          // TODO: Remove broken entry from cache
-          scanner.Close();
-          return false;
-        }
-      }
-
-      entry=cacheRef->value;
+    Must not be called while other threads access the data file.
+    */
+  template <class N>
+  void DataFile<N>::SetCacheMemoryGovernor(const CacheMemoryGovernorRef& governor)
+  {
+    if (this->governor.Valid()) {
+      this->governor->Unregister(&governedCache);
     }
 
-    return true;
+    this->governor=governor;
+
+    if (governor.Valid()) {
+      cache.SetValueSizer(&cacheSizer);
+      cache.SetMaxSize(std::numeric_limits<unsigned long>::max());
+      governor->Register(&governedCache);
+    }
   }
 
   template <class N>
@@ -23,6 +23,12 @@
 #include <list>
 #include <set>
 
+#include <osmscout/CoreFeatures.h>
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+#include <thread>
+#endif
+
 // Type and style sheet configuration
 #include <osmscout/TypeConfig.h>
 #include <osmscout/TypeSet.h>
@@ -32,6 +38,8 @@
 #include <osmscout/NodeDataFile.h>
 #include <osmscout/WayDataFile.h>
 
+#include <osmscout/ObjectView.h>
+
 #include <osmscout/OptimizeAreasLowZoom.h>
 #include <osmscout/OptimizeWaysLowZoom.h>
 
@@ -49,6 +57,7 @@
 #include <osmscout/Route.h>
 
 #include <osmscout/util/Breaker.h>
+#include <osmscout/util/CacheMemoryGovernor.h>
 #include <osmscout/util/HashMap.h>
 #include <osmscout/util/StopClock.h>
 
@@ -60,6 +69,35 @@ namespace osmscout {
 
     The following groups attributes are currently available:
     * cache sizes.
+    * memory budget for all caches.
+    * number of cache shards for concurrent access.
+    * cache snapshot for warm starts.
+    * in memory area index.
+
+    If a cache memory budget is set, the node, way and area caches and the
+    area index cache are not limited by their number of entries anymore.
+    Instead a CacheMemoryGovernor distributes the given number of bytes
+    between them based on their hit rates. The governor can be passed
+    to the Router (see RouterParameter), so that its caches share the
+    same budget.
+
+    The object lookups of Database (Get*ByOffset(), Get*ViewsByOffset()),
+    GetObjects() and GetClosestRoutableNode() are threadsafe, so a single
+    Database instance can be shared between multiple threads for loading
+    map data. The ground tile, location and address lookups use index
+    caches without locking and must not be called concurrently. If many
+    threads access the database in parallel, the node, way and area caches
+    should be split into multiple shards to reduce lock contention.
+
+    If a cache snapshot file is set, the database loads the objects and
+    index cells listed in the snapshot into its caches after opening (in a
+    background thread, if thread support is available) and writes the
+    current cache contents to the snapshot when closed. A restarted service
+    thus comes up with the caches of its last session.
+
+    If the area index is held in memory, the complete 'areaarea.idx' is
+    loaded on Open() and area lookups do not need any file access. The
+    area index cache size is ignored in this case.
     */
   class OSMSCOUT_API DatabaseParameter
   {
@@ -67,12 +105,20 @@ namespace osmscout {
     unsigned long areaAreaIndexCacheSize;
     unsigned long areaNodeIndexCacheSize;
 
+    bool          areaAreaIndexInMemory;
+
     unsigned long nodeCacheSize;
 
     unsigned long wayCacheSize;
 
     unsigned long areaCacheSize;
 
+    unsigned long cacheShardCount;
+
+    unsigned long cacheMemoryBudget;
+
+    std::string   cacheSnapshotFile;
+
     bool          debugPerformance;
 
   public:
@@ -81,23 +127,39 @@ namespace osmscout {
     void SetAreaAreaIndexCacheSize(unsigned long areaAreaIndexCacheSize);
     void SetAreaNodeIndexCacheSize(unsigned long areaNodeIndexCacheSize);
 
+    void SetAreaAreaIndexInMemory(bool inMemory);
+
     void SetNodeCacheSize(unsigned long nodeCacheSize);
 
     void SetWayCacheSize(unsigned long wayCacheSize);
 
     void SetAreaCacheSize(unsigned long relationCacheSize);
 
+    void SetCacheShardCount(unsigned long cacheShardCount);
+
+    void SetCacheMemoryBudget(unsigned long cacheMemoryBudget);
+
+    void SetCacheSnapshotFile(const std::string& cacheSnapshotFile);
+
     void SetDebugPerformance(bool debug);
 
     unsigned long GetAreaAreaIndexCacheSize() const;
     unsigned long GetAreaNodeIndexCacheSize() const;
 
+    bool IsAreaAreaIndexInMemory() const;
+
     unsigned long GetNodeCacheSize() const;
 
     unsigned long GetWayCacheSize() const;
 
     unsigned long GetAreaCacheSize() const;
 
+    unsigned long GetCacheShardCount() const;
+
+    unsigned long GetCacheMemoryBudget() const;
+
+    std::string GetCacheSnapshotFile() const;
+
     bool IsDebugPerformance() const;
   };
 
@@ -174,7 +236,19 @@ namespace osmscout {
 
     TypeConfig            *typeConfig;          //! Type config for the currently opened map
 
+    CacheMemoryGovernorRef cacheMemoryGovernor; //! Distributes the cache memory budget, if set
+
+    std::string           cacheSnapshotFile;    //! Snapshot of the cache contents, if set
+    BreakerRef            warmUpBreaker;        //! Stops loading the cache snapshot
+    bool                  warmUpAborted;        //! Loading the cache snapshot was aborted, the caches are incomplete
+#if defined(OSMSCOUT_HAVE_THREAD)
+    std::thread           warmUpThread;         //! Loads the cache snapshot after opening
+#endif
+
   private:
+    void WarmUp();
+    void StopWarmUp();
+
     bool GetObjectsNodes(const AreaSearchParameter& parameter,
                          const TypeSet &nodeTypes,
                          double lonMin, double latMin,
@@ -235,9 +309,15 @@ namespace osmscout {
 
     void FlushCache();
 
+    bool SaveCacheSnapshot(const std::string& filename) const;
+    bool LoadCacheSnapshot(const std::string& filename,
+                           const BreakerRef& breaker=BreakerRef()) const;
+
     std::string GetPath() const;
     TypeConfig* GetTypeConfig() const;
 
+    CacheMemoryGovernorRef GetCacheMemoryGovernor() const;
+
     bool GetBoundingBox(double& minLat,double& minLon,
                         double& maxLat,double& maxLon) const;
 
@@ -317,6 +397,11 @@ namespace osmscout {
     bool GetWaysByOffset(const std::set<FileOffset>& offsets,
                          OSMSCOUT_HASHMAP<FileOffset,WayRef>& dataMap) const;
 
+    bool GetAreaViewsByOffset(const std::vector<FileOffset>& offsets,
+                              std::vector<AreaView>& areas) const;
+    bool GetWayViewsByOffset(const std::vector<FileOffset>& offsets,
+                             std::vector<WayView>& ways) const;
+
     bool VisitAdminRegions(AdminRegionVisitor& visitor) const;
 
     bool VisitAdminRegionLocations(const AdminRegion& region,
@@ -55,6 +55,8 @@ namespace osmscout {
       return objects;
     }
 
+    size_t GetMemorySize() const;
+
     bool Read(FileScanner& scanner);
   };
 
@@ -413,8 +413,9 @@ namespace osmscout {
   template <class N>
   void NumericIndex<N>::DumpStatistics() const
   {
-    size_t memory=0;
-    size_t pages=0;
+    size_t          memory=0;
+    size_t          pages=0;
+    CacheStatistics statistics;
 
     pages+=1;
     memory+=root->entries.size()*sizeof(Entry);
@@ -423,9 +424,13 @@ namespace osmscout {
     for (size_t i=0; i<leafs.size(); i++) {
       pages+=leafs[i].GetSize();
       memory+=sizeof(leafs[i])+leafs[i].GetMemory(NumericIndexCacheValueSizer());
+      statistics+=leafs[i].GetStatistics();
     }
 
-    std::cout << "Index " << filepart << ": " << pages << " pages, memory " << memory << std::endl;
+    std::cout << "Index " << filepart << ": " << pages << " pages, memory " << memory;
+    std::cout << ", hits " << statistics.hits << ", misses " << statistics.misses;
+    std::cout << ", evictions " << statistics.evictions;
+    std::cout << ", hit rate " << statistics.GetHitRate()*100 << "%" << std::endl;
   }
 }
 
@@ -0,0 +1,263 @@
+#ifndef OSMSCOUT_OBJECTVIEW_H
+#define OSMSCOUT_OBJECTVIEW_H
+
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2014  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <string>
+#include <vector>
+
+#include <osmscout/GeoCoord.h>
+#include <osmscout/Tag.h>
+#include <osmscout/Types.h>
+
+#include <osmscout/AttributeAccess.h>
+
+namespace osmscout {
+
+  /**
+   * Read-only view of a way stored in a memory mapped 'ways.dat' file
+   * (see Way::Write() for the format).
+   *
+   * Only the type and the fixed size attributes are decoded when the view is
+   * set. Names and tags are decoded on access, coordinates and ids are
+   * decoded in bulk into a buffer of the caller. A view does not hold any
+   * allocated memory and is only valid as long as the data file it points
+   * into is open.
+   */
+  class OSMSCOUT_API WayView
+  {
+  private:
+    FileOffset  fileOffset;
+    const char* end;        //! End of the mapped file
+    const char* strings;    //! Start of the optional string attributes
+    const char* tags;       //! Start of the optional tags
+    const char* coords;     //! Start of the coordinate deltas
+    TypeId      type;
+    uint16_t    flags;
+    uint8_t     access;
+    int8_t      layer;
+    uint8_t     width;
+    uint8_t     maxSpeed;
+    uint8_t     grade;
+    uint32_t    nodeCount;
+    uint32_t    minLat;
+    uint32_t    minLon;
+
+  private:
+    std::string GetString(uint16_t flag) const;
+
+  public:
+    WayView();
+
+    bool Set(FileOffset fileOffset,
+             const char* data,
+             const char* end);
+
+    inline FileOffset GetFileOffset() const
+    {
+      return fileOffset;
+    }
+
+    inline TypeId GetType() const
+    {
+      return type;
+    }
+
+    inline uint16_t GetFlags() const
+    {
+      return flags;
+    }
+
+    inline AttributeAccess GetAccess() const
+    {
+      return AttributeAccess(access);
+    }
+
+    inline int8_t GetLayer() const
+    {
+      return layer;
+    }
+
+    inline uint8_t GetWidth() const
+    {
+      return width;
+    }
+
+    inline uint8_t GetMaxSpeed() const
+    {
+      return maxSpeed;
+    }
+
+    inline uint8_t GetGrade() const
+    {
+      return grade;
+    }
+
+    bool IsBridge() const;
+    bool IsTunnel() const;
+    bool IsRoundabout() const;
+    bool HasAccess() const;
+
+    std::string GetName() const;
+    std::string GetNameAlt() const;
+    std::string GetRefName() const;
+    std::string GetLocation() const;
+    std::string GetAddress() const;
+    bool GetTags(std::vector<Tag>& tags) const;
+
+    inline size_t GetNodeCount() const
+    {
+      return nodeCount;
+    }
+
+    bool GetBoundingBox(double& minLon,
+                        double& maxLon,
+                        double& minLat,
+                        double& maxLat) const;
+
+    bool GetCoords(GeoCoord* coords) const;
+    bool GetCoords(std::vector<GeoCoord>& coords) const;
+    bool GetIds(std::vector<Id>& ids) const;
+  };
+
+  /**
+   * Read-only view of an area stored in a memory mapped 'areas.dat' file
+   * (see Area::Write() for the format). Same as for WayView, only the header
+   * of the area is decoded when the view is set, the rings are decoded on
+   * access.
+   */
+  class OSMSCOUT_API AreaView
+  {
+  public:
+    /**
+     * View of one ring of an area.
+     */
+    class OSMSCOUT_API Ring
+    {
+    private:
+      const char* end;       //! End of the mapped file
+      const char* strings;   //! Start of the optional string attributes
+      const char* tags;      //! Start of the optional tags
+      const char* ids;       //! Start of the ids (NULL, if the ring has no ids)
+      const char* coords;    //! Start of the coordinates
+      const char* next;      //! Start of the next ring
+      TypeId      type;
+      uint8_t     flags;
+      uint8_t     ring;
+      uint32_t    nodeCount;
+
+    private:
+      bool Set(const char* data,
+               const char* end,
+               bool isMaster,
+               uint8_t flags,
+               uint8_t ring);
+
+      std::string GetString(uint8_t flag) const;
+
+      friend class AreaView;
+
+    public:
+      Ring();
+
+      inline TypeId GetType() const
+      {
+        return type;
+      }
+
+      inline uint8_t GetFlags() const
+      {
+        return flags;
+      }
+
+      inline uint8_t GetRing() const
+      {
+        return ring;
+      }
+
+      std::string GetName() const;
+      std::string GetNameAlt() const;
+      std::string GetLocation() const;
+      std::string GetAddress() const;
+      bool GetTags(std::vector<Tag>& tags) const;
+
+      inline size_t GetNodeCount() const
+      {
+        return nodeCount;
+      }
+
+      bool GetBoundingBox(double& minLon,
+                          double& maxLon,
+                          double& minLat,
+                          double& maxLat) const;
+
+      bool GetCoords(GeoCoord* coords) const;
+      bool GetCoords(std::vector<GeoCoord>& coords) const;
+      bool GetIds(std::vector<Id>& ids) const;
+    };
+
+  private:
+    FileOffset  fileOffset;
+    const char* end;        //! End of the mapped file
+    uint32_t    ringCount;
+    Ring        master;     //! The first ring
+
+  public:
+    AreaView();
+
+    bool Set(FileOffset fileOffset,
+             const char* data,
+             const char* end);
+
+    inline FileOffset GetFileOffset() const
+    {
+      return fileOffset;
+    }
+
+    inline TypeId GetType() const
+    {
+      return master.GetType();
+    }
+
+    inline bool IsSimple() const
+    {
+      return ringCount==1;
+    }
+
+    inline size_t GetRingCount() const
+    {
+      return ringCount;
+    }
+
+    inline const Ring& GetMasterRing() const
+    {
+      return master;
+    }
+
+    bool GetRings(std::vector<Ring>& rings) const;
+
+    bool GetBoundingBox(double& minLon,
+                        double& maxLon,
+                        double& minLat,
+                        double& maxLat) const;
+  };
+}
+
+#endif
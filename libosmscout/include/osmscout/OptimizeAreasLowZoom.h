@@ -30,6 +30,7 @@
 
 #include <osmscout/util/FileScanner.h>
 #include <osmscout/util/Magnification.h>
+#include <osmscout/util/Mutex.h>
 
 namespace osmscout {
 
@@ -65,6 +66,7 @@ namespace osmscout {
     std::string                           datafile;      //! Basename part for the data file name
     std::string                           datafilename;  //! complete filename for data file
     mutable FileScanner                   scanner;       //! File stream to the data file
+    mutable Mutex                         accessMutex;   //! Mutex to secure multi-thread access to the scanner
 
     double                                magnification; //! Magnification, upto which we support optimization
     std::map<TypeId,std::list<TypeData> > areaTypesData; //! Index information for all area types
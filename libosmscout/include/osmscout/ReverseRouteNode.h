@@ -0,0 +1,99 @@
+#ifndef OSMSCOUT_REVERSEROUTENODE_H
+#define OSMSCOUT_REVERSEROUTENODE_H
+
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2014  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <vector>
+
+#include <osmscout/ObjectRef.h>
+#include <osmscout/RouteNode.h>
+#include <osmscout/Types.h>
+
+#include <osmscout/util/FileScanner.h>
+#include <osmscout/util/FileWriter.h>
+#include <osmscout/util/Reference.h>
+
+namespace osmscout {
+
+  /**
+   * A route node of the reverse routing graph. For each route node it holds
+   * the paths of other route nodes leading to this route node, so that the
+   * routing graph can be searched backwards starting at the target.
+   *
+   * Reverse route nodes are stored in their own file in the same order as the
+   * route nodes, paths reference the source route node both in the route node
+   * file and in the reverse route node file.
+   */
+  class OSMSCOUT_API ReverseRouteNode : public Referencable
+  {
+  public:
+    /**
+     * A path of another route node that leads to this route node.
+     */
+    struct OSMSCOUT_API Path
+    {
+      FileOffset      offset;          //! File offset of the reverse route node of the source route node
+      FileOffset      routeNodeOffset; //! File offset of the source route node
+      uint32_t        pathIndex;       //! Index of the path in the source route node
+      uint32_t        objectIndex;     //! The index of the way used from the source route node to this route node
+      TypeId          type;            //! The type of the way
+      uint8_t         maxSpeed;        //! Maximum speed allowed on the way
+      uint8_t         grade;           //! Quality of road/track 1 (good)...5 (bad)
+      uint8_t         flags;           //! Flags of the path in the source route node
+      double          distance;        //! Distance from the source route node to this route node
+      double          lat;             //! Latitude of the source route node
+      double          lon;             //! Longitude of the source route node
+
+      inline bool HasAccess() const
+      {
+        return (flags & RouteNode::hasAccess) != 0;
+      }
+    };
+
+  public:
+    Id                              id;              //! Id of the route node
+    FileOffset                      fileOffset;      //! FileOffset of the reverse route node
+    FileOffset                      routeNodeOffset; //! FileOffset of the route node
+    std::vector<ObjectFileRef>      objects;         //! List of objects (ways, areas) of the paths
+    std::vector<Path>               paths;           //! List of paths leading to this route node
+    std::vector<RouteNode::Exclude> excludes;        //! The excludes of the route node (see RouteNode)
+
+    inline Id GetId() const
+    {
+      return id;
+    }
+
+    inline FileOffset GetFileOffset() const
+    {
+      return fileOffset;
+    }
+
+    uint32_t AddObject(const ObjectFileRef& object);
+
+    size_t GetMemorySize() const;
+
+    bool Read(FileScanner& scanner);
+    bool Write(FileWriter& writer) const;
+  };
+
+  typedef Ref<ReverseRouteNode> ReverseRouteNodeRef;
+}
+
+#endif
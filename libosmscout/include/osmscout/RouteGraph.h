@@ -0,0 +1,204 @@
+#ifndef OSMSCOUT_ROUTEGRAPH_H
+#define OSMSCOUT_ROUTEGRAPH_H
+
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2014  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <string>
+#include <vector>
+
+#include <osmscout/private/CoreImportExport.h>
+
+#include <osmscout/ObjectRef.h>
+#include <osmscout/RouteNode.h>
+#include <osmscout/Types.h>
+
+#include <osmscout/util/Reference.h>
+
+namespace osmscout {
+
+  /**
+   * The complete routing graph of one vehicle (as stored in the route node
+   * data file) in a compact form, that is loaded into memory at once.
+   *
+   * The graph is stored in compressed sparse row format: nodes are the route
+   * nodes, addressed by a dense 32 bit index in the order of their file offset.
+   * The paths of all route nodes are stored in one edge array, the edges of a
+   * node are the range [GetEdgesBegin(node),GetEdgesEnd(node)[ in the order of
+   * the paths of the route node. Turn restrictions are stored the same way in a
+   * separate exclude array.
+   *
+   * Objects are referenced by their index in one global, sorted object table.
+   * Coordinates and distances are stored as fixed point values with the same
+   * resolution as in the route node data file, so costs are identical to the
+   * costs calculated on the route nodes.
+   *
+   * All records have a fixed size, the file consists of the plain arrays.
+   */
+  class OSMSCOUT_API RouteGraph : public Referencable
+  {
+  public:
+    static const uint32_t noNode = 0xffffffff; //! Marker for "no node" or "no object"
+
+    /**
+     * A route node
+     */
+    struct OSMSCOUT_API Node
+    {
+      FileOffset offset;       //! File offset of the route node
+      uint32_t   firstEdge;    //! Index of the first edge
+      uint32_t   firstExclude; //! Index of the first exclude
+      uint32_t   lat;          //! Latitude in fixed point format, see conversionFactor
+      uint32_t   lon;          //! Longitude in fixed point format, see conversionFactor
+    };
+
+    /**
+     * A path of a route node, see RouteNode::Path
+     */
+    struct OSMSCOUT_API Edge
+    {
+      uint32_t target;   //! Index of the target node
+      uint32_t object;   //! Index of the way (or area) in the object table
+      uint32_t distance; //! Distance to the target node in cm
+      TypeId   type;     //! The type of the way
+      uint8_t  maxSpeed; //! Maximum speed allowed on the way
+      uint8_t  flags;    //! Flags of the path, see RouteNode
+
+      inline bool HasAccess() const
+      {
+        return (flags & RouteNode::hasAccess)!=0;
+      }
+    };
+
+    /**
+     * A turn restriction of a node, see RouteNode::Exclude
+     */
+    struct OSMSCOUT_API Exclude
+    {
+      uint32_t sourceObject; //! Index of the object arriving at the node in the object table
+      uint32_t targetPath;   //! Index of the path that cannot be used (relative to the first edge of the node)
+    };
+
+  private:
+    std::vector<Node>          nodes;    //! All nodes, ascending by file offset (plus end marker)
+    std::vector<Edge>          edges;    //! Edges of all nodes
+    std::vector<Exclude>       excludes; //! Excludes of all nodes
+    std::vector<ObjectFileRef> objects;  //! Table of all objects, sorted
+
+  public:
+    RouteGraph();
+    virtual ~RouteGraph();
+
+    void Clear();
+
+    void SetObjects(const std::vector<ObjectFileRef>& objects);
+    uint32_t AddNode(FileOffset offset,
+                     const std::vector<Edge>& nodeEdges,
+                     const std::vector<Exclude>& nodeExcludes);
+    void SetCoord(uint32_t node,
+                  uint32_t lat,
+                  uint32_t lon);
+
+    uint32_t GetNode(FileOffset offset) const;
+    uint32_t GetObject(const ObjectFileRef& object) const;
+
+    inline size_t GetNodeCount() const
+    {
+      return nodes.size()-1;
+    }
+
+    inline size_t GetEdgeCount() const
+    {
+      return edges.size();
+    }
+
+    inline FileOffset GetOffset(uint32_t node) const
+    {
+      return nodes[node].offset;
+    }
+
+    inline double GetLat(uint32_t node) const
+    {
+      return nodes[node].lat/conversionFactor-90.0;
+    }
+
+    inline double GetLon(uint32_t node) const
+    {
+      return nodes[node].lon/conversionFactor-180.0;
+    }
+
+    /**
+     * Return the index of the first edge of the given node
+     */
+    inline uint32_t GetEdgesBegin(uint32_t node) const
+    {
+      return nodes[node].firstEdge;
+    }
+
+    /**
+     * Return the index after the last edge of the given node
+     */
+    inline uint32_t GetEdgesEnd(uint32_t node) const
+    {
+      return nodes[node+1].firstEdge;
+    }
+
+    inline const Edge& GetEdge(uint32_t index) const
+    {
+      return edges[index];
+    }
+
+    /**
+     * Return the distance of the given edge in km
+     */
+    inline double GetDistance(uint32_t index) const
+    {
+      return edges[index].distance/(1000.0*100.0);
+    }
+
+    inline uint32_t GetExcludesBegin(uint32_t node) const
+    {
+      return nodes[node].firstExclude;
+    }
+
+    inline uint32_t GetExcludesEnd(uint32_t node) const
+    {
+      return nodes[node+1].firstExclude;
+    }
+
+    inline const Exclude& GetExclude(uint32_t index) const
+    {
+      return excludes[index];
+    }
+
+    inline const ObjectFileRef& GetObjectRef(uint32_t object) const
+    {
+      return objects[object];
+    }
+
+    size_t GetMemorySize() const;
+
+    bool Read(const std::string& filename);
+    bool Write(const std::string& filename) const;
+  };
+
+  typedef Ref<RouteGraph> RouteGraphRef;
+}
+
+#endif
@@ -95,6 +95,8 @@ namespace osmscout {
 
     uint32_t AddObject(const ObjectFileRef& object);
 
+    size_t GetMemorySize() const;
+
     bool Read(FileScanner& scanner);
     bool Write(FileWriter& writer) const;
   };
@@ -22,13 +22,18 @@
 
 #include <list>
 #include <set>
+#include <vector>
 
 #include <osmscout/CoreFeatures.h>
 
+#include <osmscout/GeoCoord.h>
 #include <osmscout/Point.h>
 
 #include <osmscout/TypeConfig.h>
 
+#include <osmscout/ContractionHierarchy.h>
+#include <osmscout/ReverseRouteNode.h>
+#include <osmscout/RouteGraph.h>
 #include <osmscout/RouteNode.h>
 
 // Datafiles
@@ -41,9 +46,12 @@
 #include <osmscout/RoutingProfile.h>
 
 #include <osmscout/util/Cache.h>
+#include <osmscout/util/CacheMemoryGovernor.h>
 #include <osmscout/util/HashMap.h>
 #include <osmscout/util/HashSet.h>
+#include <osmscout/util/IndexedHeap.h>
 #include <osmscout/util/Reference.h>
+#include <osmscout/util/ThreadPool.h>
 
 namespace osmscout {
 
@@ -55,14 +63,32 @@ namespace osmscout {
 
     The following groups attributes are currently available:
     * cache sizes.
+    * memory governor for the caches.
+    * use of a precalculated contraction hierarchy.
+    * use of the bidirectional search.
+    * use of the compact in-memory route graph.
+    * number of workers used to calculate route matrices.
+
+    If a CacheMemoryGovernor is set (for example the one of the Database, see
+    Database::GetCacheMemoryGovernor()), the way, area, route node and
+    intersection caches get their memory limit assigned by the governor
+    instead of being limited by the configured number of entries.
     */
   class OSMSCOUT_API RouterParameter
   {
   private:
-    unsigned long wayIndexCacheSize;
-    unsigned long wayCacheSize;
+    unsigned long          wayIndexCacheSize;
+    unsigned long          wayCacheSize;
 
-    bool          debugPerformance;
+    CacheMemoryGovernorRef cacheMemoryGovernor;
+
+    bool                   debugPerformance;
+
+    bool                   contractionHierarchy;
+    bool                   bidirectional;
+    bool                   compactRouteGraph;
+
+    size_t                 matrixWorkerCount;
 
   public:
     RouterParameter();
@@ -70,97 +96,467 @@ namespace osmscout {
     void SetWayIndexCacheSize(unsigned long wayIndexCacheSize);
     void SetWayCacheSize(unsigned long wayCacheSize);
 
+    void SetCacheMemoryGovernor(const CacheMemoryGovernorRef& governor);
+
     void SetDebugPerformance(bool debug);
 
+    void SetContractionHierarchy(bool contractionHierarchy);
+    void SetBidirectional(bool bidirectional);
+    void SetCompactRouteGraph(bool compactRouteGraph);
+
+    void SetMatrixWorkerCount(size_t workerCount);
+
     unsigned long GetWayIndexCacheSize() const;
     unsigned long GetWayCacheSize() const;
 
+    CacheMemoryGovernorRef GetCacheMemoryGovernor() const;
+
     bool IsDebugPerformance() const;
+
+    bool IsContractionHierarchy() const;
+    bool IsBidirectional() const;
+    bool IsCompactRouteGraph() const;
+
+    size_t GetMatrixWorkerCount() const;
+  };
+
+  /**
+    A position in the routing graph: the node with the given index of the
+    given routable way. Positions on areas are not supported.
+    */
+  struct OSMSCOUT_API RoutePosition
+  {
+    ObjectFileRef object;    //! The way
+    size_t        nodeIndex; //! Index of the node in the object
+
+    RoutePosition()
+    : nodeIndex(0)
+    {
+      // no code
+    }
+
+    RoutePosition(const ObjectFileRef& object,
+                  size_t nodeIndex)
+    : object(object),
+      nodeIndex(nodeIndex)
+    {
+      // no code
+    }
+  };
+
+  /**
+    Dense matrix of the costs and the travel times (in hours) of the routes
+    from a number of sources to a number of targets, as calculated by
+    Router::CalculateMatrix(). Entries for targets that cannot be reached from
+    the source are marked as unreachable.
+    */
+  class OSMSCOUT_API RouteMatrix
+  {
+  private:
+    size_t              sourceCount;
+    size_t              targetCount;
+    std::vector<double> costs;       //! Costs for each source (row) and target (column) or -1
+    std::vector<double> times;       //! Travel time for each source and target or -1
+
+  public:
+    RouteMatrix();
+
+    void Initialize(size_t sourceCount,
+                    size_t targetCount);
+
+    inline size_t GetSourceCount() const
+    {
+      return sourceCount;
+    }
+
+    inline size_t GetTargetCount() const
+    {
+      return targetCount;
+    }
+
+    inline bool IsReachable(size_t source,
+                            size_t target) const
+    {
+      return costs[source*targetCount+target]>=0.0;
+    }
+
+    inline double GetCost(size_t source,
+                          size_t target) const
+    {
+      return costs[source*targetCount+target];
+    }
+
+    inline double GetTime(size_t source,
+                          size_t target) const
+    {
+      return times[source*targetCount+target];
+    }
+
+    inline void Set(size_t source,
+                    size_t target,
+                    double cost,
+                    double time)
+    {
+      costs[source*targetCount+target]=cost;
+      times[source*targetCount+target]=time;
+    }
+  };
+
+  /**
+    A route node reachable from the start position within the budget given to
+    Router::CalculateReachableNodes().
+    */
+  struct OSMSCOUT_API ReachableNode
+  {
+    Id         id;     //! Id of the route node
+    FileOffset offset; //! File offset of the route node
+    double     lon;    //! Longitude of the route node
+    double     lat;    //! Latitude of the route node
+    double     cost;   //! Costs from the start position
+    double     time;   //! Travel time (in hours) from the start position
+  };
+
+  /**
+    Visitor that gets called for every route node reachable within the budget,
+    in the order of increasing costs. Returning false stops the search.
+    */
+  class OSMSCOUT_API ReachableNodeVisitor
+  {
+  public:
+    virtual ~ReachableNodeVisitor();
+
+    virtual bool Visit(const ReachableNode& node) = 0;
+  };
+
+  /**
+    Visitor collecting all reachable route nodes. The area reached can be
+    returned as polygon (the convex hull of the route nodes).
+    */
+  class OSMSCOUT_API ReachableAreaCollector : public ReachableNodeVisitor
+  {
+  private:
+    std::vector<ReachableNode> nodes;
+
+  public:
+    void Clear();
+
+    bool Visit(const ReachableNode& node);
+
+    inline const std::vector<ReachableNode>& GetNodes() const
+    {
+      return nodes;
+    }
+
+    void GetPolygon(std::vector<GeoCoord>& polygon) const;
   };
 
   class OSMSCOUT_API Router : public Referencable
   {
   private:
+    static const uint32_t noRNode = 0xffffffff; //! Marker for "no RNode"
+
     /**
      * A path in the routing graph from one node to the next (expressed via the target object)
      * with additional information as required by the A* algorithm.
+     *
+     * RNodes are stored in the RoutingState and reference each other by their index.
      */
-    struct RNode : public Referencable
+    struct RNode
     {
       FileOffset    nodeOffset;    //! The file offset of the current route node
-      FileOffset    prev;          //! The file offset of the previous route node
+      uint32_t      prev;          //! The index of the previous RNode or noRNode
+      bool          access;        //! Flags to signal, if we had access ("access restrictions") to this node
+      bool          closed;        //! true, if the node is in the close list
       ObjectFileRef object;        //! The object (way/area) visited from the current route node
 
       double        currentCost;   //! The cost of the current up to the current node
       double        estimateCost;  //! The estimated cost from here to the target
       double        overallCost;   //! The overall costs (currentCost+estimateCost)
 
-      bool          access;        //! Flags to signal, if we had access ("access restrictions") to this node
-
       RNode()
-      : nodeOffset(0)
-      {
-        // no code
-      }
-
-      RNode(FileOffset nodeOffset,
-            const ObjectFileRef& object)
-      : nodeOffset(nodeOffset),
-        prev(0),
-        object(object),
+      : nodeOffset(0),
+        prev(noRNode),
+        access(true),
+        closed(false),
         currentCost(0),
         estimateCost(0),
-        overallCost(0),
-        access(true)
+        overallCost(0)
       {
         // no code
       }
 
       RNode(FileOffset nodeOffset,
             const ObjectFileRef& object,
-            FileOffset prev)
+            uint32_t prev)
       : nodeOffset(nodeOffset),
         prev(prev),
+        access(true),
+        closed(false),
         object(object),
         currentCost(0),
         estimateCost(0),
-        overallCost(0),
-        access(true)
+        overallCost(0)
       {
         // no code
       }
+    };
 
-      inline bool operator==(const RNode& other)
+    /**
+     * Sort key of the open list (smallest cost first, ties broken by the
+     * file offset).
+     */
+    struct RNodeCost
+    {
+      double     overallCost;
+      FileOffset nodeOffset;
+
+      RNodeCost()
+      : overallCost(0),
+        nodeOffset(0)
+      {
+        // no code
+      }
+
+      RNodeCost(double overallCost,
+                FileOffset nodeOffset)
+      : overallCost(overallCost),
+        nodeOffset(nodeOffset)
       {
-        return nodeOffset==other.nodeOffset;
+        // no code
       }
 
-      inline bool operator<(const RNode& other) const
+      inline bool operator<(const RNodeCost& other) const
       {
-        return nodeOffset<other.nodeOffset;
+        if (overallCost==other.overallCost) {
+          return nodeOffset<other.nodeOffset;
+        }
+        else {
+          return overallCost<other.overallCost;
+        }
       }
     };
 
-    typedef Ref<RNode> RNodeRef;
+    typedef IndexedHeap<RNodeCost> OpenList;
 
-    struct RNodeCostCompare
+    /**
+     * Open addressing hash map from the file offset of a route node to the index
+     * of its RNode.
+     *
+     * Slots carry the generation they were written in, so Clear() is O(1) and the
+     * table is reused for the next route calculation without touching its memory.
+     */
+    class RNodeIndexMap
     {
-      inline bool operator()(const RNodeRef& a, const RNodeRef& b) const
+    private:
+      struct Slot
       {
-        if (a->overallCost==b->overallCost) {
-         return a->nodeOffset<b->nodeOffset;
-        }
-        else {
-          return a->overallCost<b->overallCost;
+        FileOffset offset;
+        uint32_t   index;
+        uint32_t   generation;
+      };
+
+    private:
+      std::vector<Slot> slots;      //! The hash table, size is a power of 2
+      size_t            mask;       //! slots.size()-1
+      size_t            size;       //! Number of entries in the current generation
+      uint32_t          generation; //! The current generation
+
+    private:
+      inline size_t GetSlot(FileOffset offset) const
+      {
+        uint64_t hash=(uint64_t)offset*0x9e3779b97f4a7c15ULL;
+
+        return (size_t)(hash >> 32) & mask;
+      }
+
+      void Rehash(size_t capacity);
+
+    public:
+      RNodeIndexMap();
+
+      void Clear();
+
+      /**
+       * Return the index for the given offset or noRNode
+       */
+      inline uint32_t Get(FileOffset offset) const
+      {
+        size_t slot=GetSlot(offset);
+
+        while (slots[slot].generation==generation) {
+          if (slots[slot].offset==offset) {
+            return slots[slot].index;
+          }
+
+          slot=(slot+1) & mask;
         }
+
+        return noRNode;
+      }
+
+      void Set(FileOffset offset,
+               uint32_t index);
+
+      inline size_t GetSize() const
+      {
+        return size;
+      }
+    };
+
+    /**
+     * The state of a route calculation.
+     *
+     * All RNodes of one calculation are stored in one array (arena) and are
+     * referenced by 32 bit indices. The state is cleared, but not freed, between
+     * route calculations, so after the first calculation (nearly) no memory
+     * is allocated any more.
+     */
+    struct RoutingState
+    {
+      std::vector<RNode> nodes;    //! All RNodes visited during the current calculation
+      RNodeIndexMap      nodeMap;  //! Route node file offset => index in nodes
+      OpenList           openList; //! Open RNodes, sorted by cost
+
+      void Clear();
+
+      uint32_t AddNode(const RNode& node);
+    };
+
+    /**
+     * A route node reached by the backward search of the bidirectional search
+     * together with the path used to leave it in the direction of the target.
+     *
+     * ReverseRNodes are stored in the ReverseRoutingState and reference each
+     * other by their index.
+     */
+    struct ReverseRNode
+    {
+      FileOffset    nodeOffset;    //! The file offset of the route node
+      FileOffset    reverseOffset; //! The file offset of the reverse route node
+      uint32_t      next;          //! The index of the next ReverseRNode or noRNode
+      uint32_t      pathIndex;     //! The index of the path used to leave the route node or noRNode
+      bool          access;        //! We have access rights on the path leaving the route node
+      bool          closed;        //! true, if the node is in the close list
+      ObjectFileRef object;        //! The object (way/area) used to leave the route node
+
+      double        currentCost;   //! The cost from the current node up to the target
+      double        estimateCost;  //! The potential of the current node
+      double        overallCost;   //! The overall costs (currentCost+estimateCost)
+
+      ReverseRNode()
+      : nodeOffset(0),
+        reverseOffset(0),
+        next(noRNode),
+        pathIndex(noRNode),
+        access(false),
+        closed(false),
+        currentCost(0),
+        estimateCost(0),
+        overallCost(0)
+      {
+        // no code
       }
     };
 
-    typedef std::set<RNodeRef,RNodeCostCompare>              OpenList;
-    typedef std::set<RNodeRef,RNodeCostCompare>::iterator    OpenListRef;
+    /**
+     * The state of the backward search of a bidirectional route calculation,
+     * see RoutingState.
+     */
+    struct ReverseRoutingState
+    {
+      std::vector<ReverseRNode> nodes;    //! All ReverseRNodes visited during the current calculation
+      RNodeIndexMap             nodeMap;  //! Route node file offset => index in nodes
+      OpenList                  openList; //! Open ReverseRNodes, sorted by cost
 
-    typedef OSMSCOUT_HASHMAP<FileOffset,Router::OpenListRef> OpenMap;
-    typedef OSMSCOUT_HASHMAP<FileOffset,Router::RNodeRef>    CloseMap;
+      void Clear();
+
+      uint32_t AddNode(const ReverseRNode& node);
+    };
+
+    /**
+     * One direction of a route calculation using the contraction hierarchy.
+     * Arrays are indexed by hierarchy node and are allocated only once.
+     */
+    struct CHSearch
+    {
+      std::vector<double>   costs;   //! Costs from the start (or to the target) or -1
+      std::vector<uint32_t> parents; //! The previous node
+      std::vector<uint32_t> edges;   //! Index of the edge used or noNode for start (or target) nodes
+      IndexedHeap<double>   heap;    //! Open nodes, sorted by cost
+
+      inline bool IsReached(uint32_t node) const
+      {
+        return costs[node]>=0.0;
+      }
+
+      bool Update(uint32_t node,
+                  double cost,
+                  uint32_t parent,
+                  uint32_t edge,
+                  std::vector<uint32_t>& touched);
+    };
+
+    /**
+     * State of a bidirectional route calculation using the contraction hierarchy
+     */
+    struct CHState
+    {
+      CHSearch              forward;          //! Search from the start upwards
+      CHSearch              backward;         //! Search from the target upwards
+      std::vector<uint32_t> touched;          //! All nodes reached in any direction
+      uint32_t              startNodes[2];    //! The start nodes
+      uint32_t              startObjects[2];  //! Index of the start object in the start route nodes
+
+      void Initialize(size_t nodeCount);
+      void Clear();
+    };
+
+    /**
+     * State of a route calculation on the compact route graph. Arrays are
+     * indexed by graph node and are allocated only once, so a route calculation
+     * does not allocate any memory while searching.
+     */
+    struct GraphState
+    {
+      static const uint8_t reached  = 1 << 0; //! The node was reached in the current calculation
+      static const uint8_t closed   = 1 << 1; //! The node is in the close list
+      static const uint8_t noAccess = 1 << 2; //! The node was reached via a path without access rights
+
+      std::vector<double>    costs;    //! Costs from the start
+      std::vector<uint32_t>  parents;  //! The previous node or noNode
+      std::vector<uint32_t>  objects;  //! Index of the object used to arrive at the node (in the object table)
+      std::vector<uint8_t>   flags;    //! State of the node
+      std::vector<uint32_t>  touched;  //! All nodes reached in the current calculation
+      IndexedHeap<RNodeCost> openList; //! Open nodes, sorted by cost
+
+      void Initialize(size_t nodeCount);
+      void Clear();
+    };
+
+    /**
+     * The connection between a position and one of the route nodes next to it
+     */
+    struct PositionLeg
+    {
+      FileOffset routeNodeOffset; //! File offset of the route node
+      uint32_t   objectIndex;     //! Index of the object of the position in the route node or noRNode
+      double     lon;             //! Longitude of the route node
+      double     lat;             //! Latitude of the route node
+      double     cost;            //! Costs between the position and the route node
+      double     time;            //! Travel time between the position and the route node
+    };
+
+    /**
+     * A position resolved to the route nodes next to it
+     */
+    struct ResolvedPosition
+    {
+      ObjectFileRef            object; //! The object of the position
+      std::vector<PositionLeg> legs;   //! The route nodes next to the position
+    };
+
+    class MatrixDijkstraJob;
+    class MatrixCHJob;
 
   public:
     static const char* const FILENAME_INTERSECTIONS_DAT;
@@ -168,30 +564,66 @@ namespace osmscout {
 
     static const char* const FILENAME_FOOT_DAT;
     static const char* const FILENAME_FOOT_IDX;
+    static const char* const FILENAME_FOOT_REV_DAT;
+    static const char* const FILENAME_FOOT_REV_IDX;
 
     static const char* const FILENAME_BICYCLE_DAT;
     static const char* const FILENAME_BICYCLE_IDX;
+    static const char* const FILENAME_BICYCLE_REV_DAT;
+    static const char* const FILENAME_BICYCLE_REV_IDX;
 
     static const char* const FILENAME_CAR_DAT;
     static const char* const FILENAME_CAR_IDX;
+    static const char* const FILENAME_CAR_REV_DAT;
+    static const char* const FILENAME_CAR_REV_IDX;
+    static const char* const FILENAME_CAR_CH_DAT;
+
+    static const char* const FILENAME_FOOT_GRAPH_DAT;
+    static const char* const FILENAME_BICYCLE_GRAPH_DAT;
+    static const char* const FILENAME_CAR_GRAPH_DAT;
 
   private:
     Vehicle                              vehicle;           //! We are a router for this vehicle
     bool                                 isOpen;            //! true, if opened
     bool                                 debugPerformance;
+    bool                                 useContractionHierarchy;
+    bool                                 useBidirectional;
+    bool                                 useCompactRouteGraph;
+    size_t                               matrixWorkerCount; //! Number of workers for route matrices
 
     std::string                          path;              //! Path to the directory containing all files
 
     DataFile<Area>                       areaDataFile;      //! Cached access to the 'areas.dat' file
     DataFile<Way>                        wayDataFile;       //! Cached access to the 'ways.dat' file
     IndexedDataFile<Id,RouteNode>        routeNodeDataFile; //! Cached access to the 'route.dat' file
+    IndexedDataFile<Id,ReverseRouteNode> reverseRouteNodeDataFile; //! Cached access to the reverse route graph
     IndexedDataFile<Id,Intersection>     junctionDataFile;  //! Cached access to the 'junctions.dat' file
 
     TypeConfig                           *typeConfig;       //! Type config for the currently opened map
 
+    RoutingState                         routingState;      //! Reused state of the route calculation
+    std::vector<ReachableNode>           reachableNodes;    //! Reused data of the RNodes of a reachability search
+    ReverseRoutingState                  reverseRoutingState; //! Reused state of the backward search
+
+    ContractionHierarchyRef              contractionHierarchy; //! Contraction hierarchy, if loaded
+    CHState                              chState;           //! Reused state of route calculation using the hierarchy
+
+    RouteGraphRef                        routeGraph;        //! Compact route graph, if loaded
+    GraphState                           graphState;        //! Reused state of route calculation using the compact route graph
+
+    ThreadPool                           *threadPool;       //! Workers for route matrices, created on first use
+
   private:
     std::string GetDataFilename(Vehicle vehicle) const;
     std::string GetIndexFilename(Vehicle vehicle) const;
+    std::string GetReverseDataFilename(Vehicle vehicle) const;
+    std::string GetReverseIndexFilename(Vehicle vehicle) const;
+    std::string GetGraphFilename(Vehicle vehicle) const;
+
+    bool GetRouteNodeCount(const std::string& path,
+                           uint32_t& routeNodeCount) const;
+    bool IsContractionHierarchyValid(const std::string& path) const;
+    bool CanUseContractionHierarchy(const RoutingProfile& profile) const;
 
     void GetClosestForwardRouteNode(const WayRef& way,
                                     size_t nodeIndex,
@@ -209,8 +641,9 @@ namespace osmscout {
                        double& targetLat,
                        RouteNodeRef& forwardRouteNode,
                        RouteNodeRef& backwardRouteNode,
-                       RNodeRef& forwardRNode,
-                       RNodeRef& backwardRNode);
+                       RoutingState& state,
+                       uint32_t& forwardRNode,
+                       uint32_t& backwardRNode);
 
     bool GetTargetNodes(const ObjectFileRef& object,
                         size_t nodeIndex,
@@ -219,11 +652,11 @@ namespace osmscout {
                         RouteNodeRef& forwardNode,
                         RouteNodeRef& backwardNode);
 
-    void ResolveRNodeChainToList(const RNodeRef& end,
-                                 const CloseMap& closeMap,
-                                 std::list<RNodeRef>& nodes);
+    void ResolveRNodeChainToList(uint32_t end,
+                                 const RoutingState& state,
+                                 std::vector<RNode>& nodes);
     bool ResolveRNodesToRouteData(const RoutingProfile& profile,
-                                  const std::list<RNodeRef>& nodes,
+                                  const std::vector<RNode>& nodes,
                                   const ObjectFileRef& startObject,
                                   size_t startNodeIndex,
                                   const ObjectFileRef& targetObject,
@@ -232,6 +665,55 @@ namespace osmscout {
 
     bool ResolveRouteDataJunctions(RouteData& route);
 
+    bool GetRouteNodeCoord(const ObjectFileRef& object,
+                           Id id,
+                           double& lon,
+                           double& lat);
+    bool CanTurn(const RouteNode& routeNode,
+                 const ObjectFileRef& arrivalObject,
+                 bool arrivalAccess,
+                 FileOffset arrivalOffset,
+                 uint32_t departurePath) const;
+
+    bool CalculateRouteBidirectional(const RoutingProfile& profile,
+                                     const ObjectFileRef& startObject,
+                                     size_t startNodeIndex,
+                                     const ObjectFileRef& targetObject,
+                                     size_t targetNodeIndex,
+                                     RouteData& route);
+
+    void GetCHArrival(uint32_t node,
+                      uint32_t& object,
+                      bool& access) const;
+    uint32_t GetCHDeparture(uint32_t node) const;
+
+    bool CalculateRouteCH(const RoutingProfile& profile,
+                          const ObjectFileRef& startObject,
+                          size_t startNodeIndex,
+                          const ObjectFileRef& targetObject,
+                          size_t targetNodeIndex,
+                          RouteData& route);
+
+    bool CalculateRouteGraph(const RoutingProfile& profile,
+                             const ObjectFileRef& startObject,
+                             size_t startNodeIndex,
+                             const ObjectFileRef& targetObject,
+                             size_t targetNodeIndex,
+                             RouteData& route);
+
+    bool ResolvePosition(const RoutingProfile& profile,
+                         const RoutePosition& position,
+                         ResolvedPosition& resolved);
+
+    bool CalculateMatrixDijkstra(const RoutingProfile& profile,
+                                 const std::vector<ResolvedPosition>& sources,
+                                 const std::vector<ResolvedPosition>& targets,
+                                 RouteMatrix& matrix);
+
+    bool CalculateMatrixCH(const std::vector<ResolvedPosition>& sources,
+                           const std::vector<ResolvedPosition>& targets,
+                           RouteMatrix& matrix);
+
     void AddNodes(RouteData& route,
                   Id startNodeId,
                   size_t startNodeIndex,
@@ -240,6 +722,15 @@ namespace osmscout {
                   bool oneway,
                   size_t targetNodeIndex);
 
+  public:
+    /**
+     * The budget limiting the search of Router::CalculateReachableNodes()
+     */
+    enum Budget {
+      costBudget, //! The costs of the routing profile are limited
+      timeBudget  //! The travel time is limited
+    };
+
   public:
     Router(const RouterParameter& parameter,
            Vehicle vehicle);
@@ -262,6 +753,17 @@ namespace osmscout {
                         size_t targetNodeIndex,
                         RouteData& route);
 
+    bool CalculateMatrix(const RoutingProfile& profile,
+                         const std::vector<RoutePosition>& sources,
+                         const std::vector<RoutePosition>& targets,
+                         RouteMatrix& matrix);
+
+    bool CalculateReachableNodes(const RoutingProfile& profile,
+                                 const RoutePosition& start,
+                                 Budget budgetType,
+                                 double budget,
+                                 ReachableNodeVisitor& visitor);
+
     bool TransformRouteDataToWay(const RouteData& data,
                                  Way& way);
 
@@ -26,7 +26,9 @@
 
 #include <osmscout/Way.h>
 
+#include <osmscout/RouteGraph.h>
 #include <osmscout/RouteNode.h>
+#include <osmscout/ReverseRouteNode.h>
 
 #include "Area.h"
 
@@ -44,6 +46,10 @@ namespace osmscout {
 
     virtual bool CanUse(const RouteNode& currentNode,
                         size_t pathIndex) const = 0;
+    virtual bool CanUse(const ReverseRouteNode& currentNode,
+                        size_t pathIndex) const = 0;
+    virtual bool CanUse(const RouteGraph& graph,
+                        uint32_t edge) const = 0;
     virtual bool CanUse(const Area& area) const = 0;
     virtual bool CanUse(const Way& way) const = 0;
     virtual bool CanUseForward(const Way& way) const = 0;
@@ -51,16 +57,30 @@ namespace osmscout {
 
     virtual double GetCosts(const RouteNode& currentNode,
                             size_t pathIndex) const = 0;
+    virtual double GetCosts(const ReverseRouteNode& currentNode,
+                            size_t pathIndex) const = 0;
+    virtual double GetCosts(const RouteGraph& graph,
+                            uint32_t edge) const = 0;
     virtual double GetCosts(const Area& area,
                             double distance) const = 0;
     virtual double GetCosts(const Way& way,
                             double distance) const = 0;
     virtual double GetCosts(double distance) const = 0;
 
+    virtual double GetTime(const RouteNode& currentNode,
+                           size_t pathIndex) const = 0;
     virtual double GetTime(const Area& area,
                            double distance) const = 0;
     virtual double GetTime(const Way& way,
                            double distance) const = 0;
+
+    /**
+     * Return a hash of all parameters of the profile that influence, which
+     * ways can be used and their costs. Profiles with the same hash calculate
+     * the same routes, so precalculated data like the contraction hierarchy
+     * can be shared. 0 means, that the profile cannot be described by a hash.
+     */
+    virtual uint64_t GetCostHash() const;
   };
 
   /**
@@ -97,6 +117,8 @@ namespace osmscout {
 
     void AddType(TypeId type, double speed);
 
+    uint64_t CalculateCostHash(uint8_t costType) const;
+
     inline bool CanUse(const RouteNode& currentNode,
                        size_t pathIndex) const
     {
@@ -109,6 +131,30 @@ namespace osmscout {
       return type<speeds.size() && speeds[type]>0.0;
     }
 
+    inline bool CanUse(const ReverseRouteNode& currentNode,
+                       size_t pathIndex) const
+    {
+      if (!(currentNode.paths[pathIndex].flags & vehicleRouteNodeBit)) {
+        return false;
+      }
+
+      TypeId type=currentNode.paths[pathIndex].type;
+
+      return type<speeds.size() && speeds[type]>0.0;
+    }
+
+    inline bool CanUse(const RouteGraph& graph,
+                       uint32_t edge) const
+    {
+      const RouteGraph::Edge& graphEdge=graph.GetEdge(edge);
+
+      if (!(graphEdge.flags & vehicleRouteNodeBit)) {
+        return false;
+      }
+
+      return graphEdge.type<speeds.size() && speeds[graphEdge.type]>0.0;
+    }
+
     inline bool CanUse(const Area& area) const
     {
       if (area.rings.size()!=1) {
@@ -189,6 +235,23 @@ namespace osmscout {
       return false;
     }
 
+    inline double GetTime(const RouteNode& currentNode,
+                          size_t pathIndex) const
+    {
+      double speed;
+
+      if (currentNode.paths[pathIndex].maxSpeed>0) {
+        speed=currentNode.paths[pathIndex].maxSpeed;
+      }
+      else {
+        speed=speeds[currentNode.paths[pathIndex].type];
+      }
+
+      speed=std::min(vehicleMaxSpeed,speed);
+
+      return currentNode.paths[pathIndex].distance/speed;
+    }
+
     inline double GetTime(const Area& area,
                           double distance) const
     {
@@ -229,6 +292,18 @@ namespace osmscout {
       return currentNode.paths[pathIndex].distance;
     }
 
+    inline double GetCosts(const ReverseRouteNode& currentNode,
+                           size_t pathIndex) const
+    {
+      return currentNode.paths[pathIndex].distance;
+    }
+
+    inline double GetCosts(const RouteGraph& graph,
+                           uint32_t edge) const
+    {
+      return graph.GetDistance(edge);
+    }
+
     inline double GetCosts(const Area& /*area*/,
                            double distance) const
     {
@@ -245,6 +320,8 @@ namespace osmscout {
     {
       return distance;
     }
+
+    uint64_t GetCostHash() const;
   };
 
   /**
@@ -271,6 +348,41 @@ namespace osmscout {
       return currentNode.paths[pathIndex].distance/speed;
     }
 
+    inline double GetCosts(const ReverseRouteNode& currentNode,
+                           size_t pathIndex) const
+    {
+      double speed;
+
+      if (currentNode.paths[pathIndex].maxSpeed>0) {
+        speed=currentNode.paths[pathIndex].maxSpeed;
+      }
+      else {
+        speed=speeds[currentNode.paths[pathIndex].type];
+      }
+
+      speed=std::min(vehicleMaxSpeed,speed);
+
+      return currentNode.paths[pathIndex].distance/speed;
+    }
+
+    inline double GetCosts(const RouteGraph& graph,
+                           uint32_t edge) const
+    {
+      const RouteGraph::Edge& graphEdge=graph.GetEdge(edge);
+      double                  speed;
+
+      if (graphEdge.maxSpeed>0) {
+        speed=graphEdge.maxSpeed;
+      }
+      else {
+        speed=speeds[graphEdge.type];
+      }
+
+      speed=std::min(vehicleMaxSpeed,speed);
+
+      return graph.GetDistance(edge)/speed;
+    }
+
     inline double GetCosts(const Area& area,
                            double distance) const
     {
@@ -306,6 +418,8 @@ namespace osmscout {
 
       return distance/speed;
     }
+
+    uint64_t GetCostHash() const;
   };
 }
 
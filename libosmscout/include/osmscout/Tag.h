@@ -21,6 +21,7 @@
 */
 
 #include <string>
+#include <vector>
 
 #include <osmscout/private/CoreImportExport.h>
 
@@ -47,6 +48,8 @@ namespace osmscout {
       // no code
     }
   };
+
+  extern OSMSCOUT_API size_t GetTagsMemorySize(const std::vector<Tag>& tags);
 }
 
 #endif
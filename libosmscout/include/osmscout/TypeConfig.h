@@ -40,12 +40,84 @@ namespace osmscout {
 
   const static TypeId typeIgnore      = 0;
 
+  /**
+   * A tag of an object with its value replaced by the id of the value in the
+   * TagValueTable of the TypeConfig, see TypeConfig::InternTags(). Values
+   * that are not used in any condition have the id 0.
+   */
+  struct OSMSCOUT_API InternedTag
+  {
+    TagId    tag;
+    uint32_t value;
+
+    inline bool operator<(const InternedTag& other) const
+    {
+      return tag<other.tag;
+    }
+  };
+
+  typedef std::vector<InternedTag> InternedTagList; //! Sorted by tag
+
+  /**
+   * Assigns a unique id (starting with 1) to each combination of tag and
+   * value used in a tag condition.
+   */
+  class OSMSCOUT_API TagValueTable
+  {
+  private:
+    std::vector<OSMSCOUT_HASHMAP<std::string,uint32_t> > valueIds; //! Value ids by tag
+    uint32_t                                             valueCount;
+
+  public:
+    TagValueTable();
+
+    uint32_t RegisterValue(TagId tag,
+                           const std::string& value);
+    uint32_t GetValueId(TagId tag,
+                        const std::string& value) const;
+
+    inline uint32_t GetValueCount() const
+    {
+      return valueCount;
+    }
+  };
+
+  /**
+   * A tag (if value is 0) or a value of a tag (see TagValueTable) that
+   * triggers a condition.
+   */
+  struct OSMSCOUT_API TagTrigger
+  {
+    TagId    tag;
+    uint32_t value;
+  };
+
   class OSMSCOUT_API TagCondition : public Referencable
   {
+  protected:
+    static const InternedTag* FindTag(const InternedTagList& tags,
+                                      TagId tag);
+
   public:
     virtual ~TagCondition();
 
     virtual bool Evaluate(const std::map<TagId,std::string>& tagMap) const = 0;
+
+    /**
+     * Evaluate the condition against the interned tags of an object. The
+     * condition must have been compiled against the same value table.
+     */
+    virtual bool Evaluate(const InternedTagList& tags) const = 0;
+
+    /**
+     * Register the values used by the condition in the value table and
+     * collect the triggers of the condition: the condition can only be true,
+     * if at least one of the triggers matches a tag of the object. Returns
+     * false, if the condition can be true without any trigger matching (and
+     * thus must always be evaluated).
+     */
+    virtual bool Compile(TagValueTable& valueTable,
+                         std::vector<TagTrigger>& triggers) = 0;
   };
 
   typedef Ref<TagCondition> TagConditionRef;
@@ -59,6 +131,9 @@ namespace osmscout {
     TagNotCondition(TagCondition* condition);
 
     bool Evaluate(const std::map<TagId,std::string>& tagMap) const;
+    bool Evaluate(const InternedTagList& tags) const;
+    bool Compile(TagValueTable& valueTable,
+                 std::vector<TagTrigger>& triggers);
   };
 
   class OSMSCOUT_API TagBoolCondition : public TagCondition
@@ -79,6 +154,9 @@ namespace osmscout {
     void AddCondition(TagCondition* condition);
 
     bool Evaluate(const std::map<TagId,std::string>& tagMap) const;
+    bool Evaluate(const InternedTagList& tags) const;
+    bool Compile(TagValueTable& valueTable,
+                 std::vector<TagTrigger>& triggers);
   };
 
   class OSMSCOUT_API TagExistsCondition : public TagCondition
@@ -90,6 +168,9 @@ namespace osmscout {
     TagExistsCondition(TagId tag);
 
     bool Evaluate(const std::map<TagId,std::string>& tagMap) const;
+    bool Evaluate(const InternedTagList& tags) const;
+    bool Compile(TagValueTable& valueTable,
+                 std::vector<TagTrigger>& triggers);
   };
 
   class OSMSCOUT_API TagBinaryCondition : public TagCondition
@@ -98,6 +179,7 @@ namespace osmscout {
     TagId          tag;
     BinaryOperator binaryOperator;
     std::string    tagValue;
+    uint32_t       tagValueId;
 
   public:
     TagBinaryCondition(TagId tag,
@@ -105,6 +187,9 @@ namespace osmscout {
                        const std::string& tagValue);
 
     bool Evaluate(const std::map<TagId,std::string>& tagMap) const;
+    bool Evaluate(const InternedTagList& tags) const;
+    bool Compile(TagValueTable& valueTable,
+                 std::vector<TagTrigger>& triggers);
   };
 
   class OSMSCOUT_API TagIsInCondition : public TagCondition
@@ -112,6 +197,7 @@ namespace osmscout {
   private:
     TagId                 tag;
     std::set<std::string> tagValues;
+    std::vector<uint32_t> tagValueIds; //! Sorted
 
   public:
     TagIsInCondition(TagId tag);
@@ -119,6 +205,9 @@ namespace osmscout {
     void AddTagValue(const std::string& tagValue);
 
     bool Evaluate(const std::map<TagId,std::string>& tagMap) const;
+    bool Evaluate(const InternedTagList& tags) const;
+    bool Compile(TagValueTable& valueTable,
+                 std::vector<TagTrigger>& triggers);
   };
 
   class OSMSCOUT_API TagInfo
@@ -436,6 +525,28 @@ namespace osmscout {
 
   class OSMSCOUT_API TypeConfig
   {
+  private:
+    /**
+     * Kinds of type lookup
+     */
+    enum RuleKind {
+      ruleNode         = 1 << 0,
+      ruleWayArea      = 1 << 1,
+      ruleMultipolygon = 1 << 2,
+      ruleRelation     = 1 << 3
+    };
+
+    /**
+     * One condition of a type, in the order of evaluation
+     */
+    struct TypeRule
+    {
+      TypeId          type;
+      unsigned char   types;     //! The object types of the condition (TypeInfo::typeNode...)
+      unsigned char   kinds;     //! The kinds of lookups the rule is used for (RuleKind)
+      TagConditionRef condition;
+    };
+
   private:
     std::vector<TagInfo>                   tags;
     std::vector<TypeInfo>                  types;
@@ -451,6 +562,25 @@ namespace osmscout {
 
     OSMSCOUT_HASHMAP<std::string,size_t>   surfaceToGradeMap;
 
+    TagValueTable                          tagValueTable;     //! Ids of all values used in conditions
+    uint32_t                               multipolygonValueId;
+    std::vector<TypeRule>                  typeRules;         //! All type conditions in evaluation order
+    std::vector<uint32_t>                  untriggeredRules;  //! Rules that must always be evaluated
+    std::vector<std::vector<uint32_t> >    tagRules;          //! Rules triggered by a tag, by tag id
+    std::vector<std::vector<uint32_t> >    tagValueRules;     //! Rules triggered by a value, by value id
+
+  private:
+    void AddTypeRules(const TypeInfo& typeInfo);
+    void FindNextRule(const std::vector<uint32_t>& rules,
+                      unsigned char kind,
+                      bool first,
+                      uint32_t after,
+                      bool& found,
+                      uint32_t& next) const;
+    bool GetFirstMatchingRule(const InternedTagList& tags,
+                              unsigned char kind,
+                              size_t& rule) const;
+
   public:
     TypeId                                 typeTileLand;
     TypeId                                 typeTileSea;
@@ -533,6 +663,9 @@ namespace osmscout {
     bool IsNameTag(TagId tag, uint32_t& priority) const;
     bool IsNameAltTag(TagId tag, uint32_t& priority) const;
 
+    void InternTags(const std::map<TagId,std::string>& tagMap,
+                    InternedTagList& tags) const;
+
     bool GetNodeTypeId(const std::map<TagId,std::string>& tagMap,
                        TypeId &typeId) const;
     bool GetWayAreaTypeId(const std::map<TagId,std::string>& tagMap,
@@ -541,6 +674,14 @@ namespace osmscout {
     bool GetRelationTypeId(const std::map<TagId,std::string>& tagMap,
                            TypeId &typeId) const;
 
+    bool GetNodeTypeId(const InternedTagList& tags,
+                       TypeId &typeId) const;
+    bool GetWayAreaTypeId(const InternedTagList& tags,
+                          TypeId &wayType,
+                          TypeId &areaType) const;
+    bool GetRelationTypeId(const InternedTagList& tags,
+                           TypeId &typeId) const;
+
     TypeId GetTypeId(const std::string& name) const;
     TypeId GetNodeTypeId(const std::string& name) const;
     TypeId GetWayTypeId(const std::string& name) const;
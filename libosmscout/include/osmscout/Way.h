@@ -182,8 +182,12 @@ namespace osmscout {
     bool Read(FileScanner& scanner);
     bool Write(FileWriter& writer) const;
 
+    size_t GetMemorySize() const;
+
     bool operator==(const WayAttributes& other) const;
     bool operator!=(const WayAttributes& other) const;
+
+    friend class WayView;
   };
 
   class OSMSCOUT_API Way : public Referencable
@@ -326,6 +330,8 @@ namespace osmscout {
 
     void SetLayerToMax();
 
+    size_t GetMemorySize() const;
+
     bool Read(FileScanner& scanner);
     bool ReadOptimized(FileScanner& scanner);
 
@@ -22,39 +22,344 @@
 
 #include <osmscout/CoreFeatures.h>
 
+#include <algorithm>
 #include <iostream>
-
 #include <limits>
-#include <list>
 #include <vector>
 
 #include <osmscout/system/Assert.h>
+#include <osmscout/system/Types.h>
 
 #include <osmscout/Types.h>
 
-#include <osmscout/util/HashMap.h>
+#include <osmscout/util/Mutex.h>
+
+#include <osmscout/private/CoreImportExport.h>
 
 namespace osmscout {
 
   /**
-    Generic FIFO cache implementation with O(n log n) semantic.
+    Marker for "no slot" in the slot index based data structures of the cache.
+    */
+  static const uint32_t cacheNoSlot=0xffffffff;
 
-    Template parameter class K holds the key value (must be a numerical value),
-    parameter class V holds the data class that is to be cached,
-    and parameter IK holds the internal key value, must be an unsigned value,
-    default is PageId.
+  /**
+    Hit, miss, insertion and eviction counters of a cache.
+    */
+  struct OSMSCOUT_API CacheStatistics
+  {
+    unsigned long hits;       //! Number of successful lookups
+    unsigned long misses;     //! Number of failed lookups
+    unsigned long insertions; //! Number of new entries
+    unsigned long evictions;  //! Number of entries removed because of the size limit
+
+    inline CacheStatistics()
+    : hits(0),
+      misses(0),
+      insertions(0),
+      evictions(0)
+    {
+      // no code
+    }
 
-    * The cache is not threadsafe.
-    * It uses a std::vector<std::list>> as a hash table for data lookup
-    * It uses an std::list for implementing FIFO characteristics.
+    inline CacheStatistics& operator+=(const CacheStatistics& other)
+    {
+      hits+=other.hits;
+      misses+=other.misses;
+      insertions+=other.insertions;
+      evictions+=other.evictions;
+
+      return *this;
+    }
+
+    /**
+      Returns the hit rate in the range [0..1].
+      */
+    inline double GetHitRate() const
+    {
+      if (hits+misses==0) {
+        return 0.0;
+      }
+
+      return (double)hits/(hits+misses);
+    }
+  };
+
+  /**
+    Doubly linked list of cache slots. The links itself are stored
+    in CacheSlotLinks, so a slot can be moved between multiple lists without
+    any allocation.
+    */
+  struct OSMSCOUT_API CacheSlotList
+  {
+    uint32_t      head;
+    uint32_t      tail;
+    unsigned long size;
+
+    inline CacheSlotList()
+    : head(cacheNoSlot),
+      tail(cacheNoSlot),
+      size(0)
+    {
+      // no code
+    }
+  };
+
+  /**
+    Array of previous/next links for all slots of a cache.
+    */
+  class OSMSCOUT_API CacheSlotLinks
+  {
+  private:
+    std::vector<uint32_t> prev;
+    std::vector<uint32_t> next;
 
-    Implementation details: If std::unordered_map ist available we use this
-    for fast detection (O(1)) if an object is already in the cast. If it is not
-    available, we use a vector as a hashtable via the key value with list
-    as entry type for hash code conflict handling.
+  public:
+    inline void Resize(size_t slotCount)
+    {
+      prev.resize(slotCount,cacheNoSlot);
+      next.resize(slotCount,cacheNoSlot);
+    }
+
+    inline void PushFront(CacheSlotList& list,
+                          uint32_t slot)
+    {
+      prev[slot]=cacheNoSlot;
+      next[slot]=list.head;
+
+      if (list.head!=cacheNoSlot) {
+        prev[list.head]=slot;
+      }
+      else {
+        list.tail=slot;
+      }
+
+      list.head=slot;
+      list.size++;
+    }
+
+    inline void Unlink(CacheSlotList& list,
+                       uint32_t slot)
+    {
+      if (prev[slot]!=cacheNoSlot) {
+        next[prev[slot]]=next[slot];
+      }
+      else {
+        list.head=next[slot];
+      }
+
+      if (next[slot]!=cacheNoSlot) {
+        prev[next[slot]]=prev[slot];
+      }
+      else {
+        list.tail=prev[slot];
+      }
+
+      prev[slot]=cacheNoSlot;
+      next[slot]=cacheNoSlot;
+      list.size--;
+    }
+
+    inline void MoveToFront(CacheSlotList& list,
+                            uint32_t slot)
+    {
+      if (list.head!=slot) {
+        Unlink(list,slot);
+        PushFront(list,slot);
+      }
+    }
+
+    inline size_t GetMemory() const
+    {
+      return (prev.capacity()+next.capacity())*sizeof(uint32_t);
+    }
+  };
 
+  /**
+    Eviction policy that evicts the least recently used entry.
+
+    A policy gets notified about new entries (Insert()) and cache hits (Access())
+    and decides, which entry to remove if the cache is full (Evict()). Entries
+    are identified by their slot index. Resize() is called before slots with
+    a higher index are used, SetCapacity() if the maximum size of the cache
+    changes. For caches limited by memory the capacity is the current number
+    of entries.
+    */
+  class OSMSCOUT_API LRUCachePolicy
+  {
+  private:
+    CacheSlotLinks links;
+    CacheSlotList  list;
+
+  public:
+    inline void Resize(size_t slotCount)
+    {
+      links.Resize(slotCount);
+    }
+
+    inline void SetCapacity(unsigned long /*capacity*/)
+    {
+      // no code
+    }
+
+    inline void Clear()
+    {
+      links=CacheSlotLinks();
+      list=CacheSlotList();
+    }
+
+    inline void Insert(uint32_t slot)
+    {
+      links.PushFront(list,slot);
+    }
+
+    inline void Access(uint32_t slot)
+    {
+      links.MoveToFront(list,slot);
+    }
+
+    inline uint32_t Evict()
+    {
+      uint32_t slot=list.tail;
+
+      assert(slot!=cacheNoSlot);
+
+      links.Unlink(list,slot);
+
+      return slot;
+    }
+
+    inline size_t GetMemory() const
+    {
+      return links.GetMemory();
+    }
+  };
+
+  /**
+    Scan resistant eviction policy (segmented LRU).
+
+    New entries are placed into a probationary segment. An entry is
+    promoted to the protected segment on its second access. If the protected
+    segment exceeds its share of the cache (80%), its least recently used entry
+    is moved back into the probationary segment. Eviction always takes the
+    least recently used entry of the probationary segment first.
+
+    As a result a scan over a large number of entries that are accessed only
+    once (like rendering a large area at low zoom) only flushes the
+    probationary segment while the frequently used entries in the protected
+    segment survive.
+    */
+  class OSMSCOUT_API SegmentedLRUCachePolicy
+  {
+  private:
+    CacheSlotLinks       links;
+    CacheSlotList        probationary;
+    CacheSlotList        protectedSegment;
+    std::vector<uint8_t> isProtected;
+    unsigned long        protectedCapacity;
+
+  private:
+    inline void StripProtected()
+    {
+      while (protectedSegment.size>protectedCapacity) {
+        uint32_t slot=protectedSegment.tail;
+
+        links.Unlink(protectedSegment,slot);
+        isProtected[slot]=false;
+        links.PushFront(probationary,slot);
+      }
+    }
+
+  public:
+    inline SegmentedLRUCachePolicy()
+    : protectedCapacity(0)
+    {
+      // no code
+    }
+
+    inline void Resize(size_t slotCount)
+    {
+      links.Resize(slotCount);
+      isProtected.resize(slotCount,false);
+    }
+
+    inline void SetCapacity(unsigned long capacity)
+    {
+      protectedCapacity=capacity-capacity/5;
+
+      StripProtected();
+    }
+
+    inline void Clear()
+    {
+      links=CacheSlotLinks();
+      probationary=CacheSlotList();
+      protectedSegment=CacheSlotList();
+      isProtected.clear();
+    }
+
+    inline void Insert(uint32_t slot)
+    {
+      isProtected[slot]=false;
+      links.PushFront(probationary,slot);
+    }
+
+    inline void Access(uint32_t slot)
+    {
+      if (isProtected[slot]) {
+        links.MoveToFront(protectedSegment,slot);
+      }
+      else {
+        links.Unlink(probationary,slot);
+        isProtected[slot]=true;
+        links.PushFront(protectedSegment,slot);
+
+        StripProtected();
+      }
+    }
+
+    inline uint32_t Evict()
+    {
+      CacheSlotList& list=probationary.size>0 ? probationary : protectedSegment;
+      uint32_t       slot=list.tail;
+
+      assert(slot!=cacheNoSlot);
+
+      links.Unlink(list,slot);
+      isProtected[slot]=false;
+
+      return slot;
+    }
+
+    inline size_t GetMemory() const
+    {
+      return links.GetMemory()+isProtected.capacity();
+    }
+  };
+
+  /**
+    Generic cache implementation with O(1) semantic.
+
+    Template parameter class K holds the key value (must be a numerical value),
+    parameter class V holds the data class that is to be cached,
+    parameter IK holds the internal key value, must be an unsigned value,
+    default is PageId. Parameter P defines the eviction policy, default
+    is the scan resistant SegmentedLRUCachePolicy.
+
+    * The cache is not threadsafe, use ShardedCache for concurrent access.
+    * Entries are stored in slots within fixed size arrays (chunks), which
+      are allocated on demand and never moved. A CacheRef thus stays valid until
+      the entry is evicted.
+    * Lookup is done via an open addressing hash table of slot indices.
+    * The eviction policy only works on slot indices.
+    * Beside the maximum number of entries the cache can be limited by the
+      memory used by its entries. For this a ValueSizer must be set. Evictions
+      are then driven by the size of the individual entries.
+
+    Beside adding new chunks and growing the hash table there are no memory
+    allocations for inserting, updating or evicting entries.
    */
-  template <class K, class V, class IK = PageId>
+  template <class K, class V, class IK = PageId, class P = SegmentedLRUCachePolicy>
   class Cache
   {
   public:
@@ -66,6 +371,12 @@ namespace osmscout {
       K key;
       V value;
 
+      CacheEntry()
+      : key()
+      {
+        // no code
+      }
+
       CacheEntry(const CacheEntry& entry)
       : key(entry.key),
         value(entry.value)
@@ -86,12 +397,20 @@ namespace osmscout {
       {
         // no code
       }
+
+      CacheEntry& operator=(const CacheEntry& entry)
+      {
+        key=entry.key;
+        value=entry.value;
+
+        return *this;
+      }
     };
 
     /**
       ValueSizer returns the size (in bytes) of an individual cache value.
-      An implementation of ValueSizer has to be passed in the constructor of the cache
-      to implement the GetSize() method.
+      An implementation of ValueSizer has to be passed to GetMemory() and
+      to SetValueSizer() if the cache should be limited by memory.
       */
     struct ValueSizer
     {
@@ -103,65 +422,214 @@ namespace osmscout {
       virtual unsigned long GetSize(const V& value) const = 0;
     };
 
-    typedef std::list<CacheEntry>                   OrderList;
-    typedef typename OrderList::iterator            CacheRef;
-#if defined(OSMSCOUT_HAVE_UNORDERED_MAP)
-    typedef OSMSCOUT_HASHMAP<K,typename OrderList::iterator> Map;
-#else
-    typedef std::list<typename OrderList::iterator> CacheRefList;
-    typedef std::vector<CacheRefList>               Map;
-#endif
+    typedef CacheEntry* CacheRef;
+    typedef P           Policy;
 
   private:
-    unsigned long size;
-    unsigned long maxSize;
-    OrderList     order;
-    Map           map;
+    static const size_t maxChunkSize=1024;
 
   private:
+    unsigned long            size;       //! Number of entries
+    unsigned long            maxSize;    //! Maximum number of entries
+    unsigned long            memory;     //! Memory used by all entries (only if a sizer is set)
+    unsigned long            maxMemory;  //! Maximum memory used by all entries, 0 for no limit
+    const ValueSizer*        sizer;      //! Sizer for memory accounting, or NULL
+    std::vector<unsigned long> slotMemory; //! Memory used by the entry in each slot
+    size_t                   chunkShift; //! log2 of the number of slots per chunk
+    std::vector<CacheEntry*> chunks;     //! Arrays of slots
+    uint32_t                 usedSlots;  //! Number of slots handed out at least once
+    std::vector<uint32_t>    freeSlots;  //! Slots freed by reducing the maximum size
+    std::vector<uint32_t>    table;      //! Open addressing hash table of slot indices
+    Policy                   policy;     //! Eviction policy
+    CacheEntry               inactiveEntry; //! Entry returned by SetEntry() for inactive caches
+    CacheStatistics          statistics; //! Hit/miss counters
 
-    inline IK KeyToInternalKey(K key)
+  private:
+    inline IK KeyToInternalKey(K key) const
     {
       return key - std::numeric_limits<K>::min();
     }
 
+    /**
+      Keys (ids, file offsets) are often accessed in ascending order, so we
+      keep neighbouring keys in neighbouring buckets for better memory locality,
+      but fold in higher bits to break up clustering of aligned keys.
+      */
+    inline size_t GetBucket(const K& key) const
+    {
+      IK hash=KeyToInternalKey(key);
+
+      return (size_t)(hash ^ (hash >> 7) ^ (hash >> 17)) & (table.size()-1);
+    }
+
+    inline CacheEntry& GetSlotEntry(uint32_t slot) const
+    {
+      return chunks[slot >> chunkShift][slot & ((1 << chunkShift)-1)];
+    }
 
     /**
-      Clear the cache deleting the oldest cache entries
-      until it has the given max size.
+      Returns the bucket in the hash table holding the given key or the
+      empty bucket where the key would be placed.
       */
-    void StripCache()
+    inline size_t FindBucket(const K& key) const
     {
-      while (size>maxSize) {
-        // Remove oldest entry from cache...
+      size_t mask=table.size()-1;
+      size_t bucket=GetBucket(key);
 
-        // Get oldest entry
-        typename std::list<CacheEntry>::reverse_iterator lastEntry=order.rbegin();
+      while (table[bucket]!=cacheNoSlot &&
+             GetSlotEntry(table[bucket]).key!=key) {
+        bucket=(bucket+1) & mask;
+      }
 
-#if defined(OSMSCOUT_HAVE_UNORDERED_MAP)
-        typename Map::iterator iter=map.find(lastEntry->key);
+      return bucket;
+    }
 
-        assert(iter!=map.end());
+    /**
+      Remove the slot at the given bucket from the hash table, closing the gap
+      by shifting following entries back (no tombstones needed).
+      */
+    void RemoveBucket(size_t bucket)
+    {
+      size_t mask=table.size()-1;
+      size_t hole=bucket;
+      size_t next=(hole+1) & mask;
 
-        map.erase(iter);
-#else
-        IK            lastEntryInternalKey=KeyToInternalKey(lastEntry->key);
-        unsigned long index=lastEntryInternalKey % map.size();
+      while (table[next]!=cacheNoSlot) {
+        size_t home=GetBucket(GetSlotEntry(table[next]).key);
 
-        typename CacheRefList::iterator iter=map[index].begin();
-        while (iter!=map[index].end() &&
-               (*iter)->key!=lastEntry->key) {
-          ++iter;
+        if (((next-home) & mask)>=((next-hole) & mask)) {
+          table[hole]=table[next];
+          hole=next;
         }
 
-        assert(iter!=map[index].end());
+        next=(next+1) & mask;
+      }
 
-        // Remove it from map
-        map[index].erase(iter);
-#endif
-        // Remove it from order list
-        order.pop_back();
-        size--;
+      table[hole]=cacheNoSlot;
+    }
+
+    void ResizeTable(size_t tableSize)
+    {
+      std::vector<uint32_t> oldTable(tableSize,cacheNoSlot);
+
+      std::swap(table,oldTable);
+
+      for (size_t i=0; i<oldTable.size(); i++) {
+        if (oldTable[i]!=cacheNoSlot) {
+          table[FindBucket(GetSlotEntry(oldTable[i]).key)]=oldTable[i];
+        }
+      }
+    }
+
+    uint32_t AllocateSlot()
+    {
+      if (!freeSlots.empty()) {
+        uint32_t slot=freeSlots.back();
+
+        freeSlots.pop_back();
+
+        return slot;
+      }
+
+      if (usedSlots>=(chunks.size() << chunkShift)) {
+        if (chunks.empty()) {
+          chunkShift=0;
+          while ((1ul << chunkShift)<maxChunkSize &&
+                 (1ul << chunkShift)<maxSize) {
+            chunkShift++;
+          }
+        }
+
+        chunks.push_back(new CacheEntry[1 << chunkShift]);
+        policy.Resize(chunks.size() << chunkShift);
+
+        if (sizer!=NULL) {
+          slotMemory.resize(chunks.size() << chunkShift,0);
+        }
+      }
+
+      return usedSlots++;
+    }
+
+    /**
+      Memory used by the given entry including its share of the hash table.
+      */
+    inline unsigned long GetEntryMemory(const CacheEntry& entry) const
+    {
+      return sizeof(CacheEntry)+2*sizeof(uint32_t)+sizer->GetSize(entry.value);
+    }
+
+    inline void SetSlotMemory(uint32_t slot,
+                              unsigned long entryMemory)
+    {
+      memory-=slotMemory[slot];
+      memory+=entryMemory;
+      slotMemory[slot]=entryMemory;
+    }
+
+    /**
+      Returns true, if adding the given number of entries and the given
+      amount of memory would exceed the limits of the cache.
+      */
+    inline bool ExceedsLimits(unsigned long extraEntries,
+                              unsigned long extraMemory) const
+    {
+      return size+extraEntries>maxSize ||
+             (maxMemory>0 && memory+extraMemory>maxMemory);
+    }
+
+    void EvictEntry()
+    {
+      uint32_t slot=policy.Evict();
+
+      RemoveBucket(FindBucket(GetSlotEntry(slot).key));
+      GetSlotEntry(slot)=CacheEntry();
+
+      if (sizer!=NULL) {
+        SetSlotMemory(slot,0);
+      }
+
+      freeSlots.push_back(slot);
+
+      size--;
+      statistics.evictions++;
+    }
+
+    /**
+      Remove entries chosen by the policy until the given number of entries
+      and the given amount of memory can be added without exceeding the limits,
+      but keep at least minSize entries.
+      */
+    void StripCache(unsigned long extraEntries=0,
+                    unsigned long extraMemory=0,
+                    unsigned long minSize=0)
+    {
+      while (size>minSize &&
+             ExceedsLimits(extraEntries,extraMemory)) {
+        EvictEntry();
+      }
+    }
+
+    void FreeChunks()
+    {
+      for (size_t i=0; i<chunks.size(); i++) {
+        delete [] chunks[i];
+      }
+
+      chunks.clear();
+    }
+
+    void CopyEntries(const Cache& other)
+    {
+      chunkShift=other.chunkShift;
+      usedSlots=other.usedSlots;
+
+      for (size_t i=0; i<other.chunks.size(); i++) {
+        chunks.push_back(new CacheEntry[1 << chunkShift]);
+
+        for (size_t j=0; j<(1ul << chunkShift); j++) {
+          chunks[i][j]=other.chunks[i][j];
+        }
       }
     }
 
@@ -171,20 +639,56 @@ namespace osmscout {
       */
     Cache(unsigned long maxSize)
      : size(0),
-       maxSize(maxSize)
+       maxSize(maxSize),
+       memory(0),
+       maxMemory(0),
+       sizer(NULL),
+       chunkShift(0),
+       usedSlots(0)
     {
-#if defined(OSMSCOUT_HAVE_UNORDERED_MAP)
-  #if defined(OSMSCOUT_HASHMAP_HAS_RESERVE)
-      map.reserve(maxSize);
-  #endif
-#else
-      if(maxSize>=10) {
-        map.resize(maxSize/5);
-      }
-      else {
-        map.resize(maxSize);
+      policy.SetCapacity(maxSize);
+    }
+
+    Cache(const Cache& other)
+     : size(other.size),
+       maxSize(other.maxSize),
+       memory(other.memory),
+       maxMemory(other.maxMemory),
+       sizer(other.sizer),
+       slotMemory(other.slotMemory),
+       freeSlots(other.freeSlots),
+       table(other.table),
+       policy(other.policy),
+       statistics(other.statistics)
+    {
+      CopyEntries(other);
+    }
+
+    ~Cache()
+    {
+      FreeChunks();
+    }
+
+    Cache& operator=(const Cache& other)
+    {
+      if (&other!=this) {
+        FreeChunks();
+
+        size=other.size;
+        maxSize=other.maxSize;
+        memory=other.memory;
+        maxMemory=other.maxMemory;
+        sizer=other.sizer;
+        slotMemory=other.slotMemory;
+        freeSlots=other.freeSlots;
+        table=other.table;
+        policy=other.policy;
+        statistics=other.statistics;
+
+        CopyEntries(other);
       }
-#endif
+
+      return *this;
     }
 
     /**
@@ -202,8 +706,8 @@ namespace osmscout {
       returned and the reference will be untouched.
 
       If there is a value with the given key, reference will return
-      a reference to the value and the value will moved to the
-      front position of the cache to assure FIFO behaviour.
+      a reference to the value and the eviction policy will be notified
+      about the access.
       */
     bool GetEntry(const K& key,
                   CacheRef& reference)
@@ -212,133 +716,151 @@ namespace osmscout {
         return false;
       }
 
-#if defined(OSMSCOUT_HAVE_UNORDERED_MAP)
-      typename Map::iterator iter=map.find(key);
-
-      if (iter!=map.end()) {
-        // Move key/value to the start of the order list
-        order.splice(order.begin(),order,iter->second);
-
-        // Update the map with the new iterator into the order list
-        iter->second=order.begin();
-
-        reference=order.begin();
-
-        return true;
-      }
-#else
-      IK            internalKey=KeyToInternalKey(key);
-      unsigned long index(internalKey % map.size());
-      CacheRefList  *refList=&map[index];
+      if (size>0) {
+        size_t bucket=FindBucket(key);
 
-      for (typename CacheRefList::iterator iter(refList->begin());
-           iter!=refList->end();
-           ++iter) {
-        if ((*iter)->key==key) {
-          // Move key/value to the start of the order list
-          order.splice(order.begin(),order,*iter);
+        if (table[bucket]!=cacheNoSlot) {
+          uint32_t slot=table[bucket];
 
-          // Update the map with the new iterator into the order list
-          refList->push_front(order.begin());
-          refList->erase(iter);
+          policy.Access(slot);
+          statistics.hits++;
 
-          reference=order.begin();
+          reference=&GetSlotEntry(slot);
 
           return true;
         }
       }
-#endif
+
+      statistics.misses++;
+
       return false;
     }
 
     /**
       Set or update the cache with the given value for the given key.
 
-      If the key is not available in the cache the value will be added
-      to the front of the cache (FIFO semantic) else the value will be updated
-      (also moving it to the front of the cache (FIFO again).
+      If the key is not available in the cache the value will be added,
+      evicting the entries chosen by the eviction policy if the cache is full,
+      else the value will be updated.
+
+      Since the size of the value is only evaluated here, the value should
+      not be changed via the returned reference if the cache is limited
+      by memory.
       */
     typename Cache::CacheRef SetEntry(const CacheEntry& entry)
     {
       if (!IsActive()) {
-        order.clear();
+        inactiveEntry=entry;
 
-        order.push_front(entry);
-
-        return order.begin();
+        return &inactiveEntry;
       }
 
-#if defined(OSMSCOUT_HAVE_UNORDERED_MAP)
-      typename Map::iterator iter=map.find(entry.key);
+      if (size>0) {
+        size_t bucket=FindBucket(entry.key);
 
-      if (iter!=map.end()) {
-        // Move key/value to the start of the order list
-        order.splice(order.begin(),order,iter->second);
+        if (table[bucket]!=cacheNoSlot) {
+          uint32_t slot=table[bucket];
 
-        // Update the map with the new iterator into the order list
-        iter->second=order.begin();
+          policy.Access(slot);
+          GetSlotEntry(slot).value=entry.value;
 
-        order.front().value=entry.value;
-      }
-      else {
-        // Place key/value to the start of the order list
-        order.push_front(entry);
-        size++;
-        // Update the map with the new iterator into the order list
-        map[entry.key]=order.begin();
+          if (sizer!=NULL) {
+            SetSlotMemory(slot,GetEntryMemory(entry));
+
+            // The updated entry is the most recently used one, keep it
+            StripCache(0,0,1);
+          }
 
-        StripCache();
+          return &GetSlotEntry(slot);
+        }
       }
-#else
-      IK                              internalKey=KeyToInternalKey(entry.key);
-      unsigned long                   index=internalKey % map.size();
-      CacheRefList                    *refList=&map[index];
-      typename CacheRefList::iterator iter=refList->begin();
 
-      while (iter!=refList->end() &&
-             (*iter)->key!=entry.key) {
-        ++iter;
+      unsigned long entryMemory=sizer!=NULL ? GetEntryMemory(entry) : 0;
+
+      StripCache(1,entryMemory);
+
+      uint32_t slot=AllocateSlot();
+
+      // Keep load factor of the hash table <= 0.5
+      if ((size+1)*2>table.size()) {
+        ResizeTable(std::max((size_t)16,table.size()*2));
       }
 
-      if (iter!=refList->end()) {
-        // Move key/value to the start of the order list
-        order.splice(order.begin(),order,*iter);
+      GetSlotEntry(slot)=entry;
+      table[FindBucket(entry.key)]=slot;
+      policy.Insert(slot);
 
-        // Update the map with the new iterator into the order list
-        refList->push_front(order.begin());
-        // Delete the old entry in the ref list
-        refList->erase(iter);
+      size++;
+      statistics.insertions++;
 
-        order.front().value=entry.value;
+      if (sizer!=NULL) {
+        SetSlotMemory(slot,entryMemory);
       }
-      else {
-        // Place key/value to the start of the order list
-        order.push_front(entry);
-        size++;
-        // Update the map with the new iterator into the order list
-        refList->push_front(order.begin());
 
-        StripCache();
+      if (maxMemory>0) {
+        // The number of entries is defined by the memory limit, let the policy
+        // partition the current number of entries
+        policy.SetCapacity(std::min(size,maxSize));
       }
-#endif
-      return order.begin();
+
+      return &GetSlotEntry(slot);
     }
 
     /**
-      Set a new cache max size, possible striping the oldest entries
+      Set a new cache max size, possible striping entries
       from cache if the new size is smaller than the old one.
       */
     void SetMaxSize(unsigned long maxSize)
     {
       this->maxSize=maxSize;
 
+      policy.SetCapacity(maxMemory>0 ? std::min(size,maxSize) : maxSize);
+
       StripCache();
+    }
 
-#if defined(OSMSCOUT_HAVE_UNORDERED_MAP)
-  #if defined(OSMSCOUT_HASHMAP_HAS_RESERVE)
-      map.reserve(maxSize);
-  #endif
-#endif
+    /**
+      Set the sizer used for calculating the memory of the entries. Passing
+      NULL disables memory accounting (and the memory limit). The sizer must
+      stay valid as long as it is set.
+      */
+    void SetValueSizer(const ValueSizer* sizer)
+    {
+      this->sizer=sizer;
+
+      memory=0;
+      slotMemory.clear();
+
+      if (sizer==NULL) {
+        maxMemory=0;
+        return;
+      }
+
+      slotMemory.resize(chunks.size() << chunkShift,0);
+
+      for (size_t i=0; i<table.size(); i++) {
+        if (table[i]!=cacheNoSlot) {
+          SetSlotMemory(table[i],GetEntryMemory(GetSlotEntry(table[i])));
+        }
+      }
+
+      StripCache();
+    }
+
+    /**
+      Set the maximum memory (in bytes) the entries of the cache may use,
+      evicting entries if the current memory usage is higher. 0 means no
+      limit. A ValueSizer must have been set before.
+      */
+    void SetMaxMemory(unsigned long maxMemory)
+    {
+      assert(sizer!=NULL);
+
+      this->maxMemory=maxMemory;
+
+      policy.SetCapacity(maxMemory>0 ? std::min(size,maxSize) : maxSize);
+
+      StripCache();
     }
 
     /**
@@ -346,18 +868,17 @@ namespace osmscout {
       */
     void Flush()
     {
-      order.clear();
-      map.clear();
+      FreeChunks();
+      freeSlots.clear();
+      table.clear();
+      slotMemory.clear();
+      policy.Clear();
+      policy.SetCapacity(maxMemory>0 ? 0 : maxSize);
+      inactiveEntry=CacheEntry();
+
+      usedSlots=0;
       size=0;
-
-#if !defined(OSMSCOUT_HAVE_UNORDERED_MAP)
-      if(maxSize>=10) {
-        map.resize(maxSize/5);
-      }
-      else {
-        map.resize(maxSize);
-      }
-#endif
+      memory=0;
     }
 
     /**
@@ -368,36 +889,358 @@ namespace osmscout {
       return size;
     }
 
+    /**
+      Append the keys of all entries of the cache to the given vector (in
+      no particular order).
+      */
+    void GetKeys(std::vector<K>& keys) const
+    {
+      for (size_t i=0; i<table.size(); i++) {
+        if (table[i]!=cacheNoSlot) {
+          keys.push_back(GetSlotEntry(table[i]).key);
+        }
+      }
+    }
+
+    /**
+      Returns the hit/miss counters of the cache.
+      */
+    const CacheStatistics& GetStatistics() const
+    {
+      return statistics;
+    }
+
+    /**
+      Returns the maximum memory of the cache, 0 if there is no limit.
+      */
+    unsigned long GetMaxMemory() const
+    {
+      return maxMemory;
+    }
+
+    /**
+      Returns the memory used by the entries of the cache as calculated
+      by the ValueSizer, 0 if no sizer has been set.
+      */
+    unsigned long GetMemoryUsage() const
+    {
+      return memory;
+    }
+
     unsigned long GetMemory(const ValueSizer& sizer) const
     {
       unsigned long memory=0;
 
-#if defined(OSMSCOUT_HAVE_UNORDERED_MAP)
-      // Size of map
-      memory+=map.size()*sizeof(CacheRef);
+      // Size of hash table
+      memory+=table.capacity()*sizeof(uint32_t);
+
+      // Size of slots
+      memory+=(chunks.size() << chunkShift)*sizeof(CacheEntry);
+      memory+=freeSlots.capacity()*sizeof(uint32_t);
+      memory+=policy.GetMemory();
+
+      for (size_t i=0; i<table.size(); i++) {
+        if (table[i]!=cacheNoSlot) {
+          memory+=sizer.GetSize(GetSlotEntry(table[i]).value);
+        }
+      }
+
+      return memory;
+    }
+
+    /**
+      Dump some cache statistics to std::cout.
+      */
+    void DumpStatistics(const char* cacheName, const ValueSizer& sizer) const
+    {
+      std::cout << cacheName << " entries: " << size << ", memory " << GetMemory(sizer);
+      std::cout << ", hits " << statistics.hits << ", misses " << statistics.misses;
+      std::cout << ", evictions " << statistics.evictions;
+      std::cout << ", hit rate " << statistics.GetHitRate()*100 << "%" << std::endl;
+    }
+  };
+
+  /**
+    Threadsafe cache build on top of Cache.
+
+    The key space is split into a number of shards, each shard holds its own
+    Cache instance protected by its own mutex. Threads accessing
+    different shards thus do not block each other.
+
+    Since a CacheRef into a shard would be invalidated by a parallel
+    modification of the shard, values are returned and passed by copy. V
+    should thus be cheap to copy (for example a Ref<> to the real data).
+    */
+  template <class K, class V, class IK = PageId, class P = SegmentedLRUCachePolicy>
+  class ShardedCache
+  {
+  public:
+    typedef Cache<K,V,IK,P>                 ShardCache;
+    typedef typename ShardCache::CacheEntry CacheEntry;
+    typedef typename ShardCache::ValueSizer ValueSizer;
+
+  private:
+    struct Shard
+    {
+      Mutex      mutex;
+      ShardCache cache;
+
+      Shard(unsigned long maxSize)
+      : cache(maxSize)
+      {
+        // no code
+      }
+    };
+
+  private:
+    unsigned long       maxSize;
+    unsigned long       maxMemory;
+    std::vector<Shard*> shards;
+
+  private:
+    ShardedCache(const ShardedCache& other);
+    void operator=(const ShardedCache& other);
+
+    inline Shard& GetShard(const K& key) const
+    {
+      IK internalKey=key-std::numeric_limits<K>::min();
+
+      // File offsets and ids are often aligned, so mix in the higher bits
+      return *shards[(internalKey ^ (internalKey >> 7) ^ (internalKey >> 17)) % shards.size()];
+    }
+
+    inline unsigned long GetShardSize(size_t shard) const
+    {
+      unsigned long shardSize=maxSize/shards.size();
+
+      if (shard<maxSize%shards.size()) {
+        shardSize++;
+      }
 
-      // Size of list
-      memory+=size*sizeof(CacheEntry);
+      return shardSize;
+    }
 
-      for (typename std::list<CacheEntry>::const_iterator entry=order.begin();
-           entry!=order.end();
-           ++entry) {
-        memory+=sizer.GetSize(entry->value);
+  public:
+    /**
+      Create a new cache object with the given max size, distributed
+      over the given number of shards.
+      */
+    ShardedCache(unsigned long maxSize,
+                 size_t shardCount=1)
+    : maxSize(maxSize),
+      maxMemory(0)
+    {
+      if (shardCount==0) {
+        shardCount=1;
       }
-#else
-      memory+=map.size()*sizeof(CacheRefList);
-      memory+=size*sizeof(CacheEntry);
 
-      for (unsigned long i=0; i<map.size(); i++) {
-        memory+=map[i].size()*sizeof(CacheRef);
+      shards.resize(shardCount);
+
+      for (size_t s=0; s<shards.size(); s++) {
+        shards[s]=new Shard(GetShardSize(s));
       }
+    }
 
-      for (typename std::list<CacheEntry>::const_iterator entry=order.begin();
-           entry!=order.end();
-           ++entry) {
-        memory+=sizer.GetSize(entry->value);
+    ~ShardedCache()
+    {
+      for (size_t s=0; s<shards.size(); s++) {
+        delete shards[s];
+      }
+    }
+
+    /**
+     * Returns if the cache is active (maxSize > 0)
+     */
+    bool IsActive() const
+    {
+      return maxSize>0;
+    }
+
+    /**
+      Returns the number of shards
+      */
+    size_t GetShardCount() const
+    {
+      return shards.size();
+    }
+
+    /**
+      Copies the value with the given key from cache to value.
+
+      If there is no value stored with the given key, false will be
+      returned and the value will be untouched.
+      */
+    bool GetValue(const K& key,
+                  V& value) const
+    {
+      if (!IsActive()) {
+        return false;
+      }
+
+      Shard&                        shard=GetShard(key);
+      ScopedLock                    lock(shard.mutex);
+      typename ShardCache::CacheRef reference;
+
+      if (!shard.cache.GetEntry(key,reference)) {
+        return false;
+      }
+
+      value=reference->value;
+
+      return true;
+    }
+
+    /**
+      Set or update the cache with the given value for the given key.
+      */
+    void SetValue(const K& key,
+                  const V& value) const
+    {
+      if (!IsActive()) {
+        return;
+      }
+
+      Shard&     shard=GetShard(key);
+      ScopedLock lock(shard.mutex);
+
+      shard.cache.SetEntry(CacheEntry(key,value));
+    }
+
+    /**
+      Set a new cache max size, possible striping the oldest entries
+      from the shards if the new size is smaller than the old one.
+      */
+    void SetMaxSize(unsigned long maxSize)
+    {
+      this->maxSize=maxSize;
+
+      for (size_t s=0; s<shards.size(); s++) {
+        ScopedLock lock(shards[s]->mutex);
+
+        shards[s]->cache.SetMaxSize(GetShardSize(s));
+      }
+    }
+
+    /**
+      Set the sizer used for calculating the memory of the entries
+      in all shards.
+      */
+    void SetValueSizer(const ValueSizer* sizer)
+    {
+      for (size_t s=0; s<shards.size(); s++) {
+        ScopedLock lock(shards[s]->mutex);
+
+        shards[s]->cache.SetValueSizer(sizer);
+      }
+    }
+
+    /**
+      Set the maximum memory (in bytes) of the cache, 0 for no limit. The
+      memory is split evenly between the shards.
+      */
+    void SetMaxMemory(unsigned long maxMemory)
+    {
+      this->maxMemory=maxMemory;
+
+      for (size_t s=0; s<shards.size(); s++) {
+        ScopedLock lock(shards[s]->mutex);
+
+        // Avoid a shard limit of 0, which would mean unlimited
+        shards[s]->cache.SetMaxMemory(maxMemory>0 ? std::max(maxMemory/shards.size(),1ul) : 0);
+      }
+    }
+
+    /**
+      Returns the maximum memory of the cache, 0 if there is no limit.
+      */
+    unsigned long GetMaxMemory() const
+    {
+      return maxMemory;
+    }
+
+    /**
+      Returns the memory used by the entries of all shards as calculated
+      by the ValueSizer.
+      */
+    unsigned long GetMemoryUsage() const
+    {
+      unsigned long memory=0;
+
+      for (size_t s=0; s<shards.size(); s++) {
+        ScopedLock lock(shards[s]->mutex);
+
+        memory+=shards[s]->cache.GetMemoryUsage();
+      }
+
+      return memory;
+    }
+
+    /**
+      Completely flush the cache removing all entries from it.
+      */
+    void Flush() const
+    {
+      for (size_t s=0; s<shards.size(); s++) {
+        ScopedLock lock(shards[s]->mutex);
+
+        shards[s]->cache.Flush();
+      }
+    }
+
+    /**
+      Returns the current size of the cache.
+      */
+    unsigned long GetSize() const
+    {
+      unsigned long size=0;
+
+      for (size_t s=0; s<shards.size(); s++) {
+        ScopedLock lock(shards[s]->mutex);
+
+        size+=shards[s]->cache.GetSize();
+      }
+
+      return size;
+    }
+
+    /**
+      Append the keys of all entries of all shards to the given vector (in
+      no particular order).
+      */
+    void GetKeys(std::vector<K>& keys) const
+    {
+      for (size_t s=0; s<shards.size(); s++) {
+        ScopedLock lock(shards[s]->mutex);
+
+        shards[s]->cache.GetKeys(keys);
+      }
+    }
+
+    /**
+      Returns the accumulated hit/miss counters of all shards.
+      */
+    CacheStatistics GetStatistics() const
+    {
+      CacheStatistics statistics;
+
+      for (size_t s=0; s<shards.size(); s++) {
+        ScopedLock lock(shards[s]->mutex);
+
+        statistics+=shards[s]->cache.GetStatistics();
+      }
+
+      return statistics;
+    }
+
+    unsigned long GetMemory(const ValueSizer& sizer) const
+    {
+      unsigned long memory=0;
+
+      for (size_t s=0; s<shards.size(); s++) {
+        ScopedLock lock(shards[s]->mutex);
+
+        memory+=shards[s]->cache.GetMemory(sizer);
       }
-#endif
 
       return memory;
     }
@@ -405,9 +1248,15 @@ namespace osmscout {
     /**
       Dump some cache statistics to std::cout.
       */
-    void DumpStatistics(const char* cacheName, const ValueSizer& sizer)
+    void DumpStatistics(const char* cacheName, const ValueSizer& sizer) const
     {
-      std::cout << cacheName << " entries: " << size << ", memory " << GetMemory(sizer) << std::endl;
+      CacheStatistics statistics=GetStatistics();
+
+      std::cout << cacheName << " entries: " << GetSize() << ", memory " << GetMemory(sizer);
+      std::cout << ", shards " << shards.size();
+      std::cout << ", hits " << statistics.hits << ", misses " << statistics.misses;
+      std::cout << ", evictions " << statistics.evictions;
+      std::cout << ", hit rate " << statistics.GetHitRate()*100 << "%" << std::endl;
     }
   };
 }
@@ -0,0 +1,211 @@
+#ifndef OSMSCOUT_UTIL_CACHEMEMORYGOVERNOR_H
+#define OSMSCOUT_UTIL_CACHEMEMORYGOVERNOR_H
+
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2014  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <osmscout/CoreFeatures.h>
+
+#include <string>
+#include <vector>
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+#include <atomic>
+#endif
+
+#include <osmscout/util/Cache.h>
+#include <osmscout/util/Mutex.h>
+#include <osmscout/util/Reference.h>
+
+#include <osmscout/private/CoreImportExport.h>
+
+namespace osmscout {
+
+  /**
+    Interface of a cache, that gets its memory limit assigned by
+    a CacheMemoryGovernor.
+
+    All methods are called by the governor while holding its own lock, so
+    implementations must never call the governor while holding a lock that
+    is also used by these methods.
+    */
+  class OSMSCOUT_API GovernedCache
+  {
+  public:
+    virtual ~GovernedCache();
+
+    virtual std::string GetCacheName() const = 0;
+    virtual CacheStatistics GetCacheStatistics() const = 0;
+    virtual unsigned long GetCacheMemoryUsage() const = 0;
+    virtual void SetCacheMemoryLimit(unsigned long limit) = 0;
+  };
+
+  /**
+    Implementation of GovernedCache for Cache and ShardedCache instances.
+
+    Since Cache is not threadsafe, the mutex protecting the cache must be
+    passed. For ShardedCache no mutex is required.
+    */
+  template <class C>
+  class GovernedCacheAdapter : public GovernedCache
+  {
+  private:
+    std::string name;  //! Name of the cache
+    C&          cache; //! The cache
+    Mutex*      mutex; //! Mutex protecting the cache, or NULL
+
+  private:
+    GovernedCacheAdapter(const GovernedCacheAdapter& other);
+    void operator=(const GovernedCacheAdapter& other);
+
+    inline void Lock() const
+    {
+      if (mutex!=NULL) {
+        mutex->Lock();
+      }
+    }
+
+    inline void Unlock() const
+    {
+      if (mutex!=NULL) {
+        mutex->Unlock();
+      }
+    }
+
+  public:
+    GovernedCacheAdapter(const std::string& name,
+                         C& cache,
+                         Mutex* mutex=NULL)
+    : name(name),
+      cache(cache),
+      mutex(mutex)
+    {
+      // no code
+    }
+
+    std::string GetCacheName() const
+    {
+      return name;
+    }
+
+    CacheStatistics GetCacheStatistics() const
+    {
+      Lock();
+
+      CacheStatistics statistics=cache.GetStatistics();
+
+      Unlock();
+
+      return statistics;
+    }
+
+    unsigned long GetCacheMemoryUsage() const
+    {
+      Lock();
+
+      unsigned long memory=cache.GetMemoryUsage();
+
+      Unlock();
+
+      return memory;
+    }
+
+    void SetCacheMemoryLimit(unsigned long limit)
+    {
+      Lock();
+
+      cache.SetMaxMemory(limit);
+
+      Unlock();
+    }
+  };
+
+  /**
+    Distributes a global memory budget between a number of caches.
+
+    Instead of configuring the size of each cache individually, the caches
+    are registered at the governor, which assigns each cache a memory limit
+    (the caches must evict based on the memory size of their entries).
+
+    Every given number of cache accesses (see NotifyAccesses()) the limits
+    get rebalanced based on the hit/miss counters of the caches since the
+    last rebalancing:
+    * A quarter of the budget is always split evenly between all caches, so
+      that no cache gets starved.
+    * The rest is distributed proportionally to the number of misses plus a
+      quarter of the number of hits of each cache, so caches that are
+      used more often and miss more often get more memory.
+    * Caches that had no evictions do not need more memory than they
+      currently use, their unused share goes to the other caches.
+    * Limits move only half the way to their new value to avoid oscillation.
+
+    The governor is threadsafe.
+    */
+  class OSMSCOUT_API CacheMemoryGovernor : public Referencable
+  {
+  private:
+    struct Client
+    {
+      GovernedCache*  cache;          //! The cache
+      CacheStatistics lastStatistics; //! Statistics at the last rebalancing
+      unsigned long   limit;          //! The current memory limit
+    };
+
+  private:
+    mutable Mutex                    mutex;             //! Mutex to secure the client list
+    unsigned long                    memoryBudget;      //! Memory budget in bytes
+    unsigned long                    rebalanceInterval; //! Number of accesses between rebalancing
+    std::vector<Client>              clients;           //! The registered caches
+#if defined(OSMSCOUT_HAVE_THREAD)
+    std::atomic<unsigned long>       accessCount;       //! Number of accesses since the last rebalancing
+#else
+    unsigned long                    accessCount;       //! Number of accesses since the last rebalancing
+#endif
+
+  private:
+    CacheMemoryGovernor(const CacheMemoryGovernor& other);
+    void operator=(const CacheMemoryGovernor& other);
+
+    void DistributeBudget(bool smooth);
+
+  public:
+    CacheMemoryGovernor(unsigned long memoryBudget);
+    virtual ~CacheMemoryGovernor();
+
+    void SetMemoryBudget(unsigned long memoryBudget);
+    void SetRebalanceInterval(unsigned long rebalanceInterval);
+
+    unsigned long GetMemoryBudget() const;
+    unsigned long GetRebalanceInterval() const;
+
+    void Register(GovernedCache* cache);
+    void Unregister(GovernedCache* cache);
+
+    void NotifyAccesses(unsigned long count);
+    void Rebalance();
+
+    unsigned long GetMemoryUsage() const;
+
+    void DumpStatistics() const;
+  };
+
+  typedef Ref<CacheMemoryGovernor> CacheMemoryGovernorRef;
+}
+
+#endif
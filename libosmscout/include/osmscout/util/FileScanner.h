@@ -22,6 +22,7 @@
 
 #include <cstdio>
 #include <string>
+#include <vector>
 
 #include <osmscout/CoreFeatures.h>
 
@@ -101,6 +102,13 @@ namespace osmscout {
     bool SetPos(FileOffset pos);
     bool GetPos(FileOffset &pos) const;
 
+    bool GetMappedData(FileOffset pos,
+                       const char*& data,
+                       const char*& end) const;
+
+    void Prefetch(FileOffset pos,
+                  FileOffset length);
+
     bool Read(char* buffer, size_t bytes);
 
     bool Read(std::string& value);
@@ -137,7 +145,12 @@ namespace osmscout {
     bool ReadNumber(uint64_t& number);
 #endif
 
+    bool ReadNumbers(uint32_t* numbers,
+                     size_t count);
+
     bool ReadCoord(GeoCoord& coord);
+    bool ReadDeltaCoords(size_t count,
+                         std::vector<GeoCoord>& coords);
   };
 }
 
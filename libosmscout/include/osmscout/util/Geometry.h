@@ -580,6 +580,9 @@ namespace osmscout {
 
   extern OSMSCOUT_API double NormalizeRelativeAngel(double angle);
 
+  extern OSMSCOUT_API void GetConvexHull(const std::vector<GeoCoord>& points,
+                                         std::vector<GeoCoord>& hull);
+
   struct OSMSCOUT_API ScanCell
   {
     int x;
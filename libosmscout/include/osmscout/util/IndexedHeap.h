@@ -0,0 +1,287 @@
+#ifndef OSMSCOUT_UTIL_INDEXEDHEAP_H
+#define OSMSCOUT_UTIL_INDEXEDHEAP_H
+
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2014  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <algorithm>
+#include <vector>
+
+#include <osmscout/system/Assert.h>
+#include <osmscout/system/Types.h>
+
+namespace osmscout {
+
+  /**
+    A d-ary min heap of elements with a key, supporting decrease-key.
+
+    Elements are dense 32 bit indices (for example into an array holding the actual
+    objects). For each element its current position in the heap is stored, so that
+    Contains() is O(1) and DecreaseKey()/UpdateKey() are O(log n) without searching
+    the heap.
+
+    The heap keeps its memory on Clear(), so it can be reused for a number of
+    calculations without allocating again. Clear() is O(n) in the number of elements
+    currently in the heap, not in the number of elements ever pushed.
+
+    K must be copyable and implement operator<. A higher arity D makes the heap
+    flatter (cheaper push and decrease-key) at the cost of more comparisons on pop,
+    4 is a good default for path finding.
+    */
+  template <class K, size_t D = 4>
+  class IndexedHeap
+  {
+  public:
+    static const uint32_t notInHeap = 0xffffffff;
+
+  private:
+    struct Entry
+    {
+      K        key;     //! The key
+      uint32_t element; //! The element
+    };
+
+  private:
+    std::vector<Entry>    entries;   //! The heap itself
+    std::vector<uint32_t> positions; //! For each element its position in the heap or notInHeap
+
+  private:
+    inline void Place(size_t pos,
+                      const Entry& entry)
+    {
+      entries[pos]=entry;
+      positions[entry.element]=(uint32_t)pos;
+    }
+
+    void SiftUp(size_t pos)
+    {
+      Entry entry=entries[pos];
+
+      while (pos>0) {
+        size_t parent=(pos-1)/D;
+
+        if (!(entry.key<entries[parent].key)) {
+          break;
+        }
+
+        Place(pos,entries[parent]);
+        pos=parent;
+      }
+
+      Place(pos,entry);
+    }
+
+    void SiftDown(size_t pos)
+    {
+      Entry  entry=entries[pos];
+      size_t size=entries.size();
+
+      while (true) {
+        size_t first=pos*D+1;
+
+        if (first>=size) {
+          break;
+        }
+
+        size_t last=std::min(first+D,size);
+        size_t best=first;
+
+        for (size_t child=first+1; child<last; child++) {
+          if (entries[child].key<entries[best].key) {
+            best=child;
+          }
+        }
+
+        if (!(entries[best].key<entry.key)) {
+          break;
+        }
+
+        Place(pos,entries[best]);
+        pos=best;
+      }
+
+      Place(pos,entry);
+    }
+
+  public:
+    IndexedHeap()
+    {
+      // no code
+    }
+
+    /**
+      Reserve memory for the given number of elements
+      */
+    void Reserve(size_t size)
+    {
+      entries.reserve(size);
+      positions.reserve(size);
+    }
+
+    inline bool IsEmpty() const
+    {
+      return entries.empty();
+    }
+
+    inline size_t GetSize() const
+    {
+      return entries.size();
+    }
+
+    inline bool Contains(uint32_t element) const
+    {
+      return element<positions.size() &&
+             positions[element]!=notInHeap;
+    }
+
+    /**
+      Return the key of the given element, which must be in the heap
+      */
+    inline const K& GetKey(uint32_t element) const
+    {
+      assert(Contains(element));
+
+      return entries[positions[element]].key;
+    }
+
+    /**
+      Add the given element, which must not be in the heap already
+      */
+    void Push(uint32_t element,
+              const K& key)
+    {
+      if (element>=positions.size()) {
+        positions.resize(element+1,notInHeap);
+      }
+
+      assert(positions[element]==notInHeap);
+
+      Entry entry;
+
+      entry.key=key;
+      entry.element=element;
+
+      entries.push_back(entry);
+      positions[element]=(uint32_t)(entries.size()-1);
+
+      SiftUp(entries.size()-1);
+    }
+
+    /**
+      Change the key of the given element in the heap to a key that is
+      not bigger than the current key
+      */
+    void DecreaseKey(uint32_t element,
+                     const K& key)
+    {
+      assert(Contains(element));
+      assert(!(entries[positions[element]].key<key));
+
+      size_t pos=positions[element];
+
+      entries[pos].key=key;
+
+      SiftUp(pos);
+    }
+
+    /**
+      Change the key of the given element in the heap to an arbitrary new key
+      */
+    void UpdateKey(uint32_t element,
+                   const K& key)
+    {
+      assert(Contains(element));
+
+      size_t pos=positions[element];
+      bool   decrease=key<entries[pos].key;
+
+      entries[pos].key=key;
+
+      if (decrease) {
+        SiftUp(pos);
+      }
+      else {
+        SiftDown(pos);
+      }
+    }
+
+    /**
+      Return the element with the smallest key
+      */
+    inline uint32_t GetTop() const
+    {
+      assert(!entries.empty());
+
+      return entries.front().element;
+    }
+
+    /**
+      Return the smallest key
+      */
+    inline const K& GetTopKey() const
+    {
+      assert(!entries.empty());
+
+      return entries.front().key;
+    }
+
+    /**
+      Remove the element with the smallest key from the heap and return it
+      */
+    uint32_t Pop()
+    {
+      assert(!entries.empty());
+
+      uint32_t element=entries.front().element;
+
+      positions[element]=notInHeap;
+
+      if (entries.size()>1) {
+        entries.front()=entries.back();
+        entries.pop_back();
+
+        SiftDown(0);
+      }
+      else {
+        entries.pop_back();
+      }
+
+      return element;
+    }
+
+    /**
+      Remove all elements, keeping the allocated memory
+      */
+    void Clear()
+    {
+      for (typename std::vector<Entry>::const_iterator entry=entries.begin();
+           entry!=entries.end();
+           ++entry) {
+        positions[entry->element]=notInHeap;
+      }
+
+      entries.clear();
+    }
+  };
+
+  template <class K, size_t D>
+  const uint32_t IndexedHeap<K,D>::notInHeap;
+}
+
+#endif
@@ -22,6 +22,8 @@
 
 #include <osmscout/private/CoreImportExport.h>
 
+#include <osmscout/system/Types.h>
+
 #include <limits>
 
 #include <stddef.h>
@@ -260,6 +262,23 @@ namespace osmscout {
     return DecodeNumberTemplated<std::numeric_limits<N>::is_signed, N>
       ::f(buffer,number);
   }
+
+  /**
+   * Decode count variable length encoded unsigned numbers from the buffer
+   * into the given array. In contrast to DecodeNumber() the end of the
+   * buffer is checked.
+   *
+   * If SSE2 is available, 16 bytes are classified at once and all numbers
+   * ending within this block are decoded without testing each byte
+   * separately.
+   *
+   * The method returns the position behind the last number decoded or
+   * NULL, if the buffer ended before count numbers were decoded.
+   */
+  extern OSMSCOUT_API const char* DecodeNumbers(const char* buffer,
+                                                const char* end,
+                                                uint32_t* numbers,
+                                                size_t count);
 }
 
 #endif
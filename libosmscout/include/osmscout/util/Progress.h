@@ -25,6 +25,8 @@
 
 #include <osmscout/private/CoreImportExport.h>
 
+#include <osmscout/util/Mutex.h>
+
 namespace osmscout {
 
   class OSMSCOUT_API Progress
@@ -70,6 +72,30 @@ namespace osmscout {
     void Warning(const std::string& text);
     void Error(const std::string& text);
   };
+
+  /**
+    Forwards all calls to the given Progress instance, serialized by a mutex.
+    Allows a number of threads to report their progress to the same instance
+    without interleaving (partial) output.
+    */
+  class OSMSCOUT_API ThreadSafeProgress : public Progress
+  {
+  private:
+    Progress& progress;
+    Mutex     mutex;
+
+  public:
+    ThreadSafeProgress(Progress& progress);
+
+    void SetStep(const std::string& step);
+    void SetAction(const std::string& action);
+    void SetProgress(double current, double total);
+
+    void Debug(const std::string& text);
+    void Info(const std::string& text);
+    void Warning(const std::string& text);
+    void Error(const std::string& text);
+  };
 }
 
 #endif
@@ -22,6 +22,9 @@
 
 #include <osmscout/private/CoreImportExport.h>
 
+#include <osmscout/GeoCoord.h>
+#include <osmscout/Pixel.h>
+
 #include <osmscout/system/SSEMathPublic.h>
 
 #include <osmscout/util/Magnification.h>
@@ -171,6 +174,15 @@ namespace osmscout {
     virtual bool GeoToPixel(double lon, double lat,
                             double& x, double& y) const = 0;
 
+    /**
+     * Converts count geo coordinates to pixel coordinates. The default
+     * implementation calls GeoToPixel() for each coordinate, projections
+     * should overwrite it with a faster bulk implementation.
+     */
+    virtual bool GeoToPixel(const GeoCoord* coords,
+                            size_t count,
+                            Vertex2D* pixels) const;
+
     /**
      * Returns the bounding box of the area covered
      */
@@ -207,6 +219,12 @@ namespace osmscout {
     double              scale;
     double              scaleGradtorad; //!Precalculated scale*Gradtorad
 
+    bool                linearLat;       //! Latitudes between linearLatMin and linearLatMax can be projected linear
+    double              linearLatMin;    //! Minimum latitude for the linear approximation
+    double              linearLatMax;    //! Maximum latitude for the linear approximation
+    double              linearLatScale;  //! Scale of the linear approximation (pixel per degree)
+    double              linearLatOffset; //! Offset of the linear approximation
+
 #ifdef OSMSCOUT_HAVE_SSE2
       //some extra vars for special sse needs
       v2df              sse2LonOffset;
@@ -221,6 +239,16 @@ namespace osmscout {
 
     double              pixelSize;     //! Size of a pixel in meter
 
+  private:
+    void SetupLinearLat();
+
+  protected:
+    bool GeoToPixel(const GeoCoord* coords,
+                    size_t count,
+                    Vertex2D* pixels,
+                    double yBase,
+                    double yFactor) const;
+
   public:
     MercatorProjection();
 
@@ -288,6 +316,10 @@ namespace osmscout {
     bool GeoToPixel(double lon, double lat,
                     double& x, double& y) const;
 
+    bool GeoToPixel(const GeoCoord* coords,
+                    size_t count,
+                    Vertex2D* pixels) const;
+
     bool GetDimensions(double& lonMin, double& latMin,
                        double& lonMax, double& latMax) const;
 
@@ -303,6 +335,7 @@ namespace osmscout {
   private:
     bool PixelToGeo(double x, double y, double& lon, double& lat) const;
     bool GeoToPixel(double lon, double lat, double& x, double& y) const;
+    bool GeoToPixel(const GeoCoord* coords, size_t count, Vertex2D* pixels) const;
   protected:
     bool GeoToPixel(const BatchTransformer& transformData) const;
   };
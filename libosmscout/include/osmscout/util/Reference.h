@@ -20,6 +20,12 @@
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
 */
 
+#include <osmscout/CoreFeatures.h>
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+#include <atomic>
+#endif
+
 #include <osmscout/system/Assert.h>
 #include <osmscout/system/Types.h>
 
@@ -29,6 +35,10 @@ namespace osmscout {
 
   /**
     Baseclass for all classes that support reference counting.
+
+    If thread support is available the reference counter is atomic, so
+    references to the same object can be copied and released by multiple
+    threads in parallel (for example if the object is shared via a cache).
   */
   class OSMSCOUT_API Referencable
   {
@@ -39,6 +49,25 @@ namespace osmscout {
       // no code
     }
 
+    /**
+      Copying an object does not copy its references, the copy
+      starts unreferenced.
+    */
+    Referencable(const Referencable& /*other*/)
+      : count(0)
+    {
+      // no code
+    }
+
+    /**
+      Assigning an object does not change the references to the
+      assigned object.
+    */
+    Referencable& operator=(const Referencable& /*other*/)
+    {
+      return *this;
+    }
+
     /**
       Add a reference to this object.
 
@@ -56,9 +85,7 @@ namespace osmscout {
     */
     inline unsigned long RemoveReference()
     {
-      count--;
-
-      return count;
+      return --count;
     }
 
     /**
@@ -70,7 +97,11 @@ namespace osmscout {
     }
 
   private:
-    unsigned long count;
+#if defined(OSMSCOUT_HAVE_THREAD)
+    std::atomic<unsigned long> count;
+#else
+    unsigned long              count;
+#endif
   };
 
   /**
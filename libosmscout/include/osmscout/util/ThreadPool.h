@@ -0,0 +1,106 @@
+#ifndef OSMSCOUT_UTIL_THREADPOOL_H
+#define OSMSCOUT_UTIL_THREADPOOL_H
+
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2014  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <stddef.h>
+
+#include <osmscout/CoreFeatures.h>
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#endif
+
+#include <osmscout/private/CoreImportExport.h>
+
+namespace osmscout {
+
+  /**
+    A job for the ThreadPool. The job consists of a number of independent
+    tasks, identified by their index.
+    */
+  class OSMSCOUT_API ParallelJob
+  {
+  public:
+    virtual ~ParallelJob();
+
+    /**
+      Execute the task with the given index. The worker is the index of the
+      executing worker (in the range [0,ThreadPool::GetWorkerCount()[), so
+      the job can hold state per worker. A worker executes only one task
+      at a time.
+      */
+    virtual void Execute(size_t task,
+                         size_t worker) = 0;
+  };
+
+  /**
+    A fixed number of workers executing the tasks of a ParallelJob. The
+    thread calling Execute() is worker 0, the other workers are threads
+    started once and reused for all jobs.
+
+    If thread support is not available, there is exactly one worker and
+    all tasks are executed by the calling thread.
+    */
+  class OSMSCOUT_API ThreadPool
+  {
+  private:
+    size_t                   workerCount;
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+    std::vector<std::thread> threads;
+    std::mutex               mutex;
+    std::condition_variable  wakeCondition;  //! Signaled on a new job or on shutdown
+    std::condition_variable  doneCondition;  //! Signaled if the last running worker finished
+    ParallelJob              *job;           //! The current job or NULL
+    size_t                   taskCount;      //! Number of tasks of the current job
+    size_t                   nextTask;       //! The next task to be executed
+    size_t                   runningWorkers; //! Number of threads working on the current job
+    size_t                   generation;     //! Incremented for each job
+    bool                     stop;           //! Threads should terminate
+#endif
+
+  private:
+    ThreadPool(const ThreadPool& other);
+    void operator=(const ThreadPool& other);
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+    void ExecuteTasks(size_t worker);
+    void Work(size_t worker);
+#endif
+
+  public:
+    ThreadPool(size_t workerCount=0);
+    ~ThreadPool();
+
+    inline size_t GetWorkerCount() const
+    {
+      return workerCount;
+    }
+
+    void Execute(ParallelJob& job,
+                 size_t taskCount);
+  };
+}
+
+#endif
@@ -65,6 +65,9 @@ namespace osmscout {
   public:
     TransPoint* points;
 
+  private:
+    Vertex2D*   pixels; //! Buffer for the bulk transformation of the coordinates
+
   private:
     void TransformGeoToPixel(const Projection& projection,
                              const std::vector<GeoCoord>& nodes);
@@ -121,6 +124,9 @@ namespace osmscout {
     virtual void Reset() = 0;
     virtual size_t PushCoord(double x, double y) = 0;
     virtual size_t GetLength() const = 0;
+    virtual void GetCoord(size_t index,
+                          double& x,
+                          double& y) const = 0;
     virtual bool GenerateParallelWay(size_t orgStart,
                                      size_t orgEnd,
                                      double offset,
@@ -148,6 +154,9 @@ namespace osmscout {
     void Reset();
     size_t PushCoord(double x, double y);
     size_t GetLength() const;
+    void GetCoord(size_t index,
+                  double& x,
+                  double& y) const;
 
     bool GenerateParallelWay(size_t orgStart,
                              size_t orgEnd,
@@ -219,6 +228,15 @@ namespace osmscout {
     return usedPoints;
   }
 
+  template<class P>
+  void CoordBufferImpl<P>::GetCoord(size_t index,
+                                    double& x,
+                                    double& y) const
+  {
+    x=buffer[index].GetX();
+    y=buffer[index].GetY();
+  }
+
   template<class P>
   bool CoordBufferImpl<P>::GenerateParallelWay(size_t orgStart,
                                                size_t orgEnd,
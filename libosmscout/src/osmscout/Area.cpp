@@ -131,6 +131,23 @@ namespace osmscout {
     }
   }
 
+  /**
+    Returns the (approximated) memory used by the attributes including
+    all allocated data.
+    */
+  size_t AreaAttributes::GetMemorySize() const
+  {
+    size_t memory=sizeof(AreaAttributes);
+
+    memory+=name.length();
+    memory+=nameAlt.length();
+    memory+=location.length();
+    memory+=address.length();
+    memory+=GetTagsMemorySize(tags);
+
+    return memory;
+  }
+
   bool AreaAttributes::Read(FileScanner& scanner)
   {
     uint8_t flags;
@@ -405,26 +422,28 @@ namespace osmscout {
                         uint32_t nodesCount,
                         std::vector<GeoCoord>& coords)
   {
-    uint32_t minLat;
-    uint32_t minLon;
-
-    coords.resize(nodesCount);
-
-    scanner.Read(minLat);
-    scanner.Read(minLon);
+    return scanner.ReadDeltaCoords(nodesCount,coords);
+  }
 
-    for (size_t j=0; j<nodesCount; j++) {
-      uint32_t latValue;
-      uint32_t lonValue;
+  /**
+    Returns the (approximated) memory used by the area including
+    all allocated data.
+    */
+  size_t Area::GetMemorySize() const
+  {
+    size_t memory=sizeof(Area);
 
-      scanner.ReadNumber(latValue);
-      scanner.ReadNumber(lonValue);
+    memory+=(rings.capacity()-rings.size())*sizeof(Ring);
 
-      coords[j].Set((minLat+latValue)/conversionFactor-90.0,
-                     (minLon+lonValue)/conversionFactor-180.0);
+    for (std::vector<Ring>::const_iterator ring=rings.begin();
+         ring!=rings.end();
+         ++ring) {
+      memory+=sizeof(Ring)-sizeof(AreaAttributes)+ring->attributes.GetMemorySize();
+      memory+=ring->ids.capacity()*sizeof(Id);
+      memory+=ring->nodes.capacity()*sizeof(GeoCoord);
     }
 
-    return !scanner.HasError();
+    return memory;
   }
 
   bool Area::Read(FileScanner& scanner)
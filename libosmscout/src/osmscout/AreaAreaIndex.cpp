@@ -19,26 +19,59 @@
 
 #include <osmscout/AreaAreaIndex.h>
 
+#include <algorithm>
 #include <iostream>
 
 #include <osmscout/system/Math.h>
 
+#include <osmscout/util/File.h>
+
 namespace osmscout {
 
-  AreaAreaIndex::AreaAreaIndex(size_t cacheSize)
+  /**
+    Sort entries by type, keeping the file order for entries of the same type
+    */
+  bool AreaAreaIndex::IndexEntryTypeLess(const IndexEntry& a,
+                                         const IndexEntry& b)
+  {
+    if (a.type!=b.type) {
+      return a.type<b.type;
+    }
+
+    return a.offset<b.offset;
+  }
+
+  AreaAreaIndex::AreaAreaIndex(size_t cacheSize,
+                               bool inMemory)
   : filepart("areaarea.idx"),
     maxLevel(0),
     topLevelOffset(0),
-    indexCache(cacheSize)
+    indexCache(cacheSize),
+    governedCache(filepart,indexCache,&accessMutex),
+    inMemory(inMemory),
+    typeWordCount(0)
   {
     // no code
   }
 
+  AreaAreaIndex::~AreaAreaIndex()
+  {
+    if (governor.Valid()) {
+      governor->Unregister(&governedCache);
+    }
+  }
+
   void AreaAreaIndex::Close()
   {
+    ScopedLock lock(accessMutex);
+
     if (scanner.IsOpen()) {
       scanner.Close();
     }
+
+    memoryCells.clear();
+    memoryEntries.clear();
+    subtreeTypes.clear();
   }
 
   bool AreaAreaIndex::GetIndexCell(uint32_t level,
@@ -46,10 +79,10 @@ namespace osmscout {
                                    IndexCache::CacheRef& cacheRef) const
   {
     if (!indexCache.GetEntry(offset,cacheRef)) {
+      // The cell is completely read before adding it to the cache, so that
+      // the cache knows its final size
       IndexCache::CacheEntry cacheEntry(offset);
 
-      cacheRef=indexCache.SetEntry(cacheEntry);
-
       if (!scanner.IsOpen()) {
         if (!scanner.Open(datafilename,FileScanner::LowMemRandom,true)) {
           std::cerr << "Error while opening " << datafilename << " for reading!" << std::endl;
@@ -63,7 +96,7 @@ namespace osmscout {
 
       if (level<maxLevel) {
         for (size_t c=0; c<4; c++) {
-          if (!scanner.ReadNumber(cacheRef->value.children[c])) {
+          if (!scanner.ReadNumber(cacheEntry.value.children[c])) {
             std::cerr << "Cannot read index data at offset " << offset << std::endl;
             return false;
           }
@@ -71,7 +104,7 @@ namespace osmscout {
       }
       else {
         for (size_t c=0; c<4; c++) {
-          cacheRef->value.children[c]=0;
+          cacheEntry.value.children[c]=0;
         }
       }
 
@@ -86,24 +119,26 @@ namespace osmscout {
         return false;
       }
 
-      cacheRef->value.areas.resize(offsetCount);
+      cacheEntry.value.areas.resize(offsetCount);
 
       FileOffset prevOffset=0;
 
       for (size_t c=0; c<offsetCount; c++) {
-        if (!scanner.ReadNumber(cacheRef->value.areas[c].type)) {
+        if (!scanner.ReadNumber(cacheEntry.value.areas[c].type)) {
           std::cerr << "Cannot read index data for level " << level << " at offset " << offset << std::endl;
           return false;
         }
-        if (!scanner.ReadNumber(cacheRef->value.areas[c].offset)) {
+        if (!scanner.ReadNumber(cacheEntry.value.areas[c].offset)) {
           std::cerr << "Cannot read index data for level " << level << " at offset " << offset << std::endl;
           return false;
         }
 
-        cacheRef->value.areas[c].offset+=prevOffset;
+        cacheEntry.value.areas[c].offset+=prevOffset;
 
-        prevOffset=cacheRef->value.areas[c].offset;
+        prevOffset=cacheEntry.value.areas[c].offset;
       }
+
+      cacheRef=indexCache.SetEntry(cacheEntry);
     }
 
     return true;
@@ -140,9 +175,277 @@ namespace osmscout {
       cellHeight[i]=180.0/pow(2.0,(int)i);
     }
 
+    if (inMemory &&
+        !LoadMemoryIndex()) {
+      std::cerr << "Cannot load index '" << datafilename << "' into memory" << std::endl;
+      scanner.Close();
+      return false;
+    }
+
     return !scanner.HasError() && scanner.Close();
   }
 
+  /**
+    Read all cells of the index level by level into memoryCells and
+    memoryEntries and calculate the type bitmap of each subtree.
+    */
+  bool AreaAreaIndex::LoadMemoryIndex()
+  {
+    std::vector<std::pair<FileOffset,uint32_t> > cells;     // File offset and index of the cells of the current level
+    std::vector<std::pair<FileOffset,uint32_t> > nextCells; // File offset and index of the cells of the next level
+    FileOffset                                   fileSize;
+    TypeId                                       maxType=0;
+
+    memoryCells.clear();
+    memoryEntries.clear();
+    subtreeTypes.clear();
+
+    if (!GetFileSize(datafilename,fileSize)) {
+      return false;
+    }
+
+    // The index has no cells at all
+    if (topLevelOffset>=fileSize) {
+      typeWordCount=1;
+
+      return true;
+    }
+
+    memoryCells.resize(1);
+    cells.push_back(std::make_pair(topLevelOffset,0));
+
+    for (uint32_t level=0;
+         level<=maxLevel && !cells.empty();
+         level++) {
+      nextCells.clear();
+
+      for (size_t i=0; i<cells.size(); i++) {
+        MemoryCell& cell=memoryCells[cells[i].second];
+        FileOffset  children[4];
+        uint32_t    entryCount;
+
+        if (!scanner.SetPos(cells[i].first)) {
+          std::cerr << "Cannot go to index data at offset " << cells[i].first << std::endl;
+          return false;
+        }
+
+        if (level<maxLevel) {
+          for (size_t c=0; c<4; c++) {
+            if (!scanner.ReadNumber(children[c])) {
+              std::cerr << "Cannot read index data at offset " << cells[i].first << std::endl;
+              return false;
+            }
+          }
+        }
+        else {
+          for (size_t c=0; c<4; c++) {
+            children[c]=0;
+          }
+        }
+
+        if (!scanner.ReadNumber(entryCount)) {
+          std::cerr << "Cannot read index data for level " << level << " at offset " << cells[i].first << std::endl;
+          return false;
+        }
+
+        cell.firstEntry=(uint32_t)memoryEntries.size();
+        cell.entryCount=entryCount;
+
+        FileOffset prevOffset=0;
+
+        for (size_t e=0; e<entryCount; e++) {
+          IndexEntry entry;
+
+          if (!scanner.ReadNumber(entry.type) ||
+              !scanner.ReadNumber(entry.offset)) {
+            std::cerr << "Cannot read index data for level " << level << " at offset " << cells[i].first << std::endl;
+            return false;
+          }
+
+          entry.offset+=prevOffset;
+          prevOffset=entry.offset;
+
+          maxType=std::max(maxType,entry.type);
+
+          memoryEntries.push_back(entry);
+        }
+
+        std::sort(memoryEntries.begin()+cell.firstEntry,
+                  memoryEntries.end(),
+                  IndexEntryTypeLess);
+
+        // Children are appended in the order of the current level, so each
+        // level is stored as one consecutive run of cells
+        for (size_t c=0; c<4; c++) {
+          if (children[c]!=0) {
+            uint32_t childIndex=(uint32_t)(memoryCells.size()+nextCells.size());
+
+            memoryCells[cells[i].second].children[c]=childIndex;
+            nextCells.push_back(std::make_pair(children[c],childIndex));
+          }
+          else {
+            memoryCells[cells[i].second].children[c]=0;
+          }
+        }
+      }
+
+      memoryCells.resize(memoryCells.size()+nextCells.size());
+
+      std::swap(cells,nextCells);
+    }
+
+    // Children always have a higher index than their parent, so going
+    // backwards the bitmaps of all children are complete when the parent
+    // is handled
+    typeWordCount=maxType/64+1;
+    subtreeTypes.resize(memoryCells.size()*typeWordCount,0);
+
+    for (size_t i=memoryCells.size(); i>0; i--) {
+      const MemoryCell& cell=memoryCells[i-1];
+      uint64_t*         cellTypes=&subtreeTypes[(i-1)*typeWordCount];
+
+      for (size_t e=cell.firstEntry; e<cell.firstEntry+cell.entryCount; e++) {
+        cellTypes[memoryEntries[e].type/64]|=((uint64_t)1) << (memoryEntries[e].type%64);
+      }
+
+      for (size_t c=0; c<4; c++) {
+        if (cell.children[c]!=0) {
+          const uint64_t* childTypes=&subtreeTypes[cell.children[c]*typeWordCount];
+
+          for (size_t w=0; w<typeWordCount; w++) {
+            cellTypes[w]|=childTypes[w];
+          }
+        }
+      }
+    }
+
+    return !scanner.HasError();
+  }
+
+  /**
+    Same as GetOffsets(), but working on the in memory index. Since subtrees
+    without any of the requested types are skipped, the maximum count only
+    takes the entries of the visited cells into account.
+    */
+  bool AreaAreaIndex::GetOffsetsInMemory(double minlon,
+                                         double minlat,
+                                         double maxlon,
+                                         double maxlat,
+                                         size_t maxLevel,
+                                         const TypeSet& types,
+                                         size_t maxCount,
+                                         std::vector<FileOffset>& offsets) const
+  {
+    std::vector<MemoryCellRef> cellRefs;     // cells to scan in this level
+    std::vector<MemoryCellRef> nextCellRefs; // cells to scan for the next level
+    std::vector<FileOffset>    newOffsets;   // offsets collected in the current level
+    std::vector<uint64_t>      queryTypes(typeWordCount,0);
+
+    offsets.clear();
+
+    if (memoryCells.empty()) {
+      return true;
+    }
+
+    for (TypeId type=0; type<typeWordCount*64; type++) {
+      if (types.IsTypeSet(type)) {
+        queryTypes[type/64]|=((uint64_t)1) << (type%64);
+      }
+    }
+
+    if (!HasSubtreeTypes(0,queryTypes)) {
+      return true;
+    }
+
+    minlon+=180;
+    maxlon+=180;
+    minlat+=90;
+    maxlat+=90;
+
+    offsets.reserve(std::min(100000u,(uint32_t)maxCount));
+    newOffsets.reserve(std::min(100000u,(uint32_t)maxCount));
+
+    cellRefs.push_back(MemoryCellRef(0,0,0));
+
+    bool stopArea=false;
+    for (uint32_t level=0;
+         !stopArea &&
+         level<=this->maxLevel &&
+         level<=maxLevel &&
+         !cellRefs.empty();
+         level++) {
+      nextCellRefs.clear();
+
+      newOffsets.clear();
+
+      for (size_t i=0; !stopArea && i<cellRefs.size(); i++) {
+        const MemoryCell& cell=memoryCells[cellRefs[i].index];
+
+        if (offsets.size()+
+            newOffsets.size()+
+            cell.entryCount>=maxCount) {
+          stopArea=true;
+          continue;
+        }
+
+        // Entries are sorted by type, so the type set is checked once per type
+        size_t entry=cell.firstEntry;
+        size_t entryEnd=cell.firstEntry+cell.entryCount;
+
+        while (entry<entryEnd) {
+          TypeId type=memoryEntries[entry].type;
+
+          if (types.IsTypeSet(type)) {
+            while (entry<entryEnd &&
+                   memoryEntries[entry].type==type) {
+              newOffsets.push_back(memoryEntries[entry].offset);
+              entry++;
+            }
+          }
+          else {
+            while (entry<entryEnd &&
+                   memoryEntries[entry].type==type) {
+              entry++;
+            }
+          }
+        }
+
+        // top left, top right, bottom left, bottom right
+        size_t childX[4]={0,1,0,1};
+        size_t childY[4]={1,1,0,0};
+
+        for (size_t c=0; c<4; c++) {
+          uint32_t child=cell.children[c];
+
+          if (child==0 ||
+              !HasSubtreeTypes(child,queryTypes)) {
+            continue;
+          }
+
+          size_t cx=cellRefs[i].x*2+childX[c];
+          size_t cy=cellRefs[i].y*2+childY[c];
+          double x=cx*cellWidth[level+1];
+          double y=cy*cellHeight[level+1];
+
+          if (!(x>maxlon+cellWidth[level+1]/2 ||
+                y>maxlat+cellHeight[level+1]/2 ||
+                x+cellWidth[level+1]<minlon-cellWidth[level+1]/2 ||
+                y+cellHeight[level+1]<minlat-cellHeight[level+1]/2)) {
+            nextCellRefs.push_back(MemoryCellRef(child,cx,cy));
+          }
+        }
+      }
+
+      if (!stopArea) {
+        offsets.insert(offsets.end(),newOffsets.begin(),newOffsets.end());
+      }
+
+      std::swap(cellRefs,nextCellRefs);
+    }
+
+    return true;
+  }
+
   bool AreaAreaIndex::GetOffsets(double minlon,
                                  double minlat,
                                  double maxlon,
@@ -152,6 +455,19 @@ namespace osmscout {
                                  size_t maxCount,
                                  std::vector<FileOffset>& offsets) const
   {
+    if (inMemory) {
+      return GetOffsetsInMemory(minlon,
+                                minlat,
+                                maxlon,
+                                maxlat,
+                                maxLevel,
+                                types,
+                                maxCount,
+                                offsets);
+    }
+
+    ScopedLock lock(accessMutex);
+
     std::vector<CellRef>    cellRefs;     // cells to scan in this level
     std::vector<CellRef>    nextCellRefs; // cells to scan for the next level
     std::vector<FileOffset> newOffsets;   // offsets collected in the current level
@@ -286,8 +602,123 @@ namespace osmscout {
     return true;
   }
 
+  /**
+    Append the file offsets of all index cells currently held in the
+    cache to the given vector.
+    */
+  void AreaAreaIndex::GetCachedOffsets(std::vector<FileOffset>& offsets) const
+  {
+    ScopedLock lock(accessMutex);
+
+    indexCache.GetKeys(offsets);
+  }
+
+  /**
+    Load the index cells at the given (sorted) file offsets into the cache,
+    for example the offsets returned by GetCachedOffsets() before the last
+    shutdown. Since the level of a cell is required for reading it, the
+    index is walked from the top and only cells in the given list (and
+    their children in the list) are loaded. Each level is read in file
+    order.
+
+    The index is only locked while reading a single cell, so that
+    concurrent lookups are not blocked for the whole time. Loading can be
+    aborted using the given breaker, false is returned in this case.
+    */
+  bool AreaAreaIndex::LoadCells(const std::vector<FileOffset>& offsets,
+                                const BreakerRef& breaker) const
+  {
+    if (inMemory) {
+      return true;
+    }
+
+    std::vector<FileOffset> cells;
+    std::vector<FileOffset> nextCells;
+
+    cells.push_back(topLevelOffset);
+
+    for (uint32_t level=0;
+         level<=maxLevel && !cells.empty();
+         level++) {
+      nextCells.clear();
+
+      std::sort(cells.begin(),cells.end());
+
+      for (size_t i=0; i<cells.size(); i++) {
+        if (!std::binary_search(offsets.begin(),offsets.end(),cells[i])) {
+          continue;
+        }
+
+        if (breaker.Valid() &&
+            breaker->IsAborted()) {
+          return false;
+        }
+
+        ScopedLock           lock(accessMutex);
+        IndexCache::CacheRef cell;
+
+        if (!GetIndexCell(level,cells[i],cell)) {
+          std::cerr << "Cannot load index cell at offset " << cells[i] << " in level " << level << std::endl;
+          return false;
+        }
+
+        for (size_t c=0; c<4; c++) {
+          if (cell->value.children[c]!=0) {
+            nextCells.push_back(cell->value.children[c]);
+          }
+        }
+      }
+
+      std::swap(cells,nextCells);
+    }
+
+    return true;
+  }
+
+  /**
+    Let the given governor assign the memory limit of the index cache. The
+    configured number of entries is no longer used in this case. Passing an
+    invalid reference unregisters the cache from the current governor.
+    If the index is held in memory, the cache is not used and thus not
+    registered.
+    */
+  void AreaAreaIndex::SetCacheMemoryGovernor(const CacheMemoryGovernorRef& governor)
+  {
+    if (inMemory) {
+      return;
+    }
+
+    if (this->governor.Valid()) {
+      this->governor->Unregister(&governedCache);
+    }
+
+    this->governor=governor;
+
+    if (governor.Valid()) {
+      {
+        ScopedLock lock(accessMutex);
+
+        indexCache.SetValueSizer(&cacheSizer);
+        indexCache.SetMaxSize(std::numeric_limits<unsigned long>::max());
+      }
+
+      governor->Register(&governedCache);
+    }
+  }
+
   void AreaAreaIndex::DumpStatistics()
   {
+    if (inMemory) {
+      size_t memory=memoryCells.size()*sizeof(MemoryCell)+
+                    memoryEntries.size()*sizeof(IndexEntry)+
+                    subtreeTypes.size()*sizeof(uint64_t);
+
+      std::cout << filepart << " cells: " << memoryCells.size() << ", entries: " << memoryEntries.size();
+      std::cout << ", memory " << memory << std::endl;
+
+      return;
+    }
+
     indexCache.DumpStatistics(filepart.c_str(),IndexCacheValueSizer());
   }
 }
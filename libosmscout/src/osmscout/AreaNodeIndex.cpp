@@ -52,6 +52,8 @@ namespace osmscout {
 
   void AreaNodeIndex::Close()
   {
+    ScopedLock lock(accessMutex);
+
     if (scanner.IsOpen()) {
       scanner.Close();
     }
@@ -235,6 +237,8 @@ namespace osmscout {
                                  size_t maxNodeCount,
                                  std::vector<FileOffset>& nodeOffsets) const
   {
+    ScopedLock lock(accessMutex);
+
     if (!scanner.IsOpen()) {
       if (!scanner.Open(datafilename,FileScanner::LowMemRandom,true)) {
         std::cerr << "Error while opening " << datafilename << " for reading!" << std::endl;
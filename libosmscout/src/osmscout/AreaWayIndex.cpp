@@ -52,6 +52,8 @@ namespace osmscout {
 
   void AreaWayIndex::Close()
   {
+    ScopedLock lock(accessMutex);
+
     if (scanner.IsOpen()) {
       scanner.Close();
     }
@@ -238,6 +240,8 @@ namespace osmscout {
                                 size_t maxWayCount,
                                 std::vector<FileOffset>& offsets) const
   {
+    ScopedLock lock(accessMutex);
+
     if (!scanner.IsOpen()) {
       if (!scanner.Open(datafilename,FileScanner::LowMemRandom,true)) {
         std::cerr << "Error while opening " << datafilename << " for reading!" << std::endl;
@@ -0,0 +1,419 @@
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2014  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <osmscout/ContractionHierarchy.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include <osmscout/util/FileScanner.h>
+#include <osmscout/util/FileWriter.h>
+
+#include <osmscout/system/Assert.h>
+
+namespace osmscout {
+
+  const uint32_t ContractionHierarchy::noNode;
+
+  ContractionHierarchy::ContractionHierarchy()
+  : profileHash(0)
+  {
+    firstEdges.push_back(0);
+  }
+
+  ContractionHierarchy::~ContractionHierarchy()
+  {
+    // no code
+  }
+
+  void ContractionHierarchy::Clear()
+  {
+    profileHash=0;
+    offsets.clear();
+    firstEdges.clear();
+    edges.clear();
+    coreIndexes.clear();
+    coreNodes.clear();
+
+    firstEdges.push_back(0);
+  }
+
+  void ContractionHierarchy::SetProfileHash(uint64_t profileHash)
+  {
+    this->profileHash=profileHash;
+  }
+
+  /**
+   * Add the next node. Nodes must be added in the order of their file offset.
+   */
+  uint32_t ContractionHierarchy::AddNode(FileOffset offset,
+                                         const std::vector<Edge>& nodeEdges)
+  {
+    assert(offsets.empty() || offsets.back()<offset);
+
+    offsets.push_back(offset);
+    coreIndexes.push_back(noNode);
+
+    edges.insert(edges.end(),
+                 nodeEdges.begin(),
+                 nodeEdges.end());
+    firstEdges.push_back((uint32_t)edges.size());
+
+    return (uint32_t)(offsets.size()-1);
+  }
+
+  void ContractionHierarchy::SetCoreNode(uint32_t node,
+                                         const CoreNode& coreNode)
+  {
+    assert(node<offsets.size());
+
+    if (coreIndexes[node]==noNode) {
+      coreIndexes[node]=(uint32_t)coreNodes.size();
+      coreNodes.push_back(coreNode);
+    }
+    else {
+      coreNodes[coreIndexes[node]]=coreNode;
+    }
+  }
+
+  /**
+   * Return the node for the route node with the given file offset or
+   * noNode.
+   */
+  uint32_t ContractionHierarchy::GetNode(FileOffset offset) const
+  {
+    std::vector<FileOffset>::const_iterator entry=std::lower_bound(offsets.begin(),
+                                                                   offsets.end(),
+                                                                   offset);
+
+    if (entry==offsets.end() ||
+        *entry!=offset) {
+      return noNode;
+    }
+
+    return (uint32_t)(entry-offsets.begin());
+  }
+
+  /**
+   * Append the original route node paths replaced by the given edge,
+   * leading from the given source to the given target node, to the list
+   * of steps.
+   *
+   * The two edges replaced by a shortcut are stored at its (lower) middle
+   * node. They must start with the same path and arrive via the same object
+   * as the shortcut, since these are evaluated at the end points.
+   */
+  bool ContractionHierarchy::Unpack(uint32_t source,
+                                    uint32_t target,
+                                    const Edge& edge,
+                                    std::vector<Step>& steps) const
+  {
+    struct Pending
+    {
+      uint32_t source;
+      uint32_t target;
+      Edge     edge;
+    };
+
+    std::vector<Pending> stack;
+    Pending              pending;
+
+    pending.source=source;
+    pending.target=target;
+    pending.edge=edge;
+
+    stack.push_back(pending);
+
+    while (!stack.empty()) {
+      Pending current=stack.back();
+
+      stack.pop_back();
+
+      if (!current.edge.IsShortcut()) {
+        Step step;
+
+        step.node=current.source;
+        step.path=current.edge.sourcePath;
+
+        steps.push_back(step);
+        continue;
+      }
+
+      uint32_t    middle=current.edge.middle;
+      const Edge* in=NULL;
+      const Edge* out=NULL;
+
+      for (uint32_t e=firstEdges[middle]; e<firstEdges[middle+1]; e++) {
+        const Edge& candidate=edges[e];
+
+        if (candidate.node==current.source &&
+            candidate.IsBackward() &&
+            candidate.sourcePath==current.edge.sourcePath &&
+            (in==NULL || candidate.cost<in->cost)) {
+          in=&candidate;
+        }
+
+        if (candidate.node==current.target &&
+            candidate.IsForward() &&
+            candidate.targetObject==current.edge.targetObject &&
+            candidate.HasAccess()==current.edge.HasAccess() &&
+            (out==NULL || candidate.cost<out->cost)) {
+          out=&candidate;
+        }
+      }
+
+      if (in==NULL ||
+          out==NULL) {
+        std::cerr << "Cannot unpack shortcut from " << offsets[current.source] << " to " << offsets[current.target] << std::endl;
+        return false;
+      }
+
+      // Second half first, since the stack is processed in reverse order
+      pending.source=middle;
+      pending.target=current.target;
+      pending.edge=*out;
+
+      stack.push_back(pending);
+
+      pending.source=current.source;
+      pending.target=middle;
+      pending.edge=*in;
+
+      stack.push_back(pending);
+    }
+
+    return true;
+  }
+
+  /**
+   * Return true, if one can leave the given node using the given path after
+   * having arrived via the given object (with or without access rights).
+   * Unknown objects or paths are passed as noNode.
+   */
+  bool ContractionHierarchy::CanTurn(uint32_t node,
+                                     uint32_t sourceObject,
+                                     bool sourceAccess,
+                                     uint32_t targetPath) const
+  {
+    if (coreIndexes[node]==noNode ||
+        targetPath==noNode) {
+      return true;
+    }
+
+    const CoreNode& coreNode=coreNodes[coreIndexes[node]];
+
+    // Moving from non-accessible way back to accessible way
+    if (!sourceAccess &&
+        targetPath<coreNode.pathAccess.size() &&
+        coreNode.pathAccess[targetPath]) {
+      return false;
+    }
+
+    if (sourceObject==noNode) {
+      return true;
+    }
+
+    for (std::vector<Exclude>::const_iterator exclude=coreNode.excludes.begin();
+         exclude!=coreNode.excludes.end();
+         ++exclude) {
+      if (exclude->sourceObject==sourceObject &&
+          exclude->targetPath==targetPath) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  bool ContractionHierarchy::Read(const std::string& filename)
+  {
+    FileScanner scanner;
+    uint32_t    nodeCount;
+    uint32_t    edgeCount;
+    uint32_t    coreNodeCount;
+
+    Clear();
+
+    if (!scanner.Open(filename,FileScanner::Sequential,true)) {
+      std::cerr << "Cannot open file '" << filename << "'" << std::endl;
+      return false;
+    }
+
+    scanner.Read(profileHash);
+    scanner.Read(nodeCount);
+    scanner.Read(edgeCount);
+    scanner.Read(coreNodeCount);
+
+    if (scanner.HasError()) {
+      std::cerr << "Error while reading header of '" << filename << "'" << std::endl;
+      return false;
+    }
+
+    offsets.reserve(nodeCount);
+    firstEdges.reserve(nodeCount+1);
+    coreIndexes.resize(nodeCount,noNode);
+    edges.reserve(edgeCount);
+
+    for (uint32_t n=0; n<nodeCount; n++) {
+      FileOffset offset;
+      uint32_t   nodeEdgeCount;
+
+      scanner.ReadFileOffset(offset);
+      scanner.ReadNumber(nodeEdgeCount);
+
+      offsets.push_back(offset);
+
+      for (uint32_t e=0; e<nodeEdgeCount; e++) {
+        Edge     edge;
+        uint32_t middle;
+        uint64_t cost;
+
+        scanner.ReadNumber(edge.node);
+        scanner.ReadNumber(middle);
+        scanner.ReadNumber(edge.sourcePath);
+        scanner.ReadNumber(edge.targetObject);
+        scanner.Read(cost);
+        scanner.Read(edge.flags);
+
+        // middle is stored +1, so that noNode does not need 5 bytes
+        edge.middle=middle-1;
+        memcpy(&edge.cost,&cost,sizeof(edge.cost));
+
+        if (edge.node>=nodeCount ||
+            (edge.middle!=noNode && edge.middle>=nodeCount)) {
+          std::cerr << "Illegal edge of node " << n << " in '" << filename << "'" << std::endl;
+          Clear();
+          return false;
+        }
+
+        edges.push_back(edge);
+      }
+
+      firstEdges.push_back((uint32_t)edges.size());
+    }
+
+    coreNodes.resize(coreNodeCount);
+
+    for (uint32_t c=0; c<coreNodeCount; c++) {
+      uint32_t node;
+      uint32_t excludeCount;
+      uint32_t pathCount;
+
+      scanner.ReadNumber(node);
+      scanner.ReadNumber(excludeCount);
+
+      coreNodes[c].excludes.resize(excludeCount);
+
+      for (uint32_t e=0; e<excludeCount; e++) {
+        scanner.ReadNumber(coreNodes[c].excludes[e].sourceObject);
+        scanner.ReadNumber(coreNodes[c].excludes[e].targetPath);
+      }
+
+      scanner.ReadNumber(pathCount);
+
+      coreNodes[c].pathAccess.resize(pathCount);
+
+      for (uint32_t p=0; p<pathCount; p++) {
+        bool access;
+
+        scanner.Read(access);
+
+        coreNodes[c].pathAccess[p]=access;
+      }
+
+      if (node>=nodeCount) {
+        std::cerr << "Illegal core node index " << node << " in '" << filename << "'" << std::endl;
+        Clear();
+        return false;
+      }
+
+      coreIndexes[node]=c;
+    }
+
+    if (scanner.HasError() ||
+        edges.size()!=edgeCount) {
+      std::cerr << "Error while reading '" << filename << "'" << std::endl;
+      Clear();
+      return false;
+    }
+
+    return scanner.Close();
+  }
+
+  bool ContractionHierarchy::Write(const std::string& filename) const
+  {
+    FileWriter writer;
+
+    if (!writer.Open(filename)) {
+      std::cerr << "Cannot create file '" << filename << "'" << std::endl;
+      return false;
+    }
+
+    writer.Write(profileHash);
+    writer.Write((uint32_t)offsets.size());
+    writer.Write((uint32_t)edges.size());
+    writer.Write((uint32_t)coreNodes.size());
+
+    for (size_t n=0; n<offsets.size(); n++) {
+      writer.WriteFileOffset(offsets[n]);
+      writer.WriteNumber((uint32_t)(firstEdges[n+1]-firstEdges[n]));
+
+      for (uint32_t e=firstEdges[n]; e<firstEdges[n+1]; e++) {
+        const Edge& edge=edges[e];
+        uint64_t    cost;
+
+        memcpy(&cost,&edge.cost,sizeof(cost));
+
+        writer.WriteNumber(edge.node);
+        writer.WriteNumber((uint32_t)(edge.middle+1));
+        writer.WriteNumber(edge.sourcePath);
+        writer.WriteNumber(edge.targetObject);
+        writer.Write(cost);
+        writer.Write(edge.flags);
+      }
+    }
+
+    for (size_t n=0; n<offsets.size(); n++) {
+      if (coreIndexes[n]==noNode) {
+        continue;
+      }
+
+      const CoreNode& coreNode=coreNodes[coreIndexes[n]];
+
+      writer.WriteNumber((uint32_t)n);
+      writer.WriteNumber((uint32_t)coreNode.excludes.size());
+
+      for (std::vector<Exclude>::const_iterator exclude=coreNode.excludes.begin();
+           exclude!=coreNode.excludes.end();
+           ++exclude) {
+        writer.WriteNumber(exclude->sourceObject);
+        writer.WriteNumber(exclude->targetPath);
+      }
+
+      writer.WriteNumber((uint32_t)coreNode.pathAccess.size());
+
+      for (size_t p=0; p<coreNode.pathAccess.size(); p++) {
+        writer.Write((bool)coreNode.pathAccess[p]);
+      }
+    }
+
+    return !writer.HasError() && writer.Close();
+  }
+}
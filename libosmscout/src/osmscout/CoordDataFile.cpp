@@ -19,16 +19,26 @@
 
 #include "osmscout/CoordDataFile.h"
 
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
 #include <osmscout/system/Assert.h>
 
 #include <osmscout/util/File.h>
 
 namespace osmscout {
 
+  const size_t CoordDataFile::sparseBlockSize;
+
   CoordDataFile::CoordDataFile(const std::string& datafile)
   : isOpen(false),
     datafile(datafile),
-    coordPageSize(0)
+    layout(layoutSparse),
+    coordCount(0),
+    minId(0),
+    dataOffset(0),
+    currentBlock(std::numeric_limits<size_t>::max())
   {
     // no code
   }
@@ -46,56 +56,69 @@ namespace osmscout {
     datafilename=AppendFileToDir(path,datafile);
 
     isOpen=false;
-    coordPageOffsetMap.clear();
+    blockIds.clear();
+    currentBlock=std::numeric_limits<size_t>::max();
+
+    if (!scanner.Open(datafilename,
+                      FileScanner::FastRandom,
+                      memoryMapedData)) {
+      std::cerr << "Cannot open file '" << datafilename << "'" << std::endl;
+      return false;
+    }
 
-    if (scanner.Open(datafilename,
-                     FileScanner::FastRandom,
-                     memoryMapedData)) {
-      FileOffset mapOffset;
+    uint32_t layoutValue;
 
-      if (!scanner.Read(coordPageSize)) {
-        Close();
+    scanner.Read(layoutValue);
+    scanner.Read(coordCount);
+    scanner.Read(minId);
+    scanner.GetPos(dataOffset);
 
-        return false;
-      }
+    if (scanner.HasError()) {
+      std::cerr << "Error while reading header of file '" << datafilename << "'" << std::endl;
+      Close();
+      return false;
+    }
 
-      if (!scanner.Read(mapOffset)) {
-        Close();
+    if (layoutValue==layoutDense) {
+      layout=layoutDense;
+    }
+    else if (layoutValue==layoutSparse) {
+      layout=layoutSparse;
+    }
+    else {
+      std::cerr << "Unknown layout " << layoutValue << " of file '" << datafilename << "'" << std::endl;
+      Close();
+      return false;
+    }
 
-        return false;
-      }
+    if (layout==layoutSparse) {
+      // The id of the first record of each block is stored behind the records
+      size_t blockCount=(coordCount+sparseBlockSize-1)/sparseBlockSize;
 
-      if (!scanner.SetPos(mapOffset)) {
+      if (!scanner.SetPos(dataOffset+coordCount*(sizeof(OSMId)+2*sizeof(uint32_t)))) {
         Close();
-
         return false;
       }
 
-      uint32_t mapSize;
+      blockIds.resize(blockCount);
 
-      if (!scanner.Read(mapSize)) {
-        Close();
-
-        return false;
+      for (size_t b=0; b<blockCount; b++) {
+        scanner.Read(blockIds[b]);
       }
 
-      for (size_t i=1; i<=mapSize; i++) {
-        PageId     id;
-        FileOffset offset;
-
-        if (!scanner.Read(id) ||
-            !scanner.Read(offset)) {
-          Close();
-
-          return false;
-        }
-
-        coordPageOffsetMap[id]=offset;
+      if (scanner.HasError()) {
+        std::cerr << "Error while reading block index of file '" << datafilename << "'" << std::endl;
+        Close();
+        return false;
       }
 
-      isOpen=true;
+      blockEntryIds.reserve(sparseBlockSize);
+      blockEntryLats.reserve(sparseBlockSize);
+      blockEntryLons.reserve(sparseBlockSize);
     }
 
+    isOpen=true;
+
     return isOpen;
   }
 
@@ -103,7 +126,11 @@ namespace osmscout {
   {
     bool success=true;
 
-    coordPageOffsetMap.clear();
+    blockIds.clear();
+    blockEntryIds.clear();
+    blockEntryLats.clear();
+    blockEntryLons.clear();
+    currentBlock=std::numeric_limits<size_t>::max();
 
     if (scanner.IsOpen()) {
       if (!scanner.Close()) {
@@ -116,53 +143,156 @@ namespace osmscout {
     return success;
   }
 
-  bool CoordDataFile::Get(std::set<OSMId>& ids,
-                          CoordResultMap& coordsMap) const
+  /**
+   * Read all records of the given block of the sparse layout into memory.
+   */
+  bool CoordDataFile::LoadBlock(size_t block) const
   {
-    assert(isOpen);
+    size_t blockStart=block*sparseBlockSize;
+    size_t blockSize=std::min((size_t)sparseBlockSize,(size_t)(coordCount-blockStart));
 
-    coordsMap.clear();
-#if defined(OSMSCOUT_HASHMAP_HAS_RESERVE)
-    coordsMap.reserve(ids.size());
-#endif
+    currentBlock=std::numeric_limits<size_t>::max();
+
+    if (!scanner.SetPos(dataOffset+blockStart*(sizeof(OSMId)+2*sizeof(uint32_t)))) {
+      return false;
+    }
+
+    blockEntryIds.resize(blockSize);
+    blockEntryLats.resize(blockSize);
+    blockEntryLons.resize(blockSize);
+
+    for (size_t i=0; i<blockSize; i++) {
+      scanner.Read(blockEntryIds[i]);
+      scanner.Read(blockEntryLats[i]);
+      scanner.Read(blockEntryLons[i]);
+    }
+
+    if (scanner.HasError()) {
+      return false;
+    }
+
+    currentBlock=block;
+
+    return true;
+  }
 
-    for (std::set<OSMId>::const_iterator id=ids.begin();
+  bool CoordDataFile::GetDense(const std::vector<OSMId>& ids,
+                               CoordResultMap& coordsMap) const
+  {
+    for (std::vector<OSMId>::const_iterator id=ids.begin();
          id!=ids.end();
          ++id) {
-      PageId pageId=*id-std::numeric_limits<Id>::min();
-      PageId coordPageId=pageId/coordPageSize;
+      if (*id<minId) {
+        continue;
+      }
 
-      CoordPageOffsetMap::const_iterator pageOffset=coordPageOffsetMap.find(coordPageId);
+      Id index=*id-minId;
 
-      if (pageOffset!=coordPageOffsetMap.end()) {
-        FileOffset offset=pageOffset->second+(pageId%coordPageSize)*2*sizeof(uint32_t);
-        PageId     substituteId=(offset-2*sizeof(FileOffset))/2*sizeof(uint32_t);
+      if (index>=coordCount) {
+        continue;
+      }
 
-        scanner.SetPos(offset);
+      uint32_t latDat;
+      uint32_t lonDat;
 
-        uint32_t latDat;
-        uint32_t lonDat;
+      scanner.SetPos(dataOffset+index*2*sizeof(uint32_t));
+      scanner.Read(latDat);
+      scanner.Read(lonDat);
 
-        scanner.Read(latDat);
-        scanner.Read(lonDat);
+      if (scanner.HasError()) {
+        std::cerr << "Error while reading coord of node " << *id << " from file " << datafilename << "!" << std::endl;
+        return false;
+      }
 
-        if (latDat==0xffffffff || lonDat==0xffffffff) {
-          continue;
-        }
+      if (latDat==0xffffffff || lonDat==0xffffffff) {
+        continue;
+      }
+
+      coordsMap.insert(std::make_pair(*id,
+                                      CoordEntry(index+1,
+                                                 latDat/conversionFactor-90.0,
+                                                 lonDat/conversionFactor-180.0)));
+    }
+
+    return true;
+  }
+
+  bool CoordDataFile::GetSparse(const std::vector<OSMId>& ids,
+                                CoordResultMap& coordsMap) const
+  {
+    for (std::vector<OSMId>::const_iterator id=ids.begin();
+         id!=ids.end();
+         ++id) {
+      std::vector<OSMId>::const_iterator blockEntry=std::upper_bound(blockIds.begin(),
+                                                                     blockIds.end(),
+                                                                     *id);
+
+      if (blockEntry==blockIds.begin()) {
+        continue;
+      }
+
+      size_t block=blockEntry-blockIds.begin()-1;
+
+      if (block!=currentBlock &&
+          !LoadBlock(block)) {
+        std::cerr << "Error while reading coord block " << block << " from file " << datafilename << "!" << std::endl;
+        return false;
+      }
 
-        if (scanner.HasError()) {
-          std::cerr << "Error while reading data from offset " << pageOffset->second << " of file " << datafilename << "!" << std::endl;
-          scanner.Close();
-          return false;
-        }
+      std::vector<OSMId>::const_iterator entry=std::lower_bound(blockEntryIds.begin(),
+                                                                blockEntryIds.end(),
+                                                                *id);
 
-        coordsMap.insert(std::make_pair(*id,
-                                        CoordEntry(substituteId,
-                                                   latDat/conversionFactor-90.0,
-                                                   lonDat/conversionFactor-180.0)));
+      if (entry==blockEntryIds.end() ||
+          *entry!=*id) {
+        continue;
       }
+
+      size_t index=entry-blockEntryIds.begin();
+
+      coordsMap.insert(std::make_pair(*id,
+                                      CoordEntry(block*sparseBlockSize+index+1,
+                                                 blockEntryLats[index]/conversionFactor-90.0,
+                                                 blockEntryLons[index]/conversionFactor-180.0)));
     }
 
     return true;
   }
+
+  /**
+   * Return the coordinates of the given nodes. Nodes without coordinates are
+   * missing in the result.
+   *
+   * The ids should be sorted in ascending order, so that each record (dense)
+   * or block (sparse) is accessed only once and in file order.
+   */
+  bool CoordDataFile::Get(const std::vector<OSMId>& ids,
+                          CoordResultMap& coordsMap) const
+  {
+    assert(isOpen);
+
+    coordsMap.clear();
+#if defined(OSMSCOUT_HASHMAP_HAS_RESERVE)
+    coordsMap.reserve(ids.size());
+#endif
+
+    if (layout==layoutDense) {
+      return GetDense(ids,
+                      coordsMap);
+    }
+    else {
+      return GetSparse(ids,
+                       coordsMap);
+    }
+  }
+
+  bool CoordDataFile::Get(std::set<OSMId>& ids,
+                          CoordResultMap& coordsMap) const
+  {
+    std::vector<OSMId> idList(ids.begin(),
+                              ids.end());
+
+    return Get(idList,
+               coordsMap);
+  }
 }
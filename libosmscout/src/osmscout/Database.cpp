@@ -31,6 +31,8 @@
 #include <osmscout/system/Assert.h>
 #include <osmscout/system/Math.h>
 
+#include <osmscout/util/File.h>
+#include <osmscout/util/FileWriter.h>
 #include <osmscout/util/Geometry.h>
 
 namespace osmscout {
@@ -38,9 +40,12 @@ namespace osmscout {
   DatabaseParameter::DatabaseParameter()
   : areaAreaIndexCacheSize(1000),
     areaNodeIndexCacheSize(1000),
+    areaAreaIndexInMemory(false),
     nodeCacheSize(1000),
     wayCacheSize(4000),
     areaCacheSize(4000),
+    cacheShardCount(1),
+    cacheMemoryBudget(0),
     debugPerformance(false)
   {
     // no code
@@ -56,6 +61,15 @@ namespace osmscout {
     this->areaNodeIndexCacheSize=areaNodeIndexCacheSize;
   }
 
+  /**
+    Load the complete area index into memory on Open() instead of reading
+    index cells on demand. Off by default.
+    */
+  void DatabaseParameter::SetAreaAreaIndexInMemory(bool inMemory)
+  {
+    this->areaAreaIndexInMemory=inMemory;
+  }
+
   void DatabaseParameter::SetNodeCacheSize(unsigned long nodeCacheSize)
   {
     this->nodeCacheSize=nodeCacheSize;
@@ -71,6 +85,31 @@ namespace osmscout {
     this->areaCacheSize=areaCacheSize;
   }
 
+  void DatabaseParameter::SetCacheShardCount(unsigned long cacheShardCount)
+  {
+    this->cacheShardCount=cacheShardCount;
+  }
+
+  /**
+    Set the memory (in bytes) all caches of the database may use together.
+    0 (the default) means that each cache is limited by its configured
+    number of entries.
+    */
+  void DatabaseParameter::SetCacheMemoryBudget(unsigned long cacheMemoryBudget)
+  {
+    this->cacheMemoryBudget=cacheMemoryBudget;
+  }
+
+  /**
+    Set the file, the contents of the caches are stored to on Close() and
+    loaded from after Open(). An empty name (the default) disables the
+    snapshot.
+    */
+  void DatabaseParameter::SetCacheSnapshotFile(const std::string& cacheSnapshotFile)
+  {
+    this->cacheSnapshotFile=cacheSnapshotFile;
+  }
+
   void DatabaseParameter::SetDebugPerformance(bool debug)
   {
     debugPerformance=debug;
@@ -86,6 +125,11 @@ namespace osmscout {
     return areaNodeIndexCacheSize;
   }
 
+  bool DatabaseParameter::IsAreaAreaIndexInMemory() const
+  {
+    return areaAreaIndexInMemory;
+  }
+
   unsigned long DatabaseParameter::GetNodeCacheSize() const
   {
     return nodeCacheSize;
@@ -101,6 +145,21 @@ namespace osmscout {
     return areaCacheSize;
   }
 
+  unsigned long DatabaseParameter::GetCacheShardCount() const
+  {
+    return cacheShardCount;
+  }
+
+  unsigned long DatabaseParameter::GetCacheMemoryBudget() const
+  {
+    return cacheMemoryBudget;
+  }
+
+  std::string DatabaseParameter::GetCacheSnapshotFile() const
+  {
+    return cacheSnapshotFile;
+  }
+
   bool DatabaseParameter::IsDebugPerformance() const
   {
     return debugPerformance;
@@ -201,20 +260,35 @@ namespace osmscout {
      maxLat(0.0),
      areaNodeIndex(/*parameter.GetAreaNodeIndexCacheSize()*/),
      areaWayIndex(),
-     areaAreaIndex(parameter.GetAreaAreaIndexCacheSize()),
+     areaAreaIndex(parameter.GetAreaAreaIndexCacheSize(),
+                   parameter.IsAreaAreaIndexInMemory()),
      nodeDataFile("nodes.dat",
-                  parameter.GetNodeCacheSize()),
+                  parameter.GetNodeCacheSize(),
+                  parameter.GetCacheShardCount()),
      areaDataFile("areas.dat",
-                  parameter.GetAreaCacheSize()),
+                  parameter.GetAreaCacheSize(),
+                  parameter.GetCacheShardCount()),
      wayDataFile("ways.dat",
-                  parameter.GetWayCacheSize()),
-     typeConfig(NULL)
+                  parameter.GetWayCacheSize(),
+                  parameter.GetCacheShardCount()),
+     typeConfig(NULL),
+     cacheSnapshotFile(parameter.GetCacheSnapshotFile()),
+     warmUpAborted(false)
   {
-    // no code
+    if (parameter.GetCacheMemoryBudget()>0) {
+      cacheMemoryGovernor=new CacheMemoryGovernor(parameter.GetCacheMemoryBudget());
+
+      nodeDataFile.SetCacheMemoryGovernor(cacheMemoryGovernor);
+      areaDataFile.SetCacheMemoryGovernor(cacheMemoryGovernor);
+      wayDataFile.SetCacheMemoryGovernor(cacheMemoryGovernor);
+      areaAreaIndex.SetCacheMemoryGovernor(cacheMemoryGovernor);
+    }
   }
 
   Database::~Database()
   {
+    StopWarmUp();
+
     delete typeConfig;
   }
 
@@ -337,6 +411,20 @@ namespace osmscout {
     }
 
     isOpen=true;
+    warmUpAborted=false;
+
+    if (!cacheSnapshotFile.empty()) {
+      FileOffset snapshotSize;
+
+      if (GetFileSize(cacheSnapshotFile,snapshotSize)) {
+#if defined(OSMSCOUT_HAVE_THREAD)
+        warmUpBreaker=new ThreadedBreaker();
+        warmUpThread=std::thread(&Database::WarmUp,this);
+#else
+        WarmUp();
+#endif
+      }
+    }
 
     return true;
   }
@@ -346,9 +434,53 @@ namespace osmscout {
     return isOpen;
   }
 
+  void Database::WarmUp()
+  {
+    StopClock timer;
+
+    if (LoadCacheSnapshot(cacheSnapshotFile,warmUpBreaker)) {
+      timer.Stop();
+
+      if (debugPerformance) {
+        std::cout << "Loading cache snapshot '" << cacheSnapshotFile << "': " << timer << std::endl;
+      }
+    }
+    else if (warmUpBreaker.Valid() &&
+             warmUpBreaker->IsAborted()) {
+      warmUpAborted=true;
+    }
+  }
+
+  /**
+    Abort loading the cache snapshot and wait for the warm up thread.
+    */
+  void Database::StopWarmUp()
+  {
+    if (warmUpBreaker.Valid()) {
+      warmUpBreaker->Break();
+    }
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+    if (warmUpThread.joinable()) {
+      warmUpThread.join();
+    }
+#endif
+
+    warmUpBreaker=NULL;
+  }
 
   void Database::Close()
   {
+    StopWarmUp();
+
+    // If warm up was aborted, the caches only hold part of the snapshot,
+    // so we keep the existing snapshot
+    if (isOpen &&
+        !cacheSnapshotFile.empty() &&
+        !warmUpAborted) {
+      SaveCacheSnapshot(cacheSnapshotFile);
+    }
+
     nodeDataFile.Close();
     wayDataFile.Close();
     areaDataFile.Close();
@@ -369,6 +501,209 @@ namespace osmscout {
     wayDataFile.FlushCache();
   }
 
+  /**
+    Write one section of a cache snapshot: the size of the data file (to
+    detect a changed map) followed by the sorted, delta encoded offsets.
+    */
+  static bool WriteSnapshotOffsets(FileWriter& writer,
+                                   const std::string& path,
+                                   const std::string& name,
+                                   std::vector<FileOffset>& offsets)
+  {
+    FileOffset size;
+
+    if (!GetFileSize(AppendFileToDir(path,name),size)) {
+      std::cerr << "Cannot get size of '" << name << "'" << std::endl;
+      return false;
+    }
+
+    std::sort(offsets.begin(),offsets.end());
+
+    writer.WriteNumber(size);
+    writer.WriteNumber((uint32_t)offsets.size());
+
+    FileOffset lastOffset=0;
+
+    for (size_t i=0; i<offsets.size(); i++) {
+      writer.WriteNumber(offsets[i]-lastOffset);
+
+      lastOffset=offsets[i];
+    }
+
+    return !writer.HasError();
+  }
+
+  static bool ReadSnapshotOffsets(FileScanner& scanner,
+                                  const std::string& path,
+                                  const std::string& name,
+                                  std::vector<FileOffset>& offsets)
+  {
+    FileOffset snapshotSize;
+    FileOffset size;
+    uint32_t   count;
+
+    if (!scanner.ReadNumber(snapshotSize) ||
+        !scanner.ReadNumber(count)) {
+      return false;
+    }
+
+    if (!GetFileSize(AppendFileToDir(path,name),size) ||
+        size!=snapshotSize) {
+      std::cerr << "Cache snapshot '" << scanner.GetFilename() << "' does not match '" << name << "'" << std::endl;
+      return false;
+    }
+
+    FileOffset pos;
+    FileOffset fileSize;
+
+    // Every offset takes at least one byte, so a count exceeding the rest
+    // of the file is corrupt and must not be used for allocation
+    if (!scanner.GetPos(pos) ||
+        !GetFileSize(scanner.GetFilename(),fileSize) ||
+        pos>fileSize ||
+        count>fileSize-pos) {
+      std::cerr << "Cache snapshot '" << scanner.GetFilename() << "' is corrupt" << std::endl;
+      return false;
+    }
+
+    offsets.resize(count);
+
+    FileOffset lastOffset=0;
+
+    for (size_t i=0; i<count; i++) {
+      FileOffset offset;
+
+      if (!scanner.ReadNumber(offset)) {
+        return false;
+      }
+
+      offsets[i]=lastOffset+offset;
+
+      lastOffset=offsets[i];
+    }
+
+    return true;
+  }
+
+  /**
+    Load the objects at the given (sorted) offsets into the cache of the
+    data file. The objects are requested in chunks, so that the data file
+    can prefetch them and the breaker is checked regularly.
+    */
+  template <class N>
+  static bool LoadSnapshotData(const DataFile<N>& dataFile,
+                               const std::vector<FileOffset>& offsets,
+                               const BreakerRef& breaker)
+  {
+    static const size_t chunkSize=1000;
+
+    for (size_t start=0; start<offsets.size(); start+=chunkSize) {
+      if (breaker.Valid() &&
+          breaker->IsAborted()) {
+        return false;
+      }
+
+      std::vector<FileOffset> chunk(offsets.begin()+start,
+                                    offsets.begin()+std::min(start+chunkSize,offsets.size()));
+      std::vector<Ref<N> >    data;
+
+      if (!dataFile.GetByOffset(chunk,data)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /**
+    Write the offsets of all index cells and objects currently held in the
+    caches to the given file. Only the offsets are stored, so the snapshot is
+    small and loading it (see LoadCacheSnapshot()) reads the data from the
+    map files.
+    */
+  bool Database::SaveCacheSnapshot(const std::string& filename) const
+  {
+    if (!IsOpen()) {
+      return false;
+    }
+
+    std::vector<FileOffset> areaIndexOffsets;
+    std::vector<FileOffset> nodeOffsets;
+    std::vector<FileOffset> areaOffsets;
+    std::vector<FileOffset> wayOffsets;
+
+    areaAreaIndex.GetCachedOffsets(areaIndexOffsets);
+    nodeDataFile.GetCachedOffsets(nodeOffsets);
+    areaDataFile.GetCachedOffsets(areaOffsets);
+    wayDataFile.GetCachedOffsets(wayOffsets);
+
+    FileWriter writer;
+
+    if (!writer.Open(filename)) {
+      std::cerr << "Cannot create cache snapshot '" << filename << "'" << std::endl;
+      return false;
+    }
+
+    if (!WriteSnapshotOffsets(writer,path,"areaarea.idx",areaIndexOffsets) ||
+        !WriteSnapshotOffsets(writer,path,"nodes.dat",nodeOffsets) ||
+        !WriteSnapshotOffsets(writer,path,"areas.dat",areaOffsets) ||
+        !WriteSnapshotOffsets(writer,path,"ways.dat",wayOffsets)) {
+      std::cerr << "Error while writing cache snapshot '" << filename << "'" << std::endl;
+      writer.Close();
+      return false;
+    }
+
+    return writer.Close();
+  }
+
+  /**
+    Load the index cells and objects listed in the given cache snapshot
+    (see SaveCacheSnapshot()) into the caches. The area index is loaded
+    first, then nodes, areas and ways, each in file order. Loading can be
+    aborted using the given breaker. If the map has changed since the
+    snapshot was written, nothing is loaded.
+
+    Returns false on error or if loading was aborted.
+    */
+  bool Database::LoadCacheSnapshot(const std::string& filename,
+                                   const BreakerRef& breaker) const
+  {
+    if (!IsOpen()) {
+      return false;
+    }
+
+    FileScanner             scanner;
+    std::vector<FileOffset> areaIndexOffsets;
+    std::vector<FileOffset> nodeOffsets;
+    std::vector<FileOffset> areaOffsets;
+    std::vector<FileOffset> wayOffsets;
+
+    if (!scanner.Open(filename,FileScanner::Sequential,false)) {
+      std::cerr << "Cannot open cache snapshot '" << filename << "'" << std::endl;
+      return false;
+    }
+
+    if (!ReadSnapshotOffsets(scanner,path,"areaarea.idx",areaIndexOffsets) ||
+        !ReadSnapshotOffsets(scanner,path,"nodes.dat",nodeOffsets) ||
+        !ReadSnapshotOffsets(scanner,path,"areas.dat",areaOffsets) ||
+        !ReadSnapshotOffsets(scanner,path,"ways.dat",wayOffsets)) {
+      std::cerr << "Error while reading cache snapshot '" << filename << "'" << std::endl;
+      scanner.Close();
+      return false;
+    }
+
+    scanner.Close();
+
+    if (!areaAreaIndex.LoadCells(areaIndexOffsets,
+                                 breaker)) {
+      return false;
+    }
+
+    return LoadSnapshotData(nodeDataFile,nodeOffsets,breaker) &&
+           LoadSnapshotData(areaDataFile,areaOffsets,breaker) &&
+           LoadSnapshotData(wayDataFile,wayOffsets,breaker);
+  }
+
   std::string Database::GetPath() const
   {
     return path;
@@ -379,6 +714,15 @@ namespace osmscout {
     return typeConfig;
   }
 
+  /**
+    Returns the governor distributing the cache memory budget or an invalid
+    reference, if no budget was set.
+    */
+  CacheMemoryGovernorRef Database::GetCacheMemoryGovernor() const
+  {
+    return cacheMemoryGovernor;
+  }
+
   bool Database::GetBoundingBox(double& minLat,double& minLon,
                                 double& maxLat,double& maxLon) const
   {
@@ -1130,6 +1474,34 @@ namespace osmscout {
     return wayDataFile.GetByOffset(offsets,dataMap);
   }
 
+  /**
+    Return lightweight views of the areas at the given offsets, see AreaView.
+    The views are valid as long as the database is open.
+    */
+  bool Database::GetAreaViewsByOffset(const std::vector<FileOffset>& offsets,
+                                      std::vector<AreaView>& areas) const
+  {
+    if (!IsOpen()) {
+      return false;
+    }
+
+    return areaDataFile.GetViewsByOffset(offsets,areas);
+  }
+
+  /**
+    Return lightweight views of the ways at the given offsets, see WayView.
+    The views are valid as long as the database is open.
+    */
+  bool Database::GetWayViewsByOffset(const std::vector<FileOffset>& offsets,
+                                     std::vector<WayView>& ways) const
+  {
+    if (!IsOpen()) {
+      return false;
+    }
+
+    return wayDataFile.GetViewsByOffset(offsets,ways);
+  }
+
   bool Database::VisitAdminRegions(AdminRegionVisitor& visitor) const
   {
     if (!IsOpen()) {
@@ -1541,5 +1913,9 @@ namespace osmscout {
     areaWayIndex.DumpStatistics();
     cityStreetIndex.DumpStatistics();
     waterIndex.DumpStatistics();
+
+    if (cacheMemoryGovernor.Valid()) {
+      cacheMemoryGovernor->DumpStatistics();
+    }
   }
 }
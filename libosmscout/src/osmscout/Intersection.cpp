@@ -32,6 +32,15 @@ namespace osmscout {
     // no code
   }
 
+  /**
+    Returns the (approximated) memory used by the intersection including
+    all allocated data.
+    */
+  size_t Intersection::GetMemorySize() const
+  {
+    return sizeof(Intersection)+objects.capacity()*sizeof(ObjectFileRef);
+  }
+
   bool Intersection::Read(FileScanner& scanner)
   {
     if (!scanner.ReadNumber(nodeId)) {
@@ -102,6 +102,23 @@ namespace osmscout {
     }
   }
 
+  /**
+    Returns the (approximated) memory used by the attributes including
+    all allocated data.
+    */
+  size_t NodeAttributes::GetMemorySize() const
+  {
+    size_t memory=sizeof(NodeAttributes);
+
+    memory+=name.length();
+    memory+=nameAlt.length();
+    memory+=location.length();
+    memory+=address.length();
+    memory+=GetTagsMemorySize(tags);
+
+    return memory;
+  }
+
   bool NodeAttributes::Read(FileScanner& scanner)
   {
     scanner.Read(flags);
@@ -235,6 +252,15 @@ namespace osmscout {
                               tags);
   }
 
+  /**
+    Returns the (approximated) memory used by the node including
+    all allocated data.
+    */
+  size_t Node::GetMemorySize() const
+  {
+    return sizeof(Node)-sizeof(NodeAttributes)+attributes.GetMemorySize();
+  }
+
   bool Node::Read(FileScanner& scanner)
   {
     uint32_t tmpType;
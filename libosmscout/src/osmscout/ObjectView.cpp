@@ -0,0 +1,912 @@
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2014  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <osmscout/ObjectView.h>
+
+#include <algorithm>
+
+#include <osmscout/Area.h>
+#include <osmscout/Way.h>
+
+#include <osmscout/util/Number.h>
+
+namespace osmscout {
+
+  /*
+   * Helpers for decoding data in the format written by FileWriter. All of them
+   * return NULL, if the data would be read beyond the given end.
+   */
+
+  static inline const char* DecodeUInt8(const char* data,
+                                        const char* end,
+                                        uint8_t& value)
+  {
+    if (data==NULL || data>=end) {
+      return NULL;
+    }
+
+    value=(uint8_t)*data;
+
+    return data+1;
+  }
+
+  static inline const char* DecodeUInt16(const char* data,
+                                         const char* end,
+                                         uint16_t& value)
+  {
+    if (data==NULL || end-data<2) {
+      return NULL;
+    }
+
+    value=(uint16_t)((unsigned char)data[0] |
+                     ((unsigned char)data[1] << 8));
+
+    return data+2;
+  }
+
+  static inline const char* DecodeUInt32(const char* data,
+                                         const char* end,
+                                         uint32_t& value)
+  {
+    if (data==NULL || end-data<4) {
+      return NULL;
+    }
+
+    value=(uint32_t)(unsigned char)data[0] |
+          ((uint32_t)(unsigned char)data[1] << 8) |
+          ((uint32_t)(unsigned char)data[2] << 16) |
+          ((uint32_t)(unsigned char)data[3] << 24);
+
+    return data+4;
+  }
+
+  static inline const char* SkipVarNumber(const char* data,
+                                          const char* end)
+  {
+    if (data==NULL) {
+      return NULL;
+    }
+
+    while (data<end) {
+      if ((*data & 0x80)==0) {
+        return data+1;
+      }
+
+      data++;
+    }
+
+    return NULL;
+  }
+
+  /**
+   * Decode a variable length encoded number. DecodeNumber() does not know
+   * the end of the data, so the last byte of the number is searched first.
+   */
+  template<typename N>
+  static inline const char* DecodeVarNumber(const char* data,
+                                            const char* end,
+                                            N& value)
+  {
+    const char* next=SkipVarNumber(data,end);
+
+    if (next==NULL) {
+      return NULL;
+    }
+
+    DecodeNumber(data,value);
+
+    return next;
+  }
+
+  static inline const char* SkipString(const char* data,
+                                       const char* end)
+  {
+    if (data==NULL) {
+      return NULL;
+    }
+
+    while (data<end) {
+      if (*data=='\0') {
+        return data+1;
+      }
+
+      data++;
+    }
+
+    return NULL;
+  }
+
+  static const char* DecodeString(const char* data,
+                                  const char* end,
+                                  std::string& value)
+  {
+    const char* stringEnd=SkipString(data,end);
+
+    if (stringEnd==NULL) {
+      value.clear();
+      return NULL;
+    }
+
+    value.assign(data,stringEnd-data-1);
+
+    return stringEnd;
+  }
+
+  static const char* SkipTags(const char* data,
+                              const char* end)
+  {
+    uint32_t tagCount;
+
+    data=DecodeVarNumber(data,end,tagCount);
+
+    for (uint32_t t=0; data!=NULL && t<tagCount; t++) {
+      data=SkipVarNumber(data,end);
+      data=SkipString(data,end);
+    }
+
+    return data;
+  }
+
+  static bool DecodeTags(const char* data,
+                         const char* end,
+                         std::vector<Tag>& tags)
+  {
+    uint32_t tagCount;
+
+    tags.clear();
+
+    data=DecodeVarNumber(data,end,tagCount);
+
+    if (data==NULL) {
+      return false;
+    }
+
+    tags.resize(tagCount);
+
+    for (uint32_t t=0; data!=NULL && t<tagCount; t++) {
+      data=DecodeVarNumber(data,end,tags[t].key);
+      data=DecodeString(data,end,tags[t].value);
+    }
+
+    return data!=NULL;
+  }
+
+  //! Number of coordinates decoded at once
+  static const uint32_t coordChunkSize=128;
+
+  /**
+   * Decode the given number of coordinates (minimum coordinate followed by
+   * one delta pair per node) into the given buffer.
+   */
+  static const char* DecodeCoords(const char* data,
+                                  const char* end,
+                                  uint32_t nodeCount,
+                                  GeoCoord* coords)
+  {
+    uint32_t minLat=0;
+    uint32_t minLon=0;
+
+    data=DecodeUInt32(data,end,minLat);
+    data=DecodeUInt32(data,end,minLon);
+
+    for (uint32_t start=0; data!=NULL && start<nodeCount; start+=coordChunkSize) {
+      uint32_t values[2*coordChunkSize];
+      uint32_t chunkCount=std::min(coordChunkSize,nodeCount-start);
+
+      data=DecodeNumbers(data,end,values,2*chunkCount);
+
+      for (uint32_t i=0; data!=NULL && i<chunkCount; i++) {
+        coords[start+i].Set((minLat+values[2*i])/conversionFactor-90.0,
+                            (minLon+values[2*i+1])/conversionFactor-180.0);
+      }
+    }
+
+    return data;
+  }
+
+  /**
+   * Calculate the bounding box of the given coordinates without decoding them
+   * into GeoCoords.
+   */
+  static const char* DecodeBoundingBox(const char* data,
+                                       const char* end,
+                                       uint32_t nodeCount,
+                                       double& minLon,
+                                       double& maxLon,
+                                       double& minLat,
+                                       double& maxLat)
+  {
+    uint32_t minLatValue=0;
+    uint32_t minLonValue=0;
+    uint32_t maxLatDelta=0;
+    uint32_t maxLonDelta=0;
+
+    data=DecodeUInt32(data,end,minLatValue);
+    data=DecodeUInt32(data,end,minLonValue);
+
+    for (uint32_t start=0; data!=NULL && start<nodeCount; start+=coordChunkSize) {
+      uint32_t values[2*coordChunkSize];
+      uint32_t chunkCount=std::min(coordChunkSize,nodeCount-start);
+
+      data=DecodeNumbers(data,end,values,2*chunkCount);
+
+      for (uint32_t i=0; data!=NULL && i<chunkCount; i++) {
+        maxLatDelta=std::max(maxLatDelta,values[2*i]);
+        maxLonDelta=std::max(maxLonDelta,values[2*i+1]);
+      }
+    }
+
+    if (data==NULL) {
+      return NULL;
+    }
+
+    minLat=minLatValue/conversionFactor-90.0;
+    minLon=minLonValue/conversionFactor-180.0;
+    maxLat=(minLatValue+maxLatDelta)/conversionFactor-90.0;
+    maxLon=(minLonValue+maxLonDelta)/conversionFactor-180.0;
+
+    return data;
+  }
+
+  static const char* SkipCoords(const char* data,
+                                const char* end,
+                                uint32_t nodeCount)
+  {
+    if (data==NULL || end-data<8) {
+      return NULL;
+    }
+
+    data+=8;
+
+    for (uint32_t i=0; data!=NULL && i<2*nodeCount; i++) {
+      data=SkipVarNumber(data,end);
+    }
+
+    return data;
+  }
+
+  WayView::WayView()
+  : fileOffset(0),
+    end(NULL),
+    strings(NULL),
+    tags(NULL),
+    coords(NULL),
+    type(typeIgnore),
+    flags(0),
+    access(0),
+    layer(0),
+    width(0),
+    maxSpeed(0),
+    grade(1),
+    nodeCount(0),
+    minLat(0),
+    minLon(0)
+  {
+    // no code
+  }
+
+  /**
+   * Set the view to the way at the given (mapped) position. Only the header
+   * of the way is decoded.
+   */
+  bool WayView::Set(FileOffset fileOffset,
+                    const char* data,
+                    const char* end)
+  {
+    this->fileOffset=fileOffset;
+    this->end=end;
+
+    data=DecodeVarNumber(data,end,type);
+    data=DecodeUInt16(data,end,flags);
+    data=DecodeUInt8(data,end,access);
+
+    strings=data;
+
+    if (flags & WayAttributes::hasName) {
+      data=SkipString(data,end);
+    }
+
+    if (flags & WayAttributes::hasNameAlt) {
+      data=SkipString(data,end);
+    }
+
+    if (flags & WayAttributes::hasRef) {
+      data=SkipString(data,end);
+    }
+
+    if (flags & WayAttributes::hasLocation) {
+      data=SkipString(data,end);
+    }
+
+    if (flags & WayAttributes::hasAddress) {
+      data=SkipString(data,end);
+    }
+
+    layer=0;
+    width=0;
+    maxSpeed=0;
+    grade=1;
+
+    if (flags & WayAttributes::hasLayer) {
+      uint8_t value=0;
+
+      data=DecodeUInt8(data,end,value);
+      layer=(int8_t)value;
+    }
+
+    if (flags & WayAttributes::hasWidth) {
+      data=DecodeUInt8(data,end,width);
+    }
+
+    if (flags & WayAttributes::hasMaxSpeed) {
+      data=DecodeUInt8(data,end,maxSpeed);
+    }
+
+    if (flags & WayAttributes::hasGrade) {
+      data=DecodeUInt8(data,end,grade);
+    }
+
+    tags=data;
+
+    if (flags & WayAttributes::hasTags) {
+      data=SkipTags(data,end);
+    }
+
+    data=DecodeVarNumber(data,end,nodeCount);
+
+    coords=data;
+
+    data=DecodeUInt32(data,end,minLat);
+    data=DecodeUInt32(data,end,minLon);
+
+    return data!=NULL;
+  }
+
+  bool WayView::IsBridge() const
+  {
+    return (flags & WayAttributes::isBridge)!=0;
+  }
+
+  bool WayView::IsTunnel() const
+  {
+    return (flags & WayAttributes::isTunnel)!=0;
+  }
+
+  bool WayView::IsRoundabout() const
+  {
+    return (flags & WayAttributes::isRoundabout)!=0;
+  }
+
+  bool WayView::HasAccess() const
+  {
+    return (flags & WayAttributes::hasAccess)!=0;
+  }
+
+  /**
+   * Decode the string attribute with the given flag by skipping all string
+   * attributes in front of it.
+   */
+  std::string WayView::GetString(uint16_t flag) const
+  {
+    static const uint16_t stringFlags[] = {
+      WayAttributes::hasName,
+      WayAttributes::hasNameAlt,
+      WayAttributes::hasRef,
+      WayAttributes::hasLocation,
+      WayAttributes::hasAddress
+    };
+
+    std::string value;
+    const char* data=strings;
+
+    if (!(flags & flag)) {
+      return value;
+    }
+
+    for (size_t i=0; i<sizeof(stringFlags)/sizeof(stringFlags[0]); i++) {
+      if (!(flags & stringFlags[i])) {
+        continue;
+      }
+
+      if (stringFlags[i]==flag) {
+        DecodeString(data,end,value);
+        break;
+      }
+
+      data=SkipString(data,end);
+    }
+
+    return value;
+  }
+
+  std::string WayView::GetName() const
+  {
+    return GetString(WayAttributes::hasName);
+  }
+
+  std::string WayView::GetNameAlt() const
+  {
+    return GetString(WayAttributes::hasNameAlt);
+  }
+
+  std::string WayView::GetRefName() const
+  {
+    return GetString(WayAttributes::hasRef);
+  }
+
+  std::string WayView::GetLocation() const
+  {
+    return GetString(WayAttributes::hasLocation);
+  }
+
+  std::string WayView::GetAddress() const
+  {
+    return GetString(WayAttributes::hasAddress);
+  }
+
+  bool WayView::GetTags(std::vector<Tag>& tags) const
+  {
+    if (!(flags & WayAttributes::hasTags)) {
+      tags.clear();
+      return true;
+    }
+
+    return DecodeTags(this->tags,end,tags);
+  }
+
+  bool WayView::GetBoundingBox(double& minLon,
+                               double& maxLon,
+                               double& minLat,
+                               double& maxLat) const
+  {
+    return DecodeBoundingBox(coords,
+                             end,
+                             nodeCount,
+                             minLon,
+                             maxLon,
+                             minLat,
+                             maxLat)!=NULL;
+  }
+
+  /**
+   * Decode all coordinates of the way into the given buffer, which must have
+   * room for GetNodeCount() entries.
+   */
+  bool WayView::GetCoords(GeoCoord* coords) const
+  {
+    return DecodeCoords(this->coords,end,nodeCount,coords)!=NULL;
+  }
+
+  bool WayView::GetCoords(std::vector<GeoCoord>& coords) const
+  {
+    coords.resize(nodeCount);
+
+    if (nodeCount==0) {
+      return true;
+    }
+
+    return GetCoords(&coords[0]);
+  }
+
+  /**
+   * Decode the node ids of the way, see Way::ids.
+   */
+  bool WayView::GetIds(std::vector<Id>& ids) const
+  {
+    const char* data=SkipCoords(coords,end,nodeCount);
+    uint32_t    idCount;
+
+    ids.assign(nodeCount,0);
+
+    data=DecodeVarNumber(data,end,idCount);
+
+    if (data==NULL) {
+      return false;
+    }
+
+    if (idCount>0) {
+      Id minId;
+
+      data=DecodeVarNumber(data,end,minId);
+
+      for (uint32_t i=0; data!=NULL && i<idCount; i++) {
+        uint32_t index;
+        Id       id;
+
+        data=DecodeVarNumber(data,end,index);
+        data=DecodeVarNumber(data,end,id);
+
+        if (data==NULL || index>=nodeCount) {
+          return false;
+        }
+
+        ids[index]=id+minId;
+      }
+    }
+
+    return data!=NULL;
+  }
+
+  AreaView::Ring::Ring()
+  : end(NULL),
+    strings(NULL),
+    tags(NULL),
+    ids(NULL),
+    coords(NULL),
+    next(NULL),
+    type(typeIgnore),
+    flags(0),
+    ring(0),
+    nodeCount(0)
+  {
+    // no code
+  }
+
+  /**
+   * Set the ring to the given position. The attribute flags of the master
+   * ring are stored in front of the ring count of the area, they are passed
+   * in for the master ring.
+   */
+  bool AreaView::Ring::Set(const char* data,
+                           const char* end,
+                           bool isMaster,
+                           uint8_t flags,
+                           uint8_t ring)
+  {
+    this->end=end;
+    this->flags=0;
+    this->ring=ring;
+
+    strings=NULL;
+    tags=NULL;
+    ids=NULL;
+
+    data=DecodeVarNumber(data,end,type);
+
+    bool hasAttributes=isMaster || type!=typeIgnore;
+
+    if (hasAttributes) {
+      if (isMaster) {
+        this->flags=flags;
+      }
+      else {
+        data=DecodeUInt8(data,end,this->flags);
+      }
+
+      strings=data;
+
+      if (this->flags & AreaAttributes::hasName) {
+        data=SkipString(data,end);
+      }
+
+      if (this->flags & AreaAttributes::hasNameAlt) {
+        data=SkipString(data,end);
+      }
+
+      if (this->flags & AreaAttributes::hasLocation) {
+        data=SkipString(data,end);
+      }
+
+      if (this->flags & AreaAttributes::hasAddress) {
+        data=SkipString(data,end);
+      }
+
+      tags=data;
+
+      if (this->flags & AreaAttributes::hasTags) {
+        data=SkipTags(data,end);
+      }
+    }
+
+    if (!isMaster) {
+      data=DecodeUInt8(data,end,this->ring);
+    }
+
+    data=DecodeVarNumber(data,end,nodeCount);
+
+    if (nodeCount>0) {
+      if (hasAttributes) {
+        ids=data;
+
+        data=SkipVarNumber(data,end);
+
+        for (uint32_t i=0; data!=NULL && i<nodeCount; i++) {
+          data=SkipVarNumber(data,end);
+        }
+      }
+
+      coords=data;
+
+      data=SkipCoords(data,end,nodeCount);
+    }
+    else {
+      coords=data;
+    }
+
+    next=data;
+
+    return data!=NULL;
+  }
+
+  std::string AreaView::Ring::GetString(uint8_t flag) const
+  {
+    static const uint8_t stringFlags[] = {
+      AreaAttributes::hasName,
+      AreaAttributes::hasNameAlt,
+      AreaAttributes::hasLocation,
+      AreaAttributes::hasAddress
+    };
+
+    std::string value;
+    const char* data=strings;
+
+    if (!(flags & flag)) {
+      return value;
+    }
+
+    for (size_t i=0; i<sizeof(stringFlags)/sizeof(stringFlags[0]); i++) {
+      if (!(flags & stringFlags[i])) {
+        continue;
+      }
+
+      if (stringFlags[i]==flag) {
+        DecodeString(data,end,value);
+        break;
+      }
+
+      data=SkipString(data,end);
+    }
+
+    return value;
+  }
+
+  std::string AreaView::Ring::GetName() const
+  {
+    return GetString(AreaAttributes::hasName);
+  }
+
+  std::string AreaView::Ring::GetNameAlt() const
+  {
+    return GetString(AreaAttributes::hasNameAlt);
+  }
+
+  std::string AreaView::Ring::GetLocation() const
+  {
+    return GetString(AreaAttributes::hasLocation);
+  }
+
+  std::string AreaView::Ring::GetAddress() const
+  {
+    return GetString(AreaAttributes::hasAddress);
+  }
+
+  bool AreaView::Ring::GetTags(std::vector<Tag>& tags) const
+  {
+    if (!(flags & AreaAttributes::hasTags)) {
+      tags.clear();
+      return true;
+    }
+
+    return DecodeTags(this->tags,end,tags);
+  }
+
+  bool AreaView::Ring::GetBoundingBox(double& minLon,
+                                      double& maxLon,
+                                      double& minLat,
+                                      double& maxLat) const
+  {
+    return DecodeBoundingBox(coords,
+                             end,
+                             nodeCount,
+                             minLon,
+                             maxLon,
+                             minLat,
+                             maxLat)!=NULL;
+  }
+
+  /**
+   * Decode all coordinates of the ring into the given buffer, which must have
+   * room for GetNodeCount() entries.
+   */
+  bool AreaView::Ring::GetCoords(GeoCoord* coords) const
+  {
+    if (nodeCount==0) {
+      return true;
+    }
+
+    return DecodeCoords(this->coords,end,nodeCount,coords)!=NULL;
+  }
+
+  bool AreaView::Ring::GetCoords(std::vector<GeoCoord>& coords) const
+  {
+    coords.resize(nodeCount);
+
+    if (nodeCount==0) {
+      return true;
+    }
+
+    return GetCoords(&coords[0]);
+  }
+
+  /**
+   * Decode the node ids of the ring. Rings without a type do not store ids,
+   * the result is empty for them.
+   */
+  bool AreaView::Ring::GetIds(std::vector<Id>& ids) const
+  {
+    ids.clear();
+
+    if (this->ids==NULL) {
+      return true;
+    }
+
+    const char* data=this->ids;
+    Id          minId=0;
+
+    ids.resize(nodeCount);
+
+    data=DecodeVarNumber(data,end,minId);
+
+    for (uint32_t i=0; data!=NULL && i<nodeCount; i++) {
+      Id id=0;
+
+      data=DecodeVarNumber(data,end,id);
+
+      if (data==NULL) {
+        break;
+      }
+
+      ids[i]=minId+id;
+    }
+
+    return data!=NULL;
+  }
+
+  AreaView::AreaView()
+  : fileOffset(0),
+    end(NULL),
+    ringCount(0)
+  {
+    // no code
+  }
+
+  /**
+   * Set the view to the area at the given (mapped) position. Only the header
+   * and the master ring of the area are decoded.
+   */
+  bool AreaView::Set(FileOffset fileOffset,
+                     const char* data,
+                     const char* end)
+  {
+    uint8_t outerFlags;
+
+    this->fileOffset=fileOffset;
+    this->end=end;
+
+    ringCount=1;
+
+    data=DecodeUInt8(data,end,outerFlags);
+
+    if (data==NULL) {
+      return false;
+    }
+
+    if (!(outerFlags & AreaAttributes::isSimple)) {
+      data=DecodeVarNumber(data,end,ringCount);
+
+      if (data==NULL) {
+        return false;
+      }
+
+      ringCount++;
+    }
+
+    return master.Set(data,
+                      end,
+                      true,
+                      outerFlags,
+                      ringCount>1 ? (uint8_t)Area::masterRingId : (uint8_t)Area::outerRingId);
+  }
+
+  /**
+   * Return views of all rings, including the master ring.
+   */
+  bool AreaView::GetRings(std::vector<Ring>& rings) const
+  {
+    rings.resize(ringCount);
+
+    if (ringCount==0) {
+      return false;
+    }
+
+    rings[0]=master;
+
+    for (size_t r=1; r<ringCount; r++) {
+      if (!rings[r].Set(rings[r-1].next,
+                        end,
+                        false,
+                        0,
+                        0)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * Return the bounding box of all outer rings of the area.
+   */
+  bool AreaView::GetBoundingBox(double& minLon,
+                                double& maxLon,
+                                double& minLat,
+                                double& maxLat) const
+  {
+    if (IsSimple()) {
+      return master.GetBoundingBox(minLon,
+                                   maxLon,
+                                   minLat,
+                                   maxLat);
+    }
+
+    Ring ring=master;
+    bool start=true;
+
+    for (size_t r=1; r<ringCount; r++) {
+      if (!ring.Set(ring.next,
+                    end,
+                    false,
+                    0,
+                    0)) {
+        return false;
+      }
+
+      if (ring.GetRing()!=Area::outerRingId ||
+          ring.GetNodeCount()==0) {
+        continue;
+      }
+
+      double ringMinLon,ringMaxLon,ringMinLat,ringMaxLat;
+
+      if (!ring.GetBoundingBox(ringMinLon,
+                               ringMaxLon,
+                               ringMinLat,
+                               ringMaxLat)) {
+        return false;
+      }
+
+      if (start) {
+        minLon=ringMinLon;
+        maxLon=ringMaxLon;
+        minLat=ringMinLat;
+        maxLat=ringMaxLat;
+
+        start=false;
+      }
+      else {
+        minLon=std::min(minLon,ringMinLon);
+        maxLon=std::max(maxLon,ringMaxLon);
+        minLat=std::min(minLat,ringMinLat);
+        maxLat=std::max(maxLat,ringMaxLat);
+      }
+    }
+
+    return !start;
+  }
+}
@@ -128,6 +128,8 @@ namespace osmscout
 
   bool OptimizeAreasLowZoom::Close()
   {
+    ScopedLock lock(accessMutex);
+
     bool success=true;
 
     if (scanner.IsOpen()) {
@@ -267,6 +269,8 @@ namespace osmscout
                                       TypeSet& areaTypes,
                                       std::vector<AreaRef>& areas) const
   {
+    ScopedLock lock(accessMutex);
+
     std::vector<FileOffset> offsets;
 
     if (!scanner.IsOpen()) {
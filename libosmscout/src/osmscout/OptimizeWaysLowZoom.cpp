@@ -128,6 +128,8 @@ namespace osmscout
 
   bool OptimizeWaysLowZoom::Close()
   {
+    ScopedLock lock(accessMutex);
+
     bool success=true;
 
     if (scanner.IsOpen()) {
@@ -267,6 +269,8 @@ namespace osmscout
                                     std::vector<TypeSet>& wayTypes,
                                     std::vector<WayRef>& ways) const
   {
+    ScopedLock lock(accessMutex);
+
     std::vector<FileOffset> offsets;
 
     if (!scanner.IsOpen()) {
@@ -0,0 +1,326 @@
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2014  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <osmscout/RouteGraph.h>
+
+#include <algorithm>
+#include <iostream>
+
+#include <osmscout/util/FileScanner.h>
+#include <osmscout/util/FileWriter.h>
+
+#include <osmscout/system/Assert.h>
+
+namespace osmscout {
+
+  const uint32_t RouteGraph::noNode;
+
+  RouteGraph::RouteGraph()
+  {
+    Clear();
+  }
+
+  RouteGraph::~RouteGraph()
+  {
+    // no code
+  }
+
+  void RouteGraph::Clear()
+  {
+    Node end;
+
+    end.offset=0;
+    end.firstEdge=0;
+    end.firstExclude=0;
+    end.lat=0;
+    end.lon=0;
+
+    nodes.clear();
+    edges.clear();
+    excludes.clear();
+    objects.clear();
+
+    nodes.push_back(end);
+  }
+
+  /**
+   * Set the object table. Objects must be sorted and unique.
+   */
+  void RouteGraph::SetObjects(const std::vector<ObjectFileRef>& objects)
+  {
+    this->objects=objects;
+  }
+
+  /**
+   * Add the next node. Nodes must be added in the order of their file offset.
+   * The coordinates of the node are set later using SetCoord().
+   */
+  uint32_t RouteGraph::AddNode(FileOffset offset,
+                               const std::vector<Edge>& nodeEdges,
+                               const std::vector<Exclude>& nodeExcludes)
+  {
+    assert(nodes.size()==1 || nodes[nodes.size()-2].offset<offset);
+
+    Node& node=nodes.back();
+
+    node.offset=offset;
+
+    edges.insert(edges.end(),
+                 nodeEdges.begin(),
+                 nodeEdges.end());
+    excludes.insert(excludes.end(),
+                    nodeExcludes.begin(),
+                    nodeExcludes.end());
+
+    Node end;
+
+    end.offset=0;
+    end.firstEdge=(uint32_t)edges.size();
+    end.firstExclude=(uint32_t)excludes.size();
+    end.lat=0;
+    end.lon=0;
+
+    nodes.push_back(end);
+
+    return (uint32_t)(nodes.size()-2);
+  }
+
+  void RouteGraph::SetCoord(uint32_t node,
+                            uint32_t lat,
+                            uint32_t lon)
+  {
+    assert(node<GetNodeCount());
+
+    nodes[node].lat=lat;
+    nodes[node].lon=lon;
+  }
+
+  /**
+   * Return the node for the route node with the given file offset or
+   * noNode.
+   */
+  uint32_t RouteGraph::GetNode(FileOffset offset) const
+  {
+    size_t low=0;
+    size_t high=GetNodeCount();
+
+    while (low<high) {
+      size_t middle=(low+high)/2;
+
+      if (nodes[middle].offset<offset) {
+        low=middle+1;
+      }
+      else {
+        high=middle;
+      }
+    }
+
+    if (low==GetNodeCount() ||
+        nodes[low].offset!=offset) {
+      return noNode;
+    }
+
+    return (uint32_t)low;
+  }
+
+  /**
+   * Return the index of the given object in the object table or noNode
+   */
+  uint32_t RouteGraph::GetObject(const ObjectFileRef& object) const
+  {
+    std::vector<ObjectFileRef>::const_iterator entry=std::lower_bound(objects.begin(),
+                                                                      objects.end(),
+                                                                      object);
+
+    if (entry==objects.end() ||
+        *entry!=object) {
+      return noNode;
+    }
+
+    return (uint32_t)(entry-objects.begin());
+  }
+
+  /**
+    Returns the (approximated) memory used by the graph.
+    */
+  size_t RouteGraph::GetMemorySize() const
+  {
+    size_t memory=sizeof(RouteGraph);
+
+    memory+=nodes.capacity()*sizeof(Node);
+    memory+=edges.capacity()*sizeof(Edge);
+    memory+=excludes.capacity()*sizeof(Exclude);
+    memory+=objects.capacity()*sizeof(ObjectFileRef);
+
+    return memory;
+  }
+
+  bool RouteGraph::Read(const std::string& filename)
+  {
+    FileScanner scanner;
+    uint32_t    nodeCount;
+    uint32_t    edgeCount;
+    uint32_t    excludeCount;
+    uint32_t    objectCount;
+
+    Clear();
+
+    if (!scanner.Open(filename,FileScanner::Sequential,true)) {
+      std::cerr << "Cannot open file '" << filename << "'" << std::endl;
+      return false;
+    }
+
+    scanner.Read(nodeCount);
+    scanner.Read(edgeCount);
+    scanner.Read(excludeCount);
+    scanner.Read(objectCount);
+
+    if (scanner.HasError()) {
+      std::cerr << "Error while reading header of '" << filename << "'" << std::endl;
+      return false;
+    }
+
+    objects.resize(objectCount);
+
+    for (uint32_t o=0; o<objectCount; o++) {
+      uint8_t    type;
+      FileOffset offset;
+
+      scanner.Read(type);
+      scanner.ReadFileOffset(offset);
+
+      objects[o].Set(offset,(RefType)type);
+    }
+
+    nodes.resize(nodeCount+1);
+
+    for (uint32_t n=0; n<=nodeCount; n++) {
+      scanner.ReadFileOffset(nodes[n].offset);
+      scanner.Read(nodes[n].firstEdge);
+      scanner.Read(nodes[n].firstExclude);
+      scanner.Read(nodes[n].lat);
+      scanner.Read(nodes[n].lon);
+    }
+
+    edges.resize(edgeCount);
+
+    for (uint32_t e=0; e<edgeCount; e++) {
+      scanner.Read(edges[e].target);
+      scanner.Read(edges[e].object);
+      scanner.Read(edges[e].distance);
+      scanner.Read(edges[e].type);
+      scanner.Read(edges[e].maxSpeed);
+      scanner.Read(edges[e].flags);
+    }
+
+    excludes.resize(excludeCount);
+
+    for (uint32_t e=0; e<excludeCount; e++) {
+      scanner.Read(excludes[e].sourceObject);
+      scanner.Read(excludes[e].targetPath);
+    }
+
+    if (scanner.HasError()) {
+      std::cerr << "Error while reading '" << filename << "'" << std::endl;
+      Clear();
+      return false;
+    }
+
+    // Check the indices, so that the router can access the arrays without checks
+    bool valid=nodes[0].firstEdge==0 &&
+               nodes[0].firstExclude==0 &&
+               nodes[nodeCount].firstEdge==edgeCount &&
+               nodes[nodeCount].firstExclude==excludeCount;
+
+    for (uint32_t n=0; valid && n<nodeCount; n++) {
+      valid=nodes[n].firstEdge<=nodes[n+1].firstEdge &&
+            nodes[n].firstExclude<=nodes[n+1].firstExclude &&
+            (n==0 || nodes[n-1].offset<nodes[n].offset);
+    }
+
+    for (uint32_t e=0; valid && e<edgeCount; e++) {
+      valid=edges[e].target<nodeCount &&
+            edges[e].object<objectCount;
+    }
+
+    for (uint32_t e=0; valid && e<excludeCount; e++) {
+      valid=excludes[e].sourceObject<objectCount;
+    }
+
+    if (!valid) {
+      std::cerr << "Inconsistent data in '" << filename << "'" << std::endl;
+      Clear();
+      return false;
+    }
+
+    return scanner.Close();
+  }
+
+  bool RouteGraph::Write(const std::string& filename) const
+  {
+    FileWriter writer;
+
+    if (!writer.Open(filename)) {
+      std::cerr << "Cannot create file '" << filename << "'" << std::endl;
+      return false;
+    }
+
+    writer.Write((uint32_t)GetNodeCount());
+    writer.Write((uint32_t)edges.size());
+    writer.Write((uint32_t)excludes.size());
+    writer.Write((uint32_t)objects.size());
+
+    for (std::vector<ObjectFileRef>::const_iterator object=objects.begin();
+         object!=objects.end();
+         ++object) {
+      writer.Write((uint8_t)object->GetType());
+      writer.WriteFileOffset(object->GetFileOffset());
+    }
+
+    for (std::vector<Node>::const_iterator node=nodes.begin();
+         node!=nodes.end();
+         ++node) {
+      writer.WriteFileOffset(node->offset);
+      writer.Write(node->firstEdge);
+      writer.Write(node->firstExclude);
+      writer.Write(node->lat);
+      writer.Write(node->lon);
+    }
+
+    for (std::vector<Edge>::const_iterator edge=edges.begin();
+         edge!=edges.end();
+         ++edge) {
+      writer.Write(edge->target);
+      writer.Write(edge->object);
+      writer.Write(edge->distance);
+      writer.Write(edge->type);
+      writer.Write(edge->maxSpeed);
+      writer.Write(edge->flags);
+    }
+
+    for (std::vector<Exclude>::const_iterator exclude=excludes.begin();
+         exclude!=excludes.end();
+         ++exclude) {
+      writer.Write(exclude->sourceObject);
+      writer.Write(exclude->targetPath);
+    }
+
+    return !writer.HasError() && writer.Close();
+  }
+}
@@ -43,11 +43,24 @@ namespace osmscout {
   }
 
 
+  /**
+    Returns the (approximated) memory used by the route node including
+    all allocated data.
+    */
+  size_t RouteNode::GetMemorySize() const
+  {
+    size_t memory=sizeof(RouteNode);
+
+    memory+=objects.capacity()*sizeof(ObjectFileRef);
+    memory+=paths.capacity()*sizeof(Path);
+    memory+=excludes.capacity()*sizeof(Exclude);
+
+    return memory;
+  }
+
   bool RouteNode::Read(FileScanner& scanner)
   {
-    uint32_t objectCount;
-    uint32_t pathCount;
-    uint32_t excludesCount;
+    uint32_t counts[3];
     uint32_t minLat;
     uint32_t minLon;
 
@@ -57,9 +70,12 @@ namespace osmscout {
 
     scanner.ReadNumber(id);
 
-    scanner.ReadNumber(objectCount);
-    scanner.ReadNumber(pathCount);
-    scanner.ReadNumber(excludesCount);
+    // object, path and exclude count
+    scanner.ReadNumbers(counts,3);
+
+    uint32_t objectCount=counts[0];
+    uint32_t pathCount=counts[1];
+    uint32_t excludesCount=counts[2];
 
     scanner.Read(minLat);
     scanner.Read(minLon);
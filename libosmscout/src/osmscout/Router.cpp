@@ -27,6 +27,7 @@
 
 #include <osmscout/system/Assert.h>
 
+#include <osmscout/util/File.h>
 #include <osmscout/util/Geometry.h>
 #include <osmscout/util/StopClock.h>
 
@@ -37,7 +38,11 @@ namespace osmscout {
   RouterParameter::RouterParameter()
   : wayIndexCacheSize(10000),
     wayCacheSize(0),
-    debugPerformance(false)
+    debugPerformance(false),
+    contractionHierarchy(false),
+    bidirectional(false),
+    compactRouteGraph(false),
+    matrixWorkerCount(0)
   {
     // no code
   }
@@ -52,11 +57,61 @@ namespace osmscout {
     this->wayCacheSize=wayCacheSize;
   }
 
+  void RouterParameter::SetCacheMemoryGovernor(const CacheMemoryGovernorRef& governor)
+  {
+    cacheMemoryGovernor=governor;
+  }
+
   void RouterParameter::SetDebugPerformance(bool debug)
   {
     debugPerformance=debug;
   }
 
+  /**
+   * Use the contraction hierarchy generated during import (for car routing
+   * only). The hierarchy is only used for routing profiles with the same costs
+   * as the profile used during import (see RoutingProfile::GetCostHash()),
+   * other profiles use the other search methods.
+   */
+  void RouterParameter::SetContractionHierarchy(bool contractionHierarchy)
+  {
+    this->contractionHierarchy=contractionHierarchy;
+  }
+
+  /**
+   * Use a bidirectional A* search, searching from the start and from the target
+   * at the same time. Requires the reverse route graph generated during import.
+   *
+   * If the contraction hierarchy is requested, too, the bidirectional search
+   * is used as fallback, if the hierarchy does not match the route graph.
+   */
+  void RouterParameter::SetBidirectional(bool bidirectional)
+  {
+    this->bidirectional=bidirectional;
+  }
+
+  /**
+   * Load the compact route graph generated during import into memory and use it
+   * instead of the route node data file for the A* search. Routes are the
+   * same as calculated on the route node data file.
+   *
+   * The contraction hierarchy and the bidirectional search take precedence,
+   * if requested, too.
+   */
+  void RouterParameter::SetCompactRouteGraph(bool compactRouteGraph)
+  {
+    this->compactRouteGraph=compactRouteGraph;
+  }
+
+  /**
+   * Number of workers (including the calling thread) used by
+   * Router::CalculateMatrix(). 0 means one worker per hardware thread.
+   */
+  void RouterParameter::SetMatrixWorkerCount(size_t workerCount)
+  {
+    this->matrixWorkerCount=workerCount;
+  }
+
   unsigned long RouterParameter::GetWayIndexCacheSize() const
   {
     return wayIndexCacheSize;
@@ -67,28 +122,326 @@ namespace osmscout {
     return wayCacheSize;
   }
 
+  CacheMemoryGovernorRef RouterParameter::GetCacheMemoryGovernor() const
+  {
+    return cacheMemoryGovernor;
+  }
+
   bool RouterParameter::IsDebugPerformance() const
   {
     return debugPerformance;
   }
 
+  bool RouterParameter::IsContractionHierarchy() const
+  {
+    return contractionHierarchy;
+  }
+
+  bool RouterParameter::IsBidirectional() const
+  {
+    return bidirectional;
+  }
+
+  bool RouterParameter::IsCompactRouteGraph() const
+  {
+    return compactRouteGraph;
+  }
+
+  size_t RouterParameter::GetMatrixWorkerCount() const
+  {
+    return matrixWorkerCount;
+  }
+
+  RouteMatrix::RouteMatrix()
+  : sourceCount(0),
+    targetCount(0)
+  {
+    // no code
+  }
+
+  /**
+   * Resize the matrix to the given number of sources and targets and mark all
+   * entries as unreachable.
+   */
+  void RouteMatrix::Initialize(size_t sourceCount,
+                               size_t targetCount)
+  {
+    this->sourceCount=sourceCount;
+    this->targetCount=targetCount;
+
+    costs.assign(sourceCount*targetCount,-1.0);
+    times.assign(sourceCount*targetCount,-1.0);
+  }
+
+  ReachableNodeVisitor::~ReachableNodeVisitor()
+  {
+    // no code
+  }
+
+  void ReachableAreaCollector::Clear()
+  {
+    nodes.clear();
+  }
+
+  bool ReachableAreaCollector::Visit(const ReachableNode& node)
+  {
+    nodes.push_back(node);
+
+    return true;
+  }
+
+  /**
+   * Return the area reached as the convex hull of the coordinates of all route
+   * nodes collected.
+   */
+  void ReachableAreaCollector::GetPolygon(std::vector<GeoCoord>& polygon) const
+  {
+    std::vector<GeoCoord> coords;
+
+    coords.reserve(nodes.size());
+
+    for (std::vector<ReachableNode>::const_iterator node=nodes.begin();
+         node!=nodes.end();
+         ++node) {
+      coords.push_back(GeoCoord(node->lat,node->lon));
+    }
+
+    GetConvexHull(coords,
+                  polygon);
+  }
+
   const char* const Router::FILENAME_INTERSECTIONS_DAT = "intersections.dat";
   const char* const Router::FILENAME_INTERSECTIONS_IDX = "intersections.idx";
 
   const char* const Router::FILENAME_FOOT_DAT          = "routefoot.dat";
   const char* const Router::FILENAME_FOOT_IDX          = "routefoot.idx";
+  const char* const Router::FILENAME_FOOT_REV_DAT      = "routefootrev.dat";
+  const char* const Router::FILENAME_FOOT_REV_IDX      = "routefootrev.idx";
 
   const char* const Router::FILENAME_BICYCLE_DAT       = "routebicycle.dat";
   const char* const Router::FILENAME_BICYCLE_IDX       = "routebicycle.idx";
+  const char* const Router::FILENAME_BICYCLE_REV_DAT   = "routebicyclerev.dat";
+  const char* const Router::FILENAME_BICYCLE_REV_IDX   = "routebicyclerev.idx";
 
   const char* const Router::FILENAME_CAR_DAT           = "routecar.dat";
   const char* const Router::FILENAME_CAR_IDX           = "routecar.idx";
+  const char* const Router::FILENAME_CAR_REV_DAT       = "routecarrev.dat";
+  const char* const Router::FILENAME_CAR_REV_IDX       = "routecarrev.idx";
+  const char* const Router::FILENAME_CAR_CH_DAT        = "routecarch.dat";
+
+  const char* const Router::FILENAME_FOOT_GRAPH_DAT    = "routefootgraph.dat";
+  const char* const Router::FILENAME_BICYCLE_GRAPH_DAT = "routebicyclegraph.dat";
+  const char* const Router::FILENAME_CAR_GRAPH_DAT     = "routecargraph.dat";
+
+  Router::RNodeIndexMap::RNodeIndexMap()
+  : mask(0),
+    size(0),
+    generation(1)
+  {
+    Rehash(1024);
+  }
+
+  void Router::RNodeIndexMap::Rehash(size_t capacity)
+  {
+    std::vector<Slot> oldSlots;
+    Slot              empty;
+
+    empty.offset=0;
+    empty.index=0;
+    empty.generation=0;
+
+    oldSlots.swap(slots);
+    slots.assign(capacity,empty);
+    mask=capacity-1;
+    size=0;
+
+    for (std::vector<Slot>::const_iterator slot=oldSlots.begin();
+         slot!=oldSlots.end();
+         ++slot) {
+      if (slot->generation==generation) {
+        Set(slot->offset,
+            slot->index);
+      }
+    }
+  }
+
+  void Router::RNodeIndexMap::Clear()
+  {
+    size=0;
+    generation++;
+
+    // After a wrap around old slots could look valid again
+    if (generation==0) {
+      for (std::vector<Slot>::iterator slot=slots.begin();
+           slot!=slots.end();
+           ++slot) {
+        slot->generation=0;
+      }
+
+      generation=1;
+    }
+  }
+
+  void Router::RNodeIndexMap::Set(FileOffset offset,
+                                  uint32_t index)
+  {
+    // Keep the load factor below 1/2
+    if ((size+1)*2>slots.size()) {
+      Rehash(slots.size()*2);
+    }
+
+    size_t slot=GetSlot(offset);
+
+    while (slots[slot].generation==generation) {
+      if (slots[slot].offset==offset) {
+        slots[slot].index=index;
+        return;
+      }
+
+      slot=(slot+1) & mask;
+    }
+
+    slots[slot].offset=offset;
+    slots[slot].index=index;
+    slots[slot].generation=generation;
+
+    size++;
+  }
+
+  void Router::RoutingState::Clear()
+  {
+    nodes.clear();
+    nodeMap.Clear();
+    openList.Clear();
+  }
+
+  uint32_t Router::RoutingState::AddNode(const RNode& node)
+  {
+    uint32_t index=(uint32_t)nodes.size();
+
+    nodes.push_back(node);
+    nodeMap.Set(node.nodeOffset,
+                index);
+
+    return index;
+  }
+
+  void Router::ReverseRoutingState::Clear()
+  {
+    nodes.clear();
+    nodeMap.Clear();
+    openList.Clear();
+  }
+
+  uint32_t Router::ReverseRoutingState::AddNode(const ReverseRNode& node)
+  {
+    uint32_t index=(uint32_t)nodes.size();
+
+    nodes.push_back(node);
+    nodeMap.Set(node.nodeOffset,
+                index);
+
+    return index;
+  }
+
+  bool Router::CHSearch::Update(uint32_t node,
+                                double cost,
+                                uint32_t parent,
+                                uint32_t edge,
+                                std::vector<uint32_t>& touched)
+  {
+    if (costs[node]<0.0) {
+      touched.push_back(node);
+    }
+    else if (cost>=costs[node] ||
+             !heap.Contains(node)) {
+      return false;
+    }
+
+    costs[node]=cost;
+    parents[node]=parent;
+    edges[node]=edge;
+
+    if (heap.Contains(node)) {
+      heap.DecreaseKey(node,cost);
+    }
+    else {
+      heap.Push(node,cost);
+    }
+
+    return true;
+  }
+
+  void Router::CHState::Initialize(size_t nodeCount)
+  {
+    forward.costs.assign(nodeCount,-1.0);
+    forward.parents.assign(nodeCount,ContractionHierarchy::noNode);
+    forward.edges.assign(nodeCount,ContractionHierarchy::noNode);
+    forward.heap.Clear();
+
+    backward.costs.assign(nodeCount,-1.0);
+    backward.parents.assign(nodeCount,ContractionHierarchy::noNode);
+    backward.edges.assign(nodeCount,ContractionHierarchy::noNode);
+    backward.heap.Clear();
+
+    touched.clear();
+
+    startNodes[0]=ContractionHierarchy::noNode;
+    startNodes[1]=ContractionHierarchy::noNode;
+  }
+
+  void Router::CHState::Clear()
+  {
+    for (std::vector<uint32_t>::const_iterator node=touched.begin();
+         node!=touched.end();
+         ++node) {
+      forward.costs[*node]=-1.0;
+      backward.costs[*node]=-1.0;
+    }
+
+    touched.clear();
+    forward.heap.Clear();
+    backward.heap.Clear();
+
+    startNodes[0]=ContractionHierarchy::noNode;
+    startNodes[1]=ContractionHierarchy::noNode;
+  }
+
+  const uint8_t Router::GraphState::reached;
+  const uint8_t Router::GraphState::closed;
+  const uint8_t Router::GraphState::noAccess;
+
+  void Router::GraphState::Initialize(size_t nodeCount)
+  {
+    costs.assign(nodeCount,0.0);
+    parents.assign(nodeCount,RouteGraph::noNode);
+    objects.assign(nodeCount,RouteGraph::noNode);
+    flags.assign(nodeCount,0);
+    touched.clear();
+    openList.Clear();
+  }
+
+  void Router::GraphState::Clear()
+  {
+    for (std::vector<uint32_t>::const_iterator node=touched.begin();
+         node!=touched.end();
+         ++node) {
+      flags[*node]=0;
+    }
+
+    touched.clear();
+    openList.Clear();
+  }
 
   Router::Router(const RouterParameter& parameter,
                  Vehicle vehicle)
    : vehicle(vehicle),
      isOpen(false),
      debugPerformance(parameter.IsDebugPerformance()),
+     useContractionHierarchy(parameter.IsContractionHierarchy()),
+     useBidirectional(parameter.IsBidirectional()),
+     useCompactRouteGraph(parameter.IsCompactRouteGraph()),
+     matrixWorkerCount(parameter.GetMatrixWorkerCount()),
      areaDataFile("areas.dat",
                   parameter.GetWayCacheSize()),
      wayDataFile("ways.dat",
@@ -97,13 +450,24 @@ namespace osmscout {
                        GetIndexFilename(vehicle),
                        0,
                        6000),
+     reverseRouteNodeDataFile(GetReverseDataFilename(vehicle),
+                              GetReverseIndexFilename(vehicle),
+                              0,
+                              6000),
      junctionDataFile(Router::FILENAME_INTERSECTIONS_DAT,
                       Router::FILENAME_INTERSECTIONS_IDX,
                       0,
                       6000),
-     typeConfig(NULL)
+     typeConfig(NULL),
+     threadPool(NULL)
   {
-    // no code
+    if (parameter.GetCacheMemoryGovernor().Valid()) {
+      areaDataFile.SetCacheMemoryGovernor(parameter.GetCacheMemoryGovernor());
+      wayDataFile.SetCacheMemoryGovernor(parameter.GetCacheMemoryGovernor());
+      routeNodeDataFile.SetCacheMemoryGovernor(parameter.GetCacheMemoryGovernor());
+      reverseRouteNodeDataFile.SetCacheMemoryGovernor(parameter.GetCacheMemoryGovernor());
+      junctionDataFile.SetCacheMemoryGovernor(parameter.GetCacheMemoryGovernor());
+    }
   }
 
   Router::~Router()
@@ -112,6 +476,7 @@ namespace osmscout {
       Close();
     }
 
+    delete threadPool;
     delete typeConfig;
   }
 
@@ -147,6 +512,105 @@ namespace osmscout {
     return ""; // make the compiler happy
   }
 
+  std::string Router::GetReverseDataFilename(Vehicle vehicle) const
+  {
+    switch (vehicle) {
+    case vehicleFoot:
+      return FILENAME_FOOT_REV_DAT;
+    case vehicleBicycle:
+      return FILENAME_BICYCLE_REV_DAT;
+    case vehicleCar:
+      return FILENAME_CAR_REV_DAT;
+    default:
+      assert(false);
+    }
+
+    return ""; // make the compiler happy
+  }
+
+  std::string Router::GetReverseIndexFilename(Vehicle vehicle) const
+  {
+    switch (vehicle) {
+    case vehicleFoot:
+      return FILENAME_FOOT_REV_IDX;
+    case vehicleBicycle:
+      return FILENAME_BICYCLE_REV_IDX;
+    case vehicleCar:
+      return FILENAME_CAR_REV_IDX;
+    default:
+      assert(false);
+    }
+
+    return ""; // make the compiler happy
+  }
+
+  std::string Router::GetGraphFilename(Vehicle vehicle) const
+  {
+    switch (vehicle) {
+    case vehicleFoot:
+      return FILENAME_FOOT_GRAPH_DAT;
+    case vehicleBicycle:
+      return FILENAME_BICYCLE_GRAPH_DAT;
+    case vehicleCar:
+      return FILENAME_CAR_GRAPH_DAT;
+    default:
+      assert(false);
+    }
+
+    return ""; // make the compiler happy
+  }
+
+  /**
+   * Return the number of route nodes in the route node data file
+   */
+  bool Router::GetRouteNodeCount(const std::string& path,
+                                 uint32_t& routeNodeCount) const
+  {
+    FileScanner scanner;
+
+    if (!scanner.Open(AppendFileToDir(path,
+                                      GetDataFilename(vehicle)),
+                      FileScanner::Sequential,
+                      false)) {
+      return false;
+    }
+
+    if (!scanner.Read(routeNodeCount)) {
+      scanner.Close();
+      return false;
+    }
+
+    return scanner.Close();
+  }
+
+  /**
+   * Check, if the loaded contraction hierarchy was generated for the current
+   * route graph (it must contain exactly the route nodes of the route graph).
+   */
+  bool Router::IsContractionHierarchyValid(const std::string& path) const
+  {
+    uint32_t routeNodeCount;
+
+    return GetRouteNodeCount(path,routeNodeCount) &&
+           routeNodeCount==contractionHierarchy->GetNodeCount();
+  }
+
+  /**
+   * Return true, if the contraction hierarchy is loaded and was calculated
+   * for a routing profile with the same costs as the given profile.
+   */
+  bool Router::CanUseContractionHierarchy(const RoutingProfile& profile) const
+  {
+    if (contractionHierarchy.Invalid()) {
+      return false;
+    }
+
+    uint64_t profileHash=profile.GetCostHash();
+
+    return profileHash!=0 &&
+           profileHash==contractionHierarchy->GetProfileHash();
+  }
+
   Vehicle Router::GetVehicle() const
   {
     return vehicle;
@@ -192,6 +656,82 @@ namespace osmscout {
       return false;
     }
 
+    if (useBidirectional) {
+      if (!reverseRouteNodeDataFile.Open(path,
+                                         FileScanner::FastRandom,true,
+                                         FileScanner::FastRandom,true)) {
+        std::cerr << "Cannot open '" << GetReverseDataFilename(vehicle) << "'!" << std::endl;
+        routeNodeDataFile.Close();
+        delete typeConfig;
+        typeConfig=NULL;
+        return false;
+      }
+    }
+
+    if (useContractionHierarchy) {
+      if (vehicle!=vehicleCar) {
+        std::cerr << "Contraction hierarchy is only available for car routing!" << std::endl;
+        routeNodeDataFile.Close();
+        if (useBidirectional) {
+          reverseRouteNodeDataFile.Close();
+        }
+        delete typeConfig;
+        typeConfig=NULL;
+        return false;
+      }
+
+      contractionHierarchy=new ContractionHierarchy();
+
+      if (!contractionHierarchy->Read(AppendFileToDir(path,
+                                                      FILENAME_CAR_CH_DAT))) {
+        std::cerr << "Cannot open '" << FILENAME_CAR_CH_DAT << "'!" << std::endl;
+        contractionHierarchy=NULL;
+      }
+      else if (!IsContractionHierarchyValid(path)) {
+        std::cerr << "'" << FILENAME_CAR_CH_DAT << "' does not match the route graph!" << std::endl;
+        contractionHierarchy=NULL;
+      }
+
+      if (contractionHierarchy.Invalid()) {
+        if (!useBidirectional) {
+          routeNodeDataFile.Close();
+          delete typeConfig;
+          typeConfig=NULL;
+          return false;
+        }
+
+        std::cerr << "Falling back to bidirectional search" << std::endl;
+      }
+    }
+
+    if (contractionHierarchy.Valid()) {
+      chState.Initialize(contractionHierarchy->GetNodeCount());
+    }
+
+    if (useCompactRouteGraph) {
+      uint32_t routeNodeCount;
+
+      routeGraph=new RouteGraph();
+
+      if (!routeGraph->Read(AppendFileToDir(path,
+                                            GetGraphFilename(vehicle)))) {
+        std::cerr << "Cannot open '" << GetGraphFilename(vehicle) << "'!" << std::endl;
+        routeGraph=NULL;
+      }
+      else if (!GetRouteNodeCount(path,routeNodeCount) ||
+               routeNodeCount!=routeGraph->GetNodeCount()) {
+        std::cerr << "'" << GetGraphFilename(vehicle) << "' does not match the route graph!" << std::endl;
+        routeGraph=NULL;
+      }
+
+      if (routeGraph.Valid()) {
+        graphState.Initialize(routeGraph->GetNodeCount());
+      }
+      else {
+        std::cerr << "Falling back to the route node data file" << std::endl;
+      }
+    }
+
     isOpen=true;
 
     return true;
@@ -206,9 +746,16 @@ namespace osmscout {
   void Router::Close()
   {
     routeNodeDataFile.Close();
+
+    if (useBidirectional) {
+      reverseRouteNodeDataFile.Close();
+    }
     wayDataFile.Close();
     areaDataFile.Close();
 
+    contractionHierarchy=NULL;
+    routeGraph=NULL;
+
     isOpen=false;
   }
 
@@ -266,22 +813,18 @@ namespace osmscout {
     }
   }
 
-  void Router::ResolveRNodeChainToList(const RNodeRef& end,
-                                       const CloseMap& closeMap,
-                                       std::list<RNodeRef>& nodes)
+  void Router::ResolveRNodeChainToList(uint32_t end,
+                                       const RoutingState& state,
+                                       std::vector<RNode>& nodes)
   {
-    CloseMap::const_iterator current=closeMap.find(end->nodeOffset);
-
-    while (current->second->prev!=0) {
-      CloseMap::const_iterator prev=closeMap.find(current->second->prev);
+    uint32_t current=end;
 
-      nodes.push_back(current->second);
+    while (current!=noRNode) {
+      nodes.push_back(state.nodes[current]);
 
-      current=prev;
+      current=state.nodes[current].prev;
     }
 
-    nodes.push_back(current->second);
-
     std::reverse(nodes.begin(),nodes.end());
   }
 
@@ -387,7 +930,7 @@ namespace osmscout {
   }
 
   bool Router::ResolveRNodesToRouteData(const RoutingProfile& profile,
-                                        const std::list<RNodeRef>& nodes,
+                                        const std::vector<RNode>& nodes,
                                         const ObjectFileRef& startObject,
                                         size_t startNodeIndex,
                                         const ObjectFileRef& targetObject,
@@ -408,11 +951,9 @@ namespace osmscout {
 
     // Collect all route node file offsets on the path and also
     // all area/way file offsets on the path
-    for (std::list<RNodeRef>::const_iterator n=nodes.begin();
-        n!=nodes.end();
-        n++) {
-      RNodeRef node(*n);
-
+    for (std::vector<RNode>::const_iterator node=nodes.begin();
+        node!=nodes.end();
+        node++) {
       routeNodeOffsets.insert(node->nodeOffset);
 
       if (node->object.Valid()) {
@@ -505,7 +1046,7 @@ namespace osmscout {
       return true;
     }
 
-    RouteNodeRef initialNode=routeNodeMap.find(nodes.front()->nodeOffset)->second;
+    RouteNodeRef initialNode=routeNodeMap.find(nodes.front().nodeOffset)->second;
 
     //
     // Add The path from the start node to the first routing node
@@ -533,14 +1074,14 @@ namespace osmscout {
     // Walk the routing path from route node to the next route node
     // and build entries.
     //
-    for (std::list<RNodeRef>::const_iterator n=nodes.begin();
+    for (std::vector<RNode>::const_iterator n=nodes.begin();
         n!=nodes.end();
         n++) {
-      std::list<RNodeRef>::const_iterator nn=n;
+      std::vector<RNode>::const_iterator nn=n;
 
       nn++;
 
-      RouteNodeRef node=routeNodeMap.find((*n)->nodeOffset)->second;
+      RouteNodeRef node=routeNodeMap.find(n->nodeOffset)->second;
 
       //
       // The path from the last routing node to the target node and the
@@ -593,18 +1134,18 @@ namespace osmscout {
         break;
       }
 
-      RouteNodeRef nextNode=routeNodeMap.find((*nn)->nodeOffset)->second;
+      RouteNodeRef nextNode=routeNodeMap.find(nn->nodeOffset)->second;
 
-      if ((*nn)->object.GetType()==refArea) {
-        OSMSCOUT_HASHMAP<FileOffset,AreaRef>::const_iterator entry=areaMap.find((*nn)->object.GetFileOffset());
+      if (nn->object.GetType()==refArea) {
+        OSMSCOUT_HASHMAP<FileOffset,AreaRef>::const_iterator entry=areaMap.find(nn->object.GetFileOffset());
 
         assert(entry!=areaMap.end());
 
         ids=&entry->second->rings.front().ids;
         oneway=false;
       }
-      else if ((*nn)->object.GetType()==refWay) {
-        OSMSCOUT_HASHMAP<FileOffset,WayRef>::const_iterator entry=wayMap.find((*nn)->object.GetFileOffset());
+      else if (nn->object.GetType()==refWay) {
+        OSMSCOUT_HASHMAP<FileOffset,WayRef>::const_iterator entry=wayMap.find(nn->object.GetFileOffset());
 
         assert(entry!=wayMap.end());
 
@@ -634,7 +1175,7 @@ namespace osmscout {
       AddNodes(route,
                (*ids)[currentNodeIndex],
                currentNodeIndex,
-               (*nn)->object,
+               nn->object,
                ids->size(),
                oneway,
                nextNodeIndex);
@@ -705,9 +1246,13 @@ namespace osmscout {
                              double& targetLat,
                              RouteNodeRef& forwardRouteNode,
                              RouteNodeRef& backwardRouteNode,
-                             RNodeRef& forwardRNode,
-                             RNodeRef& backwardRNode)
+                             RoutingState& state,
+                             uint32_t& forwardRNode,
+                             uint32_t& backwardRNode)
   {
+    forwardRNode=noRNode;
+    backwardRNode=noRNode;
+
     if (object.GetType()==refArea) {
       // TODO:
       return false;
@@ -757,22 +1302,23 @@ namespace osmscout {
           std::cerr << "Cannot get offset of startForwardRouteNode" << std::endl;
         }
 
-        RNodeRef node=new RNode(forwardOffset,
-                                object);
+        RNode node(forwardOffset,
+                   object,
+                   noRNode);
 
-        node->currentCost=profile.GetCosts(way,
-                                           GetSphericalDistance(startLon,
+        node.currentCost=profile.GetCosts(way,
+                                          GetSphericalDistance(startLon,
+                                                               startLat,
+                                                               way->nodes[forwardNodePos].GetLon(),
+                                                               way->nodes[forwardNodePos].GetLat()));
+        node.estimateCost=profile.GetCosts(GetSphericalDistance(startLon,
                                                                 startLat,
-                                                                way->nodes[forwardNodePos].GetLon(),
-                                                                way->nodes[forwardNodePos].GetLat()));
-        node->estimateCost=profile.GetCosts(GetSphericalDistance(startLon,
-                                                                 startLat,
-                                                                 targetLon,
-                                                                 targetLat));
+                                                                targetLon,
+                                                                targetLat));
 
-        node->overallCost=node->currentCost+node->estimateCost;
+        node.overallCost=node.currentCost+node.estimateCost;
 
-        forwardRNode=node;
+        forwardRNode=state.AddNode(node);
       }
 
       if (backwardRouteNode.Valid()) {
@@ -781,22 +1327,23 @@ namespace osmscout {
           std::cerr << "Cannot get offset of startBackwardRouteNode" << std::endl;
         }
 
-        RNodeRef node=new RNode(backwardOffset,
-                                object);
+        RNode node(backwardOffset,
+                   object,
+                   noRNode);
 
-        node->currentCost=profile.GetCosts(way,
-                                           GetSphericalDistance(startLon,
+        node.currentCost=profile.GetCosts(way,
+                                          GetSphericalDistance(startLon,
+                                                               startLat,
+                                                               way->nodes[backwardNodePos].GetLon(),
+                                                               way->nodes[backwardNodePos].GetLat()));
+        node.estimateCost=profile.GetCosts(GetSphericalDistance(startLon,
                                                                 startLat,
-                                                                way->nodes[backwardNodePos].GetLon(),
-                                                                way->nodes[backwardNodePos].GetLat()));
-        node->estimateCost=profile.GetCosts(GetSphericalDistance(startLon,
-                                                                 startLat,
-                                                                 targetLon,
-                                                                 targetLat));
+                                                                targetLon,
+                                                                targetLat));
 
-        node->overallCost=node->currentCost+node->estimateCost;
+        node.overallCost=node.currentCost+node.estimateCost;
 
-        backwardRNode=node;
+        backwardRNode=state.AddNode(node);
       }
 
       return true;
@@ -877,43 +1424,84 @@ namespace osmscout {
   }
 
 
-  bool Router::CalculateRoute(const RoutingProfile& profile,
-                              const ObjectFileRef& startObject,
-                              size_t startNodeIndex,
-                              const ObjectFileRef& targetObject,
-                              size_t targetNodeIndex,
-                              RouteData& route)
+  /**
+   * Return the object (as index into the objects of the route node) used to
+   * arrive at the given node by the forward search and if we had access.
+   */
+  void Router::GetCHArrival(uint32_t node,
+                            uint32_t& object,
+                            bool& access) const
   {
-    RouteNodeRef             startForwardRouteNode;
-    RouteNodeRef             startBackwardRouteNode;
-    RNodeRef                 startForwardNode;
-    RNodeRef                 startBackwardNode;
+    uint32_t edge=chState.forward.edges[node];
 
-    double                   targetLon=0.0L,targetLat=0.0L;
+    if (edge!=ContractionHierarchy::noNode) {
+      object=contractionHierarchy->GetEdge(edge).targetObject;
+      access=contractionHierarchy->GetEdge(edge).HasAccess();
+      return;
+    }
 
-    RouteNodeRef             targetForwardRouteNode;
-    RouteNodeRef             targetBackwardRouteNode;
+    object=ContractionHierarchy::noNode;
+    access=true;
 
-    // Sorted list (smallest cost first) of ways to check (we are using a std::set)
-    OpenList                 openList;
-    // Map routing nodes by id
-    OpenMap                  openMap;
-    CloseMap                 closeMap;
+    for (size_t i=0; i<2; i++) {
+      if (chState.startNodes[i]==node) {
+        object=chState.startObjects[i];
+      }
+    }
+  }
 
-    size_t                   nodesLoadedCount=0;
-    size_t                   nodesIgnoredCount=0;
-    size_t                   maxOpenList=0;
-    size_t                   maxCloseMap=0;
+  /**
+   * Return the path (as index into the paths of the route node) used to
+   * leave the given node by the backward search.
+   */
+  uint32_t Router::GetCHDeparture(uint32_t node) const
+  {
+    uint32_t edge=chState.backward.edges[node];
 
-    route.Clear();
+    if (edge!=ContractionHierarchy::noNode) {
+      return contractionHierarchy->GetEdge(edge).sourcePath;
+    }
 
-#if defined(OSMSCOUT_HASHMAP_HAS_RESERVE)
-    openMap.reserve(10000);
-    closeMap.reserve(300000);
-#endif
+    return ContractionHierarchy::noNode;
+  }
 
-    if (!GetTargetNodes(targetObject,
-                        targetNodeIndex,
+  /**
+   * Calculate the route using a bidirectional Dijkstra on the contraction
+   * hierarchy, both directions only following edges upwards the hierarchy.
+   * The resulting shortcuts get unpacked into the original route node paths,
+   * so the result is the same RouteData as for the A* search.
+   */
+  bool Router::CalculateRouteCH(const RoutingProfile& profile,
+                                const ObjectFileRef& startObject,
+                                size_t startNodeIndex,
+                                const ObjectFileRef& targetObject,
+                                size_t targetNodeIndex,
+                                RouteData& route)
+  {
+    const ContractionHierarchy& hierarchy=*contractionHierarchy;
+    CHState&                    state=chState;
+
+    RouteNodeRef                startForwardRouteNode;
+    RouteNodeRef                startBackwardRouteNode;
+    uint32_t                    startForwardNode;
+    uint32_t                    startBackwardNode;
+
+    double                      targetLon=0.0L,targetLat=0.0L;
+
+    RouteNodeRef                targetForwardRouteNode;
+    RouteNodeRef                targetBackwardRouteNode;
+    uint32_t                    targetForwardNode;
+    uint32_t                    targetBackwardNode;
+
+    size_t                      nodesSettledCount=0;
+    size_t                      edgesRelaxedCount=0;
+
+    route.Clear();
+    routingState.Clear();
+    state.Clear();
+
+    if (!GetTargetNodes(targetObject,
+                        targetNodeIndex,
                         targetLon,
                         targetLat,
                         targetForwardRouteNode,
@@ -921,6 +1509,22 @@ namespace osmscout {
       return false;
     }
 
+    // Only used to get the costs between the target position and the target route nodes,
+    // which are the same as for leaving the target position
+    if (!GetStartNodes(profile,
+                       targetObject,
+                       targetNodeIndex,
+                       targetLon,
+                       targetLat,
+                       targetForwardRouteNode,
+                       targetBackwardRouteNode,
+                       routingState,
+                       targetForwardNode,
+                       targetBackwardNode)) {
+      return false;
+    }
+
+    // Only used to get the costs from the start position to the start route nodes
     if (!GetStartNodes(profile,
                        startObject,
                        startNodeIndex,
@@ -928,275 +1532,2477 @@ namespace osmscout {
                        targetLat,
                        startForwardRouteNode,
                        startBackwardRouteNode,
+                       routingState,
                        startForwardNode,
                        startBackwardNode)) {
       return false;
     }
 
-    if (startForwardNode.Valid()) {
-      std::pair<OpenListRef,bool> result=openList.insert(startForwardNode);
-      openMap[startForwardNode->nodeOffset]=result.first;
-    }
+    uint32_t     startRNodes[2]={startForwardNode,startBackwardNode};
+    RouteNodeRef startRouteNodes[2]={startForwardRouteNode,startBackwardRouteNode};
 
-    if (startBackwardNode.Valid()) {
-      std::pair<OpenListRef,bool> result=openList.insert(startBackwardNode);
-      openMap[startBackwardNode->nodeOffset]=result.first;
-    }
+    for (size_t i=0; i<2; i++) {
+      if (startRNodes[i]==noRNode) {
+        continue;
+      }
 
-    StopClock    clock;
-    RNodeRef     current;
-    RouteNodeRef currentRouteNode;
+      const RNode& rnode=routingState.nodes[startRNodes[i]];
+      uint32_t     node=hierarchy.GetNode(rnode.nodeOffset);
 
-    do {
-      //
-      // Take entry from open list with lowest cost
-      //
+      if (node==ContractionHierarchy::noNode) {
+        std::cerr << "Start route node " << rnode.nodeOffset << " is not part of the contraction hierarchy" << std::endl;
+        return false;
+      }
 
-      current=*openList.begin();
+      std::vector<ObjectFileRef>::const_iterator object=std::find(startRouteNodes[i]->objects.begin(),
+                                                                  startRouteNodes[i]->objects.end(),
+                                                                  startObject);
 
-      openMap.erase(current->nodeOffset);
-      openList.erase(openList.begin());
+      state.startNodes[i]=node;
+      state.startObjects[i]=object!=startRouteNodes[i]->objects.end() ? (uint32_t)(object-startRouteNodes[i]->objects.begin()) : ContractionHierarchy::noNode;
 
-      if (!routeNodeDataFile.GetByOffset(current->nodeOffset,
-                                         currentRouteNode)) {
-        std::cerr << "Cannot load route node with id " << current->nodeOffset << std::endl;
-        return false;
+      state.forward.Update(node,
+                           rnode.currentCost,
+                           ContractionHierarchy::noNode,
+                           ContractionHierarchy::noNode,
+                           state.touched);
+    }
+
+    uint32_t targetRNodes[2]={targetForwardNode,targetBackwardNode};
+
+    for (size_t i=0; i<2; i++) {
+      if (targetRNodes[i]==noRNode) {
+        continue;
       }
 
-      nodesLoadedCount++;
+      const RNode& rnode=routingState.nodes[targetRNodes[i]];
+      uint32_t     node=hierarchy.GetNode(rnode.nodeOffset);
 
-      // Get potential follower in the current way
+      if (node==ContractionHierarchy::noNode) {
+        std::cerr << "Target route node " << rnode.nodeOffset << " is not part of the contraction hierarchy" << std::endl;
+        return false;
+      }
 
-#if defined(DEBUG_ROUTING)
-      std::cout << "Analysing follower of node " << currentRouteNode->GetFileOffset();
-      std::cout << " (" << current->object.GetTypeName() << " " << current->object.GetFileOffset() << "["  << currentRouteNode->GetId() << "]" << ")";
-      std::cout << " " << current->currentCost << " " << current->estimateCost << " " << current->overallCost << std::endl;
-#endif
-      size_t i=0;
-      for (std::vector<osmscout::RouteNode::Path>::const_iterator path=currentRouteNode->paths.begin();
-           path!=currentRouteNode->paths.end();
-           ++path,
-           ++i) {
-        if (path->offset==current->prev) {
-#if defined(DEBUG_ROUTING)
-          std::cout << "  Skipping route";
-          std::cout << " to " << path->offset;
-          std::cout << " (" << currentRouteNode->objects[path->objectIndex].GetTypeName() << " " << currentRouteNode->objects[path->objectIndex].GetFileOffset() << ")";
-          std::cout << " => back to the last node visited" << std::endl;
-#endif
-          nodesIgnoredCount++;
-          continue;
-        }
+      state.backward.Update(node,
+                            rnode.currentCost,
+                            ContractionHierarchy::noNode,
+                            ContractionHierarchy::noNode,
+                            state.touched);
+    }
 
-        if (!current->access &&
-            path->HasAccess()) {
-#if defined(DEBUG_ROUTING)
-          std::cout << "  Skipping route";
-          std::cout << " to " << path->offset;
-          std::cout << " (" << currentRouteNode->objects[path->objectIndex].GetTypeName() << " " << currentRouteNode->objects[path->objectIndex].GetFileOffset() << ")";
-          std::cout << " => moving from non-accessible way back to accessible way" << std::endl;
-#endif
-          nodesIgnoredCount++;
-          continue;
-        }
+    StopClock clock;
+    double    bestCosts=-1.0;
+    uint32_t  meetingNode=ContractionHierarchy::noNode;
 
-        if (!profile.CanUse(*currentRouteNode,i)) {
-#if defined(DEBUG_ROUTING)
-          std::cout << "  Skipping route";
-          std::cout << " to " << path->offset;
-          std::cout << " (" << currentRouteNode->objects[path->objectIndex].GetTypeName() << " " << currentRouteNode->objects[path->objectIndex].GetFileOffset() << ")";
-          std::cout << " => Cannot be used"<< std::endl;
-#endif
-          nodesIgnoredCount++;
-          continue;
-        }
+    while (true) {
+      bool forwardActive=!state.forward.heap.IsEmpty() &&
+                         (bestCosts<0.0 || state.forward.heap.GetTopKey()<bestCosts);
+      bool backwardActive=!state.backward.heap.IsEmpty() &&
+                          (bestCosts<0.0 || state.backward.heap.GetTopKey()<bestCosts);
 
-        if (closeMap.find(path->offset)!=closeMap.end()) {
-#if defined(DEBUG_ROUTING)
-          std::cout << "  Skipping route";
-          std::cout << " to " << path->offset;
-          std::cout << " (" << currentRouteNode->objects[path->objectIndex].GetTypeName() << " " << currentRouteNode->objects[path->objectIndex].GetFileOffset() << ")";
-          std::cout << " => already calculated" << std::endl;
-#endif
-          continue;
+      if (!forwardActive &&
+          !backwardActive) {
+        break;
+      }
+
+      bool      forward=forwardActive &&
+                        (!backwardActive || state.forward.heap.GetTopKey()<=state.backward.heap.GetTopKey());
+      CHSearch& search=forward ? state.forward : state.backward;
+      CHSearch& other=forward ? state.backward : state.forward;
+      uint32_t  node=search.heap.Pop();
+      double    costs=search.costs[node];
+      uint32_t  arrivalObject;
+      bool      arrivalAccess;
+      uint32_t  departurePath;
+
+      nodesSettledCount++;
+
+      GetCHArrival(node,
+                   arrivalObject,
+                   arrivalAccess);
+      departurePath=GetCHDeparture(node);
+
+      if (other.IsReached(node) &&
+          hierarchy.CanTurn(node,
+                            arrivalObject,
+                            arrivalAccess,
+                            departurePath)) {
+        double meetingCosts=state.forward.costs[node]+state.backward.costs[node];
+
+        if (bestCosts<0.0 ||
+            meetingCosts<bestCosts) {
+          bestCosts=meetingCosts;
+          meetingNode=node;
         }
+      }
 
-        if (!currentRouteNode->excludes.empty()) {
-          bool canTurnedInto=true;
-          for (size_t e=0; e<currentRouteNode->excludes.size(); e++) {
-            if (currentRouteNode->excludes[e].source==current->object &&
-                currentRouteNode->excludes[e].targetIndex==i) {
-#if defined(DEBUG_ROUTING)
-              std::cout << "  Skipping route";
-              std::cout << " to " << path->offset;
-              std::cout << " (" << currentRouteNode->objects[path->objectIndex].GetTypeName() << " " << currentRouteNode->objects[path->objectIndex].GetFileOffset() << ")";
-              std::cout << " => turn not allowed" << std::endl;
-#endif
-              canTurnedInto=false;
-              break;
-            }
+      for (uint32_t e=hierarchy.GetEdgesBegin(node);
+           e<hierarchy.GetEdgesEnd(node);
+           e++) {
+        const ContractionHierarchy::Edge& edge=hierarchy.GetEdge(e);
+
+        if (forward) {
+          if (!edge.IsForward() ||
+              !hierarchy.CanTurn(node,
+                                 arrivalObject,
+                                 arrivalAccess,
+                                 edge.sourcePath)) {
+            continue;
           }
-
-          if (!canTurnedInto) {
-            nodesIgnoredCount++;
+        }
+        else {
+          if (!edge.IsBackward() ||
+              !hierarchy.CanTurn(node,
+                                 edge.targetObject,
+                                 edge.HasAccess(),
+                                 departurePath)) {
             continue;
           }
         }
 
-        double currentCost=current->currentCost+
-                           profile.GetCosts(*currentRouteNode,i);
+        edgesRelaxedCount++;
 
-        OpenMap::iterator openEntry=openMap.find(path->offset);
+        search.Update(edge.node,
+                      costs+edge.cost,
+                      node,
+                      e,
+                      state.touched);
+      }
+    }
 
-        // Check, if we already have a cheaper path to the new node. If yes, do not put the new path
-        // into the open list
-        if (openEntry!=openMap.end() &&
-            (*openEntry->second)->currentCost<=currentCost) {
-#if defined(DEBUG_ROUTING)
-          std::cout << "  Skipping route";
-          std::cout << " to " << path->offset;
-          std::cout << " (" << currentRouteNode->objects[path->objectIndex].GetTypeName() << " " << currentRouteNode->objects[path->objectIndex].GetFileOffset() << ")";
-          std::cout << "  => cheaper route exists " << currentCost << "<=>" << (*openEntry->second)->currentCost << std::endl;
-#endif
-          continue;
-        }
+    clock.Stop();
 
-        double distanceToTarget=GetSphericalDistance(path->lon,
-                                                     path->lat,
-                                                     targetLon,
-                                                     targetLat);
-        // Estimate costs for the rest of the distance to the target
-        double estimateCost=profile.GetCosts(distanceToTarget);
-        double overallCost=currentCost+estimateCost;
+    if (debugPerformance) {
+      std::cout << "Time:                " << clock << std::endl;
+      std::cout << "Nodes settled:       " << nodesSettledCount << std::endl;
+      std::cout << "Edges relaxed:       " << edgesRelaxedCount << std::endl;
+    }
 
-        // If we already have the node in the open list, but the new path is cheaper,
-        // update the existing entry
-        if (openEntry!=openMap.end()) {
-          RNodeRef node=*openEntry->second;
+    if (meetingNode==ContractionHierarchy::noNode) {
+      std::cout << "No route found!" << std::endl;
+      route.Clear();
 
-          node->prev=current->nodeOffset;
-          node->object=currentRouteNode->objects[path->objectIndex];
+      return true;
+    }
 
-          node->currentCost=currentCost;
-          node->estimateCost=estimateCost;
-          node->overallCost=overallCost;
-          node->access=currentRouteNode->paths[i].HasAccess();
+    //
+    // Unpack the shortcuts of both halves into route node paths
+    //
 
-#if defined(DEBUG_ROUTING)
-          std::cout << "  Updating route " << current->nodeOffset << " via " << node->object.GetTypeName() << " " << node->object.GetFileOffset() << " " << currentCost << " " << estimateCost << " " << overallCost << " " << currentRouteNode->id << std::endl;
-#endif
+    std::vector<uint32_t>                   forwardNodes;
+    std::vector<ContractionHierarchy::Step> steps;
+    uint32_t                                startNode=meetingNode;
 
-          openList.erase(openEntry->second);
+    while (state.forward.edges[startNode]!=ContractionHierarchy::noNode) {
+      forwardNodes.push_back(startNode);
+      startNode=state.forward.parents[startNode];
+    }
 
-          std::pair<OpenListRef,bool> result=openList.insert(node);
-          openEntry->second=result.first;
-        }
-        else {
-          RNodeRef node=new RNode(path->offset,
-                                  currentRouteNode->objects[path->objectIndex],
-                                  current->nodeOffset);
+    for (std::vector<uint32_t>::const_reverse_iterator node=forwardNodes.rbegin();
+         node!=forwardNodes.rend();
+         ++node) {
+      if (!hierarchy.Unpack(state.forward.parents[*node],
+                            *node,
+                            hierarchy.GetEdge(state.forward.edges[*node]),
+                            steps)) {
+        return false;
+      }
+    }
 
-          node->currentCost=currentCost;
-          node->estimateCost=estimateCost;
-          node->overallCost=overallCost;
-          node->access=path->HasAccess();
+    for (uint32_t node=meetingNode;
+         state.backward.edges[node]!=ContractionHierarchy::noNode;
+         node=state.backward.parents[node]) {
+      if (!hierarchy.Unpack(node,
+                            state.backward.parents[node],
+                            hierarchy.GetEdge(state.backward.edges[node]),
+                            steps)) {
+        return false;
+      }
+    }
 
-#if defined(DEBUG_ROUTING)
-          std::cout << "  Inserting route to " << path->offset;
-          std::cout <<  " (" << node->object.GetTypeName() << " " << node->object.GetFileOffset() << ")";
-          std::cout << " " << currentCost << " " << estimateCost << " " << overallCost << " " << currentRouteNode->id << std::endl;
-#endif
+    std::vector<RNode> nodes;
 
-          std::pair<OpenListRef,bool> result=openList.insert(node);
-          openMap[node->nodeOffset]=result.first;
-        }
+    nodes.reserve(steps.size()+1);
+    nodes.push_back(RNode(hierarchy.GetOffset(startNode),
+                          startObject,
+                          noRNode));
+
+    for (std::vector<ContractionHierarchy::Step>::const_iterator step=steps.begin();
+         step!=steps.end();
+         ++step) {
+      RouteNodeRef routeNode;
+
+      if (!routeNodeDataFile.GetByOffset(hierarchy.GetOffset(step->node),
+                                         routeNode)) {
+        std::cerr << "Cannot load route node with id " << hierarchy.GetOffset(step->node) << std::endl;
+        return false;
       }
 
-      //
-      // Added current node to close map
-      //
+      const RouteNode::Path& path=routeNode->paths[step->path];
 
-      closeMap[current->nodeOffset]=current;
+      nodes.push_back(RNode(path.offset,
+                            routeNode->objects[path.objectIndex],
+                            noRNode));
+    }
 
-      maxOpenList=std::max(maxOpenList,openMap.size());
-      maxCloseMap=std::max(maxCloseMap,closeMap.size());
+    if (!ResolveRNodesToRouteData(profile,
+                                  nodes,
+                                  startObject,
+                                  startNodeIndex,
+                                  targetObject,
+                                  targetNodeIndex,
+                                  route)) {
+      return false;
+    }
 
-#if defined(DEBUG_ROUTING)
-      if (openList.empty()) {
-        std::cout << "No more alternatives, stopping" << std::endl;
-      }
+    ResolveRouteDataJunctions(route);
 
-      if ((targetForwardRouteNode.Valid() && current->nodeOffset==targetForwardRouteNode->fileOffset)) {
-        std::cout << "Reached target: " << current->nodeOffset << " == " << targetForwardRouteNode->fileOffset << " (forward)" << std::endl;
-      }
+    return true;
+  }
 
-      if (targetBackwardRouteNode.Valid() && current->nodeOffset==targetBackwardRouteNode->fileOffset) {
-        std::cout << "Reached target: " << current->nodeOffset << " == " << targetBackwardRouteNode->fileOffset << " (backward)" << std::endl;
-      }
-#endif
-    } while (!openList.empty() &&
-             (targetForwardRouteNode.Invalid() || current->nodeOffset!=targetForwardRouteNode->fileOffset) &&
-             (targetBackwardRouteNode.Invalid() || current->nodeOffset!=targetBackwardRouteNode->fileOffset));
+  /**
+   * Return the coordinates of the route node with the given id, which must be
+   * part of the given object.
+   */
+  bool Router::GetRouteNodeCoord(const ObjectFileRef& object,
+                                 Id id,
+                                 double& lon,
+                                 double& lat)
+  {
+    if (object.GetType()!=refWay) {
+      return false;
+    }
 
-    clock.Stop();
+    WayRef way;
 
-    if (debugPerformance) {
-      std::cout << "From:                " << startObject.GetTypeName() << " " << startObject.GetFileOffset();
-      std::cout << "[";
-      if (startForwardRouteNode.Valid()) {
-        std::cout << startForwardRouteNode->GetId() << " - ";
-      }
-      std::cout << startNodeIndex;
-      if (startBackwardRouteNode.Valid()) {
-        std::cout << " - " << startBackwardRouteNode->GetId();
-      }
-      std::cout << "]" << std::endl;
+    if (!wayDataFile.GetByOffset(object.GetFileOffset(),
+                                 way)) {
+      std::cerr << "Cannot get way at offset " << object.GetFileOffset() << "!" << std::endl;
+      return false;
+    }
 
-      std::cout << "To:                  " << targetObject.GetTypeName() <<  " " << targetObject.GetFileOffset();
-      std::cout << "[";
-      if (targetForwardRouteNode.Valid()) {
-        std::cout << targetForwardRouteNode->GetId() << " - ";
-      }
-      std::cout << targetNodeIndex;
-      if (targetBackwardRouteNode.Valid()) {
-        std::cout << " - " << targetBackwardRouteNode->GetId();
+    for (size_t i=0; i<way->ids.size(); i++) {
+      if (way->ids[i]==id) {
+        lon=way->nodes[i].GetLon();
+        lat=way->nodes[i].GetLat();
+
+        return true;
       }
-      std::cout << "]" << std::endl;
+    }
 
-      std::cout << "Time:                " << clock << std::endl;
+    return false;
+  }
 
-      std::cout << "Route nodes loaded:  " << nodesLoadedCount << std::endl;
-      std::cout << "Route nodes ignored: " << nodesIgnoredCount << std::endl;
-      std::cout << "Max. OpenList size:  " << maxOpenList << std::endl;
-      std::cout << "Max. CloseMap size:  " << maxCloseMap << std::endl;
+  /**
+   * Return true, if we can leave the given route node using the path with the given
+   * index (or noRNode for "no path"), after arriving via the given object from
+   * the route node at the given offset (or 0 for "no route node").
+   *
+   * The rules are the same as used by the A* search.
+   */
+  bool Router::CanTurn(const RouteNode& routeNode,
+                       const ObjectFileRef& arrivalObject,
+                       bool arrivalAccess,
+                       FileOffset arrivalOffset,
+                       uint32_t departurePath) const
+  {
+    if (departurePath==noRNode) {
+      return true;
     }
 
-    if (!((targetForwardRouteNode.Valid() && currentRouteNode->GetId()==targetForwardRouteNode->id) ||
-          (targetBackwardRouteNode.Valid() && currentRouteNode->GetId()==targetBackwardRouteNode->id))) {
-      std::cout << "No route found!" << std::endl;
-      route.Clear();
+    const RouteNode::Path& path=routeNode.paths[departurePath];
 
-      return true;
+    if (path.offset==arrivalOffset) {
+      return false;
     }
 
-    std::list<RNodeRef> nodes;
+    if (!arrivalAccess &&
+        path.HasAccess()) {
+      return false;
+    }
 
-    ResolveRNodeChainToList(current,
-                            closeMap,
-                            nodes);
+    for (size_t e=0; e<routeNode.excludes.size(); e++) {
+      if (routeNode.excludes[e].source==arrivalObject &&
+          routeNode.excludes[e].targetIndex==departurePath) {
+        return false;
+      }
+    }
 
-    if (!ResolveRNodesToRouteData(profile,
-                                  nodes,
-                                  startObject,
-                                  startNodeIndex,
-                                  targetObject,
-                                  targetNodeIndex,
-                                  route)) {
-      //std::cerr << "Cannot convert routing result to route data" << std::endl;
+    return true;
+  }
+
+  /**
+   * Calculate the route using a bidirectional A* search: a forward search on the
+   * route graph starting at the start route nodes and a backward search on the
+   * reverse route graph starting at the target route nodes.
+   *
+   * Both searches use the average of the estimates to the target and from the
+   * start as potential, so both use consistent costs and the search can stop, as soon
+   * as the sum of the smallest costs of both open lists reaches the costs of the
+   * best route found. Routes found are at least as good as the routes of the A*
+   * search, since the costs between the target position and the target route nodes
+   * are respected, too.
+   */
+  bool Router::CalculateRouteBidirectional(const RoutingProfile& profile,
+                                           const ObjectFileRef& startObject,
+                                           size_t startNodeIndex,
+                                           const ObjectFileRef& targetObject,
+                                           size_t targetNodeIndex,
+                                           RouteData& route)
+  {
+    RoutingState&            state=routingState;
+    ReverseRoutingState&     reverseState=reverseRoutingState;
+
+    RouteNodeRef             startForwardRouteNode;
+    RouteNodeRef             startBackwardRouteNode;
+    uint32_t                 startForwardNode;
+    uint32_t                 startBackwardNode;
+
+    double                   startLon=0.0L,startLat=0.0L;
+    double                   targetLon=0.0L,targetLat=0.0L;
+
+    RouteNodeRef             targetForwardRouteNode;
+    RouteNodeRef             targetBackwardRouteNode;
+    uint32_t                 targetForwardNode;
+    uint32_t                 targetBackwardNode;
+
+    size_t                   forwardNodesLoadedCount=0;
+    size_t                   backwardNodesLoadedCount=0;
+
+    route.Clear();
+    state.Clear();
+    reverseState.Clear();
+
+    if (!GetTargetNodes(targetObject,
+                        targetNodeIndex,
+                        targetLon,
+                        targetLat,
+                        targetForwardRouteNode,
+                        targetBackwardRouteNode)) {
       return false;
     }
 
-    ResolveRouteDataJunctions(route);
+    // Only used to get the start position
+    if (!GetTargetNodes(startObject,
+                        startNodeIndex,
+                        startLon,
+                        startLat,
+                        startForwardRouteNode,
+                        startBackwardRouteNode)) {
+      return false;
+    }
+
+    // Only used to get the costs between the target position and the target route nodes,
+    // which are the same as for leaving the target position
+    if (!GetStartNodes(profile,
+                       targetObject,
+                       targetNodeIndex,
+                       targetLon,
+                       targetLat,
+                       targetForwardRouteNode,
+                       targetBackwardRouteNode,
+                       state,
+                       targetForwardNode,
+                       targetBackwardNode)) {
+      return false;
+    }
+
+    RouteNodeRef targetRouteNodes[2]={targetForwardRouteNode,targetBackwardRouteNode};
+    FileOffset   targetOffsets[2]={0,0};
+    double       targetCosts[2]={0.0,0.0};
+
+    if (targetForwardNode!=noRNode) {
+      targetOffsets[0]=state.nodes[targetForwardNode].nodeOffset;
+      targetCosts[0]=state.nodes[targetForwardNode].currentCost;
+    }
+
+    if (targetBackwardNode!=noRNode) {
+      targetOffsets[1]=state.nodes[targetBackwardNode].nodeOffset;
+      targetCosts[1]=state.nodes[targetBackwardNode].currentCost;
+    }
+
+    state.Clear();
+
+    if (!GetStartNodes(profile,
+                       startObject,
+                       startNodeIndex,
+                       targetLon,
+                       targetLat,
+                       startForwardRouteNode,
+                       startBackwardRouteNode,
+                       state,
+                       startForwardNode,
+                       startBackwardNode)) {
+      return false;
+    }
+
+    //
+    // Initialize both searches. The potential of the forward search is the
+    // average of the estimate to the target and the (negative) estimate from the
+    // start, the potential of the backward search is the negative of it.
+    //
+
+    uint32_t     startNodes[2]={startForwardNode,startBackwardNode};
+    RouteNodeRef startRouteNodes[2]={startForwardRouteNode,startBackwardRouteNode};
+
+    for (size_t i=0; i<2; i++) {
+      if (startNodes[i]==noRNode) {
+        continue;
+      }
+
+      RNode& node=state.nodes[startNodes[i]];
+      double lon=startLon;
+      double lat=startLat;
+
+      GetRouteNodeCoord(startObject,
+                        startRouteNodes[i]->GetId(),
+                        lon,
+                        lat);
+
+      node.estimateCost=(profile.GetCosts(GetSphericalDistance(lon,lat,targetLon,targetLat))-
+                         profile.GetCosts(GetSphericalDistance(startLon,startLat,lon,lat)))/2;
+      node.overallCost=node.currentCost+node.estimateCost;
+
+      state.openList.Push(startNodes[i],
+                          RNodeCost(node.overallCost,
+                                    node.nodeOffset));
+    }
+
+    for (size_t i=0; i<2; i++) {
+      if (targetRouteNodes[i].Invalid() ||
+          targetOffsets[i]==0) {
+        continue;
+      }
+
+      uint32_t existingIndex=reverseState.nodeMap.Get(targetOffsets[i]);
+
+      // The same route node in both directions
+      if (existingIndex!=noRNode) {
+        ReverseRNode& node=reverseState.nodes[existingIndex];
+
+        if (targetCosts[i]<node.currentCost) {
+          node.currentCost=targetCosts[i];
+          node.overallCost=node.currentCost+node.estimateCost;
+
+          reverseState.openList.UpdateKey(existingIndex,
+                                          RNodeCost(node.overallCost,
+                                                    node.nodeOffset));
+        }
+
+        continue;
+      }
+
+      ReverseRNode node;
+      double       lon=targetLon;
+      double       lat=targetLat;
+
+      if (!reverseRouteNodeDataFile.GetOffset(targetRouteNodes[i]->GetId(),
+                                              node.reverseOffset)) {
+        std::cerr << "Cannot get offset of reverse route node " << targetRouteNodes[i]->GetId() << std::endl;
+        return false;
+      }
+
+      GetRouteNodeCoord(targetObject,
+                        targetRouteNodes[i]->GetId(),
+                        lon,
+                        lat);
+
+      node.nodeOffset=targetOffsets[i];
+      node.object=targetObject;
+      node.currentCost=targetCosts[i];
+      node.estimateCost=-(profile.GetCosts(GetSphericalDistance(lon,lat,targetLon,targetLat))-
+                          profile.GetCosts(GetSphericalDistance(startLon,startLat,lon,lat)))/2;
+      node.overallCost=node.currentCost+node.estimateCost;
+
+      reverseState.openList.Push(reverseState.AddNode(node),
+                                 RNodeCost(node.overallCost,
+                                           node.nodeOffset));
+    }
+
+    //
+    // The best route found so far, joining the forward RNode meetingForward via the
+    // object meetingObject (if meetingEdge is set) with the ReverseRNode meetingBackward.
+    //
+
+    double        bestCost=-1.0;
+    uint32_t      meetingForward=noRNode;
+    uint32_t      meetingBackward=noRNode;
+    bool          meetingEdge=false;
+    ObjectFileRef meetingObject;
+
+    for (size_t i=0; i<2; i++) {
+      if (startNodes[i]==noRNode) {
+        continue;
+      }
+
+      uint32_t reverseIndex=reverseState.nodeMap.Get(state.nodes[startNodes[i]].nodeOffset);
+
+      if (reverseIndex!=noRNode) {
+        double cost=state.nodes[startNodes[i]].currentCost+reverseState.nodes[reverseIndex].currentCost;
+
+        if (bestCost<0.0 ||
+            cost<bestCost) {
+          bestCost=cost;
+          meetingForward=startNodes[i];
+          meetingBackward=reverseIndex;
+          meetingEdge=false;
+        }
+      }
+    }
+
+    StopClock           clock;
+    RouteNodeRef        currentRouteNode;
+    ReverseRouteNodeRef currentReverseNode;
+    RouteNodeRef        meetingRouteNode;
+
+    while (!state.openList.IsEmpty() ||
+           !reverseState.openList.IsEmpty()) {
+      bool forward;
+
+      if (state.openList.IsEmpty()) {
+        forward=false;
+      }
+      else if (reverseState.openList.IsEmpty()) {
+        forward=true;
+      }
+      else {
+        forward=state.openList.GetTopKey().overallCost<=reverseState.openList.GetTopKey().overallCost;
+      }
+
+      if (bestCost>=0.0) {
+        if (state.openList.IsEmpty() ||
+            reverseState.openList.IsEmpty()) {
+          break;
+        }
+
+        if (state.openList.GetTopKey().overallCost+reverseState.openList.GetTopKey().overallCost>=bestCost) {
+          break;
+        }
+      }
+
+      if (forward) {
+        uint32_t currentIndex=state.openList.Pop();
+        RNode    current=state.nodes[currentIndex];
+
+        state.nodes[currentIndex].closed=true;
+
+        FileOffset prevOffset=current.prev!=noRNode ? state.nodes[current.prev].nodeOffset : 0;
+
+        if (!routeNodeDataFile.GetByOffset(current.nodeOffset,
+                                           currentRouteNode)) {
+          std::cerr << "Cannot load route node with id " << current.nodeOffset << std::endl;
+          return false;
+        }
+
+        forwardNodesLoadedCount++;
+
+        for (size_t i=0; i<currentRouteNode->paths.size(); i++) {
+          const RouteNode::Path& path=currentRouteNode->paths[i];
+
+          if (!profile.CanUse(*currentRouteNode,i) ||
+              !CanTurn(*currentRouteNode,
+                       current.object,
+                       current.access,
+                       prevOffset,
+                       (uint32_t)i)) {
+            continue;
+          }
+
+          uint32_t nextIndex=state.nodeMap.Get(path.offset);
+
+          if (nextIndex!=noRNode &&
+              state.nodes[nextIndex].closed) {
+            continue;
+          }
+
+          double        currentCost=current.currentCost+
+                                    profile.GetCosts(*currentRouteNode,i);
+          ObjectFileRef object=currentRouteNode->objects[path.objectIndex];
+          uint32_t      reverseIndex=reverseState.nodeMap.Get(path.offset);
+
+          if (reverseIndex!=noRNode) {
+            const ReverseRNode& reverseNode=reverseState.nodes[reverseIndex];
+            double              cost=currentCost+reverseNode.currentCost;
+
+            if ((bestCost<0.0 || cost<bestCost) &&
+                routeNodeDataFile.GetByOffset(path.offset,
+                                              meetingRouteNode) &&
+                CanTurn(*meetingRouteNode,
+                        object,
+                        path.HasAccess(),
+                        current.nodeOffset,
+                        reverseNode.pathIndex)) {
+              bestCost=cost;
+              meetingForward=currentIndex;
+              meetingBackward=reverseIndex;
+              meetingEdge=true;
+              meetingObject=object;
+            }
+          }
+
+          if (nextIndex!=noRNode &&
+              state.nodes[nextIndex].currentCost<=currentCost) {
+            continue;
+          }
+
+          // The potential of a node does not change, so it is only calculated once
+          if (nextIndex!=noRNode) {
+            RNode& node=state.nodes[nextIndex];
+
+            node.prev=currentIndex;
+            node.object=object;
+            node.currentCost=currentCost;
+            node.overallCost=currentCost+node.estimateCost;
+            node.access=path.HasAccess();
+
+            state.openList.UpdateKey(nextIndex,
+                                     RNodeCost(node.overallCost,
+                                               node.nodeOffset));
+          }
+          else {
+            double estimateCost=(profile.GetCosts(GetSphericalDistance(path.lon,path.lat,targetLon,targetLat))-
+                                 profile.GetCosts(GetSphericalDistance(startLon,startLat,path.lon,path.lat)))/2;
+            double overallCost=currentCost+estimateCost;
+            RNode  node(path.offset,
+                        object,
+                        currentIndex);
+
+            node.currentCost=currentCost;
+            node.estimateCost=estimateCost;
+            node.overallCost=overallCost;
+            node.access=path.HasAccess();
+
+            state.openList.Push(state.AddNode(node),
+                                RNodeCost(overallCost,
+                                          path.offset));
+          }
+        }
+      }
+      else {
+        uint32_t     currentIndex=reverseState.openList.Pop();
+        ReverseRNode current=reverseState.nodes[currentIndex];
+
+        reverseState.nodes[currentIndex].closed=true;
+
+        FileOffset nextOffset=current.next!=noRNode ? reverseState.nodes[current.next].nodeOffset : 0;
+
+        if (!reverseRouteNodeDataFile.GetByOffset(current.reverseOffset,
+                                                  currentReverseNode)) {
+          std::cerr << "Cannot load reverse route node with id " << current.reverseOffset << std::endl;
+          return false;
+        }
+
+        backwardNodesLoadedCount++;
+
+        for (size_t i=0; i<currentReverseNode->paths.size(); i++) {
+          const ReverseRouteNode::Path& path=currentReverseNode->paths[i];
+          ObjectFileRef                 object=currentReverseNode->objects[path.objectIndex];
+
+          if (path.routeNodeOffset==nextOffset) {
+            continue;
+          }
+
+          if (!path.HasAccess() &&
+              current.access) {
+            continue;
+          }
+
+          if (!profile.CanUse(*currentReverseNode,i)) {
+            continue;
+          }
+
+          if (current.pathIndex!=noRNode) {
+            bool canTurnedInto=true;
+
+            for (size_t e=0; e<currentReverseNode->excludes.size(); e++) {
+              if (currentReverseNode->excludes[e].source==object &&
+                  currentReverseNode->excludes[e].targetIndex==current.pathIndex) {
+                canTurnedInto=false;
+                break;
+              }
+            }
+
+            if (!canTurnedInto) {
+              continue;
+            }
+          }
+
+          uint32_t prevIndex=reverseState.nodeMap.Get(path.routeNodeOffset);
+
+          if (prevIndex!=noRNode &&
+              reverseState.nodes[prevIndex].closed) {
+            continue;
+          }
+
+          double   currentCost=current.currentCost+
+                               profile.GetCosts(*currentReverseNode,i);
+          uint32_t forwardIndex=state.nodeMap.Get(path.routeNodeOffset);
+
+          if (forwardIndex!=noRNode) {
+            const RNode& forwardNode=state.nodes[forwardIndex];
+            double       cost=forwardNode.currentCost+currentCost;
+
+            if ((bestCost<0.0 || cost<bestCost) &&
+                routeNodeDataFile.GetByOffset(path.routeNodeOffset,
+                                              meetingRouteNode) &&
+                CanTurn(*meetingRouteNode,
+                        forwardNode.object,
+                        forwardNode.access,
+                        forwardNode.prev!=noRNode ? state.nodes[forwardNode.prev].nodeOffset : 0,
+                        path.pathIndex)) {
+              bestCost=cost;
+              meetingForward=forwardIndex;
+              meetingBackward=currentIndex;
+              meetingEdge=true;
+              meetingObject=object;
+            }
+          }
+
+          if (prevIndex!=noRNode &&
+              reverseState.nodes[prevIndex].currentCost<=currentCost) {
+            continue;
+          }
+
+          if (prevIndex!=noRNode) {
+            ReverseRNode& node=reverseState.nodes[prevIndex];
+
+            node.reverseOffset=path.offset;
+            node.next=currentIndex;
+            node.pathIndex=path.pathIndex;
+            node.access=path.HasAccess();
+            node.object=object;
+            node.currentCost=currentCost;
+            node.overallCost=currentCost+node.estimateCost;
+
+            reverseState.openList.UpdateKey(prevIndex,
+                                            RNodeCost(node.overallCost,
+                                                      node.nodeOffset));
+          }
+          else {
+            double       estimateCost=-(profile.GetCosts(GetSphericalDistance(path.lon,path.lat,targetLon,targetLat))-
+                                        profile.GetCosts(GetSphericalDistance(startLon,startLat,path.lon,path.lat)))/2;
+            double       overallCost=currentCost+estimateCost;
+            ReverseRNode node;
+
+            node.nodeOffset=path.routeNodeOffset;
+            node.reverseOffset=path.offset;
+            node.next=currentIndex;
+            node.pathIndex=path.pathIndex;
+            node.access=path.HasAccess();
+            node.object=object;
+            node.currentCost=currentCost;
+            node.estimateCost=estimateCost;
+            node.overallCost=overallCost;
+
+            reverseState.openList.Push(reverseState.AddNode(node),
+                                       RNodeCost(overallCost,
+                                                 node.nodeOffset));
+          }
+        }
+      }
+    }
+
+    clock.Stop();
+
+    if (debugPerformance) {
+      std::cout << "Time:                " << clock << std::endl;
+      std::cout << "Route nodes loaded:  " << forwardNodesLoadedCount << " + " << backwardNodesLoadedCount << std::endl;
+    }
+
+    if (bestCost<0.0) {
+      std::cout << "No route found!" << std::endl;
+      route.Clear();
+
+      return true;
+    }
+
+    //
+    // Join the forward chain and the backward chain
+    //
+
+    std::vector<RNode> nodes;
+
+    ResolveRNodeChainToList(meetingForward,
+                            state,
+                            nodes);
+
+    uint32_t backwardIndex=meetingBackward;
+
+    if (meetingEdge) {
+      nodes.push_back(RNode(reverseState.nodes[backwardIndex].nodeOffset,
+                            meetingObject,
+                            noRNode));
+    }
+
+    while (reverseState.nodes[backwardIndex].next!=noRNode) {
+      const ReverseRNode& node=reverseState.nodes[backwardIndex];
+
+      nodes.push_back(RNode(reverseState.nodes[node.next].nodeOffset,
+                            node.object,
+                            noRNode));
+
+      backwardIndex=node.next;
+    }
+
+    if (!ResolveRNodesToRouteData(profile,
+                                  nodes,
+                                  startObject,
+                                  startNodeIndex,
+                                  targetObject,
+                                  targetNodeIndex,
+                                  route)) {
+      return false;
+    }
+
+    ResolveRouteDataJunctions(route);
+
+    return true;
+  }
+
+  /**
+   * A* search on the compact route graph. The search is the same as the search
+   * on the route node data file in CalculateRoute() (same costs, same estimate,
+   * same order of the open list), so the resulting routes are identical.
+   *
+   * Only the route nodes next to the start and the target position are loaded
+   * from the route node data file, the search itself works on the arrays of
+   * the route graph and of the GraphState and does not allocate memory.
+   */
+  bool Router::CalculateRouteGraph(const RoutingProfile& profile,
+                                   const ObjectFileRef& startObject,
+                                   size_t startNodeIndex,
+                                   const ObjectFileRef& targetObject,
+                                   size_t targetNodeIndex,
+                                   RouteData& route)
+  {
+    const RouteGraph& graph=*routeGraph;
+    GraphState&       state=graphState;
+
+    RouteNodeRef      startForwardRouteNode;
+    RouteNodeRef      startBackwardRouteNode;
+    uint32_t          startForwardNode;
+    uint32_t          startBackwardNode;
+
+    double            targetLon=0.0L,targetLat=0.0L;
+
+    RouteNodeRef      targetForwardRouteNode;
+    RouteNodeRef      targetBackwardRouteNode;
+    uint32_t          targetNodes[2]={RouteGraph::noNode,RouteGraph::noNode};
+
+    size_t            nodesSettledCount=0;
+    size_t            nodesIgnoredCount=0;
+    size_t            maxOpenList=0;
+
+    route.Clear();
+    routingState.Clear();
+    state.Clear();
+
+    if (!GetTargetNodes(targetObject,
+                        targetNodeIndex,
+                        targetLon,
+                        targetLat,
+                        targetForwardRouteNode,
+                        targetBackwardRouteNode)) {
+      return false;
+    }
+
+    // Only used to get the costs from the start position to the start route nodes
+    if (!GetStartNodes(profile,
+                       startObject,
+                       startNodeIndex,
+                       targetLon,
+                       targetLat,
+                       startForwardRouteNode,
+                       startBackwardRouteNode,
+                       routingState,
+                       startForwardNode,
+                       startBackwardNode)) {
+      return false;
+    }
+
+    if (targetForwardRouteNode.Valid()) {
+      targetNodes[0]=graph.GetNode(targetForwardRouteNode->GetFileOffset());
+    }
+
+    if (targetBackwardRouteNode.Valid()) {
+      targetNodes[1]=graph.GetNode(targetBackwardRouteNode->GetFileOffset());
+    }
+
+    uint32_t startRNodes[2]={startForwardNode,startBackwardNode};
+    uint32_t startObjectIndex=graph.GetObject(startObject);
+
+    for (size_t i=0; i<2; i++) {
+      if (startRNodes[i]==noRNode) {
+        continue;
+      }
+
+      const RNode& rnode=routingState.nodes[startRNodes[i]];
+      uint32_t     node=graph.GetNode(rnode.nodeOffset);
+
+      if (node==RouteGraph::noNode) {
+        std::cerr << "Start route node " << rnode.nodeOffset << " is not part of the route graph" << std::endl;
+        return false;
+      }
+
+      if (state.flags[node] & GraphState::reached) {
+        if (state.costs[node]<=rnode.currentCost) {
+          continue;
+        }
+      }
+      else {
+        state.touched.push_back(node);
+      }
+
+      state.costs[node]=rnode.currentCost;
+      state.parents[node]=RouteGraph::noNode;
+      state.objects[node]=startObjectIndex;
+      state.flags[node]=GraphState::reached;
+
+      if (state.openList.Contains(node)) {
+        state.openList.UpdateKey(node,
+                                 RNodeCost(rnode.overallCost,
+                                           rnode.nodeOffset));
+      }
+      else {
+        state.openList.Push(node,
+                            RNodeCost(rnode.overallCost,
+                                      rnode.nodeOffset));
+      }
+    }
+
+    StopClock clock;
+    uint32_t  current=RouteGraph::noNode;
+    bool      targetReached=false;
+
+    while (!state.openList.IsEmpty()) {
+      current=state.openList.Pop();
+
+      state.flags[current]|=GraphState::closed;
+      nodesSettledCount++;
+
+      if (current==targetNodes[0] ||
+          current==targetNodes[1]) {
+        targetReached=true;
+        break;
+      }
+
+      uint32_t prev=state.parents[current];
+      uint32_t arrivalObject=state.objects[current];
+      bool     access=(state.flags[current] & GraphState::noAccess)==0;
+      double   currentCost=state.costs[current];
+      uint32_t edgesBegin=graph.GetEdgesBegin(current);
+      uint32_t edgesEnd=graph.GetEdgesEnd(current);
+      uint32_t excludesBegin=graph.GetExcludesBegin(current);
+      uint32_t excludesEnd=graph.GetExcludesEnd(current);
+
+      for (uint32_t e=edgesBegin; e<edgesEnd; e++) {
+        const RouteGraph::Edge& edge=graph.GetEdge(e);
+
+        // Back to the last node visited
+        if (edge.target==prev) {
+          nodesIgnoredCount++;
+          continue;
+        }
+
+        // Moving from non-accessible way back to accessible way
+        if (!access &&
+            edge.HasAccess()) {
+          nodesIgnoredCount++;
+          continue;
+        }
+
+        if (!profile.CanUse(graph,e)) {
+          nodesIgnoredCount++;
+          continue;
+        }
+
+        uint8_t nextFlags=state.flags[edge.target];
+
+        if (nextFlags & GraphState::closed) {
+          continue;
+        }
+
+        bool canTurnInto=true;
+
+        for (uint32_t x=excludesBegin; x<excludesEnd; x++) {
+          const RouteGraph::Exclude& exclude=graph.GetExclude(x);
+
+          if (exclude.sourceObject==arrivalObject &&
+              exclude.targetPath==e-edgesBegin) {
+            canTurnInto=false;
+            break;
+          }
+        }
+
+        if (!canTurnInto) {
+          nodesIgnoredCount++;
+          continue;
+        }
+
+        double nextCost=currentCost+
+                        profile.GetCosts(graph,e);
+
+        // Check, if we already have a cheaper path to the new node
+        if ((nextFlags & GraphState::reached) &&
+            state.costs[edge.target]<=nextCost) {
+          continue;
+        }
+
+        double distanceToTarget=GetSphericalDistance(graph.GetLon(edge.target),
+                                                     graph.GetLat(edge.target),
+                                                     targetLon,
+                                                     targetLat);
+        // Estimate costs for the rest of the distance to the target
+        double estimateCost=profile.GetCosts(distanceToTarget);
+        double overallCost=nextCost+estimateCost;
+
+        state.costs[edge.target]=nextCost;
+        state.parents[edge.target]=current;
+        state.objects[edge.target]=edge.object;
+        state.flags[edge.target]=edge.HasAccess() ? GraphState::reached : (GraphState::reached | GraphState::noAccess);
+
+        if (nextFlags & GraphState::reached) {
+          // The estimate of start nodes is based on the start position, so the
+          // overall costs might nevertheless increase
+          state.openList.UpdateKey(edge.target,
+                                   RNodeCost(overallCost,
+                                             graph.GetOffset(edge.target)));
+        }
+        else {
+          state.touched.push_back(edge.target);
+          state.openList.Push(edge.target,
+                              RNodeCost(overallCost,
+                                        graph.GetOffset(edge.target)));
+        }
+      }
+
+      maxOpenList=std::max(maxOpenList,state.openList.GetSize());
+    }
+
+    clock.Stop();
+
+    if (debugPerformance) {
+      std::cout << "From:                " << startObject.GetTypeName() << " " << startObject.GetFileOffset();
+      std::cout << "[" << startNodeIndex << "]" << std::endl;
+      std::cout << "To:                  " << targetObject.GetTypeName() <<  " " << targetObject.GetFileOffset();
+      std::cout << "[" << targetNodeIndex << "]" << std::endl;
+
+      std::cout << "Time:                " << clock << std::endl;
+
+      std::cout << "Route nodes settled: " << nodesSettledCount << std::endl;
+      std::cout << "Route nodes ignored: " << nodesIgnoredCount << std::endl;
+      std::cout << "Max. OpenList size:  " << maxOpenList << std::endl;
+    }
+
+    if (!targetReached) {
+      std::cout << "No route found!" << std::endl;
+      route.Clear();
+
+      return true;
+    }
+
+    std::vector<RNode> nodes;
+
+    for (uint32_t node=current;
+         node!=RouteGraph::noNode;
+         node=state.parents[node]) {
+      if (state.parents[node]==RouteGraph::noNode) {
+        nodes.push_back(RNode(graph.GetOffset(node),
+                              startObject,
+                              noRNode));
+      }
+      else {
+        nodes.push_back(RNode(graph.GetOffset(node),
+                              graph.GetObjectRef(state.objects[node]),
+                              noRNode));
+      }
+    }
+
+    std::reverse(nodes.begin(),nodes.end());
+
+    if (!ResolveRNodesToRouteData(profile,
+                                  nodes,
+                                  startObject,
+                                  startNodeIndex,
+                                  targetObject,
+                                  targetNodeIndex,
+                                  route)) {
+      return false;
+    }
+
+    ResolveRouteDataJunctions(route);
+
+    return true;
+  }
+
+  bool Router::CalculateRoute(const RoutingProfile& profile,
+                              const ObjectFileRef& startObject,
+                              size_t startNodeIndex,
+                              const ObjectFileRef& targetObject,
+                              size_t targetNodeIndex,
+                              RouteData& route)
+  {
+    if (CanUseContractionHierarchy(profile)) {
+      if (CalculateRouteCH(profile,
+                           startObject,
+                           startNodeIndex,
+                           targetObject,
+                           targetNodeIndex,
+                           route)) {
+        return true;
+      }
+
+      if (!useBidirectional) {
+        return false;
+      }
+
+      std::cerr << "Falling back to bidirectional search" << std::endl;
+    }
+
+    if (useBidirectional) {
+      return CalculateRouteBidirectional(profile,
+                                         startObject,
+                                         startNodeIndex,
+                                         targetObject,
+                                         targetNodeIndex,
+                                         route);
+    }
+
+    if (routeGraph.Valid()) {
+      return CalculateRouteGraph(profile,
+                                 startObject,
+                                 startNodeIndex,
+                                 targetObject,
+                                 targetNodeIndex,
+                                 route);
+    }
+
+    RouteNodeRef             startForwardRouteNode;
+    RouteNodeRef             startBackwardRouteNode;
+    uint32_t                 startForwardNode;
+    uint32_t                 startBackwardNode;
+
+    double                   targetLon=0.0L,targetLat=0.0L;
+
+    RouteNodeRef             targetForwardRouteNode;
+    RouteNodeRef             targetBackwardRouteNode;
+
+    // RNodes, the index of RNodes by route node offset and the sorted list (smallest cost first)
+    // of nodes to check. Memory is reused from the last route calculation.
+    RoutingState&            state=routingState;
+
+    size_t                   nodesLoadedCount=0;
+    size_t                   nodesIgnoredCount=0;
+    size_t                   maxOpenList=0;
+    size_t                   maxCloseMap=0;
+
+    route.Clear();
+    state.Clear();
+
+    if (!GetTargetNodes(targetObject,
+                        targetNodeIndex,
+                        targetLon,
+                        targetLat,
+                        targetForwardRouteNode,
+                        targetBackwardRouteNode)) {
+      return false;
+    }
+
+    if (!GetStartNodes(profile,
+                       startObject,
+                       startNodeIndex,
+                       targetLon,
+                       targetLat,
+                       startForwardRouteNode,
+                       startBackwardRouteNode,
+                       state,
+                       startForwardNode,
+                       startBackwardNode)) {
+      return false;
+    }
+
+    if (startForwardNode!=noRNode) {
+      state.openList.Push(startForwardNode,
+                          RNodeCost(state.nodes[startForwardNode].overallCost,
+                                    state.nodes[startForwardNode].nodeOffset));
+    }
+
+    if (startBackwardNode!=noRNode) {
+      state.openList.Push(startBackwardNode,
+                          RNodeCost(state.nodes[startBackwardNode].overallCost,
+                                    state.nodes[startBackwardNode].nodeOffset));
+    }
+
+    StopClock    clock;
+    uint32_t     currentIndex=noRNode;
+    RNode        current;
+    RouteNodeRef currentRouteNode;
+
+    do {
+      //
+      // Take entry from open list with lowest cost
+      //
+
+      currentIndex=state.openList.Pop();
+
+      // Copy, since adding new nodes may move the array
+      current=state.nodes[currentIndex];
+
+      // Move current node to the close list
+      state.nodes[currentIndex].closed=true;
+
+      FileOffset prevOffset=current.prev!=noRNode ? state.nodes[current.prev].nodeOffset : 0;
+
+      if (!routeNodeDataFile.GetByOffset(current.nodeOffset,
+                                         currentRouteNode)) {
+        std::cerr << "Cannot load route node with id " << current.nodeOffset << std::endl;
+        return false;
+      }
+
+      nodesLoadedCount++;
+
+      // Get potential follower in the current way
+
+#if defined(DEBUG_ROUTING)
+      std::cout << "Analysing follower of node " << currentRouteNode->GetFileOffset();
+      std::cout << " (" << current.object.GetTypeName() << " " << current.object.GetFileOffset() << "["  << currentRouteNode->GetId() << "]" << ")";
+      std::cout << " " << current.currentCost << " " << current.estimateCost << " " << current.overallCost << std::endl;
+#endif
+      size_t i=0;
+      for (std::vector<osmscout::RouteNode::Path>::const_iterator path=currentRouteNode->paths.begin();
+           path!=currentRouteNode->paths.end();
+           ++path,
+           ++i) {
+        if (path->offset==prevOffset) {
+#if defined(DEBUG_ROUTING)
+          std::cout << "  Skipping route";
+          std::cout << " to " << path->offset;
+          std::cout << " (" << currentRouteNode->objects[path->objectIndex].GetTypeName() << " " << currentRouteNode->objects[path->objectIndex].GetFileOffset() << ")";
+          std::cout << " => back to the last node visited" << std::endl;
+#endif
+          nodesIgnoredCount++;
+          continue;
+        }
+
+        if (!current.access &&
+            path->HasAccess()) {
+#if defined(DEBUG_ROUTING)
+          std::cout << "  Skipping route";
+          std::cout << " to " << path->offset;
+          std::cout << " (" << currentRouteNode->objects[path->objectIndex].GetTypeName() << " " << currentRouteNode->objects[path->objectIndex].GetFileOffset() << ")";
+          std::cout << " => moving from non-accessible way back to accessible way" << std::endl;
+#endif
+          nodesIgnoredCount++;
+          continue;
+        }
+
+        if (!profile.CanUse(*currentRouteNode,i)) {
+#if defined(DEBUG_ROUTING)
+          std::cout << "  Skipping route";
+          std::cout << " to " << path->offset;
+          std::cout << " (" << currentRouteNode->objects[path->objectIndex].GetTypeName() << " " << currentRouteNode->objects[path->objectIndex].GetFileOffset() << ")";
+          std::cout << " => Cannot be used"<< std::endl;
+#endif
+          nodesIgnoredCount++;
+          continue;
+        }
+
+        uint32_t nextIndex=state.nodeMap.Get(path->offset);
+
+        if (nextIndex!=noRNode &&
+            state.nodes[nextIndex].closed) {
+#if defined(DEBUG_ROUTING)
+          std::cout << "  Skipping route";
+          std::cout << " to " << path->offset;
+          std::cout << " (" << currentRouteNode->objects[path->objectIndex].GetTypeName() << " " << currentRouteNode->objects[path->objectIndex].GetFileOffset() << ")";
+          std::cout << " => already calculated" << std::endl;
+#endif
+          continue;
+        }
+
+        if (!currentRouteNode->excludes.empty()) {
+          bool canTurnedInto=true;
+          for (size_t e=0; e<currentRouteNode->excludes.size(); e++) {
+            if (currentRouteNode->excludes[e].source==current.object &&
+                currentRouteNode->excludes[e].targetIndex==i) {
+#if defined(DEBUG_ROUTING)
+              std::cout << "  Skipping route";
+              std::cout << " to " << path->offset;
+              std::cout << " (" << currentRouteNode->objects[path->objectIndex].GetTypeName() << " " << currentRouteNode->objects[path->objectIndex].GetFileOffset() << ")";
+              std::cout << " => turn not allowed" << std::endl;
+#endif
+              canTurnedInto=false;
+              break;
+            }
+          }
+
+          if (!canTurnedInto) {
+            nodesIgnoredCount++;
+            continue;
+          }
+        }
+
+        double currentCost=current.currentCost+
+                           profile.GetCosts(*currentRouteNode,i);
+
+        // Check, if we already have a cheaper path to the new node. If yes, do not put the new path
+        // into the open list
+        if (nextIndex!=noRNode &&
+            state.nodes[nextIndex].currentCost<=currentCost) {
+#if defined(DEBUG_ROUTING)
+          std::cout << "  Skipping route";
+          std::cout << " to " << path->offset;
+          std::cout << " (" << currentRouteNode->objects[path->objectIndex].GetTypeName() << " " << currentRouteNode->objects[path->objectIndex].GetFileOffset() << ")";
+          std::cout << "  => cheaper route exists " << currentCost << "<=>" << state.nodes[nextIndex].currentCost << std::endl;
+#endif
+          continue;
+        }
+
+        double distanceToTarget=GetSphericalDistance(path->lon,
+                                                     path->lat,
+                                                     targetLon,
+                                                     targetLat);
+        // Estimate costs for the rest of the distance to the target
+        double estimateCost=profile.GetCosts(distanceToTarget);
+        double overallCost=currentCost+estimateCost;
+
+        // If we already have the node in the open list, but the new path is cheaper,
+        // update the existing entry
+        if (nextIndex!=noRNode) {
+          RNode& node=state.nodes[nextIndex];
+
+          node.prev=currentIndex;
+          node.object=currentRouteNode->objects[path->objectIndex];
+
+          node.currentCost=currentCost;
+          node.estimateCost=estimateCost;
+          node.overallCost=overallCost;
+          node.access=currentRouteNode->paths[i].HasAccess();
+
+#if defined(DEBUG_ROUTING)
+          std::cout << "  Updating route " << current.nodeOffset << " via " << node.object.GetTypeName() << " " << node.object.GetFileOffset() << " " << currentCost << " " << estimateCost << " " << overallCost << " " << currentRouteNode->id << std::endl;
+#endif
+
+          // The estimate of start nodes is based on the start position, so the
+          // overall costs might nevertheless increase
+          state.openList.UpdateKey(nextIndex,
+                                   RNodeCost(overallCost,
+                                             node.nodeOffset));
+        }
+        else {
+          RNode node(path->offset,
+                     currentRouteNode->objects[path->objectIndex],
+                     currentIndex);
+
+          node.currentCost=currentCost;
+          node.estimateCost=estimateCost;
+          node.overallCost=overallCost;
+          node.access=path->HasAccess();
+
+#if defined(DEBUG_ROUTING)
+          std::cout << "  Inserting route to " << path->offset;
+          std::cout <<  " (" << node.object.GetTypeName() << " " << node.object.GetFileOffset() << ")";
+          std::cout << " " << currentCost << " " << estimateCost << " " << overallCost << " " << currentRouteNode->id << std::endl;
+#endif
+
+          state.openList.Push(state.AddNode(node),
+                              RNodeCost(overallCost,
+                                        path->offset));
+        }
+      }
+
+      maxOpenList=std::max(maxOpenList,state.openList.GetSize());
+      maxCloseMap++;
+
+#if defined(DEBUG_ROUTING)
+      if (state.openList.IsEmpty()) {
+        std::cout << "No more alternatives, stopping" << std::endl;
+      }
+
+      if ((targetForwardRouteNode.Valid() && current.nodeOffset==targetForwardRouteNode->fileOffset)) {
+        std::cout << "Reached target: " << current.nodeOffset << " == " << targetForwardRouteNode->fileOffset << " (forward)" << std::endl;
+      }
+
+      if (targetBackwardRouteNode.Valid() && current.nodeOffset==targetBackwardRouteNode->fileOffset) {
+        std::cout << "Reached target: " << current.nodeOffset << " == " << targetBackwardRouteNode->fileOffset << " (backward)" << std::endl;
+      }
+#endif
+    } while (!state.openList.IsEmpty() &&
+             (targetForwardRouteNode.Invalid() || current.nodeOffset!=targetForwardRouteNode->fileOffset) &&
+             (targetBackwardRouteNode.Invalid() || current.nodeOffset!=targetBackwardRouteNode->fileOffset));
+
+    clock.Stop();
+
+    if (debugPerformance) {
+      std::cout << "From:                " << startObject.GetTypeName() << " " << startObject.GetFileOffset();
+      std::cout << "[";
+      if (startForwardRouteNode.Valid()) {
+        std::cout << startForwardRouteNode->GetId() << " - ";
+      }
+      std::cout << startNodeIndex;
+      if (startBackwardRouteNode.Valid()) {
+        std::cout << " - " << startBackwardRouteNode->GetId();
+      }
+      std::cout << "]" << std::endl;
+
+      std::cout << "To:                  " << targetObject.GetTypeName() <<  " " << targetObject.GetFileOffset();
+      std::cout << "[";
+      if (targetForwardRouteNode.Valid()) {
+        std::cout << targetForwardRouteNode->GetId() << " - ";
+      }
+      std::cout << targetNodeIndex;
+      if (targetBackwardRouteNode.Valid()) {
+        std::cout << " - " << targetBackwardRouteNode->GetId();
+      }
+      std::cout << "]" << std::endl;
+
+      std::cout << "Time:                " << clock << std::endl;
+
+      std::cout << "Route nodes loaded:  " << nodesLoadedCount << std::endl;
+      std::cout << "Route nodes ignored: " << nodesIgnoredCount << std::endl;
+      std::cout << "Max. OpenList size:  " << maxOpenList << std::endl;
+      std::cout << "Max. CloseMap size:  " << maxCloseMap << std::endl;
+    }
+
+    if (!((targetForwardRouteNode.Valid() && currentRouteNode->GetId()==targetForwardRouteNode->id) ||
+          (targetBackwardRouteNode.Valid() && currentRouteNode->GetId()==targetBackwardRouteNode->id))) {
+      std::cout << "No route found!" << std::endl;
+      route.Clear();
+
+      return true;
+    }
+
+    std::vector<RNode> nodes;
+
+    ResolveRNodeChainToList(currentIndex,
+                            state,
+                            nodes);
+
+    if (!ResolveRNodesToRouteData(profile,
+                                  nodes,
+                                  startObject,
+                                  startNodeIndex,
+                                  targetObject,
+                                  targetNodeIndex,
+                                  route)) {
+      //std::cerr << "Cannot convert routing result to route data" << std::endl;
+      return false;
+    }
+
+    ResolveRouteDataJunctions(route);
+
+    return true;
+  }
+
+  /**
+   * Resolve the given position to the route nodes next to it, together with the
+   * costs and the travel time between the position and each route node. If
+   * there is no route node next to the position, it has no legs. Only
+   * positions on ways can be resolved.
+   */
+  bool Router::ResolvePosition(const RoutingProfile& profile,
+                               const RoutePosition& position,
+                               ResolvedPosition& resolved)
+  {
+    resolved.object=position.object;
+    resolved.legs.clear();
+
+    if (position.object.GetType()!=refWay) {
+      std::cerr << "Only ways are supported as positions" << std::endl;
+      return false;
+    }
+
+    WayRef way;
+
+    if (!wayDataFile.GetByOffset(position.object.GetFileOffset(),
+                                 way)) {
+      std::cerr << "Cannot get way at offset " << position.object.GetFileOffset() << "!" << std::endl;
+      return false;
+    }
+
+    if (position.nodeIndex>=way->nodes.size()) {
+      std::cerr << "Given node index " << position.nodeIndex << " is not within valid range [0," << way->nodes.size()-1 << std::endl;
+      return false;
+    }
+
+    RouteNodeRef routeNodes[2];
+    size_t       routeNodePos[2];
+
+    GetClosestForwardRouteNode(way,
+                               position.nodeIndex,
+                               routeNodes[0],
+                               routeNodePos[0]);
+    GetClosestBackwardRouteNode(way,
+                                position.nodeIndex,
+                                routeNodes[1],
+                                routeNodePos[1]);
+
+    for (size_t i=0; i<2; i++) {
+      if (routeNodes[i].Invalid()) {
+        continue;
+      }
+
+      std::vector<ObjectFileRef>::const_iterator object=std::find(routeNodes[i]->objects.begin(),
+                                                                  routeNodes[i]->objects.end(),
+                                                                  position.object);
+      double                                     distance=GetSphericalDistance(way->nodes[position.nodeIndex].GetLon(),
+                                                                               way->nodes[position.nodeIndex].GetLat(),
+                                                                               way->nodes[routeNodePos[i]].GetLon(),
+                                                                               way->nodes[routeNodePos[i]].GetLat());
+      PositionLeg                                leg;
+
+      leg.routeNodeOffset=routeNodes[i]->GetFileOffset();
+      leg.objectIndex=object!=routeNodes[i]->objects.end() ? (uint32_t)(object-routeNodes[i]->objects.begin()) : noRNode;
+      leg.lon=way->nodes[routeNodePos[i]].GetLon();
+      leg.lat=way->nodes[routeNodePos[i]].GetLat();
+      leg.cost=profile.GetCosts(*way,
+                                distance);
+      leg.time=profile.GetTime(*way,
+                               distance);
+
+      resolved.legs.push_back(leg);
+    }
+
+    return true;
+  }
+
+  /**
+   * Calculates the rows of a route matrix using one Dijkstra search on the route
+   * graph for each source. The search of a source stops, as soon as all route
+   * nodes next to the targets are settled.
+   *
+   * Each worker has its own search state and its own access to the route node file,
+   * so workers do not share any mutable data. A task only writes its own row of
+   * the matrix.
+   */
+  class Router::MatrixDijkstraJob : public ParallelJob
+  {
+  private:
+    /**
+     * A target reached via a route node
+     */
+    struct TargetLeg
+    {
+      size_t target; //! Index of the target
+      double cost;   //! Costs from the route node to the target
+      double time;   //! Travel time from the route node to the target
+    };
+
+    typedef OSMSCOUT_HASHMAP<FileOffset,std::vector<TargetLeg> > TargetMap;
+
+    struct Worker
+    {
+      DataFile<RouteNode> routeNodeDataFile; //! Own access to the route node file
+      RoutingState        state;             //! Reused search state
+      std::vector<double> times;             //! The travel time for each RNode of the state
+      size_t              nodesLoadedCount;
+      bool                success;           //! false, if a route node could not be loaded
+
+      Worker(const std::string& filename)
+      : routeNodeDataFile(filename,0),
+        nodesLoadedCount(0),
+        success(true)
+      {
+        // no code
+      }
+    };
+
+  private:
+    const Router&                        router;
+    const RoutingProfile&                profile;
+    const std::vector<ResolvedPosition>& sources;
+    RouteMatrix&                         matrix;
+    TargetMap                            targetMap; //! Route node file offset => targets next to it
+    std::vector<Worker*>                 workers;
+
+  public:
+    MatrixDijkstraJob(const Router& router,
+                      const RoutingProfile& profile,
+                      const std::vector<ResolvedPosition>& sources,
+                      const std::vector<ResolvedPosition>& targets,
+                      RouteMatrix& matrix)
+    : router(router),
+      profile(profile),
+      sources(sources),
+      matrix(matrix)
+    {
+      for (size_t t=0; t<targets.size(); t++) {
+        for (std::vector<PositionLeg>::const_iterator leg=targets[t].legs.begin();
+             leg!=targets[t].legs.end();
+             ++leg) {
+          TargetLeg targetLeg;
+
+          targetLeg.target=t;
+          targetLeg.cost=leg->cost;
+          targetLeg.time=leg->time;
+
+          targetMap[leg->routeNodeOffset].push_back(targetLeg);
+        }
+      }
+    }
+
+    ~MatrixDijkstraJob()
+    {
+      for (size_t i=0; i<workers.size(); i++) {
+        delete workers[i];
+      }
+    }
+
+    bool Open(const std::string& path,
+              size_t workerCount)
+    {
+      for (size_t i=0; i<workerCount; i++) {
+        workers.push_back(new Worker(router.GetDataFilename(router.vehicle)));
+
+        if (!workers.back()->routeNodeDataFile.Open(path,
+                                                    FileScanner::FastRandom,true)) {
+          std::cerr << "Cannot open '" << router.GetDataFilename(router.vehicle) << "'!" << std::endl;
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    bool IsSuccess() const
+    {
+      for (size_t i=0; i<workers.size(); i++) {
+        if (!workers[i]->success) {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    size_t GetNodesLoadedCount() const
+    {
+      size_t count=0;
+
+      for (size_t i=0; i<workers.size(); i++) {
+        count+=workers[i]->nodesLoadedCount;
+      }
+
+      return count;
+    }
+
+    void Execute(size_t task,
+                 size_t workerIndex)
+    {
+      Worker&                 worker=*workers[workerIndex];
+      RoutingState&           state=worker.state;
+      std::vector<double>&    times=worker.times;
+      const ResolvedPosition& source=sources[task];
+      size_t                  settledTargetNodes=0;
+      RouteNodeRef            routeNode;
+
+      if (!worker.success) {
+        return;
+      }
+
+      state.Clear();
+      times.clear();
+
+      for (std::vector<PositionLeg>::const_iterator leg=source.legs.begin();
+           leg!=source.legs.end();
+           ++leg) {
+        uint32_t index=state.nodeMap.Get(leg->routeNodeOffset);
+
+        if (index!=noRNode) {
+          if (state.nodes[index].currentCost<=leg->cost) {
+            continue;
+          }
+
+          state.nodes[index].currentCost=leg->cost;
+          state.nodes[index].overallCost=leg->cost;
+          times[index]=leg->time;
+
+          state.openList.UpdateKey(index,
+                                   RNodeCost(leg->cost,
+                                             leg->routeNodeOffset));
+          continue;
+        }
+
+        RNode node(leg->routeNodeOffset,
+                   source.object,
+                   noRNode);
+
+        node.currentCost=leg->cost;
+        node.overallCost=leg->cost;
+
+        index=state.AddNode(node);
+        times.push_back(leg->time);
+
+        state.openList.Push(index,
+                            RNodeCost(leg->cost,
+                                      leg->routeNodeOffset));
+      }
+
+      while (!state.openList.IsEmpty() &&
+             settledTargetNodes<targetMap.size()) {
+        uint32_t currentIndex=state.openList.Pop();
+        // Copy, since adding new nodes may move the array
+        RNode    current=state.nodes[currentIndex];
+        double   currentTime=times[currentIndex];
+
+        state.nodes[currentIndex].closed=true;
+
+        TargetMap::const_iterator targetEntry=targetMap.find(current.nodeOffset);
+
+        if (targetEntry!=targetMap.end()) {
+          settledTargetNodes++;
+
+          for (std::vector<TargetLeg>::const_iterator leg=targetEntry->second.begin();
+               leg!=targetEntry->second.end();
+               ++leg) {
+            double cost=current.currentCost+leg->cost;
+
+            if (!matrix.IsReachable(task,leg->target) ||
+                cost<matrix.GetCost(task,leg->target)) {
+              matrix.Set(task,
+                         leg->target,
+                         cost,
+                         currentTime+leg->time);
+            }
+          }
+
+          if (settledTargetNodes==targetMap.size()) {
+            break;
+          }
+        }
+
+        if (!worker.routeNodeDataFile.GetByOffset(current.nodeOffset,
+                                                  routeNode)) {
+          std::cerr << "Cannot load route node with id " << current.nodeOffset << std::endl;
+          worker.success=false;
+          return;
+        }
+
+        worker.nodesLoadedCount++;
+
+        FileOffset prevOffset=current.prev!=noRNode ? state.nodes[current.prev].nodeOffset : 0;
+
+        for (uint32_t i=0; i<routeNode->paths.size(); i++) {
+          const RouteNode::Path& path=routeNode->paths[i];
+
+          if (!router.CanTurn(*routeNode,
+                              current.object,
+                              current.access,
+                              prevOffset,
+                              i) ||
+              !profile.CanUse(*routeNode,i)) {
+            continue;
+          }
+
+          uint32_t nextIndex=state.nodeMap.Get(path.offset);
+
+          if (nextIndex!=noRNode &&
+              state.nodes[nextIndex].closed) {
+            continue;
+          }
+
+          double cost=current.currentCost+profile.GetCosts(*routeNode,i);
+          double time=currentTime+profile.GetTime(*routeNode,i);
+
+          if (nextIndex!=noRNode) {
+            RNode& node=state.nodes[nextIndex];
+
+            if (node.currentCost<=cost) {
+              continue;
+            }
+
+            node.prev=currentIndex;
+            node.object=routeNode->objects[path.objectIndex];
+            node.currentCost=cost;
+            node.overallCost=cost;
+            node.access=path.HasAccess();
+            times[nextIndex]=time;
+
+            state.openList.DecreaseKey(nextIndex,
+                                       RNodeCost(cost,
+                                                 path.offset));
+          }
+          else {
+            RNode node(path.offset,
+                       routeNode->objects[path.objectIndex],
+                       currentIndex);
+
+            node.currentCost=cost;
+            node.overallCost=cost;
+            node.access=path.HasAccess();
+
+            nextIndex=state.AddNode(node);
+            times.push_back(time);
+
+            state.openList.Push(nextIndex,
+                                RNodeCost(cost,
+                                          path.offset));
+          }
+        }
+      }
+    }
+  };
+
+  /**
+   * Calculates a route matrix on the contraction hierarchy using buckets
+   * (many-to-many search): in a first phase an upward backward search for each
+   * target stores all nodes reached together with their costs to the target
+   * in the bucket of the node. In a second phase an upward forward search for
+   * each source scans the buckets of all nodes settled. Each phase runs its
+   * searches in parallel, buckets are built in between.
+   *
+   * The costs of the hierarchy are travel times (it is built using the fastest
+   * path profile), so the travel time of a route is its costs in the hierarchy
+   * plus the travel times between the positions and their route nodes.
+   */
+  class Router::MatrixCHJob : public ParallelJob
+  {
+  private:
+    /**
+     * A target reachable from a node, stored in the bucket of the node
+     */
+    struct BucketEntry
+    {
+      uint32_t target;        //! Index of the target
+      uint32_t departurePath; //! Path used to leave the node or noNode
+      double   cost;          //! Costs from the node to the target
+      double   time;          //! Travel time from the node to the target
+    };
+
+    /**
+     * The state of an upward search. Arrays are indexed by hierarchy node.
+     */
+    struct Search
+    {
+      std::vector<double>   costs;           //! Costs or -1
+      std::vector<double>   times;           //! Travel time
+      std::vector<uint32_t> edges;           //! Index of the edge used or noNode for start nodes
+      IndexedHeap<double>   heap;            //! Open nodes, sorted by cost
+      std::vector<uint32_t> touched;         //! All nodes reached
+      uint32_t              startNodes[2];   //! The start nodes
+      uint32_t              startObjects[2]; //! Index of the object of the position in the start nodes
+      size_t                nodesSettledCount;
+
+      void Initialize(size_t nodeCount)
+      {
+        costs.assign(nodeCount,-1.0);
+        times.assign(nodeCount,0.0);
+        edges.assign(nodeCount,ContractionHierarchy::noNode);
+        nodesSettledCount=0;
+      }
+
+      void Clear()
+      {
+        for (std::vector<uint32_t>::const_iterator node=touched.begin();
+             node!=touched.end();
+             ++node) {
+          costs[*node]=-1.0;
+        }
+
+        touched.clear();
+        heap.Clear();
+
+        startNodes[0]=ContractionHierarchy::noNode;
+        startNodes[1]=ContractionHierarchy::noNode;
+      }
+
+      void Update(uint32_t node,
+                  double cost,
+                  double time,
+                  uint32_t edge)
+      {
+        if (costs[node]<0.0) {
+          touched.push_back(node);
+        }
+        else if (cost>=costs[node] ||
+                 !heap.Contains(node)) {
+          return;
+        }
+
+        costs[node]=cost;
+        times[node]=time;
+        edges[node]=edge;
+
+        if (heap.Contains(node)) {
+          heap.DecreaseKey(node,cost);
+        }
+        else {
+          heap.Push(node,cost);
+        }
+      }
+    };
+
+    /**
+     * A node reached by the backward search of a target
+     */
+    struct ReachedNode
+    {
+      uint32_t    node;
+      BucketEntry entry;
+    };
+
+  private:
+    const ContractionHierarchy&            hierarchy;
+    const std::vector<ResolvedPosition>&   sources;
+    const std::vector<ResolvedPosition>&   targets;
+    RouteMatrix&                           matrix;
+    bool                                   backward;     //! true for the first, false for the second phase
+    std::vector<Search>                    searches;     //! State for each worker
+    std::vector<std::vector<ReachedNode> > reachedNodes; //! Result of the backward search for each target
+    std::vector<uint32_t>                  bucketBegins; //! Index of the first bucket entry of each node (plus end marker)
+    std::vector<BucketEntry>               buckets;      //! Bucket entries of all nodes
+
+  private:
+    void StartSearch(Search& search,
+                     const ResolvedPosition& position)
+    {
+      if (search.costs.empty()) {
+        search.Initialize(hierarchy.GetNodeCount());
+      }
+
+      search.Clear();
+
+      for (size_t i=0; i<position.legs.size() && i<2; i++) {
+        const PositionLeg& leg=position.legs[i];
+        uint32_t         node=hierarchy.GetNode(leg.routeNodeOffset);
+
+        search.startNodes[i]=node;
+        search.startObjects[i]=leg.objectIndex!=noRNode ? leg.objectIndex : ContractionHierarchy::noNode;
+
+        search.Update(node,
+                      leg.cost,
+                      leg.time,
+                      ContractionHierarchy::noNode);
+      }
+    }
+
+    void SearchBackward(size_t target,
+                        Search& search)
+    {
+      StartSearch(search,
+                  targets[target]);
+
+      while (!search.heap.IsEmpty()) {
+        uint32_t    node=search.heap.Pop();
+        uint32_t    edge=search.edges[node];
+        ReachedNode reached;
+
+        search.nodesSettledCount++;
+
+        reached.node=node;
+        reached.entry.target=(uint32_t)target;
+        reached.entry.departurePath=edge!=ContractionHierarchy::noNode ? hierarchy.GetEdge(edge).sourcePath : ContractionHierarchy::noNode;
+        reached.entry.cost=search.costs[node];
+        reached.entry.time=search.times[node];
+
+        reachedNodes[target].push_back(reached);
+
+        for (uint32_t e=hierarchy.GetEdgesBegin(node);
+             e<hierarchy.GetEdgesEnd(node);
+             e++) {
+          const ContractionHierarchy::Edge& edge=hierarchy.GetEdge(e);
+
+          if (!edge.IsBackward() ||
+              !hierarchy.CanTurn(node,
+                                 edge.targetObject,
+                                 edge.HasAccess(),
+                                 reached.entry.departurePath)) {
+            continue;
+          }
+
+          search.Update(edge.node,
+                        search.costs[node]+edge.cost,
+                        search.times[node]+edge.cost,
+                        e);
+        }
+      }
+    }
+
+    void SearchForward(size_t source,
+                       Search& search)
+    {
+      StartSearch(search,
+                  sources[source]);
+
+      while (!search.heap.IsEmpty()) {
+        uint32_t node=search.heap.Pop();
+        uint32_t edge=search.edges[node];
+        uint32_t arrivalObject=ContractionHierarchy::noNode;
+        bool     arrivalAccess=true;
+
+        search.nodesSettledCount++;
+
+        if (edge!=ContractionHierarchy::noNode) {
+          arrivalObject=hierarchy.GetEdge(edge).targetObject;
+          arrivalAccess=hierarchy.GetEdge(edge).HasAccess();
+        }
+        else {
+          for (size_t i=0; i<2; i++) {
+            if (search.startNodes[i]==node) {
+              arrivalObject=search.startObjects[i];
+            }
+          }
+        }
+
+        for (uint32_t b=bucketBegins[node]; b<bucketBegins[node+1]; b++) {
+          const BucketEntry& entry=buckets[b];
+
+          if (!hierarchy.CanTurn(node,
+                                 arrivalObject,
+                                 arrivalAccess,
+                                 entry.departurePath)) {
+            continue;
+          }
+
+          double cost=search.costs[node]+entry.cost;
+
+          if (!matrix.IsReachable(source,entry.target) ||
+              cost<matrix.GetCost(source,entry.target)) {
+            matrix.Set(source,
+                       entry.target,
+                       cost,
+                       search.times[node]+entry.time);
+          }
+        }
+
+        for (uint32_t e=hierarchy.GetEdgesBegin(node);
+             e<hierarchy.GetEdgesEnd(node);
+             e++) {
+          const ContractionHierarchy::Edge& edge=hierarchy.GetEdge(e);
+
+          if (!edge.IsForward() ||
+              !hierarchy.CanTurn(node,
+                                 arrivalObject,
+                                 arrivalAccess,
+                                 edge.sourcePath)) {
+            continue;
+          }
+
+          search.Update(edge.node,
+                        search.costs[node]+edge.cost,
+                        search.times[node]+edge.cost,
+                        e);
+        }
+      }
+    }
+
+  public:
+    MatrixCHJob(const ContractionHierarchy& hierarchy,
+                const std::vector<ResolvedPosition>& sources,
+                const std::vector<ResolvedPosition>& targets,
+                RouteMatrix& matrix,
+                size_t workerCount)
+    : hierarchy(hierarchy),
+      sources(sources),
+      targets(targets),
+      matrix(matrix),
+      backward(true),
+      searches(workerCount),
+      reachedNodes(targets.size())
+    {
+      // no code
+    }
+
+    /**
+     * Return true, if all route nodes of the sources and targets are part of
+     * the hierarchy
+     */
+    bool CheckEndpoints() const
+    {
+      const std::vector<ResolvedPosition>* endpoints[2]={&sources,&targets};
+
+      for (size_t i=0; i<2; i++) {
+        for (std::vector<ResolvedPosition>::const_iterator endpoint=endpoints[i]->begin();
+             endpoint!=endpoints[i]->end();
+             ++endpoint) {
+          for (std::vector<PositionLeg>::const_iterator leg=endpoint->legs.begin();
+               leg!=endpoint->legs.end();
+               ++leg) {
+            if (hierarchy.GetNode(leg->routeNodeOffset)==ContractionHierarchy::noNode) {
+              std::cerr << "Route node " << leg->routeNodeOffset << " is not part of the contraction hierarchy" << std::endl;
+              return false;
+            }
+          }
+        }
+      }
+
+      return true;
+    }
+
+    /**
+     * Move the result of the backward searches into the buckets and switch to
+     * the forward searches.
+     */
+    void BuildBuckets()
+    {
+      bucketBegins.assign(hierarchy.GetNodeCount()+1,0);
+
+      for (size_t t=0; t<reachedNodes.size(); t++) {
+        for (std::vector<ReachedNode>::const_iterator reached=reachedNodes[t].begin();
+             reached!=reachedNodes[t].end();
+             ++reached) {
+          bucketBegins[reached->node+1]++;
+        }
+      }
+
+      for (size_t n=1; n<bucketBegins.size(); n++) {
+        bucketBegins[n]+=bucketBegins[n-1];
+      }
+
+      std::vector<uint32_t> positions(bucketBegins.begin(),bucketBegins.end()-1);
+
+      buckets.resize(bucketBegins.back());
+
+      for (size_t t=0; t<reachedNodes.size(); t++) {
+        for (std::vector<ReachedNode>::const_iterator reached=reachedNodes[t].begin();
+             reached!=reachedNodes[t].end();
+             ++reached) {
+          buckets[positions[reached->node]++]=reached->entry;
+        }
+
+        std::vector<ReachedNode>().swap(reachedNodes[t]);
+      }
+
+      backward=false;
+    }
+
+    size_t GetBucketEntryCount() const
+    {
+      return buckets.size();
+    }
+
+    size_t GetNodesSettledCount() const
+    {
+      size_t count=0;
+
+      for (size_t i=0; i<searches.size(); i++) {
+        count+=searches[i].nodesSettledCount;
+      }
+
+      return count;
+    }
+
+    void Execute(size_t task,
+                 size_t worker)
+    {
+      if (backward) {
+        SearchBackward(task,
+                       searches[worker]);
+      }
+      else {
+        SearchForward(task,
+                      searches[worker]);
+      }
+    }
+  };
+
+  bool Router::CalculateMatrixDijkstra(const RoutingProfile& profile,
+                                       const std::vector<ResolvedPosition>& sources,
+                                       const std::vector<ResolvedPosition>& targets,
+                                       RouteMatrix& matrix)
+  {
+    MatrixDijkstraJob job(*this,
+                          profile,
+                          sources,
+                          targets,
+                          matrix);
+
+    if (!job.Open(path,
+                  threadPool->GetWorkerCount())) {
+      return false;
+    }
+
+    threadPool->Execute(job,
+                        sources.size());
+
+    if (debugPerformance) {
+      std::cout << "Route nodes loaded:  " << job.GetNodesLoadedCount() << std::endl;
+    }
+
+    return job.IsSuccess();
+  }
+
+  bool Router::CalculateMatrixCH(const std::vector<ResolvedPosition>& sources,
+                                 const std::vector<ResolvedPosition>& targets,
+                                 RouteMatrix& matrix)
+  {
+    MatrixCHJob job(*contractionHierarchy,
+                    sources,
+                    targets,
+                    matrix,
+                    threadPool->GetWorkerCount());
+
+    if (!job.CheckEndpoints()) {
+      return false;
+    }
+
+    threadPool->Execute(job,
+                        targets.size());
+
+    job.BuildBuckets();
+
+    threadPool->Execute(job,
+                        sources.size());
+
+    if (debugPerformance) {
+      std::cout << "Nodes settled:       " << job.GetNodesSettledCount() << std::endl;
+      std::cout << "Bucket entries:      " << job.GetBucketEntryCount() << std::endl;
+    }
+
+    return true;
+  }
+
+  /**
+   * Calculate the costs and travel times of the routes from each source to
+   * each target without resolving the routes themselves.
+   *
+   * If the contraction hierarchy is loaded and matches the routing profile,
+   * a bucket based many-to-many search on the hierarchy is used, else a Dijkstra search on the route graph
+   * for each source. In both cases the searches are distributed on a number
+   * of workers (see RouterParameter::SetMatrixWorkerCount()).
+   *
+   * Only positions on ways are supported as sources and targets, positions
+   * on areas are rejected.
+   *
+   * Returns false on error. Targets that cannot be reached from a source are
+   * marked as unreachable in the matrix.
+   */
+  bool Router::CalculateMatrix(const RoutingProfile& profile,
+                               const std::vector<RoutePosition>& sources,
+                               const std::vector<RoutePosition>& targets,
+                               RouteMatrix& matrix)
+  {
+    std::vector<ResolvedPosition> resolvedSources(sources.size());
+    std::vector<ResolvedPosition> resolvedTargets(targets.size());
+
+    matrix.Initialize(sources.size(),
+                      targets.size());
+
+    for (size_t s=0; s<sources.size(); s++) {
+      if (!ResolvePosition(profile,
+                           sources[s],
+                           resolvedSources[s])) {
+        return false;
+      }
+    }
+
+    for (size_t t=0; t<targets.size(); t++) {
+      if (!ResolvePosition(profile,
+                           targets[t],
+                           resolvedTargets[t])) {
+        return false;
+      }
+    }
+
+    if (sources.empty() ||
+        targets.empty()) {
+      return true;
+    }
+
+    if (threadPool==NULL) {
+      threadPool=new ThreadPool(matrixWorkerCount);
+    }
+
+    StopClock clock;
+    bool      success=false;
+
+    if (CanUseContractionHierarchy(profile)) {
+      success=CalculateMatrixCH(resolvedSources,
+                                resolvedTargets,
+                                matrix);
+
+      if (!success) {
+        std::cerr << "Falling back to Dijkstra search" << std::endl;
+
+        matrix.Initialize(sources.size(),
+                          targets.size());
+      }
+    }
+
+    if (!success) {
+      success=CalculateMatrixDijkstra(profile,
+                                      resolvedSources,
+                                      resolvedTargets,
+                                      matrix);
+    }
+
+    clock.Stop();
+
+    if (debugPerformance) {
+      std::cout << "Matrix:              " << sources.size() << "x" << targets.size() << std::endl;
+      std::cout << "Workers:             " << threadPool->GetWorkerCount() << std::endl;
+      std::cout << "Time:                " << clock << std::endl;
+    }
+
+    return success;
+  }
+
+  /**
+   * Calculate all route nodes reachable from the given start position within
+   * the given budget, either limiting the costs of the routing profile or the
+   * travel time. The visitor gets called for each route node reached in the
+   * order of increasing costs, without resolving any routes.
+   *
+   * The search is a Dijkstra search on the route graph, that does not follow paths
+   * exceeding the budget. If the budget limits the travel time, the travel time
+   * of a route node is the travel time of its cheapest route.
+   *
+   * The search state is reused between calls, so after the first call (nearly)
+   * no memory is allocated.
+   */
+  bool Router::CalculateReachableNodes(const RoutingProfile& profile,
+                                       const RoutePosition& start,
+                                       Budget budgetType,
+                                       double budget,
+                                       ReachableNodeVisitor& visitor)
+  {
+    RoutingState&              state=routingState;
+    std::vector<ReachableNode>& nodes=reachableNodes;
+    ResolvedPosition           position;
+    RouteNodeRef               routeNode;
+    size_t                     nodesLoadedCount=0;
+
+    state.Clear();
+    nodes.clear();
+
+    if (!ResolvePosition(profile,
+                         start,
+                         position)) {
+      return false;
+    }
+
+    StopClock clock;
+
+    for (std::vector<PositionLeg>::const_iterator leg=position.legs.begin();
+         leg!=position.legs.end();
+         ++leg) {
+      if ((budgetType==costBudget ? leg->cost : leg->time)>budget ||
+          state.nodeMap.Get(leg->routeNodeOffset)!=noRNode) {
+        continue;
+      }
+
+      RNode         node(leg->routeNodeOffset,
+                         position.object,
+                         noRNode);
+      ReachableNode reachable;
+
+      node.currentCost=leg->cost;
+      node.overallCost=leg->cost;
+
+      reachable.id=0;
+      reachable.offset=leg->routeNodeOffset;
+      reachable.lon=leg->lon;
+      reachable.lat=leg->lat;
+      reachable.cost=leg->cost;
+      reachable.time=leg->time;
+
+      state.openList.Push(state.AddNode(node),
+                          RNodeCost(leg->cost,
+                                    leg->routeNodeOffset));
+      nodes.push_back(reachable);
+    }
+
+    while (!state.openList.IsEmpty()) {
+      uint32_t currentIndex=state.openList.Pop();
+      // Copy, since adding new nodes may move the arrays
+      RNode    current=state.nodes[currentIndex];
+
+      state.nodes[currentIndex].closed=true;
+
+      if (!routeNodeDataFile.GetByOffset(current.nodeOffset,
+                                         routeNode)) {
+        std::cerr << "Cannot load route node with id " << current.nodeOffset << std::endl;
+        return false;
+      }
+
+      nodesLoadedCount++;
+
+      nodes[currentIndex].id=routeNode->GetId();
+
+      if (!visitor.Visit(nodes[currentIndex])) {
+        break;
+      }
+
+      double     currentTime=nodes[currentIndex].time;
+      FileOffset prevOffset=current.prev!=noRNode ? state.nodes[current.prev].nodeOffset : 0;
+
+      for (uint32_t i=0; i<routeNode->paths.size(); i++) {
+        const RouteNode::Path& path=routeNode->paths[i];
+
+        if (!CanTurn(*routeNode,
+                     current.object,
+                     current.access,
+                     prevOffset,
+                     i) ||
+            !profile.CanUse(*routeNode,i)) {
+          continue;
+        }
+
+        uint32_t nextIndex=state.nodeMap.Get(path.offset);
+
+        if (nextIndex!=noRNode &&
+            state.nodes[nextIndex].closed) {
+          continue;
+        }
+
+        double cost=current.currentCost+profile.GetCosts(*routeNode,i);
+        double time=currentTime+profile.GetTime(*routeNode,i);
+
+        if ((budgetType==costBudget ? cost : time)>budget) {
+          continue;
+        }
+
+        if (nextIndex!=noRNode) {
+          RNode& node=state.nodes[nextIndex];
+
+          if (node.currentCost<=cost) {
+            continue;
+          }
+
+          node.prev=currentIndex;
+          node.object=routeNode->objects[path.objectIndex];
+          node.currentCost=cost;
+          node.overallCost=cost;
+          node.access=path.HasAccess();
+
+          nodes[nextIndex].cost=cost;
+          nodes[nextIndex].time=time;
+
+          state.openList.DecreaseKey(nextIndex,
+                                     RNodeCost(cost,
+                                               path.offset));
+        }
+        else {
+          RNode         node(path.offset,
+                             routeNode->objects[path.objectIndex],
+                             currentIndex);
+          ReachableNode reachable;
+
+          node.currentCost=cost;
+          node.overallCost=cost;
+          node.access=path.HasAccess();
+
+          reachable.id=0;
+          reachable.offset=path.offset;
+          reachable.lon=path.lon;
+          reachable.lat=path.lat;
+          reachable.cost=cost;
+          reachable.time=time;
+
+          state.openList.Push(state.AddNode(node),
+                              RNodeCost(cost,
+                                        path.offset));
+          nodes.push_back(reachable);
+        }
+      }
+    }
+
+    clock.Stop();
+
+    if (debugPerformance) {
+      std::cout << "Time:                " << clock << std::endl;
+      std::cout << "Route nodes loaded:  " << nodesLoadedCount << std::endl;
+    }
 
     return true;
   }
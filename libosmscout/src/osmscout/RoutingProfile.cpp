@@ -19,6 +19,7 @@
 
 #include <osmscout/RoutingProfile.h>
 
+#include <cstring>
 #include <limits>
 #include <iostream>
 
@@ -31,6 +32,11 @@ namespace osmscout {
     // no code
   }
 
+  uint64_t RoutingProfile::GetCostHash() const
+  {
+    return 0;
+  }
+
   AbstractRoutingProfile::AbstractRoutingProfile()
    : vehicle(vehicleCar),
      vehicleRouteNodeBit(RouteNode::usableByCar),
@@ -145,5 +151,60 @@ namespace osmscout {
 
     speeds[type]=speed;
   }
-}
 
+  /**
+   * FNV-1a hash of the given bytes
+   */
+  static void HashBytes(uint64_t& hash,
+                        const void* data,
+                        size_t size)
+  {
+    const unsigned char* bytes=(const unsigned char*)data;
+
+    for (size_t i=0; i<size; i++) {
+      hash^=bytes[i];
+      hash*=1099511628211ULL;
+    }
+  }
+
+  static void HashDouble(uint64_t& hash,
+                         double value)
+  {
+    uint64_t bits;
+
+    memcpy(&bits,&value,sizeof(bits));
+
+    HashBytes(hash,&bits,sizeof(bits));
+  }
+
+  /**
+   * Calculate a hash over the given type of cost calculation, the vehicle and
+   * all speeds.
+   */
+  uint64_t AbstractRoutingProfile::CalculateCostHash(uint8_t costType) const
+  {
+    uint64_t hash=14695981039346656037ULL;
+    uint8_t  vehicleValue=(uint8_t)vehicle;
+
+    HashBytes(hash,&costType,sizeof(costType));
+    HashBytes(hash,&vehicleValue,sizeof(vehicleValue));
+    HashDouble(hash,vehicleMaxSpeed);
+
+    for (size_t type=0; type<speeds.size(); type++) {
+      HashDouble(hash,speeds[type]);
+    }
+
+    // 0 is reserved for "no hash"
+    return hash!=0 ? hash : 1;
+  }
+
+  uint64_t ShortestPathRoutingProfile::GetCostHash() const
+  {
+    return CalculateCostHash(1);
+  }
+
+  uint64_t FastestPathRoutingProfile::GetCostHash() const
+  {
+    return CalculateCostHash(2);
+  }
+}
@@ -21,4 +21,20 @@
 
 namespace osmscout {
 
+  /**
+    Returns the (approximated) memory allocated by the given list of tags,
+    not including the size of the vector object itself.
+    */
+  size_t GetTagsMemorySize(const std::vector<Tag>& tags)
+  {
+    size_t memory=tags.capacity()*sizeof(Tag);
+
+    for (std::vector<Tag>::const_iterator tag=tags.begin();
+         tag!=tags.end();
+         ++tag) {
+      memory+=tag->value.length();
+    }
+
+    return memory;
+  }
 }
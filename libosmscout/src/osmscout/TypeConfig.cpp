@@ -21,14 +21,85 @@
 
 #include <osmscout/system/Assert.h>
 
+#include <algorithm>
 #include <iostream>
 namespace osmscout {
 
+  TagValueTable::TagValueTable()
+  : valueCount(0)
+  {
+    // no code
+  }
+
+  /**
+   * Return the id of the given value of the given tag, assigning a new id
+   * if the value is not yet known.
+   */
+  uint32_t TagValueTable::RegisterValue(TagId tag,
+                                        const std::string& value)
+  {
+    if (tag>=valueIds.size()) {
+      valueIds.resize(tag+1);
+    }
+
+    OSMSCOUT_HASHMAP<std::string,uint32_t>::const_iterator entry=valueIds[tag].find(value);
+
+    if (entry!=valueIds[tag].end()) {
+      return entry->second;
+    }
+
+    valueCount++;
+
+    valueIds[tag].insert(std::make_pair(value,valueCount));
+
+    return valueCount;
+  }
+
+  /**
+   * Return the id of the given value of the given tag or 0, if the value
+   * is not known.
+   */
+  uint32_t TagValueTable::GetValueId(TagId tag,
+                                     const std::string& value) const
+  {
+    if (tag>=valueIds.size() ||
+        valueIds[tag].empty()) {
+      return 0;
+    }
+
+    OSMSCOUT_HASHMAP<std::string,uint32_t>::const_iterator entry=valueIds[tag].find(value);
+
+    if (entry==valueIds[tag].end()) {
+      return 0;
+    }
+
+    return entry->second;
+  }
+
   TagCondition::~TagCondition()
   {
     // no code
   }
 
+  const InternedTag* TagCondition::FindTag(const InternedTagList& tags,
+                                           TagId tag)
+  {
+    InternedTag key;
+
+    key.tag=tag;
+
+    InternedTagList::const_iterator entry=std::lower_bound(tags.begin(),
+                                                           tags.end(),
+                                                           key);
+
+    if (entry==tags.end() ||
+        entry->tag!=tag) {
+      return NULL;
+    }
+
+    return &(*entry);
+  }
+
   TagNotCondition::TagNotCondition(TagCondition* condition)
   : condition(condition)
   {
@@ -40,6 +111,23 @@ namespace osmscout {
     return !condition->Evaluate(tagMap);
   }
 
+  bool TagNotCondition::Evaluate(const InternedTagList& tags) const
+  {
+    return !condition->Evaluate(tags);
+  }
+
+  bool TagNotCondition::Compile(TagValueTable& valueTable,
+                                std::vector<TagTrigger>& /*triggers*/)
+  {
+    std::vector<TagTrigger> conditionTriggers;
+
+    condition->Compile(valueTable,
+                       conditionTriggers);
+
+    // A negation is true, if the tags of the condition are missing
+    return false;
+  }
+
   TagBoolCondition::TagBoolCondition(Type type)
   : type(type)
   {
@@ -81,6 +169,76 @@ namespace osmscout {
     }
   }
 
+  bool TagBoolCondition::Evaluate(const InternedTagList& tags) const
+  {
+    switch (type) {
+    case boolAnd:
+      for (std::list<TagConditionRef>::const_iterator condition=conditions.begin();
+           condition!=conditions.end();
+           ++condition) {
+        if (!(*condition)->Evaluate(tags)) {
+          return false;
+        }
+      }
+
+      return true;
+    case boolOr:
+      for (std::list<TagConditionRef>::const_iterator condition=conditions.begin();
+           condition!=conditions.end();
+           ++condition) {
+        if ((*condition)->Evaluate(tags)) {
+          return true;
+        }
+      }
+
+      return false;
+    default:
+      assert(false);
+
+      return false;
+    }
+  }
+
+  bool TagBoolCondition::Compile(TagValueTable& valueTable,
+                                 std::vector<TagTrigger>& triggers)
+  {
+    bool triggered=(type==boolOr);
+    bool hasTriggers=false;
+
+    for (std::list<TagConditionRef>::const_iterator condition=conditions.begin();
+         condition!=conditions.end();
+         ++condition) {
+      std::vector<TagTrigger> conditionTriggers;
+      bool                    conditionTriggered=(*condition)->Compile(valueTable,
+                                                                       conditionTriggers);
+
+      if (type==boolAnd) {
+        // One triggered child is sufficient, since all children must be true
+        if (conditionTriggered &&
+            !hasTriggers) {
+          triggers.insert(triggers.end(),
+                          conditionTriggers.begin(),
+                          conditionTriggers.end());
+          hasTriggers=true;
+          triggered=true;
+        }
+      }
+      else {
+        // All children must be triggered, since any child may be true
+        if (conditionTriggered) {
+          triggers.insert(triggers.end(),
+                          conditionTriggers.begin(),
+                          conditionTriggers.end());
+        }
+        else {
+          triggered=false;
+        }
+      }
+    }
+
+    return triggered;
+  }
+
   TagExistsCondition::TagExistsCondition(TagId tag)
   : tag(tag)
   {
@@ -92,12 +250,31 @@ namespace osmscout {
     return tagMap.find(tag)!=tagMap.end();
   }
 
+  bool TagExistsCondition::Evaluate(const InternedTagList& tags) const
+  {
+    return FindTag(tags,tag)!=NULL;
+  }
+
+  bool TagExistsCondition::Compile(TagValueTable& /*valueTable*/,
+                                   std::vector<TagTrigger>& triggers)
+  {
+    TagTrigger trigger;
+
+    trigger.tag=tag;
+    trigger.value=0;
+
+    triggers.push_back(trigger);
+
+    return true;
+  }
+
   TagBinaryCondition::TagBinaryCondition(TagId tag,
                                          BinaryOperator binaryOperator,
                                          const std::string& tagValue)
   : tag(tag),
     binaryOperator(binaryOperator),
-    tagValue(tagValue)
+    tagValue(tagValue),
+    tagValueId(0)
   {
     // no code
   }
@@ -126,6 +303,47 @@ namespace osmscout {
     }
   }
 
+  bool TagBinaryCondition::Evaluate(const InternedTagList& tags) const
+  {
+    const InternedTag* t=FindTag(tags,tag);
+
+    switch (binaryOperator) {
+    case  operatorEqual:
+      if (t==NULL) {
+        return false;
+      }
+      return t->value==tagValueId;
+    case operatorNotEqual:
+      if (t==NULL) {
+        return true;
+      }
+      return t->value!=tagValueId;
+    default:
+      assert(false);
+
+      return false;
+    }
+  }
+
+  bool TagBinaryCondition::Compile(TagValueTable& valueTable,
+                                   std::vector<TagTrigger>& triggers)
+  {
+    tagValueId=valueTable.RegisterValue(tag,tagValue);
+
+    if (binaryOperator!=operatorEqual) {
+      return false;
+    }
+
+    TagTrigger trigger;
+
+    trigger.tag=tag;
+    trigger.value=tagValueId;
+
+    triggers.push_back(trigger);
+
+    return true;
+  }
+
   TagIsInCondition::TagIsInCondition(TagId tag)
   : tag(tag)
   {
@@ -150,6 +368,42 @@ namespace osmscout {
     return tagValues.find(t->second)!=tagValues.end();
   }
 
+  bool TagIsInCondition::Evaluate(const InternedTagList& tags) const
+  {
+    const InternedTag* t=FindTag(tags,tag);
+
+    if (t==NULL) {
+      return false;
+    }
+
+    return std::binary_search(tagValueIds.begin(),
+                              tagValueIds.end(),
+                              t->value);
+  }
+
+  bool TagIsInCondition::Compile(TagValueTable& valueTable,
+                                 std::vector<TagTrigger>& triggers)
+  {
+    tagValueIds.clear();
+
+    for (std::set<std::string>::const_iterator tagValue=tagValues.begin();
+         tagValue!=tagValues.end();
+         ++tagValue) {
+      TagTrigger trigger;
+
+      trigger.tag=tag;
+      trigger.value=valueTable.RegisterValue(tag,*tagValue);
+
+      tagValueIds.push_back(trigger.value);
+      triggers.push_back(trigger);
+    }
+
+    std::sort(tagValueIds.begin(),
+              tagValueIds.end());
+
+    return true;
+  }
+
   TagInfo::TagInfo()
    : id(0),
      internalOnly(true)
@@ -251,7 +505,8 @@ namespace osmscout {
 
   TypeConfig::TypeConfig()
    : nextTagId(0),
-     nextTypeId(0)
+     nextTypeId(0),
+     multipolygonValueId(0)
   {
     // Make sure, that this is always registered first.
     // It assures that id 0 is always reserved for tagIgnore
@@ -384,6 +639,8 @@ namespace osmscout {
     tagArea=GetTagId("area");
     tagNatural=GetTagId("natural");
 
+    multipolygonValueId=tagValueTable.RegisterValue(tagType,"multipolygon");
+
     assert(tagRef!=tagIgnore);
     assert(tagBridge!=tagIgnore);
     assert(tagTunnel!=tagIgnore);
@@ -561,9 +818,86 @@ namespace osmscout {
 
     idToTypeMap[typeInfo.GetId()]=typeInfo;
 
+    AddTypeRules(typeInfo);
+
     return *this;
   }
 
+  /**
+   * Compile the conditions of the given type and add them to the rule table.
+   * Since types are added in the order of evaluation, rules are appended.
+   */
+  void TypeConfig::AddTypeRules(const TypeInfo& typeInfo)
+  {
+    for (std::list<TypeInfo::TypeCondition>::const_iterator cond=typeInfo.GetConditions().begin();
+         cond!=typeInfo.GetConditions().end();
+         ++cond) {
+      TypeRule rule;
+
+      rule.type=typeInfo.GetId();
+      rule.types=cond->types;
+      rule.kinds=0;
+      rule.condition=cond->condition;
+
+      if (typeInfo.CanBeNode() &&
+          (cond->types & TypeInfo::typeNode)) {
+        rule.kinds|=ruleNode;
+      }
+
+      if ((typeInfo.CanBeWay() || typeInfo.CanBeArea()) &&
+          (cond->types & (TypeInfo::typeWay | TypeInfo::typeArea))) {
+        rule.kinds|=ruleWayArea;
+      }
+
+      if (typeInfo.CanBeArea() &&
+          (cond->types & TypeInfo::typeArea)) {
+        rule.kinds|=ruleMultipolygon;
+      }
+
+      if (typeInfo.CanBeRelation() &&
+          (cond->types & TypeInfo::typeRelation)) {
+        rule.kinds|=ruleRelation;
+      }
+
+      std::vector<TagTrigger> triggers;
+      uint32_t                ruleIndex=(uint32_t)typeRules.size();
+
+      typeRules.push_back(rule);
+
+      if (!rule.condition->Compile(tagValueTable,
+                                   triggers)) {
+        untriggeredRules.push_back(ruleIndex);
+        continue;
+      }
+
+      for (std::vector<TagTrigger>::const_iterator trigger=triggers.begin();
+           trigger!=triggers.end();
+           ++trigger) {
+        std::vector<uint32_t>* rules;
+
+        if (trigger->value==0) {
+          if (trigger->tag>=tagRules.size()) {
+            tagRules.resize(trigger->tag+1);
+          }
+
+          rules=&tagRules[trigger->tag];
+        }
+        else {
+          if (trigger->value>=tagValueRules.size()) {
+            tagValueRules.resize(trigger->value+1);
+          }
+
+          rules=&tagValueRules[trigger->value];
+        }
+
+        if (rules->empty() ||
+            rules->back()!=ruleIndex) {
+          rules->push_back(ruleIndex);
+        }
+      }
+    }
+  }
+
   TypeId TypeConfig::GetMaxTypeId() const
   {
     if (nextTypeId==0) {
@@ -655,141 +989,249 @@ namespace osmscout {
     return true;
   }
 
-  bool TypeConfig::GetNodeTypeId(const std::map<TagId,std::string>& tagMap,
-                                 TypeId &typeId) const
+  /**
+   * Convert the given tags to a list of tags with interned values, as
+   * expected by the InternedTagList variants of the type lookup methods.
+   */
+  void TypeConfig::InternTags(const std::map<TagId,std::string>& tagMap,
+                              InternedTagList& tags) const
   {
-    typeId=typeIgnore;
+    tags.clear();
+    tags.reserve(tagMap.size());
 
-    if (tagMap.empty()) {
-      return false;
+    // std::map is sorted by tag id, so the result is sorted, too
+    for (std::map<TagId,std::string>::const_iterator t=tagMap.begin();
+         t!=tagMap.end();
+         ++t) {
+      InternedTag tag;
+
+      tag.tag=t->first;
+      tag.value=tagValueTable.GetValueId(t->first,
+                                         t->second);
+
+      tags.push_back(tag);
     }
+  }
 
-    for (size_t i=0; i<types.size(); i++) {
-      if (!types[i].HasConditions() ||
-          !types[i].CanBeNode()) {
-        continue;
+  /**
+   * Find the smallest rule index of the given kind in the (ascending) list of
+   * rules that is bigger than 'after' (or the smallest at all, if 'first' is
+   * true). Updates 'next' only if such a rule exists and it is smaller than
+   * the current value of 'next' (or 'found' is false).
+   */
+  void TypeConfig::FindNextRule(const std::vector<uint32_t>& rules,
+                                unsigned char kind,
+                                bool first,
+                                uint32_t after,
+                                bool& found,
+                                uint32_t& next) const
+  {
+    std::vector<uint32_t>::const_iterator r=first ? rules.begin() : std::upper_bound(rules.begin(),
+                                                                                      rules.end(),
+                                                                                      after);
+
+    while (r!=rules.end() &&
+           (!found || *r<next)) {
+      if (typeRules[*r].kinds & kind) {
+        next=*r;
+        found=true;
+        return;
       }
 
-      for (std::list<TypeInfo::TypeCondition>::const_iterator cond=types[i].GetConditions().begin();
-           cond!=types[i].GetConditions().end();
-           ++cond) {
-        if (!(cond->types & TypeInfo::typeNode)) {
-          continue;
+      ++r;
+    }
+  }
+
+  /**
+   * Find the first rule of the given kind (in order of the types and their
+   * conditions) that matches the given tags.
+   *
+   * Instead of evaluating all rules, only the rules triggered by one of the
+   * tags (or the values of the tags) and the rules without triggers are
+   * evaluated. Since all rule lists are sorted, the candidates are
+   * enumerated in ascending order by walking the lists directly, without
+   * collecting them in a temporary buffer first.
+   */
+  bool TypeConfig::GetFirstMatchingRule(const InternedTagList& tags,
+                                        unsigned char kind,
+                                        size_t& rule) const
+  {
+    bool     first=true;
+    uint32_t current=0;
+
+    while (true) {
+      bool     found=false;
+      uint32_t next=0;
+
+      FindNextRule(untriggeredRules,
+                   kind,
+                   first,
+                   current,
+                   found,
+                   next);
+
+      for (InternedTagList::const_iterator tag=tags.begin();
+           tag!=tags.end();
+           ++tag) {
+        if (tag->tag<tagRules.size()) {
+          FindNextRule(tagRules[tag->tag],
+                       kind,
+                       first,
+                       current,
+                       found,
+                       next);
         }
 
-        if (cond->condition->Evaluate(tagMap)) {
-          typeId=types[i].GetId();
-          return true;
+        if (tag->value!=0 &&
+            tag->value<tagValueRules.size()) {
+          FindNextRule(tagValueRules[tag->value],
+                       kind,
+                       first,
+                       current,
+                       found,
+                       next);
         }
       }
+
+      if (!found) {
+        return false;
+      }
+
+      if (typeRules[next].condition->Evaluate(tags)) {
+        rule=next;
+        return true;
+      }
+
+      first=false;
+      current=next;
     }
+  }
 
-    return false;
+  bool TypeConfig::GetNodeTypeId(const std::map<TagId,std::string>& tagMap,
+                                 TypeId &typeId) const
+  {
+    InternedTagList tags;
+
+    InternTags(tagMap,
+               tags);
+
+    return GetNodeTypeId(tags,
+                         typeId);
   }
 
   bool TypeConfig::GetWayAreaTypeId(const std::map<TagId,std::string>& tagMap,
                                     TypeId &wayType,
                                     TypeId &areaType) const
   {
-    wayType=typeIgnore;
-    areaType=typeIgnore;
+    InternedTagList tags;
+
+    InternTags(tagMap,
+               tags);
+
+    return GetWayAreaTypeId(tags,
+                            wayType,
+                            areaType);
+  }
+
+  bool TypeConfig::GetRelationTypeId(const std::map<TagId,std::string>& tagMap,
+                                     TypeId &typeId) const
+  {
+    InternedTagList tags;
+
+    InternTags(tagMap,
+               tags);
+
+    return GetRelationTypeId(tags,
+                             typeId);
+  }
+
+  bool TypeConfig::GetNodeTypeId(const InternedTagList& tags,
+                                 TypeId &typeId) const
+  {
+    size_t rule;
+
+    typeId=typeIgnore;
 
-    if (tagMap.empty()) {
+    if (tags.empty()) {
       return false;
     }
 
-    for (size_t i=0; i<types.size(); i++) {
-      if (!((types[i].CanBeWay() ||
-             types[i].CanBeArea()) &&
-             types[i].HasConditions())) {
-        continue;
-      }
+    if (!GetFirstMatchingRule(tags,
+                              ruleNode,
+                              rule)) {
+      return false;
+    }
 
-      for (std::list<TypeInfo::TypeCondition>::const_iterator cond=types[i].GetConditions().begin();
-           cond!=types[i].GetConditions().end();
-           ++cond) {
-        if (!((cond->types & TypeInfo::typeWay) || (cond->types & TypeInfo::typeArea))) {
-          continue;
-        }
+    typeId=typeRules[rule].type;
 
-        if (cond->condition->Evaluate(tagMap)) {
-          if (wayType==typeIgnore &&
-              (cond->types & TypeInfo::typeWay)) {
-            wayType=types[i].GetId();
-          }
+    return true;
+  }
 
-          if (areaType==typeIgnore &&
-              (cond->types & TypeInfo::typeArea)) {
-            areaType=types[i].GetId();
-          }
+  bool TypeConfig::GetWayAreaTypeId(const InternedTagList& tags,
+                                    TypeId &wayType,
+                                    TypeId &areaType) const
+  {
+    size_t rule;
 
-          if (wayType!=typeIgnore ||
-              areaType!=typeIgnore) {
-            return true;
-          }
-        }
-      }
+    wayType=typeIgnore;
+    areaType=typeIgnore;
+
+    if (tags.empty()) {
+      return false;
     }
 
-    return false;
+    if (!GetFirstMatchingRule(tags,
+                              ruleWayArea,
+                              rule)) {
+      return false;
+    }
+
+    if (typeRules[rule].types & TypeInfo::typeWay) {
+      wayType=typeRules[rule].type;
+    }
+
+    if (typeRules[rule].types & TypeInfo::typeArea) {
+      areaType=typeRules[rule].type;
+    }
+
+    return true;
   }
 
-  bool TypeConfig::GetRelationTypeId(const std::map<TagId,std::string>& tagMap,
+  bool TypeConfig::GetRelationTypeId(const InternedTagList& tags,
                                      TypeId &typeId) const
   {
+    size_t rule;
+
     typeId=typeIgnore;
 
-    if (tagMap.empty()) {
+    if (tags.empty()) {
       return false;
     }
 
-    std::map<TagId,std::string>::const_iterator relationType=tagMap.find(tagType);
+    InternedTag key;
 
-    if (relationType!=tagMap.end() &&
-        relationType->second=="multipolygon") {
-      for (size_t i=0; i<types.size(); i++) {
-        if (!types[i].HasConditions() ||
-            !types[i].CanBeArea()) {
-          continue;
-        }
+    key.tag=tagType;
 
-        for (std::list<TypeInfo::TypeCondition>::const_iterator cond=types[i].GetConditions().begin();
-             cond!=types[i].GetConditions().end();
-             ++cond) {
-          if (!(cond->types & TypeInfo::typeArea)) {
-            continue;
-          }
+    InternedTagList::const_iterator relationType=std::lower_bound(tags.begin(),
+                                                                  tags.end(),
+                                                                  key);
+    unsigned char kind=ruleRelation;
 
-          if (cond->condition->Evaluate(tagMap)) {
-            typeId=types[i].GetId();
-            return true;
-          }
-        }
-      }
+    if (relationType!=tags.end() &&
+        relationType->tag==tagType &&
+        relationType->value==multipolygonValueId) {
+      kind=ruleMultipolygon;
     }
-    else {
-      for (size_t i=0; i<types.size(); i++) {
-        if (!types[i].HasConditions() ||
-            !types[i].CanBeRelation()) {
-          continue;
-        }
-
-        for (std::list<TypeInfo::TypeCondition>::const_iterator cond=types[i].GetConditions().begin();
-             cond!=types[i].GetConditions().end();
-             ++cond) {
-          if (!(cond->types & TypeInfo::typeRelation)) {
-            continue;
-          }
 
-          if (cond->condition->Evaluate(tagMap)) {
-            typeId=types[i].GetId();
-            return true;
-          }
-        }
-      }
+    if (!GetFirstMatchingRule(tags,
+                              kind,
+                              rule)) {
+      return false;
     }
 
-    return false;
+    typeId=typeRules[rule].type;
+
+    return true;
   }
 
   TypeId TypeConfig::GetTypeId(const std::string& name) const
@@ -306,6 +306,24 @@ namespace osmscout {
     this->layer=layer;
   }
 
+  /**
+    Returns the (approximated) memory used by the attributes including
+    all allocated data.
+    */
+  size_t WayAttributes::GetMemorySize() const
+  {
+    size_t memory=sizeof(WayAttributes);
+
+    memory+=name.length();
+    memory+=nameAlt.length();
+    memory+=ref.length();
+    memory+=location.length();
+    memory+=address.length();
+    memory+=GetTagsMemorySize(tags);
+
+    return memory;
+  }
+
   bool WayAttributes::Read(FileScanner& scanner)
   {
     uint16_t flags;
@@ -652,6 +670,20 @@ namespace osmscout {
     return false;
   }
 
+  /**
+    Returns the (approximated) memory used by the way including
+    all allocated data.
+    */
+  size_t Way::GetMemorySize() const
+  {
+    size_t memory=sizeof(Way)-sizeof(WayAttributes)+attributes.GetMemorySize();
+
+    memory+=ids.capacity()*sizeof(Id);
+    memory+=nodes.capacity()*sizeof(GeoCoord);
+
+    return memory;
+  }
+
   bool Way::Read(FileScanner& scanner)
   {
     uint32_t nodeCount;
@@ -668,22 +700,8 @@ namespace osmscout {
       return false;
     }
 
-    uint32_t minLat;
-    uint32_t minLon;
-
-    scanner.Read(minLat);
-    scanner.Read(minLon);
-
-    nodes.resize(nodeCount);
-    for (size_t i=0; i<nodeCount; i++) {
-      uint32_t latValue;
-      uint32_t lonValue;
-
-      scanner.ReadNumber(latValue);
-      scanner.ReadNumber(lonValue);
-
-      nodes[i].Set((minLat+latValue)/conversionFactor-90.0,
-                   (minLon+lonValue)/conversionFactor-180.0);
+    if (!scanner.ReadDeltaCoords(nodeCount,nodes)) {
+      return false;
     }
 
     ids.resize(nodeCount,0);
@@ -727,22 +745,8 @@ namespace osmscout {
       return false;
     }
 
-    uint32_t minLat;
-    uint32_t minLon;
-
-    scanner.Read(minLat);
-    scanner.Read(minLon);
-
-    nodes.resize(nodeCount);
-    for (size_t i=0; i<nodeCount; i++) {
-      uint32_t latValue;
-      uint32_t lonValue;
-
-      scanner.ReadNumber(latValue);
-      scanner.ReadNumber(lonValue);
-
-      nodes[i].Set((minLat+latValue)/conversionFactor-90.0,
-                   (minLon+lonValue)/conversionFactor-180.0);
+    if (!scanner.ReadDeltaCoords(nodeCount,nodes)) {
+      return false;
     }
 
     return !scanner.HasError();
@@ -0,0 +1,269 @@
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2014  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <osmscout/util/CacheMemoryGovernor.h>
+
+#include <iostream>
+
+namespace osmscout {
+
+  GovernedCache::~GovernedCache()
+  {
+    // no code
+  }
+
+  CacheMemoryGovernor::CacheMemoryGovernor(unsigned long memoryBudget)
+  : memoryBudget(memoryBudget),
+    rebalanceInterval(10000),
+    accessCount(0)
+  {
+    // no code
+  }
+
+  CacheMemoryGovernor::~CacheMemoryGovernor()
+  {
+    // no code
+  }
+
+  /**
+    Calculate the new memory limit of all caches and pass it to the caches.
+    If smooth is false, the limits are set directly and caches without evictions
+    are not limited to their current memory usage (used if the set of caches
+    or the budget changes).
+    */
+  void CacheMemoryGovernor::DistributeBudget(bool smooth)
+  {
+    if (clients.empty()) {
+      return;
+    }
+
+    size_t                     count=clients.size();
+    unsigned long              baseShare=memoryBudget/4/count;
+    double                     remaining=(double)(memoryBudget-baseShare*count);
+    double                     weightSum=0.0;
+    std::vector<double>        weights(count);
+    std::vector<unsigned long> needs(count,0);
+    std::vector<bool>          isFixed(count,false);
+    std::vector<double>        extras(count,0.0);
+
+    for (size_t i=0; i<count; i++) {
+      CacheStatistics statistics=clients[i].cache->GetCacheStatistics();
+      unsigned long   hits=statistics.hits-clients[i].lastStatistics.hits;
+      unsigned long   misses=statistics.misses-clients[i].lastStatistics.misses;
+      unsigned long   evictions=statistics.evictions-clients[i].lastStatistics.evictions;
+
+      clients[i].lastStatistics=statistics;
+
+      weights[i]=misses+hits/4.0+1.0;
+      weightSum+=weights[i];
+
+      if (smooth && evictions==0) {
+        unsigned long usage=clients[i].cache->GetCacheMemoryUsage();
+
+        // Leave some room for growing until the next rebalancing
+        usage+=usage/4;
+
+        isFixed[i]=true;
+        needs[i]=usage>baseShare ? usage-baseShare : 0;
+      }
+    }
+
+    // Caches that are not limited by memory get what they need (if this is less than
+    // their proportional share), the rest is distributed between the other caches
+
+    bool changed=true;
+
+    while (changed) {
+      changed=false;
+
+      for (size_t i=0; i<count; i++) {
+        if (isFixed[i] &&
+            remaining*weights[i]/weightSum>needs[i]) {
+          extras[i]=needs[i];
+          remaining-=needs[i];
+          weightSum-=weights[i];
+          weights[i]=0.0;
+          isFixed[i]=false;
+          changed=true;
+        }
+      }
+    }
+
+    for (size_t i=0; i<count; i++) {
+      if (weights[i]>0.0) {
+        extras[i]=remaining*weights[i]/weightSum;
+      }
+
+      unsigned long target=baseShare+(unsigned long)extras[i];
+
+      if (smooth) {
+        clients[i].limit=clients[i].limit/2+target/2;
+      }
+      else {
+        clients[i].limit=target;
+      }
+
+      // A limit of 0 would mean "no limit"
+      if (clients[i].limit==0) {
+        clients[i].limit=1;
+      }
+
+      clients[i].cache->SetCacheMemoryLimit(clients[i].limit);
+    }
+  }
+
+  /**
+    Set the memory budget (in bytes) to be distributed between all caches.
+    */
+  void CacheMemoryGovernor::SetMemoryBudget(unsigned long memoryBudget)
+  {
+    ScopedLock lock(mutex);
+
+    this->memoryBudget=memoryBudget;
+
+    DistributeBudget(false);
+  }
+
+  /**
+    Set the number of cache accesses (as signaled by NotifyAccesses()) after which
+    the memory limits of the caches are rebalanced.
+    */
+  void CacheMemoryGovernor::SetRebalanceInterval(unsigned long rebalanceInterval)
+  {
+    this->rebalanceInterval=rebalanceInterval;
+  }
+
+  unsigned long CacheMemoryGovernor::GetMemoryBudget() const
+  {
+    return memoryBudget;
+  }
+
+  unsigned long CacheMemoryGovernor::GetRebalanceInterval() const
+  {
+    return rebalanceInterval;
+  }
+
+  /**
+    Register a cache. The budget will be distributed evenly between all
+    caches (respecting the usage since the last rebalancing).
+    */
+  void CacheMemoryGovernor::Register(GovernedCache* cache)
+  {
+    ScopedLock lock(mutex);
+
+    for (std::vector<Client>::const_iterator client=clients.begin();
+         client!=clients.end();
+         ++client) {
+      if (client->cache==cache) {
+        return;
+      }
+    }
+
+    Client client;
+
+    client.cache=cache;
+    client.lastStatistics=cache->GetCacheStatistics();
+    client.limit=0;
+
+    clients.push_back(client);
+
+    DistributeBudget(false);
+  }
+
+  /**
+    Unregister the given cache. The cache keeps its last memory limit.
+    */
+  void CacheMemoryGovernor::Unregister(GovernedCache* cache)
+  {
+    ScopedLock lock(mutex);
+
+    for (std::vector<Client>::iterator client=clients.begin();
+         client!=clients.end();
+         ++client) {
+      if (client->cache==cache) {
+        clients.erase(client);
+
+        DistributeBudget(false);
+        return;
+      }
+    }
+  }
+
+  /**
+    Signal the given number of accesses to the registered caches. Rebalances
+    the memory limits if the rebalance interval is reached.
+
+    Must not be called while holding a lock used by one of the registered caches.
+    */
+  void CacheMemoryGovernor::NotifyAccesses(unsigned long count)
+  {
+    accessCount+=count;
+
+    if (accessCount>=rebalanceInterval) {
+      accessCount=0;
+
+      Rebalance();
+    }
+  }
+
+  /**
+    Redistribute the memory budget between the registered caches based on their
+    hit/miss/eviction counters since the last rebalancing.
+    */
+  void CacheMemoryGovernor::Rebalance()
+  {
+    ScopedLock lock(mutex);
+
+    DistributeBudget(true);
+  }
+
+  /**
+    Returns the memory currently used by all registered caches.
+    */
+  unsigned long CacheMemoryGovernor::GetMemoryUsage() const
+  {
+    ScopedLock    lock(mutex);
+    unsigned long memory=0;
+
+    for (std::vector<Client>::const_iterator client=clients.begin();
+         client!=clients.end();
+         ++client) {
+      memory+=client->cache->GetCacheMemoryUsage();
+    }
+
+    return memory;
+  }
+
+  void CacheMemoryGovernor::DumpStatistics() const
+  {
+    ScopedLock lock(mutex);
+
+    std::cout << "Cache memory budget: " << memoryBudget << std::endl;
+
+    for (std::vector<Client>::const_iterator client=clients.begin();
+         client!=clients.end();
+         ++client) {
+      CacheStatistics statistics=client->cache->GetCacheStatistics();
+
+      std::cout << "  " << client->cache->GetCacheName() << " limit: " << client->limit;
+      std::cout << ", memory " << client->cache->GetCacheMemoryUsage();
+      std::cout << ", hit rate " << statistics.GetHitRate()*100 << "%" << std::endl;
+    }
+  }
+}
@@ -25,6 +25,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
 #include <iostream>
 #include <limits>
 
@@ -368,6 +369,78 @@ namespace osmscout {
     return !hasError;
   }
 
+  /**
+    If the file is memory mapped, return a pointer to the data at the given
+    position and a pointer to the end of the file. The data can then be
+    accessed directly without copying. The pointers stay valid until the file
+    is closed.
+
+    Returns false, if the file is not memory mapped or the position is
+    beyond the end of the file.
+    */
+  bool FileScanner::GetMappedData(FileOffset pos,
+                                  const char*& data,
+                                  const char*& end) const
+  {
+    if (HasError()) {
+      return false;
+    }
+
+#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
+    if (buffer!=NULL) {
+      if (pos>=(FileOffset)size) {
+        return false;
+      }
+
+      data=&buffer[pos];
+      end=&buffer[size];
+
+      return true;
+    }
+#endif
+
+    return false;
+  }
+
+  /**
+    Tell the operating system that the given range of the file will be read
+    soon, so that it can load it asynchronously in the background while the
+    caller is still busy with other data. This is only a hint, the call
+    returns immediately and failures are ignored.
+    */
+  void FileScanner::Prefetch(FileOffset pos,
+                             FileOffset length)
+  {
+    if (file==NULL ||
+        pos>=size ||
+        length==0) {
+      return;
+    }
+
+    if (length>size-pos) {
+      length=size-pos;
+    }
+
+#if defined(HAVE_MMAP) && defined(HAVE_POSIX_MADVISE)
+    if (buffer!=NULL) {
+      FileOffset pageSize=(FileOffset)sysconf(_SC_PAGESIZE);
+      FileOffset start=pos-pos%pageSize;
+
+      if (posix_madvise(&buffer[start],(size_t)(pos+length-start),POSIX_MADV_WILLNEED)!=0) {
+        std::cerr << "Cannot set mmaped file access advice: " << strerror(errno) << std::endl;
+      }
+
+      return;
+    }
+#endif
+
+#if defined(HAVE_POSIX_FADVISE)
+    if (posix_fadvise(fileno(file),(off_t)pos,(off_t)length,POSIX_FADV_WILLNEED)!=0) {
+      std::cerr << "Cannot set file access advice: " << strerror(errno) << std::endl;
+    }
+#endif
+  }
+
   bool FileScanner::Read(char* buffer, size_t bytes)
   {
 #if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
@@ -1932,5 +2005,85 @@ namespace osmscout {
 
     return true;
   }
-}
 
+  /**
+   * Read count variable length encoded numbers into the given array.
+   *
+   * If the file is memory mapped, the numbers are decoded in one run
+   * using DecodeNumbers(), else one number after the other is read.
+   */
+  bool FileScanner::ReadNumbers(uint32_t* numbers,
+                                size_t count)
+  {
+    if (HasError()) {
+      return false;
+    }
+
+#if defined(HAVE_MMAP) || defined(__WIN32__) || defined(WIN32)
+    if (buffer!=NULL) {
+      const char* start=&buffer[offset];
+      const char* end=DecodeNumbers(start,
+                                    buffer+size,
+                                    numbers,
+                                    count);
+
+      if (end==NULL) {
+        std::cerr << "Cannot read uint32_t numbers beyond file end!" << std::endl;
+        hasError=true;
+        return false;
+      }
+
+      offset+=end-start;
+
+      return true;
+    }
+#endif
+
+    for (size_t i=0; i<count; i++) {
+      if (!ReadNumber(numbers[i])) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * Read count delta encoded coordinates as written for ways and areas: The
+   * minimum latitude and longitude as uint32_t followed by the difference of
+   * each coordinate to the minimum as pair of variable length encoded
+   * numbers.
+   */
+  bool FileScanner::ReadDeltaCoords(size_t count,
+                                    std::vector<GeoCoord>& coords)
+  {
+    // Number of coordinates decoded at once
+    static const size_t chunkSize=128;
+
+    uint32_t minLat;
+    uint32_t minLon;
+    uint32_t values[2*chunkSize];
+
+    coords.resize(count);
+
+    if (!Read(minLat) ||
+        !Read(minLon)) {
+      return false;
+    }
+
+    for (size_t start=0; start<count; start+=chunkSize) {
+      size_t chunkCount=std::min(chunkSize,count-start);
+
+      if (!ReadNumbers(values,2*chunkCount)) {
+        return false;
+      }
+
+      for (size_t i=0; i<chunkCount; i++) {
+        coords[start+i].Set((minLat+values[2*i])/conversionFactor-90.0,
+                            (minLon+values[2*i+1])/conversionFactor-180.0);
+      }
+    }
+
+    return true;
+  }
+}
@@ -302,6 +302,72 @@ namespace osmscout {
     return angle;
   }
 
+  static bool IsLonLatLess(const GeoCoord& a,
+                           const GeoCoord& b)
+  {
+    return a.GetLon()<b.GetLon() ||
+           (a.GetLon()==b.GetLon() && a.GetLat()<b.GetLat());
+  }
+
+  static double GetTurn(const GeoCoord& a,
+                        const GeoCoord& b,
+                        const GeoCoord& c)
+  {
+    return Det(b.GetLon()-a.GetLon(),b.GetLat()-a.GetLat(),
+               c.GetLon()-a.GetLon(),c.GetLat()-a.GetLat());
+  }
+
+  /**
+   * Calculates the convex hull of the given points (Andrew's monotone chain).
+   * The hull is returned counter clockwise (longitude as x, latitude as y) and is
+   * not closed, the first point is not repeated at the end. For less than three
+   * distinct points, the distinct points are returned.
+   */
+  void GetConvexHull(const std::vector<GeoCoord>& points,
+                     std::vector<GeoCoord>& hull)
+  {
+    std::vector<GeoCoord> sorted(points);
+
+    hull.clear();
+
+    std::sort(sorted.begin(),sorted.end(),IsLonLatLess);
+    sorted.erase(std::unique(sorted.begin(),sorted.end()),sorted.end());
+
+    if (sorted.size()<3) {
+      hull=sorted;
+      return;
+    }
+
+    hull.resize(2*sorted.size());
+
+    size_t count=0;
+
+    // Lower hull
+    for (size_t i=0; i<sorted.size(); i++) {
+      while (count>=2 &&
+             GetTurn(hull[count-2],hull[count-1],sorted[i])<=0.0) {
+        count--;
+      }
+
+      hull[count++]=sorted[i];
+    }
+
+    // Upper hull
+    size_t lowerCount=count+1;
+
+    for (size_t i=sorted.size()-1; i>0; i--) {
+      while (count>=lowerCount &&
+             GetTurn(hull[count-2],hull[count-1],sorted[i-1])<=0.0) {
+        count--;
+      }
+
+      hull[count++]=sorted[i-1];
+    }
+
+    // The last point is the first point
+    hull.resize(count-1);
+  }
+
   ScanCell::ScanCell(int x, int y)
   : x(x),
     y(y)
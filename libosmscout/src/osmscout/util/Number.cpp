@@ -19,6 +19,133 @@
 
 #include <osmscout/util/Number.h>
 
+#include <string.h>
+
+#if defined(OSMSCOUT_HAVE_SSE2)
+#include <emmintrin.h>
+#endif
+
 namespace osmscout {
 
+#if defined(OSMSCOUT_HAVE_SSE2)
+  static inline unsigned int CountTrailingZeros(unsigned int value)
+  {
+#if defined(__GNUC__)
+    return __builtin_ctz(value);
+#else
+    unsigned int count=0;
+
+    while ((value & 0x01)==0) {
+      value>>=1;
+      count++;
+    }
+
+    return count;
+#endif
+  }
+
+  /**
+   * Decode a number of length bytes (1-5) from the (at least 8 bytes large)
+   * buffer by loading all bytes at once and joining the 7 bit groups.
+   */
+  static inline uint32_t DecodeNumberWord(const char* buffer,
+                                          unsigned int length)
+  {
+    uint64_t word;
+
+    memcpy(&word,buffer,sizeof(word));
+
+    if (length<8) {
+      word&=(((uint64_t)1) << (8*length))-1;
+    }
+
+    return (uint32_t)((word & 0x7f) |
+                      ((word >> 1) & 0x3f80) |
+                      ((word >> 2) & 0x1fc000) |
+                      ((word >> 3) & 0xfe00000) |
+                      ((word >> 4) & 0xf0000000));
+  }
+#endif
+
+  const char* DecodeNumbers(const char* buffer,
+                            const char* end,
+                            uint32_t* numbers,
+                            size_t count)
+  {
+    size_t i=0;
+
+#if defined(OSMSCOUT_HAVE_SSE2)
+    // We need 16 bytes for the block plus 8 bytes to load the last number
+    // starting within the block as one word
+    while (count-i>=16 && end-buffer>=24) {
+      __m128i      bytes=_mm_loadu_si128((const __m128i*)buffer);
+      unsigned int terminators=~_mm_movemask_epi8(bytes) & 0xffff;
+
+      if (terminators==0xffff) {
+        // 16 numbers with one byte each
+        __m128i zero=_mm_setzero_si128();
+        __m128i low=_mm_unpacklo_epi8(bytes,zero);
+        __m128i high=_mm_unpackhi_epi8(bytes,zero);
+
+        _mm_storeu_si128((__m128i*)&numbers[i],_mm_unpacklo_epi16(low,zero));
+        _mm_storeu_si128((__m128i*)&numbers[i+4],_mm_unpackhi_epi16(low,zero));
+        _mm_storeu_si128((__m128i*)&numbers[i+8],_mm_unpacklo_epi16(high,zero));
+        _mm_storeu_si128((__m128i*)&numbers[i+12],_mm_unpackhi_epi16(high,zero));
+
+        buffer+=16;
+        i+=16;
+
+        continue;
+      }
+
+      unsigned int start=0;
+
+      while (terminators!=0) {
+        unsigned int stop=CountTrailingZeros(terminators);
+
+        numbers[i]=DecodeNumberWord(buffer+start,stop-start+1);
+
+        i++;
+        start=stop+1;
+        terminators&=terminators-1;
+      }
+
+      if (start==0) {
+        // Number with more than 16 bytes, leave it to the scalar code
+        break;
+      }
+
+      buffer+=start;
+    }
+#endif
+
+    for (; i<count; i++) {
+      uint32_t     number=0;
+      unsigned int shift=0;
+
+      while (true) {
+        if (buffer>=end) {
+          return NULL;
+        }
+
+        unsigned char byte=(unsigned char)*buffer;
+
+        buffer++;
+
+        if (shift<32) {
+          number|=(uint32_t)(byte & 0x7f) << shift;
+        }
+
+        if ((byte & 0x80)==0) {
+          break;
+        }
+
+        shift+=7;
+      }
+
+      numbers[i]=number;
+    }
+
+    return buffer;
+  }
 }
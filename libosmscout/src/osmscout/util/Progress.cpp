@@ -133,5 +133,59 @@ namespace osmscout {
   {
     std::cout << "   !! " << text << std::endl;
   }
-}
 
+  ThreadSafeProgress::ThreadSafeProgress(Progress& progress)
+  : progress(progress)
+  {
+    SetOutputDebug(progress.OutputDebug());
+  }
+
+  void ThreadSafeProgress::SetStep(const std::string& step)
+  {
+    ScopedLock lock(mutex);
+
+    progress.SetStep(step);
+  }
+
+  void ThreadSafeProgress::SetAction(const std::string& action)
+  {
+    ScopedLock lock(mutex);
+
+    progress.SetAction(action);
+  }
+
+  void ThreadSafeProgress::SetProgress(double current, double total)
+  {
+    ScopedLock lock(mutex);
+
+    progress.SetProgress(current,total);
+  }
+
+  void ThreadSafeProgress::Debug(const std::string& text)
+  {
+    ScopedLock lock(mutex);
+
+    progress.Debug(text);
+  }
+
+  void ThreadSafeProgress::Info(const std::string& text)
+  {
+    ScopedLock lock(mutex);
+
+    progress.Info(text);
+  }
+
+  void ThreadSafeProgress::Warning(const std::string& text)
+  {
+    ScopedLock lock(mutex);
+
+    progress.Warning(text);
+  }
+
+  void ThreadSafeProgress::Error(const std::string& text)
+  {
+    ScopedLock lock(mutex);
+
+    progress.Error(text);
+  }
+}
@@ -34,11 +34,36 @@ namespace osmscout {
 
   static const double gradtorad=2*M_PI/360;
 
+  // Maximum error in pixel of the linear approximation of latitudes
+  static const double linearLatTolerance=0.05;
+  // Linear approximation is only used up to 85 degree (in radians)
+  static const double linearLatLimit=85*gradtorad;
+
   Projection::~Projection()
   {
     // no code
   }
 
+  bool Projection::GeoToPixel(const GeoCoord* coords,
+                              size_t count,
+                              Vertex2D* pixels) const
+  {
+    double x;
+    double y;
+
+    for (size_t i=0; i<count; i++) {
+      if (!GeoToPixel(coords[i].GetLon(),
+                      coords[i].GetLat(),
+                      x,y)) {
+        return false;
+      }
+
+      pixels[i].Set(x,y);
+    }
+
+    return true;
+  }
+
   MercatorProjection::MercatorProjection()
   : valid(false),
     lon(0),
@@ -122,6 +147,8 @@ namespace osmscout {
     sse2Height         = _mm_set1_pd(height);
 #endif
 
+    SetupLinearLat();
+
     return true;
   }
 
@@ -185,9 +212,56 @@ namespace osmscout {
     sse2Height         = _mm_set1_pd(height);
 #endif
 
+    SetupLinearLat();
+
     return true;
   }
 
+  /**
+   * The mercator projection of latitudes is not linear, but for the small
+   * region visible at high magnifications it is nearly. We calculate the
+   * latitude range around the center, where the tangent at the center differs
+   * less than linearLatTolerance pixel from the exact projection. If the range
+   * covers the visible region, GeoToPixel() for coordinate arrays projects all
+   * latitudes in the range using the tangent.
+   */
+  void MercatorProjection::SetupLinearLat()
+  {
+    double center=lat*gradtorad;
+    double absCenter=fabs(center);
+
+    linearLat=false;
+
+    if (absCenter>=linearLatLimit) {
+      return;
+    }
+
+    // The error of the tangent for a distance delta to the center is limited
+    // by 0.5*scale*f''(outer)*delta^2, with f(x)=atanh(sin(x)),
+    // f''(x)=tan(x)/cos(x) and outer=|center|+delta, because |f''| grows with |x|.
+    double low=0.0;
+    double high=linearLatLimit-absCenter;
+
+    for (size_t i=0; i<32; i++) {
+      double delta=(low+high)/2;
+      double outer=absCenter+delta;
+
+      if (0.5*scale*tan(outer)/cos(outer)*delta*delta<=linearLatTolerance) {
+        low=delta;
+      }
+      else {
+        high=delta;
+      }
+    }
+
+    linearLatMin=lat-low/gradtorad;
+    linearLatMax=lat+low/gradtorad;
+    linearLatScale=scaleGradtorad/cos(center);
+    linearLatOffset=scale*atanh(sin(center))-latOffset;
+
+    linearLat=linearLatMin<=latMin && linearLatMax>=latMax;
+  }
+
   bool MercatorProjection::GeoIsIn(double lon, double lat) const
   {
     assert(valid);
@@ -267,6 +341,85 @@ namespace osmscout {
 
 #endif
 
+  bool MercatorProjection::GeoToPixel(const GeoCoord* coords,
+                                      size_t count,
+                                      Vertex2D* pixels) const
+  {
+    return GeoToPixel(coords,
+                      count,
+                      pixels,
+                      (double)height,
+                      -1.0);
+  }
+
+  /**
+   * Converts count geo coordinates to pixel coordinates, the y coordinate is
+   * yBase+yFactor*(mercator y-latOffset) to support both directions of the y axis.
+   */
+  bool MercatorProjection::GeoToPixel(const GeoCoord* coords,
+                                      size_t count,
+                                      Vertex2D* pixels,
+                                      double yBase,
+                                      double yFactor) const
+  {
+    assert(valid);
+
+    size_t i=0;
+
+    if (linearLat) {
+      for (; i<count; i++) {
+        double coordLat=coords[i].GetLat();
+        double x=coords[i].GetLon()*scaleGradtorad-lonOffset;
+        double y;
+
+        if (coordLat>=linearLatMin && coordLat<=linearLatMax) {
+          y=(coordLat-lat)*linearLatScale+linearLatOffset;
+        }
+        else {
+#ifdef OSMSCOUT_HAVE_SSE2
+          y=scale*atanh_sin_pd(coordLat*gradtorad)-latOffset;
+#else
+          y=scale*atanh(sin(coordLat*gradtorad))-latOffset;
+#endif
+        }
+
+        pixels[i].Set(x,yBase+yFactor*y);
+      }
+
+      return true;
+    }
+
+#ifdef OSMSCOUT_HAVE_SSE2
+    v2df sse2YBase=_mm_set1_pd(yBase);
+    v2df sse2YFactor=_mm_set1_pd(yFactor);
+    ALIGN16_BEG double x[2] ALIGN16_END;
+    ALIGN16_BEG double y[2] ALIGN16_END;
+
+    for (; i+1<count; i+=2) {
+      v2df coordLon=_mm_setr_pd(coords[i].GetLon(),coords[i+1].GetLon());
+      v2df coordLat=_mm_setr_pd(coords[i].GetLat(),coords[i+1].GetLat());
+
+      _mm_store_pd(x,_mm_sub_pd(_mm_mul_pd(coordLon,sse2ScaleGradtorad),sse2LonOffset));
+      _mm_store_pd(y,_mm_add_pd(sse2YBase,_mm_mul_pd(sse2YFactor,_mm_sub_pd(_mm_mul_pd(sse2Scale,atanh_sin_pd(_mm_mul_pd(coordLat,ARRAY2V2DF(sseGradtorad)))),sse2LatOffset))));
+
+      pixels[i].Set(x[0],y[0]);
+      pixels[i+1].Set(x[1],y[1]);
+    }
+
+    for (; i<count; i++) {
+      pixels[i].Set(coords[i].GetLon()*scaleGradtorad-lonOffset,
+                    yBase+yFactor*(scale*atanh_sin_pd(coords[i].GetLat()*gradtorad)-latOffset));
+    }
+#else
+    for (; i<count; i++) {
+      pixels[i].Set(coords[i].GetLon()*scaleGradtorad-lonOffset,
+                    yBase+yFactor*(scale*atanh(sin(coords[i].GetLat()*gradtorad))-latOffset));
+    }
+#endif
+
+    return true;
+  }
+
   bool MercatorProjection::GetDimensions(double& lonMin, double& latMin,
                                          double& lonMax, double& latMax) const
   {
@@ -291,6 +444,17 @@ namespace osmscout {
 // ReversedYAxisMercatorProjection class
 //
 
+  bool ReversedYAxisMercatorProjection::GeoToPixel(const GeoCoord* coords,
+                                                   size_t count,
+                                                   Vertex2D* pixels) const
+  {
+    return MercatorProjection::GeoToPixel(coords,
+                                          count,
+                                          pixels,
+                                          0.0,
+                                          1.0);
+  }
+
   bool ReversedYAxisMercatorProjection::PixelToGeo(double x, double y,
                                                    double& lon, double& lat) const
   {
@@ -0,0 +1,176 @@
+/*
+  This source is part of the libosmscout library
+  Copyright (C) 2014  Tim Teulings
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+*/
+
+#include <osmscout/util/ThreadPool.h>
+
+namespace osmscout {
+
+  ParallelJob::~ParallelJob()
+  {
+    // no code
+  }
+
+#if defined(OSMSCOUT_HAVE_THREAD)
+  /**
+    Create a thread pool with the given number of workers (including the
+    calling thread). If 0 is given, one worker per hardware thread is used.
+    */
+  ThreadPool::ThreadPool(size_t workerCount)
+  : workerCount(workerCount),
+    job(NULL),
+    taskCount(0),
+    nextTask(0),
+    runningWorkers(0),
+    generation(0),
+    stop(false)
+  {
+    if (this->workerCount==0) {
+      this->workerCount=std::thread::hardware_concurrency();
+    }
+
+    if (this->workerCount==0) {
+      this->workerCount=1;
+    }
+
+    for (size_t worker=1; worker<this->workerCount; worker++) {
+      threads.push_back(std::thread(&ThreadPool::Work,this,worker));
+    }
+  }
+
+  ThreadPool::~ThreadPool()
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+
+      stop=true;
+    }
+
+    wakeCondition.notify_all();
+
+    for (size_t i=0; i<threads.size(); i++) {
+      threads[i].join();
+    }
+  }
+
+  /**
+    Execute tasks of the current job, until no task is left
+    */
+  void ThreadPool::ExecuteTasks(size_t worker)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (nextTask<taskCount) {
+      ParallelJob *currentJob=job;
+      size_t      task=nextTask++;
+
+      lock.unlock();
+
+      currentJob->Execute(task,worker);
+
+      lock.lock();
+    }
+  }
+
+  void ThreadPool::Work(size_t worker)
+  {
+    size_t handledGeneration=0;
+
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (!stop && generation==handledGeneration) {
+          wakeCondition.wait(lock);
+        }
+
+        if (stop) {
+          return;
+        }
+
+        handledGeneration=generation;
+        runningWorkers++;
+      }
+
+      ExecuteTasks(worker);
+
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        runningWorkers--;
+
+        if (runningWorkers==0) {
+          doneCondition.notify_all();
+        }
+      }
+    }
+  }
+
+  /**
+    Execute all tasks of the given job and return, after all tasks have been
+    finished. Must not be called concurrently.
+    */
+  void ThreadPool::Execute(ParallelJob& job,
+                           size_t taskCount)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+
+      this->job=&job;
+      this->taskCount=taskCount;
+      this->nextTask=0;
+      generation++;
+    }
+
+    wakeCondition.notify_all();
+
+    ExecuteTasks(0);
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+
+      while (runningWorkers>0) {
+        doneCondition.wait(lock);
+      }
+
+      this->job=NULL;
+      this->taskCount=0;
+      this->nextTask=0;
+    }
+  }
+#else
+  ThreadPool::ThreadPool(size_t /*workerCount*/)
+  : workerCount(1)
+  {
+    // no code
+  }
+
+  ThreadPool::~ThreadPool()
+  {
+    // no code
+  }
+
+  void ThreadPool::Execute(ParallelJob& job,
+                           size_t taskCount)
+  {
+    for (size_t task=0; task<taskCount; task++) {
+      job.Execute(task,0);
+    }
+  }
+#endif
+}
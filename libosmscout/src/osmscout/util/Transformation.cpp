@@ -161,7 +161,8 @@ namespace osmscout {
     length(0),
     start(0),
     end(0),
-    points(NULL)
+    points(NULL),
+    pixels(NULL)
   {
     // no code
   }
@@ -169,23 +170,24 @@ namespace osmscout {
   TransPolygon::~TransPolygon()
   {
     delete [] points;
+    delete [] pixels;
   }
 
   void TransPolygon::TransformGeoToPixel(const Projection& projection,
                                          const std::vector<GeoCoord>& nodes)
   {
-    Projection::BatchTransformer batchTransformer(projection);
-
     if (!nodes.empty()) {
       start=0;
       length=nodes.size();
       end=length-1;
 
+      projection.GeoToPixel(&nodes[0],
+                            nodes.size(),
+                            pixels);
+
       for (size_t i=start; i<=end; i++) {
-         batchTransformer.GeoToPixel(nodes[i].GetLon(),
-                                     nodes[i].GetLat(),
-                                     points[i].x,
-                                     points[i].y);
+        points[i].x=pixels[i].GetX();
+        points[i].y=pixels[i].GetY();
         points[i].draw=true;
       }
     }
@@ -351,8 +353,10 @@ namespace osmscout {
 
     if (pointsSize<nodes.size()) {
       delete [] points;
+      delete [] pixels;
 
       points=new TransPoint[nodes.size()];
+      pixels=new Vertex2D[nodes.size()];
       pointsSize=nodes.size();
     }
 
@@ -405,8 +409,10 @@ namespace osmscout {
 
     if (pointsSize<nodes.size()) {
       delete [] points;
+      delete [] pixels;
 
       points=new TransPoint[nodes.size()];
+      pixels=new Vertex2D[nodes.size()];
       pointsSize=nodes.size();
     }
 
@@ -0,0 +1,328 @@
+#include <cstdlib>
+#include <iostream>
+#include <map>
+
+#include <osmscout/util/Cache.h>
+#include <osmscout/util/CacheMemoryGovernor.h>
+
+typedef osmscout::Cache<osmscout::Id,size_t> SLRUCache;
+typedef osmscout::Cache<osmscout::Id,
+                        size_t,
+                        osmscout::PageId,
+                        osmscout::LRUCachePolicy> LRUCache;
+
+int errors=0;
+
+/**
+  The value itself is the size of the entry
+  */
+struct ValueSizer : public SLRUCache::ValueSizer
+{
+  unsigned long GetSize(const size_t& value) const
+  {
+    return value;
+  }
+};
+
+template <class C>
+bool CheckEntry(C& cache, osmscout::Id key, size_t expected)
+{
+  typename C::CacheRef ref;
+
+  if (!cache.GetEntry(key,ref)) {
+    std::cerr << "Key " << key << " not found in cache!" << std::endl;
+    return false;
+  }
+
+  if (ref->value!=expected) {
+    std::cerr << "Key " << key << " has value " << ref->value << " expected " << expected << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+  Compare the cache against a std::map using random operations, checking
+  that the cache never returns wrong values and never exceeds its size.
+  */
+template <class C>
+void CheckRandomOperations(unsigned long maxSize)
+{
+  C                             cache(maxSize);
+  std::map<osmscout::Id,size_t> reference;
+
+  srand(maxSize);
+
+  for (size_t i=0; i<200000; i++) {
+    osmscout::Id key=rand() % (maxSize*4+1);
+
+    if (rand()%2==0) {
+      size_t value=rand();
+
+      cache.SetEntry(typename C::CacheEntry(key,value));
+      reference[key]=value;
+    }
+    else {
+      typename C::CacheRef ref;
+
+      if (cache.GetEntry(key,ref)) {
+        if (reference.find(key)==reference.end() ||
+            reference[key]!=ref->value) {
+          std::cerr << "Wrong value for key " << key << std::endl;
+          errors++;
+        }
+      }
+    }
+
+    if (cache.GetSize()>maxSize) {
+      std::cerr << "Cache size " << cache.GetSize() << " exceeds " << maxSize << std::endl;
+      errors++;
+    }
+
+    if (i==100000) {
+      cache.SetMaxSize(maxSize/2);
+      maxSize=maxSize/2;
+    }
+  }
+
+  // All entries still counted must be found
+  size_t found=0;
+
+  for (std::map<osmscout::Id,size_t>::const_iterator entry=reference.begin();
+       entry!=reference.end();
+       ++entry) {
+    typename C::CacheRef ref;
+
+    if (cache.GetEntry(entry->first,ref)) {
+      found++;
+    }
+  }
+
+  if (found!=cache.GetSize()) {
+    std::cerr << "Found " << found << " entries, but cache has size " << cache.GetSize() << std::endl;
+    errors++;
+  }
+}
+
+/**
+  Check that a cache limited by memory never exceeds its limit.
+  */
+void CheckMemoryLimit()
+{
+  ValueSizer sizer;
+  SLRUCache  cache(std::numeric_limits<unsigned long>::max());
+
+  cache.SetValueSizer(&sizer);
+  cache.SetMaxMemory(100000);
+
+  srand(42);
+
+  for (size_t i=0; i<100000; i++) {
+    osmscout::Id key=rand()%10000;
+
+    cache.SetEntry(SLRUCache::CacheEntry(key,rand()%2000));
+
+    if (cache.GetMemoryUsage()>cache.GetMaxMemory()) {
+      std::cerr << "Cache memory " << cache.GetMemoryUsage() << " exceeds " << cache.GetMaxMemory() << std::endl;
+      errors++;
+      return;
+    }
+  }
+
+  // Entries bigger than the limit still get cached (alone)
+  SLRUCache::CacheRef ref=cache.SetEntry(SLRUCache::CacheEntry(1,200000));
+
+  if (cache.GetSize()!=1 || ref->value!=200000) {
+    std::cerr << "Big entry not cached!" << std::endl;
+    errors++;
+  }
+
+  cache.SetMaxMemory(10000);
+
+  for (size_t i=0; i<100; i++) {
+    cache.SetEntry(SLRUCache::CacheEntry(i+2,50));
+  }
+
+  if (cache.GetMemoryUsage()>10000 || cache.GetSize()<10) {
+    std::cerr << "Cache has memory " << cache.GetMemoryUsage() << " and " << cache.GetSize() << " entries" << std::endl;
+    errors++;
+  }
+
+  cache.Flush();
+
+  if (cache.GetMemoryUsage()!=0) {
+    std::cerr << "Cache memory not 0 after flush!" << std::endl;
+    errors++;
+  }
+}
+
+/**
+  The governor should give the cache with the most misses the most memory,
+  while caches that do not need more memory keep what they use.
+  */
+void CheckGovernor()
+{
+  ValueSizer                                    sizer;
+  SLRUCache                                     busyCache(std::numeric_limits<unsigned long>::max());
+  SLRUCache                                     idleCache(std::numeric_limits<unsigned long>::max());
+  osmscout::GovernedCacheAdapter<SLRUCache>     busyAdapter("busy",busyCache);
+  osmscout::GovernedCacheAdapter<SLRUCache>     idleAdapter("idle",idleCache);
+  osmscout::CacheMemoryGovernorRef              governor(new osmscout::CacheMemoryGovernor(1000000));
+
+  busyCache.SetValueSizer(&sizer);
+  idleCache.SetValueSizer(&sizer);
+
+  governor->Register(&busyAdapter);
+  governor->Register(&idleAdapter);
+
+  if (busyCache.GetMaxMemory()!=idleCache.GetMaxMemory()) {
+    std::cerr << "Initial budget not split evenly!" << std::endl;
+    errors++;
+  }
+
+  SLRUCache::CacheRef ref;
+
+  idleCache.SetEntry(SLRUCache::CacheEntry(1,1000));
+
+  for (size_t r=0; r<10; r++) {
+    for (size_t i=0; i<10000; i++) {
+      if (!busyCache.GetEntry(i,ref)) {
+        busyCache.SetEntry(SLRUCache::CacheEntry(i,100));
+      }
+    }
+
+    idleCache.GetEntry(1,ref);
+
+    governor->Rebalance();
+  }
+
+  if (busyCache.GetMaxMemory()<=idleCache.GetMaxMemory() ||
+      busyCache.GetMaxMemory()+idleCache.GetMaxMemory()>governor->GetMemoryBudget()) {
+    std::cerr << "Unexpected memory limits " << busyCache.GetMaxMemory() << " " << idleCache.GetMaxMemory() << std::endl;
+    errors++;
+  }
+
+  if (idleCache.GetSize()!=1) {
+    std::cerr << "Idle cache lost its entry!" << std::endl;
+    errors++;
+  }
+
+  governor->Unregister(&busyAdapter);
+  governor->Unregister(&idleAdapter);
+}
+
+int main()
+{
+  SLRUCache cache(100);
+
+  for (size_t i=0; i<100; i++) {
+    cache.SetEntry(SLRUCache::CacheEntry(i,i*2));
+  }
+
+  for (size_t i=0; i<100; i++) {
+    if (!CheckEntry(cache,i,i*2)) {
+      errors++;
+    }
+  }
+
+  // Update
+  cache.SetEntry(SLRUCache::CacheEntry(5,42));
+
+  if (!CheckEntry(cache,5,42)) {
+    errors++;
+  }
+
+  // Entries 0..9 are hot, the rest was only accessed once more.
+  for (size_t t=0; t<10; t++) {
+    for (size_t i=0; i<10; i++) {
+      SLRUCache::CacheRef ref;
+
+      cache.GetEntry(i,ref);
+    }
+  }
+
+  // Scan over a large number of entries, which are only accessed once
+  for (size_t i=1000; i<10000; i++) {
+    cache.SetEntry(SLRUCache::CacheEntry(i,i));
+  }
+
+  if (cache.GetSize()!=100) {
+    std::cerr << "Cache has size " << cache.GetSize() << " expected 100" << std::endl;
+    errors++;
+  }
+
+  for (size_t i=0; i<10; i++) {
+    if (!CheckEntry(cache,i,i==5 ? 42 : i*2)) {
+      std::cerr << "Hot entry " << i << " was evicted by scan!" << std::endl;
+      errors++;
+    }
+  }
+
+  if (cache.GetStatistics().evictions!=9000) {
+    std::cerr << "Expected 9000 evictions, got " << cache.GetStatistics().evictions << std::endl;
+    errors++;
+  }
+
+  cache.Flush();
+
+  if (cache.GetSize()!=0) {
+    std::cerr << "Cache not empty after flush!" << std::endl;
+    errors++;
+  }
+
+  SLRUCache::CacheRef ref;
+
+  if (cache.GetEntry(1,ref)) {
+    std::cerr << "Entry found after flush!" << std::endl;
+    errors++;
+  }
+
+  // LRU evicts the least recently used entry
+  LRUCache lruCache(3);
+
+  lruCache.SetEntry(LRUCache::CacheEntry(1,1));
+  lruCache.SetEntry(LRUCache::CacheEntry(2,2));
+  lruCache.SetEntry(LRUCache::CacheEntry(3,3));
+
+  if (!CheckEntry(lruCache,1,1)) {
+    errors++;
+  }
+
+  lruCache.SetEntry(LRUCache::CacheEntry(4,4));
+
+  LRUCache::CacheRef lruRef;
+
+  if (lruCache.GetEntry(2,lruRef)) {
+    std::cerr << "Least recently used entry was not evicted!" << std::endl;
+    errors++;
+  }
+
+  // Inactive cache
+  SLRUCache inactiveCache(0);
+
+  if (inactiveCache.SetEntry(SLRUCache::CacheEntry(1,7))->value!=7) {
+    std::cerr << "Inactive cache does not return set value!" << std::endl;
+    errors++;
+  }
+
+  if (inactiveCache.GetEntry(1,ref)) {
+    std::cerr << "Inactive cache returns entry!" << std::endl;
+    errors++;
+  }
+
+  CheckRandomOperations<SLRUCache>(1);
+  CheckRandomOperations<SLRUCache>(1000);
+  CheckRandomOperations<SLRUCache>(3000);
+  CheckRandomOperations<LRUCache>(1000);
+
+  CheckMemoryLimit();
+  CheckGovernor();
+
+  if (errors!=0) {
+    return 1;
+  }
+  else {
+    return 0;
+  }
+}
@@ -0,0 +1,67 @@
+#include <iostream>
+
+#include <osmscout/util/Geometry.h>
+
+int errors=0;
+
+int main()
+{
+  std::vector<osmscout::GeoCoord> points;
+  std::vector<osmscout::GeoCoord> hull;
+
+  osmscout::GetConvexHull(points,hull);
+
+  if (!hull.empty()) {
+    std::cerr << "Hull of no points is not empty" << std::endl;
+    errors++;
+  }
+
+  // A square (lat,lon) with points inside, on the border and duplicates
+  points.push_back(osmscout::GeoCoord(0.0,0.0));
+  points.push_back(osmscout::GeoCoord(0.0,2.0));
+  points.push_back(osmscout::GeoCoord(2.0,2.0));
+  points.push_back(osmscout::GeoCoord(2.0,0.0));
+  points.push_back(osmscout::GeoCoord(1.0,1.0));
+  points.push_back(osmscout::GeoCoord(0.5,1.5));
+  points.push_back(osmscout::GeoCoord(0.0,1.0));
+  points.push_back(osmscout::GeoCoord(2.0,2.0));
+
+  osmscout::GetConvexHull(points,hull);
+
+  if (hull.size()!=4) {
+    std::cerr << "Wrong point count for square: " << hull.size() << std::endl;
+    errors++;
+  }
+  else {
+    // Counter clockwise, starting with the smallest longitude
+    osmscout::GeoCoord expected[4]={osmscout::GeoCoord(0.0,0.0),
+                                    osmscout::GeoCoord(0.0,2.0),
+                                    osmscout::GeoCoord(2.0,2.0),
+                                    osmscout::GeoCoord(2.0,0.0)};
+
+    for (size_t i=0; i<4; i++) {
+      if (!(hull[i]==expected[i])) {
+        std::cerr << "Wrong point " << i << " for square: " << hull[i].GetLat() << "," << hull[i].GetLon() << std::endl;
+        errors++;
+      }
+    }
+  }
+
+  points.clear();
+  points.push_back(osmscout::GeoCoord(1.0,1.0));
+  points.push_back(osmscout::GeoCoord(1.0,1.0));
+
+  osmscout::GetConvexHull(points,hull);
+
+  if (hull.size()!=1) {
+    std::cerr << "Wrong point count for single point: " << hull.size() << std::endl;
+    errors++;
+  }
+
+  if (errors!=0) {
+    return 1;
+  }
+  else {
+    return 0;
+  }
+}
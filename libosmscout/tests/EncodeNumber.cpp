@@ -1,4 +1,6 @@
+#include <cstdlib>
 #include <iostream>
+#include <vector>
 
 #include <osmscout/util/Number.h>
 
@@ -49,6 +51,52 @@ bool CheckDecode(const char* buffer, unsigned long expected, size_t bytesExpecte
   return true;
 }
 
+bool CheckDecodeNumbers()
+{
+  std::vector<uint32_t> values;
+  std::vector<char>     buffer;
+
+  // A run of one byte numbers, followed by numbers of mixed length
+  for (size_t i=0; i<100; i++) {
+    values.push_back(rand()%128);
+  }
+
+  for (size_t i=0; i<1000; i++) {
+    values.push_back(((uint32_t)rand()) >> (rand()%32));
+  }
+
+  values.push_back(4294967295u);
+
+  for (size_t i=0; i<values.size(); i++) {
+    char         data[5];
+    unsigned int bytes=osmscout::EncodeNumber(values[i],data);
+
+    buffer.insert(buffer.end(),data,data+bytes);
+  }
+
+  std::vector<uint32_t> decoded(values.size());
+  const char*           end=&buffer[0]+buffer.size();
+
+  if (osmscout::DecodeNumbers(&buffer[0],end,&decoded[0],decoded.size())!=end) {
+    std::cerr << "Bulk decoding returned wrong length" << std::endl;
+    return false;
+  }
+
+  for (size_t i=0; i<values.size(); i++) {
+    if (decoded[i]!=values[i]) {
+      std::cerr << "Error in bulk decoding of number " << i << ": expected " << values[i] << " actual " << decoded[i] << std::endl;
+      return false;
+    }
+  }
+
+  if (osmscout::DecodeNumbers(&buffer[0],end-1,&decoded[0],decoded.size())!=NULL) {
+    std::cerr << "Bulk decoding beyond buffer end not detected" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
 int main()
 {
   if (!CheckEncode(0,"\0",1)) {
@@ -115,6 +163,10 @@ int main()
     errors++;
   }
 
+  if (!CheckDecodeNumbers()) {
+    errors++;
+  }
+
   if (errors!=0) {
     return 1;
   }
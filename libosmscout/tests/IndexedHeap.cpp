@@ -0,0 +1,141 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <osmscout/util/IndexedHeap.h>
+
+typedef osmscout::IndexedHeap<int> Heap;
+
+int errors=0;
+
+/**
+  Compare the heap against a plain array of keys using random
+  push, pop and key update operations.
+  */
+void CheckRandomOperations()
+{
+  Heap             heap;
+  std::vector<int> keys(1000,-1); // -1 => not in heap
+
+  srand(42);
+
+  for (size_t i=0; i<100000; i++) {
+    uint32_t element=rand()%keys.size();
+    int      key=rand()%10000;
+
+    switch (rand()%3) {
+    case 0:
+      if (keys[element]<0) {
+        heap.Push(element,key);
+      }
+      else {
+        heap.UpdateKey(element,key);
+      }
+      keys[element]=key;
+      break;
+    case 1:
+      if (keys[element]>=0 && key<keys[element]) {
+        heap.DecreaseKey(element,key);
+        keys[element]=key;
+      }
+      break;
+    case 2:
+      if (!heap.IsEmpty()) {
+        int      expected=-1;
+        uint32_t top=heap.GetTop();
+
+        for (size_t e=0; e<keys.size(); e++) {
+          if (keys[e]>=0 && (expected<0 || keys[e]<expected)) {
+            expected=keys[e];
+          }
+        }
+
+        if (heap.GetTopKey()!=expected || keys[top]!=expected) {
+          std::cerr << "Top key is " << heap.GetTopKey() << " expected " << expected << std::endl;
+          errors++;
+          return;
+        }
+
+        if (heap.Pop()!=top) {
+          std::cerr << "Pop() does not return top element" << std::endl;
+          errors++;
+          return;
+        }
+
+        keys[top]=-1;
+      }
+      break;
+    }
+
+    if (heap.Contains(element)!=(keys[element]>=0)) {
+      std::cerr << "Contains() returns wrong result for " << element << std::endl;
+      errors++;
+      return;
+    }
+  }
+}
+
+int main()
+{
+  Heap heap;
+
+  heap.Push(3,30);
+  heap.Push(1,10);
+  heap.Push(2,20);
+  heap.Push(7,5);
+
+  if (heap.GetSize()!=4 || heap.GetTop()!=7) {
+    std::cerr << "Element 7 not on top!" << std::endl;
+    errors++;
+  }
+
+  heap.DecreaseKey(3,1);
+
+  if (heap.GetTop()!=3 || heap.GetKey(3)!=1) {
+    std::cerr << "Element 3 not on top after DecreaseKey()!" << std::endl;
+    errors++;
+  }
+
+  heap.UpdateKey(3,100);
+
+  uint32_t order[]={7,1,2,3};
+
+  for (size_t i=0; i<4; i++) {
+    uint32_t element=heap.Pop();
+
+    if (element!=order[i]) {
+      std::cerr << "Popped " << element << " expected " << order[i] << std::endl;
+      errors++;
+    }
+  }
+
+  if (!heap.IsEmpty() || heap.Contains(1)) {
+    std::cerr << "Heap not empty!" << std::endl;
+    errors++;
+  }
+
+  heap.Push(1,10);
+  heap.Push(2,20);
+  heap.Clear();
+
+  if (!heap.IsEmpty() || heap.Contains(1) || heap.Contains(2)) {
+    std::cerr << "Heap not empty after Clear()!" << std::endl;
+    errors++;
+  }
+
+  heap.Push(2,20);
+
+  if (heap.GetTop()!=2) {
+    std::cerr << "Heap not reusable after Clear()!" << std::endl;
+    errors++;
+  }
+
+  CheckRandomOperations();
+
+  if (errors!=0) {
+    return 1;
+  }
+  else {
+    return 0;
+  }
+}
@@ -0,0 +1,298 @@
+#include <cstdlib>
+#include <iostream>
+
+#include <osmscout/Area.h>
+#include <osmscout/ObjectView.h>
+#include <osmscout/Way.h>
+
+#include <osmscout/util/FileScanner.h>
+#include <osmscout/util/FileWriter.h>
+
+int errors=0;
+
+static void Check(bool condition,
+                  const std::string& message)
+{
+  if (!condition) {
+    std::cerr << message << std::endl;
+    errors++;
+  }
+}
+
+static void AddNodes(size_t count,
+                     std::vector<osmscout::GeoCoord>& nodes,
+                     std::vector<osmscout::Id>& ids,
+                     bool withGaps)
+{
+  for (size_t i=0; i<count; i++) {
+    nodes.push_back(osmscout::GeoCoord(50.0+rand()%100000/100000.0,
+                                       7.0+rand()%100000/100000.0));
+
+    if (withGaps && i%3==1) {
+      ids.push_back(0);
+    }
+    else {
+      ids.push_back(1000000+rand()%100000);
+    }
+  }
+}
+
+static bool SameCoords(const std::vector<osmscout::GeoCoord>& a,
+                       const std::vector<osmscout::GeoCoord>& b)
+{
+  if (a.size()!=b.size()) {
+    return false;
+  }
+
+  for (size_t i=0; i<a.size(); i++) {
+    if (a[i].GetLat()!=b[i].GetLat() ||
+        a[i].GetLon()!=b[i].GetLon()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static bool SameTags(const std::vector<osmscout::Tag>& a,
+                     const std::vector<osmscout::Tag>& b)
+{
+  if (a.size()!=b.size()) {
+    return false;
+  }
+
+  for (size_t i=0; i<a.size(); i++) {
+    if (a[i].key!=b[i].key ||
+        a[i].value!=b[i].value) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static void CheckWay(const osmscout::Way& way,
+                     const osmscout::WayView& view)
+{
+  std::vector<osmscout::GeoCoord> coords;
+  std::vector<osmscout::Id>       ids;
+  std::vector<osmscout::Tag>      tags;
+
+  Check(view.GetFileOffset()==way.GetFileOffset(),"Way: Wrong file offset");
+  Check(view.GetType()==way.GetType(),"Way: Wrong type");
+  Check(view.GetName()==way.GetName(),"Way: Wrong name");
+  Check(view.GetNameAlt()==way.GetAttributes().GetNameAlt(),"Way: Wrong alternative name");
+  Check(view.GetRefName()==way.GetRefName(),"Way: Wrong ref");
+  Check(view.GetLocation()==way.GetLocation(),"Way: Wrong location");
+  Check(view.GetAddress()==way.GetAddress(),"Way: Wrong address");
+  Check(view.GetLayer()==way.GetLayer(),"Way: Wrong layer");
+  Check(view.GetWidth()==way.GetWidth(),"Way: Wrong width");
+  Check(view.GetMaxSpeed()==way.GetMaxSpeed(),"Way: Wrong max speed");
+  Check(view.GetGrade()==way.GetGrade(),"Way: Wrong grade");
+  Check(view.IsBridge()==way.IsBridge(),"Way: Wrong bridge flag");
+  Check(view.HasAccess()==way.HasAccess(),"Way: Wrong access flag");
+  Check(view.GetTags(tags) && SameTags(tags,way.GetAttributes().GetTags()),"Way: Wrong tags");
+  Check(view.GetNodeCount()==way.nodes.size(),"Way: Wrong node count");
+  Check(view.GetCoords(coords) && SameCoords(coords,way.nodes),"Way: Wrong coordinates");
+  Check(view.GetIds(ids) && ids==way.ids,"Way: Wrong ids");
+
+  double minLon,maxLon,minLat,maxLat;
+  double viewMinLon,viewMaxLon,viewMinLat,viewMaxLat;
+
+  way.GetBoundingBox(minLon,maxLon,minLat,maxLat);
+
+  Check(view.GetBoundingBox(viewMinLon,viewMaxLon,viewMinLat,viewMaxLat) &&
+        minLon==viewMinLon && maxLon==viewMaxLon &&
+        minLat==viewMinLat && maxLat==viewMaxLat,"Way: Wrong bounding box");
+}
+
+static void CheckArea(const osmscout::Area& area,
+                      const osmscout::AreaView& view)
+{
+  std::vector<osmscout::AreaView::Ring> rings;
+
+  Check(view.GetFileOffset()==area.GetFileOffset(),"Area: Wrong file offset");
+  Check(view.GetType()==area.GetType(),"Area: Wrong type");
+  Check(view.IsSimple()==area.IsSimple(),"Area: Wrong simple flag");
+  Check(view.GetRings(rings) && rings.size()==area.rings.size(),"Area: Wrong ring count");
+
+  for (size_t r=0; r<rings.size() && r<area.rings.size(); r++) {
+    std::vector<osmscout::GeoCoord> coords;
+    std::vector<osmscout::Id>       ids;
+    std::vector<osmscout::Tag>      tags;
+
+    Check(rings[r].GetType()==area.rings[r].GetType(),"Area: Wrong ring type");
+    Check(rings[r].GetRing()==area.rings[r].ring,"Area: Wrong ring");
+    Check(rings[r].GetName()==area.rings[r].GetName(),"Area: Wrong ring name");
+    Check(rings[r].GetLocation()==area.rings[r].GetAttributes().GetLocation(),"Area: Wrong ring location");
+    Check(rings[r].GetAddress()==area.rings[r].GetAttributes().GetAddress(),"Area: Wrong ring address");
+    Check(rings[r].GetTags(tags) && SameTags(tags,area.rings[r].GetAttributes().GetTags()),"Area: Wrong ring tags");
+    Check(rings[r].GetCoords(coords) && SameCoords(coords,area.rings[r].nodes),"Area: Wrong ring coordinates");
+    Check(rings[r].GetIds(ids) && ids==area.rings[r].ids,"Area: Wrong ring ids");
+  }
+}
+
+int main()
+{
+  osmscout::TypeConfig            typeConfig;
+  osmscout::SilentProgress        progress;
+  std::vector<osmscout::Way>      ways(3);
+  std::vector<osmscout::Area>     areas(2);
+  osmscout::TagId                 tagName=typeConfig.GetTagId("name");
+  osmscout::TagId                 tagSurface=typeConfig.GetTagId("surface");
+  osmscout::TagId                 tagPlace=typeConfig.GetTagId("place");
+  std::vector<osmscout::Tag>      tags;
+
+  typeConfig.RegisterNameTag("name",1);
+
+  // A way without any attributes
+  ways[0].SetType(1);
+  AddNodes(2,ways[0].nodes,ways[0].ids,false);
+
+  // A way with all kind of attributes
+  tags.clear();
+  tags.push_back(osmscout::Tag(tagName,"Main Street"));
+  tags.push_back(osmscout::Tag(typeConfig.tagRef,"B 1"));
+  tags.push_back(osmscout::Tag(typeConfig.tagLayer,"-1"));
+  tags.push_back(osmscout::Tag(typeConfig.tagBridge,"yes"));
+  tags.push_back(osmscout::Tag(typeConfig.tagMaxSpeed,"50"));
+  tags.push_back(osmscout::Tag(typeConfig.tagWidth,"7"));
+  tags.push_back(osmscout::Tag(tagPlace,"village"));
+  ways[1].SetType(2);
+  ways[1].SetTags(progress,typeConfig,1,tags);
+  AddNodes(500,ways[1].nodes,ways[1].ids,true);
+
+  // A way with a grade
+  tags.clear();
+  tags.push_back(osmscout::Tag(tagSurface,"gravel"));
+  tags.push_back(osmscout::Tag(typeConfig.tagHouseNr,"12a"));
+  ways[2].SetType(3);
+  ways[2].SetTags(progress,typeConfig,2,tags);
+  AddNodes(3,ways[2].nodes,ways[2].ids,true);
+
+  // A simple area
+  areas[0].rings.resize(1);
+  areas[0].rings[0].SetType(4);
+  areas[0].rings[0].ring=osmscout::Area::outerRingId;
+  tags.clear();
+  tags.push_back(osmscout::Tag(tagName,"Park"));
+  tags.push_back(osmscout::Tag(typeConfig.tagStreet,"Main Street"));
+  tags.push_back(osmscout::Tag(tagPlace,"square"));
+  areas[0].rings[0].attributes.SetTags(progress,typeConfig,tags);
+  AddNodes(10,areas[0].rings[0].nodes,areas[0].rings[0].ids,false);
+
+  // A multipolygon with two outer rings and a typed inner ring
+  areas[1].rings.resize(4);
+  areas[1].rings[0].SetType(5);
+  areas[1].rings[0].ring=osmscout::Area::masterRingId;
+  tags.clear();
+  tags.push_back(osmscout::Tag(tagName,"Forest"));
+  areas[1].rings[0].attributes.SetTags(progress,typeConfig,tags);
+  areas[1].rings[1].ring=osmscout::Area::outerRingId;
+  AddNodes(20,areas[1].rings[1].nodes,areas[1].rings[1].ids,false);
+  areas[1].rings[1].ids.clear();
+  areas[1].rings[2].ring=osmscout::Area::outerRingId;
+  AddNodes(30,areas[1].rings[2].nodes,areas[1].rings[2].ids,false);
+  areas[1].rings[2].ids.clear();
+  areas[1].rings[3].SetType(6);
+  areas[1].rings[3].ring=osmscout::Area::outerRingId+1;
+  tags.clear();
+  tags.push_back(osmscout::Tag(tagName,"Lake"));
+  areas[1].rings[3].attributes.SetTags(progress,typeConfig,tags);
+  AddNodes(5,areas[1].rings[3].nodes,areas[1].rings[3].ids,false);
+
+  osmscout::FileWriter writer;
+
+  if (!writer.Open("objectview.dat")) {
+    std::cerr << "Cannot create 'objectview.dat'" << std::endl;
+    return 1;
+  }
+
+  for (size_t w=0; w<ways.size(); w++) {
+    ways[w].Write(writer);
+  }
+
+  for (size_t a=0; a<areas.size(); a++) {
+    areas[a].Write(writer);
+  }
+
+  if (!writer.Close()) {
+    std::cerr << "Cannot write 'objectview.dat'" << std::endl;
+    return 1;
+  }
+
+  osmscout::FileScanner scanner;
+
+  if (!scanner.Open("objectview.dat",osmscout::FileScanner::FastRandom,true)) {
+    std::cerr << "Cannot open 'objectview.dat'" << std::endl;
+    return 1;
+  }
+
+  for (size_t w=0; w<ways.size(); w++) {
+    osmscout::FileOffset offset;
+    const char*          data;
+    const char*          end;
+    osmscout::WayView    view;
+
+    scanner.GetPos(offset);
+
+    if (!scanner.GetMappedData(offset,data,end)) {
+      std::cerr << "File is not memory mapped" << std::endl;
+      return 1;
+    }
+
+    Check(view.Set(offset,data,end),"Way: Cannot set view");
+
+    ways[w].Read(scanner);
+
+    CheckWay(ways[w],view);
+  }
+
+  for (size_t a=0; a<areas.size(); a++) {
+    osmscout::FileOffset offset;
+    const char*          data;
+    const char*          end;
+    osmscout::AreaView   view;
+
+    scanner.GetPos(offset);
+
+    if (!scanner.GetMappedData(offset,data,end)) {
+      std::cerr << "File is not memory mapped" << std::endl;
+      return 1;
+    }
+
+    Check(view.Set(offset,data,end),"Area: Cannot set view");
+
+    areas[a].Read(scanner);
+
+    CheckArea(areas[a],view);
+  }
+
+  // Data beyond the end of the file must be detected
+  {
+    osmscout::FileOffset offset;
+    const char*          data;
+    const char*          end;
+    osmscout::WayView    view;
+
+    scanner.GotoBegin();
+    scanner.GetPos(offset);
+    scanner.GetMappedData(offset,data,end);
+
+    Check(!view.Set(offset,data,data+3),"Way: Truncated data not detected");
+
+    // The last byte of the data has the continuation bit of a number set
+    const char number[]={(char)0x81};
+
+    Check(!view.Set(offset,number,number+sizeof(number)),"Way: Truncated number not detected");
+  }
+
+  scanner.Close();
+
+  if (errors!=0) {
+    return 1;
+  }
+  else {
+    return 0;
+  }
+}
@@ -0,0 +1,84 @@
+#include <iostream>
+#include <vector>
+
+#include <osmscout/util/ThreadPool.h>
+
+int errors=0;
+
+/**
+  Every task writes its own slot, so the result shows, if each task
+  has been executed exactly once.
+  */
+class CountJob : public osmscout::ParallelJob
+{
+public:
+  std::vector<int>    executions;
+  std::vector<size_t> workers;
+  size_t              workerCount;
+
+  CountJob(size_t taskCount,
+           size_t workerCount)
+  : executions(taskCount,0),
+    workers(taskCount,0),
+    workerCount(workerCount)
+  {
+    // no code
+  }
+
+  void Execute(size_t task,
+               size_t worker)
+  {
+    executions[task]++;
+    workers[task]=worker;
+  }
+
+  void Check(const char* name) const
+  {
+    for (size_t task=0; task<executions.size(); task++) {
+      if (executions[task]!=1) {
+        std::cerr << name << ": task " << task << " executed " << executions[task] << " times" << std::endl;
+        errors++;
+        return;
+      }
+
+      if (workers[task]>=workerCount) {
+        std::cerr << name << ": task " << task << " executed by invalid worker " << workers[task] << std::endl;
+        errors++;
+        return;
+      }
+    }
+  }
+};
+
+int main(int /*argc*/, char* /*argv*/[])
+{
+  osmscout::ThreadPool pool(4);
+
+  if (pool.GetWorkerCount()==0) {
+    std::cerr << "No workers!" << std::endl;
+    errors++;
+  }
+
+  // Jobs executed one after another by the same workers
+  for (size_t i=0; i<100; i++) {
+    CountJob job(i*10,pool.GetWorkerCount());
+
+    pool.Execute(job,i*10);
+
+    job.Check("Reused pool");
+  }
+
+  osmscout::ThreadPool defaultPool;
+  CountJob             job(10000,defaultPool.GetWorkerCount());
+
+  defaultPool.Execute(job,10000);
+
+  job.Check("Default pool");
+
+  if (errors!=0) {
+    return 1;
+  }
+  else {
+    return 0;
+  }
+}